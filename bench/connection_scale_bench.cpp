@@ -0,0 +1,354 @@
+// Connection-scale benchmark: opens N loopback TcpSocket connections (both
+// ends in this process), parks the server ends on an EventLoop and reports
+//
+//   - user-space RSS per connection (VmRSS delta, both ends included)
+//   - kernel socket memory per connection: buffer pages from
+//     /proc/net/sockstat and, when /proc/slabinfo is readable (root), the
+//     socket objects themselves
+//   - accept rate while establishing the connections
+//   - CPU per event-loop tick while every connection is idle
+//   - CPU per tick and per wakeup while a fraction of clients send
+//
+// Usage:
+//   connection_scale_bench [--connections 10000,100000,500000]
+//                          [--active-fraction 0.01] [--ticks 200]
+//                          [--tick-ms 10] [--per-listener 20000]
+//
+// Each connection uses two descriptors and one ephemeral port per listener;
+// the benchmark spreads clients across several listening ports and raises
+// RLIMIT_NOFILE as far as the hard limit allows. Half a million connections
+// need a hard limit above 1M (fs.nr_open) and ample tcp_mem.
+
+#include "net/core/endpoint.h"
+#include "net/core/event_loop.h"
+#include "net/core/io_capabilities.h"
+#include "net/protocol/tcp/tcp_acceptor.h"
+#include "net/protocol/tcp/tcp_socket.h"
+
+#include <array>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <optional>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <vector>
+
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+using namespace net;
+using Clock = std::chrono::steady_clock;
+
+namespace {
+
+struct Config {
+  std::vector<std::size_t> connections{10000};
+  double active_fraction = 0.01;
+  std::size_t ticks = 200;
+  std::chrono::milliseconds tick{10};
+  std::size_t per_listener = 20000;
+};
+
+struct Result {
+  std::size_t connections = 0;
+  double rss_per_connection = 0;    ///< Bytes
+  double kernel_per_connection = 0; ///< Bytes of buffer pages
+  double slab_per_connection = -1;  ///< Bytes; negative if unreadable
+  double accept_rate = 0;           ///< Connections per second
+  double idle_tick_cpu = 0;         ///< Microseconds
+  double active_tick_cpu = 0;       ///< Microseconds
+  double wakeup_cpu = 0;            ///< Microseconds per handler call
+};
+
+std::vector<std::size_t> parseList(std::string_view text) {
+  std::vector<std::size_t> values;
+  std::stringstream stream{std::string(text)};
+  std::string item;
+  while (std::getline(stream, item, ',')) {
+    values.push_back(std::stoul(item));
+  }
+  return values;
+}
+
+Config parseArgs(int argc, char **argv) {
+  Config config;
+  for (int i = 1; i + 1 < argc; i += 2) {
+    const std::string_view flag = argv[i];
+    const char *value = argv[i + 1];
+    if (flag == "--connections") {
+      config.connections = parseList(value);
+    } else if (flag == "--active-fraction") {
+      config.active_fraction = std::stod(value);
+    } else if (flag == "--ticks") {
+      config.ticks = std::stoul(value);
+    } else if (flag == "--tick-ms") {
+      config.tick = std::chrono::milliseconds(std::stol(value));
+    } else if (flag == "--per-listener") {
+      config.per_listener = std::stoul(value);
+    } else {
+      std::fprintf(stderr, "unknown option %s\n", argv[i]);
+      std::exit(2);
+    }
+  }
+  return config;
+}
+
+/// Resident set size in bytes (VmRSS).
+std::size_t residentBytes() {
+  std::ifstream status("/proc/self/status");
+  std::string line;
+  while (std::getline(status, line)) {
+    if (line.rfind("VmRSS:", 0) == 0) {
+      return std::stoul(line.substr(6)) * 1024;
+    }
+  }
+  return 0;
+}
+
+/// Kernel TCP memory in bytes ("TCP: ... mem <pages>" in sockstat).
+std::size_t kernelTcpBytes() {
+  std::ifstream sockstat("/proc/net/sockstat");
+  std::string line;
+  while (std::getline(sockstat, line)) {
+    if (line.rfind("TCP:", 0) != 0) {
+      continue;
+    }
+    const auto pos = line.find(" mem ");
+    if (pos != std::string::npos) {
+      const auto page = static_cast<std::size_t>(::sysconf(_SC_PAGESIZE));
+      return std::stoul(line.substr(pos + 5)) * page;
+    }
+  }
+  return 0;
+}
+
+/// Bytes in the slab caches backing TCP sockets, or nullopt if
+/// /proc/slabinfo is not readable.
+std::optional<std::size_t> socketSlabBytes() {
+  std::ifstream slabinfo("/proc/slabinfo");
+  if (!slabinfo) {
+    return std::nullopt;
+  }
+  std::size_t total = 0;
+  std::string line;
+  while (std::getline(slabinfo, line)) {
+    std::istringstream fields(line);
+    std::string name;
+    std::size_t active = 0, objects = 0, size = 0;
+    if (!(fields >> name >> active >> objects >> size)) {
+      continue;
+    }
+    if (name == "TCP" || name == "TCPv6" || name == "sock_inode_cache") {
+      total += active * size;
+    }
+  }
+  return total;
+}
+
+/// User plus system CPU time of the process.
+std::chrono::microseconds cpuTime() {
+  rusage usage{};
+  ::getrusage(RUSAGE_SELF, &usage);
+  auto micros = [](const timeval &tv) {
+    return std::chrono::seconds(tv.tv_sec) +
+           std::chrono::microseconds(tv.tv_usec);
+  };
+  return std::chrono::duration_cast<std::chrono::microseconds>(
+      micros(usage.ru_utime) + micros(usage.ru_stime));
+}
+
+double microsPer(std::chrono::microseconds total, std::size_t count) {
+  return count == 0 ? 0.0
+                    : static_cast<double>(total.count()) /
+                          static_cast<double>(count);
+}
+
+/// Close with RST so torn-down runs leave no TIME_WAIT behind.
+void abortiveClose(TcpSocket &socket) {
+  linger option{1, 0};
+  ::setsockopt(socket.native_handle(), SOL_SOCKET, SO_LINGER, &option,
+               sizeof(option));
+  socket.close();
+}
+
+class ScaleRun {
+public:
+  ScaleRun(const Config &config, std::size_t connections)
+      : config_(config), target_(connections) {}
+
+  Result run() {
+    Result result;
+    result.connections = target_;
+
+    const std::size_t rss_before = residentBytes();
+    const std::size_t kernel_before = kernelTcpBytes();
+    const auto slab_before = socketSlabBytes();
+
+    const auto setup_start = Clock::now();
+    establish();
+    const std::chrono::duration<double> setup = Clock::now() - setup_start;
+    result.accept_rate = static_cast<double>(servers_.size()) / setup.count();
+
+    for (std::size_t i = 0; i < servers_.size(); ++i) {
+      loop_.add(servers_[i].native_handle(), EventLoop::Readable,
+                [this, i](unsigned) { onReadable(i); }, "connection");
+    }
+
+    const double count = static_cast<double>(servers_.size());
+    result.rss_per_connection =
+        static_cast<double>(residentBytes() - rss_before) / count;
+    result.kernel_per_connection =
+        static_cast<double>(kernelTcpBytes() - kernel_before) / count;
+    if (const auto slab_after = socketSlabBytes(); slab_before && slab_after) {
+      result.slab_per_connection =
+          (static_cast<double>(*slab_after) -
+           static_cast<double>(*slab_before)) /
+          count;
+    }
+
+    result.idle_tick_cpu = microsPer(measureTicks(0), config_.ticks);
+
+    const auto active = static_cast<std::size_t>(
+        count * config_.active_fraction + 0.5);
+    wakeups_ = 0;
+    const auto busy = measureTicks(active);
+    result.active_tick_cpu = microsPer(busy, config_.ticks);
+    result.wakeup_cpu = microsPer(busy, wakeups_);
+
+    teardown();
+    return result;
+  }
+
+private:
+  void establish() {
+    const std::size_t listeners =
+        (target_ + config_.per_listener - 1) / config_.per_listener;
+    for (std::size_t i = 0; i < listeners; ++i) {
+      auto &listener = listeners_.emplace_back(std::make_unique<TcpSocket>(
+          TcpSocket::AddressFamily::IPV4, TcpSocket::BlockingType::NonBlocking));
+      listener->bind(Endpoint("127.0.0.1", 0));
+      listener->listen(kBacklog);
+      acceptors_.push_back(std::make_unique<TcpAcceptor>(
+          *listener, TcpAcceptor::Options{.raise_descriptor_limit = false}));
+    }
+
+    clients_.reserve(target_);
+    servers_.reserve(target_);
+    while (clients_.size() < target_) {
+      // Keep each batch below the backlog: an overflowing accept queue
+      // drops SYNs and stalls connect() for a retransmit timeout.
+      const std::size_t batch =
+          std::min<std::size_t>(kBacklog / 2, target_ - clients_.size());
+      for (std::size_t n = 0; n < batch; ++n) {
+        const std::size_t listener = clients_.size() / config_.per_listener;
+        clients_.emplace_back().connect(listeners_[listener]->localEndpoint());
+      }
+      acceptPending();
+    }
+    while (servers_.size() < clients_.size()) {
+      acceptPending();
+    }
+  }
+
+  void acceptPending() {
+    for (auto &acceptor : acceptors_) {
+      Endpoint peer;
+      while (auto accepted = acceptor->accept(peer)) {
+        servers_.push_back(std::move(*accepted));
+      }
+    }
+  }
+
+  void onReadable(std::size_t index) {
+    ++wakeups_;
+    std::array<std::byte, 64> buffer{};
+    try {
+      (void)servers_[index].receive(buffer);
+    } catch (const std::system_error &) {
+      // Spurious wakeup (EAGAIN) on a non-blocking server end.
+    }
+  }
+
+  /// Run `ticks` loop iterations; `active` clients send one byte per tick.
+  std::chrono::microseconds measureTicks(std::size_t active) {
+    const std::array<std::byte, 1> ping{std::byte{'p'}};
+    std::size_t next = 0;
+    const auto cpu_start = cpuTime();
+    for (std::size_t tick = 0; tick < config_.ticks; ++tick) {
+      for (std::size_t n = 0; n < active; ++n) {
+        (void)clients_[next].send(ping);
+        next = (next + 1) % clients_.size();
+      }
+      loop_.runOnce(config_.tick);
+    }
+    return cpuTime() - cpu_start;
+  }
+
+  void teardown() {
+    for (auto &server : servers_) {
+      loop_.remove(server.native_handle());
+    }
+    for (auto &client : clients_) {
+      abortiveClose(client);
+    }
+    servers_.clear();
+    clients_.clear();
+  }
+
+  static constexpr int kBacklog = 4096;
+
+  const Config &config_;
+  std::size_t target_;
+  EventLoop loop_;
+  std::vector<std::unique_ptr<TcpSocket>> listeners_;
+  std::vector<std::unique_ptr<TcpAcceptor>> acceptors_;
+  std::vector<TcpSocket> clients_;
+  std::vector<TcpSocket> servers_;
+  std::size_t wakeups_ = 0;
+};
+
+} // namespace
+
+int main(int argc, char **argv) {
+  const Config config = parseArgs(argc, argv);
+
+  std::size_t largest = 0;
+  for (std::size_t n : config.connections) {
+    largest = std::max(largest, n);
+  }
+  const std::size_t limit = raiseFileDescriptorLimit(2 * largest + 1024);
+  const IoBackends backends = ioBackends();
+  std::printf("kernel %s, poller %s, descriptor limit %zu\n",
+              ioCapabilities().kernel.c_str(),
+              std::string(toString(backends.poller)).c_str(), limit);
+  std::printf("%12s %12s %12s %12s %12s %12s %12s %12s\n", "connections",
+              "rss/conn B", "kbuf/conn B", "slab/conn B", "accept/s",
+              "idle tick us", "active tick", "us/wakeup");
+
+  for (std::size_t connections : config.connections) {
+    if (2 * connections + 64 > limit) {
+      std::printf("%12zu skipped: needs %zu descriptors\n", connections,
+                  2 * connections + 64);
+      continue;
+    }
+    try {
+      const Result r = ScaleRun(config, connections).run();
+      std::printf("%12zu %12.0f %12.0f %12.0f %12.0f %12.2f %12.2f %12.2f\n",
+                  r.connections, r.rss_per_connection,
+                  r.kernel_per_connection, r.slab_per_connection,
+                  r.accept_rate, r.idle_tick_cpu, r.active_tick_cpu,
+                  r.wakeup_cpu);
+    } catch (const std::exception &e) {
+      std::printf("%12zu failed: %s\n", connections, e.what());
+    }
+    std::fflush(stdout);
+  }
+  return 0;
+}
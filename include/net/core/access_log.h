@@ -0,0 +1,174 @@
+#pragma once
+#include "net/core/endpoint.h"
+#include "net/detail/spsc_queue.h"
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+namespace net {
+
+/**
+ * @brief One access-log entry: a fixed-size, trivially copyable record.
+ *
+ * Producers fill it in without formatting or allocating; the logger's
+ * background thread turns it into text.
+ */
+struct AccessRecord {
+  /// Wall-clock time in nanoseconds since the Unix epoch; 0 means "stamp
+  /// when logged".
+  std::int64_t timestamp_ns = 0;
+  Endpoint peer;
+  std::uint32_t status = 0;
+  std::uint32_t duration_us = 0;
+  std::uint64_t bytes_in = 0;
+  std::uint64_t bytes_out = 0;
+  /// Request target or label, truncated and NUL-padded.
+  std::array<char, 64> target{};
+
+  /// Copy `text` into target, truncating if needed.
+  void setTarget(std::string_view text) noexcept;
+
+  /// The stored target.
+  [[nodiscard]] std::string_view targetView() const noexcept;
+};
+
+/**
+ * @brief Asynchronous access logger with per-thread rings and batched
+ * writes.
+ *
+ * log() copies the record into a single-producer ring owned by the calling
+ * thread: no lock, allocation or formatting on the request path (a
+ * thread's first log() registers its ring under a mutex). A background
+ * thread drains all rings, formats lines with format() and writes them to
+ * the descriptor in batches of up to `batch_bytes`.
+ *
+ * A record that finds its ring full is dropped and counted rather than
+ * blocking the worker. Lines from different threads are not ordered by
+ * time; lines from one thread keep their order.
+ *
+ * Line format:
+ * `2026-10-18T09:30:00.123456Z 10.0.0.1:51234 "/index.html" 200 1532us
+ * in=120 out=5120`
+ *
+ * @note Available on POSIX platforms only.
+ */
+class AccessLogger {
+public:
+  /// Logger configuration.
+  struct Options {
+    /// Records buffered per producing thread.
+    std::size_t ring_capacity = 1024;
+    /// Formatted bytes collected before a write().
+    std::size_t batch_bytes = 64 * 1024;
+    /// How often the background thread drains the rings.
+    std::chrono::milliseconds flush_interval{20};
+  };
+
+  /// Counters since construction.
+  struct Stats {
+    std::uint64_t logged = 0;  ///< Records accepted by log()
+    std::uint64_t dropped = 0; ///< Records rejected because a ring was full
+    std::uint64_t written = 0; ///< Records written out
+    std::uint64_t writes = 0;  ///< write() calls
+    std::uint64_t write_errors = 0;
+  };
+
+  /// Longest line format() produces, newline included.
+  static constexpr std::size_t max_line_length = 256;
+
+  /**
+   * @brief Start the background thread writing to `fd`.
+   *
+   * @param fd Open descriptor; not owned, must stay open until the logger
+   * is destroyed.
+   *
+   * @throws std::invalid_argument if ring_capacity is zero or batch_bytes
+   * is smaller than max_line_length.
+   */
+  AccessLogger(int fd, Options options);
+
+  /// Log to `fd` with default options.
+  explicit AccessLogger(int fd) : AccessLogger(fd, Options{}) {}
+
+  /// Write everything still buffered, then stop the background thread.
+  ~AccessLogger();
+
+  AccessLogger(const AccessLogger &) = delete;
+  AccessLogger &operator=(const AccessLogger &) = delete;
+
+  /**
+   * @brief Queue a record; never blocks after the thread's first call.
+   *
+   * @return False if the calling thread's ring is full and the record was
+   * dropped.
+   */
+  bool log(const AccessRecord &record);
+
+  /**
+   * @brief Block until every record the calling thread logged before the
+   * call has been written.
+   */
+  void flush();
+
+  /// Counters since construction.
+  [[nodiscard]] Stats stats() const noexcept;
+
+  /**
+   * @brief Format one record as a newline-terminated line.
+   *
+   * @param out Destination; max_line_length characters always suffice.
+   *
+   * @return Characters written, or 0 if `out` is too small.
+   */
+  static std::size_t format(const AccessRecord &record,
+                            std::span<char> out) noexcept;
+
+private:
+  /// One producing thread's ring and counters (written by that thread).
+  struct Producer {
+    explicit Producer(std::size_t capacity) : ring(capacity) {}
+    detail::SpscQueue<AccessRecord> ring;
+    alignas(64) std::atomic<std::uint64_t> logged{0};
+    std::atomic<std::uint64_t> dropped{0};
+  };
+
+  Producer &localProducer();
+  void run();
+  void drain();
+  void writeBatch();
+
+  int fd_;
+  Options options_;
+  std::uint64_t id_; ///< Distinguishes loggers in thread-local caches
+
+  mutable std::mutex mutex_;
+  std::condition_variable wake_;
+  std::condition_variable flushed_cv_;
+  std::vector<std::unique_ptr<Producer>> producers_; ///< Guarded by mutex_
+  std::uint64_t flush_requested_ = 0;        ///< Guarded by mutex_
+  std::uint64_t flush_done_ = 0;             ///< Guarded by mutex_
+  bool stopping_ = false;                    ///< Guarded by mutex_
+
+  // Background thread only.
+  std::vector<char> batch_;
+  std::size_t batch_used_ = 0;
+  std::size_t batch_records_ = 0;
+  std::vector<Producer *> draining_;
+
+  std::atomic<std::uint64_t> written_{0};
+  std::atomic<std::uint64_t> writes_{0};
+  std::atomic<std::uint64_t> write_errors_{0};
+
+  std::thread thread_;
+};
+
+} // namespace net
@@ -0,0 +1,92 @@
+#pragma once
+#include <cstddef>
+#include <memory_resource>
+#include <span>
+#include <vector>
+
+namespace net {
+
+/**
+ * @brief Single-threaded pool of fixed-size I/O buffers.
+ *
+ * Buffers are carved from an upstream memory resource and recycled through
+ * a free list, so steady-state acquire/release never reaches the global
+ * allocator. The pool is not thread-safe: in a thread-per-core design each
+ * core owns one and buffers must be released on the owning thread.
+ */
+class BufferPool {
+public:
+  /**
+   * @brief Lease of one buffer; returns it to the pool on destruction.
+   */
+  class Buffer {
+  public:
+    Buffer() = default;
+    Buffer(Buffer &&other) noexcept;
+    Buffer &operator=(Buffer &&other) noexcept;
+    Buffer(const Buffer &) = delete;
+    Buffer &operator=(const Buffer &) = delete;
+    ~Buffer() { reset(); }
+
+    /// Writable view of the whole buffer.
+    [[nodiscard]] std::span<std::byte> data() const noexcept {
+      return {data_, size_};
+    }
+
+    /// True if this lease holds a buffer.
+    explicit operator bool() const noexcept { return data_ != nullptr; }
+
+    /// Return the buffer to its pool early.
+    void reset() noexcept;
+
+  private:
+    friend class BufferPool;
+    Buffer(BufferPool *pool, std::byte *data, std::size_t size) noexcept
+        : pool_(pool), data_(data), size_(size) {}
+
+    BufferPool *pool_ = nullptr;
+    std::byte *data_ = nullptr;
+    std::size_t size_ = 0;
+  };
+
+  /**
+   * @brief Create a pool.
+   *
+   * @param buffer_size Size of every buffer in bytes.
+   * @param preallocate Buffers allocated up front.
+   * @param upstream Resource supplying buffer memory; must outlive the pool.
+   *
+   * @throws std::invalid_argument if buffer_size is zero.
+   */
+  explicit BufferPool(
+      std::size_t buffer_size, std::size_t preallocate = 0,
+      std::pmr::memory_resource *upstream = std::pmr::get_default_resource());
+
+  /// Frees all buffers; every lease must have been released.
+  ~BufferPool();
+
+  BufferPool(const BufferPool &) = delete;
+  BufferPool &operator=(const BufferPool &) = delete;
+
+  /// Lease a buffer, allocating a new one if the free list is empty.
+  [[nodiscard]] Buffer acquire();
+
+  /// Size of every buffer.
+  [[nodiscard]] std::size_t bufferSize() const noexcept { return buffer_size_; }
+
+  /// Buffers currently in the free list.
+  [[nodiscard]] std::size_t available() const noexcept { return free_.size(); }
+
+  /// Buffers allocated over the pool's lifetime.
+  [[nodiscard]] std::size_t allocated() const noexcept { return allocated_; }
+
+private:
+  void release(std::byte *data) noexcept;
+
+  std::size_t buffer_size_;
+  std::pmr::memory_resource *upstream_;
+  std::vector<std::byte *> free_;
+  std::size_t allocated_ = 0;
+};
+
+} // namespace net
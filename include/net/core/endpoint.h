@@ -1,7 +1,11 @@
 #pragma once
 #include "net/detail/ip_address.h"
 #include "net/detail/platform_types.h"
+#include <cstddef>
 #include <cstdint>
+#include <functional>
+#include <span>
+#include <string>
 
 namespace net {
 
@@ -93,6 +97,35 @@ public:
    */
   std::string to_string() const;
 
+  /// Upper bound on the length of to_string(): "[" IPv6 "]:" port.
+  static constexpr std::size_t max_string_length = 1 + 45 + 2 + 5;
+
+  /**
+   * @brief Writes the to_string() form into `out` without allocating.
+   *
+   * IPv4 addresses are formatted directly rather than through
+   * inet_ntop(), which makes this cheap enough for per-request logging.
+   *
+   * @param out Destination; max_string_length characters always suffice.
+   *
+   * @return Number of characters written (no terminator), or 0 if `out` is
+   * too small or the address family is unknown.
+   */
+  std::size_t format_to(std::span<char> out) const noexcept;
+
+  /**
+   * @brief Compares address family, address and port.
+   *
+   * IPv6 endpoints also compare their scope id; flow information is
+   * ignored. Endpoints of any other family compare their raw bytes.
+   */
+  bool operator==(const Endpoint &other) const noexcept;
+
+  /**
+   * @brief Hash consistent with operator==, for unordered containers.
+   */
+  std::size_t hash() const noexcept;
+
   /**
    * @brief Sets the size of the sockaddr_storage.
    *
@@ -103,9 +136,15 @@ public:
   void set_size(detail::socket_length_t size) noexcept { size_ = size; }
 
 private:
-  sockaddr_storage storage_; ///< Internal storage for the address
+  sockaddr_storage storage_{}; ///< Internal storage for the address
   detail::socket_length_t size_ =
       sizeof(storage_); ///< Current size of the address
 };
 
 } // namespace net
+
+template <> struct std::hash<net::Endpoint> {
+  std::size_t operator()(const net::Endpoint &endpoint) const noexcept {
+    return endpoint.hash();
+  }
+};
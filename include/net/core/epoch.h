@@ -0,0 +1,211 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+namespace net {
+
+namespace detail {
+struct EpochSlot;
+} // namespace detail
+
+/**
+ * @brief Epoch-based reclamation for read-mostly shared structures.
+ *
+ * Readers access shared objects without locks and without touching shared
+ * reference counts; writers unlink an object, retire() it, and the domain
+ * frees it once no reader can still hold it.
+ *
+ * Each thread that reads gets its own cache-line-sized slot in the domain
+ * (registered on first use, recycled when the thread exits). A reader
+ * announces the domain's current epoch in its slot while it may hold
+ * references; the only shared location it reads is the epoch counter,
+ * which changes once per retire(). An object retired at epoch E is freed
+ * when every announced epoch is at least E.
+ *
+ * Two reader styles share one domain:
+ *
+ *  - Critical sections: a Guard from pin() covers the accesses. Guards
+ *    nest and cost one slot store and a fence on entry.
+ *  - Quiescent states (QSBR): a thread that calls online() stays
+ *    protected with no per-access cost and calls quiescent() at points
+ *    where it holds no references, e.g. once per event loop iteration,
+ *    and offline() before blocking for long. Guards taken by an online
+ *    thread are free.
+ *
+ * A reader that stays pinned (or online without quiescent()) delays
+ * reclamation but never blocks writers. retire(), reclaim() and
+ * synchronize() may run on any thread, including readers outside a
+ * critical section.
+ */
+class EpochDomain {
+public:
+  /// Critical section of the calling thread; see pin().
+  class Guard {
+  public:
+    Guard(Guard &&other) noexcept
+        : slot_(std::exchange(other.slot_, nullptr)) {}
+    Guard &operator=(Guard &&other) noexcept {
+      if (this != &other) {
+        release();
+        slot_ = std::exchange(other.slot_, nullptr);
+      }
+      return *this;
+    }
+    Guard(const Guard &) = delete;
+    Guard &operator=(const Guard &) = delete;
+    ~Guard() { release(); }
+
+    /// Leave the critical section early.
+    void release() noexcept;
+
+  private:
+    friend class EpochDomain;
+    explicit Guard(detail::EpochSlot *slot) noexcept : slot_(slot) {}
+
+    detail::EpochSlot *slot_;
+  };
+
+  EpochDomain();
+
+  /// Frees every retired object; no thread may be pinned or online.
+  ~EpochDomain();
+
+  EpochDomain(const EpochDomain &) = delete;
+  EpochDomain &operator=(const EpochDomain &) = delete;
+
+  /**
+   * @brief Enter a critical section on the calling thread.
+   *
+   * Objects reachable when pin() returns stay valid until the guard is
+   * released. The guard must be released on the same thread. Allocates
+   * only on a thread's first use of the domain.
+   */
+  [[nodiscard]] Guard pin();
+
+  /// Mark the calling thread as a QSBR reader, protected from now on.
+  void online();
+
+  /// Declare that the calling thread holds no references; no-op unless
+  /// online and outside every Guard.
+  void quiescent() noexcept;
+
+  /// Stop protecting the calling thread until the next online().
+  void offline() noexcept;
+
+  /**
+   * @brief Free `object` with `deleter` once no reader can hold it.
+   *
+   * The object must already be unreachable for new readers. Also frees
+   * earlier retirees that have become safe.
+   */
+  void retire(void *object, void (*deleter)(void *));
+
+  /// Retire an object allocated with new.
+  template <typename T> void retire(T *object) {
+    retire(const_cast<void *>(static_cast<const void *>(object)),
+           [](void *p) { delete static_cast<T *>(p); });
+  }
+
+  /**
+   * @brief Free retired objects that no reader can hold any more.
+   *
+   * @return Number of objects freed.
+   */
+  std::size_t reclaim();
+
+  /**
+   * @brief Wait until every reader that might hold a retired object has
+   * moved on, then free them all.
+   *
+   * Must not be called while the calling thread is pinned or online.
+   */
+  void synchronize();
+
+  /// Retired objects not freed yet.
+  [[nodiscard]] std::size_t pending() const;
+
+private:
+  struct Retired {
+    void *object;
+    void (*deleter)(void *);
+    std::uint64_t epoch;
+  };
+
+  detail::EpochSlot *slot();
+  detail::EpochSlot *registerThread();
+  void announce(detail::EpochSlot &slot) noexcept;
+  [[nodiscard]] std::uint64_t oldestReader() const;
+
+  alignas(64) std::atomic<std::uint64_t> epoch_{1};
+  const std::uint64_t id_;
+  mutable std::mutex mutex_;
+  std::vector<std::shared_ptr<detail::EpochSlot>> slots_;
+  std::vector<Retired> retired_;
+};
+
+/**
+ * @brief An atomically replaceable pointer to an immutable T whose old
+ * values are reclaimed through an EpochDomain.
+ *
+ * read() pins the current value for the lifetime of the returned Reader;
+ * publish() swaps in a new value and retires the previous one. Writers
+ * should serialize among themselves if they derive the new value from the
+ * old one.
+ */
+template <typename T> class EpochCell {
+public:
+  /// Pinned access to the value current when read() was called.
+  class Reader {
+  public:
+    const T &operator*() const noexcept { return *value_; }
+    const T *operator->() const noexcept { return value_; }
+    [[nodiscard]] const T *get() const noexcept { return value_; }
+
+  private:
+    friend class EpochCell;
+    Reader(EpochDomain::Guard guard, const T *value) noexcept
+        : guard_(std::move(guard)), value_(value) {}
+
+    EpochDomain::Guard guard_;
+    const T *value_;
+  };
+
+  EpochCell(EpochDomain &domain, std::unique_ptr<const T> initial)
+      : domain_(domain), value_(initial.release()) {}
+
+  /// Frees the current value; no reader may be alive.
+  ~EpochCell() { delete value_.load(std::memory_order_relaxed); }
+
+  EpochCell(const EpochCell &) = delete;
+  EpochCell &operator=(const EpochCell &) = delete;
+
+  /// Pin and return the current value.
+  [[nodiscard]] Reader read() const {
+    EpochDomain::Guard guard = domain_.pin();
+    return Reader(std::move(guard), value_.load(std::memory_order_acquire));
+  }
+
+  /// Current value for a thread that is already pinned or online.
+  [[nodiscard]] const T *load() const noexcept {
+    return value_.load(std::memory_order_acquire);
+  }
+
+  /// Replace the value; the old one is freed when readers have moved on.
+  void publish(std::unique_ptr<const T> value) {
+    const T *old = value_.exchange(value.release(), std::memory_order_acq_rel);
+    if (old != nullptr) {
+      domain_.retire(old);
+    }
+  }
+
+private:
+  EpochDomain &domain_;
+  std::atomic<const T *> value_;
+};
+
+} // namespace net
@@ -0,0 +1,477 @@
+#pragma once
+#include "net/detail/mpsc_queue.h"
+#include "net/detail/socket_handle.h"
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <queue>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace net {
+
+namespace detail {
+class EventPoller;
+} // namespace detail
+
+/**
+ * @brief Single-threaded readiness event loop with built-in profiling.
+ *
+ * Dispatches descriptor readiness (epoll on Linux, poll() on other POSIX
+ * systems), one-shot timers and tasks posted from other threads. Every
+ * iteration is split into four phases whose durations are accumulated:
+ *
+ *  - wait:      blocked in epoll_wait()/poll()
+ *  - dispatch:  loop bookkeeping for readiness events and posted tasks
+ *  - timers:    timer queue bookkeeping
+ *  - callbacks: user code (I/O handlers, timer tasks, posted tasks)
+ *
+ * Timer lateness (actual minus scheduled firing time) is exported as loop
+ * lag. When the busy part of an iteration exceeds `Options::stall_threshold`
+ * the stall handler receives the phase breakdown and the label of the
+ * slowest callback, so a handler that blocks the loop can be identified.
+ *
+ * Apart from `post()` and `stop()`, all members must be called from the
+ * thread running the loop (or before it starts).
+ *
+ * @note Available on POSIX platforms only.
+ */
+class EventLoop {
+public:
+  using Handle = detail::SocketDescriptorHandle::Handle;
+  using Clock = std::chrono::steady_clock;
+  using TimerId = std::uint64_t;
+
+  /// Readiness bits, used both as interest and as reported events.
+  enum IoEvent : unsigned {
+    Readable = 1u << 0,
+    Writable = 1u << 1,
+    Error = 1u << 2,  ///< Reported only
+    Hangup = 1u << 3, ///< Reported only
+    /// Interest only: report transitions instead of levels (EPOLLET). The
+    /// poll() backend ignores it and stays level-triggered.
+    EdgeTriggered = 1u << 4,
+  };
+
+  /// Called with the reported IoEvent bits when a descriptor is ready.
+  using IoHandler = std::function<void(unsigned events)>;
+  using Task = std::function<void()>;
+
+  /**
+   * @brief Work a budgeted handler may do for one connection per iteration.
+   *
+   * The handler charges what it reads and writes; once a direction is
+   * exhausted it should stop and return IoStatus::Pending so that other
+   * connections get their turn.
+   */
+  struct IoBudget {
+    std::size_t read_bytes = 64 * 1024;
+    std::size_t write_bytes = 64 * 1024;
+    std::size_t read_ops = 16;
+    std::size_t write_ops = 16;
+
+    [[nodiscard]] bool canRead() const noexcept {
+      return read_bytes > 0 && read_ops > 0;
+    }
+    [[nodiscard]] bool canWrite() const noexcept {
+      return write_bytes > 0 && write_ops > 0;
+    }
+
+    /// Account for one or more receive calls that returned `bytes`.
+    void chargeRead(std::size_t bytes, std::size_t ops = 1) noexcept {
+      read_bytes -= bytes < read_bytes ? bytes : read_bytes;
+      read_ops -= ops < read_ops ? ops : read_ops;
+    }
+    /// Account for one or more send calls that accepted `bytes`.
+    void chargeWrite(std::size_t bytes, std::size_t ops = 1) noexcept {
+      write_bytes -= bytes < write_bytes ? bytes : write_bytes;
+      write_ops -= ops < write_ops ? ops : write_ops;
+    }
+  };
+
+  /// Outcome of a budgeted handler invocation.
+  enum class IoStatus {
+    Done,    ///< Caught up; wait for the next readiness event
+    Pending, ///< Stopped on budget; run again after other ready connections
+  };
+
+  /**
+   * @brief Handler that works within a per-iteration IoBudget.
+   *
+   * Receives the ready events (for a requeued connection, the events that
+   * were still outstanding) and a fresh budget on every call.
+   */
+  using BudgetedHandler = std::function<IoStatus(unsigned events, IoBudget &)>;
+
+  /// Time spent in each phase of the loop.
+  struct PhaseTimes {
+    std::chrono::nanoseconds wait{};
+    std::chrono::nanoseconds dispatch{};
+    std::chrono::nanoseconds timers{};
+    std::chrono::nanoseconds callbacks{};
+
+    /// Time the loop was not waiting for events.
+    [[nodiscard]] std::chrono::nanoseconds busy() const noexcept {
+      return dispatch + timers + callbacks;
+    }
+  };
+
+  /// Cumulative loop measurements.
+  struct Stats {
+    std::uint64_t iterations = 0;
+    PhaseTimes total; ///< Sum over all iterations
+    PhaseTimes last;  ///< Most recent iteration
+
+    std::chrono::nanoseconds lag_last{}; ///< Lateness of the last timer
+    std::chrono::nanoseconds lag_max{};  ///< Worst timer lateness
+    std::chrono::nanoseconds lag_total{};
+    std::uint64_t lag_samples = 0;
+
+    std::uint64_t stalls = 0; ///< Iterations over the stall threshold
+
+    std::uint64_t requeued = 0; ///< Budgeted handlers that returned Pending
+
+    /// Mean timer lateness.
+    [[nodiscard]] std::chrono::nanoseconds lagMean() const noexcept {
+      return lag_samples == 0
+                 ? std::chrono::nanoseconds{}
+                 : lag_total / static_cast<std::int64_t>(lag_samples);
+    }
+  };
+
+  /// Description of an iteration that exceeded the stall threshold.
+  struct StallReport {
+    PhaseTimes phases;        ///< Breakdown of the slow iteration
+    std::string_view culprit; ///< Label of the slowest callback
+    std::chrono::nanoseconds culprit_time{};
+  };
+
+  using StallHandler = std::function<void(const StallReport &)>;
+
+  /// Loop configuration.
+  struct Options {
+    /// Busy time per iteration that counts as a stall; zero disables.
+    std::chrono::nanoseconds stall_threshold = std::chrono::milliseconds(100);
+    /// Readiness events fetched per wait.
+    std::size_t max_events = 256;
+    /// Use the poll() backend even where epoll is available. Otherwise
+    /// the backend follows ioBackends().poller.
+    bool force_poll = false;
+    /// Budget given to budgeted handlers that do not specify their own.
+    IoBudget io_budget;
+  };
+
+  /**
+   * @brief Create the loop and its wakeup channel.
+   *
+   * The default stall handler writes one line per stall to stderr.
+   *
+   * @throws std::invalid_argument if max_events is zero.
+   * @throws std::system_error if the poller cannot be created.
+   */
+  explicit EventLoop(Options options);
+
+  /// Create a loop with default options.
+  EventLoop() : EventLoop(Options{}) {}
+
+  ~EventLoop();
+
+  EventLoop(const EventLoop &) = delete;
+  EventLoop &operator=(const EventLoop &) = delete;
+
+  /**
+   * @brief Watch a descriptor.
+   *
+   * @param fd Descriptor to watch; it should be non-blocking.
+   * @param interest Readable and/or Writable.
+   * @param handler Called with the ready events; may add, modify or remove
+   *                registrations, including its own.
+   * @param label Name reported when this handler causes a stall.
+   *
+   * @throws std::invalid_argument if fd is invalid, already registered or
+   * the handler is empty.
+   * @throws std::system_error if the poller rejects the descriptor.
+   */
+  void add(Handle fd, unsigned interest, IoHandler handler,
+           std::string label = {});
+
+  /**
+   * @brief Watch a descriptor with a handler that is limited per iteration.
+   *
+   * Ready connections are served in order; a handler that returns
+   * IoStatus::Pending is requeued at the back of the ready list with its
+   * outstanding events, so a single busy connection (notably with
+   * EdgeTriggered interest, where the kernel will not report it again)
+   * cannot monopolize the loop while others wait.
+   *
+   * @param fd Descriptor to watch; it should be non-blocking.
+   * @param interest Readable and/or Writable, optionally EdgeTriggered.
+   * @param handler Handler charging its work against the budget.
+   * @param label Name reported when this handler causes a stall.
+   * @param budget Per-iteration budget; Options::io_budget if omitted.
+   *
+   * @throws std::invalid_argument if fd is invalid, already registered or
+   * the handler is empty.
+   * @throws std::system_error if the poller rejects the descriptor.
+   */
+  void addBudgeted(Handle fd, unsigned interest, BudgetedHandler handler,
+                   std::string label = {},
+                   std::optional<IoBudget> budget = std::nullopt);
+
+  /**
+   * @brief Change the interest set of a registered descriptor.
+   *
+   * @throws std::invalid_argument if fd is not registered.
+   * @throws std::system_error if the poller rejects the change.
+   */
+  void modify(Handle fd, unsigned interest);
+
+  /**
+   * @brief Stop watching a descriptor. Unknown descriptors are ignored.
+   *
+   * Must be called before the descriptor is closed.
+   */
+  void remove(Handle fd) noexcept;
+
+  /// True if fd is registered.
+  [[nodiscard]] bool contains(Handle fd) const noexcept;
+
+  /// Number of registered descriptors, e.g. as a load signal for migration.
+  [[nodiscard]] std::size_t registrationCount() const noexcept {
+    return registrations_.size();
+  }
+
+  class Migration;
+
+  /// Called on the target loop's thread once a migration is registered.
+  using AdoptedHandler = std::function<void(EventLoop &)>;
+
+  /**
+   * @brief Unregister a descriptor so it can be handed to another loop.
+   *
+   * The returned Migration carries the handler (and with it whatever
+   * connection state the handler owns), label, interest, budget and any
+   * events still owed to a requeued budgeted handler. May be called from
+   * the descriptor's own handler.
+   *
+   * @throws std::invalid_argument if fd is not registered.
+   */
+  [[nodiscard]] Migration detach(Handle fd);
+
+  /**
+   * @brief Register a detached descriptor on this loop. Thread-safe.
+   *
+   * The migration travels through a lock-free handoff queue and is
+   * registered on this loop's thread during its next iteration. The
+   * handler is then dispatched once with its interest set (plus any events
+   * still owed to it) so readiness consumed before the move is not lost;
+   * handlers must therefore tolerate spurious readiness.
+   *
+   * @param migration Result of detach() on the source loop.
+   * @param adopted Optional callback run on this loop's thread right after
+   *                registration, e.g. to update a connection's loop pointer.
+   *
+   * @throws std::invalid_argument if the migration is empty.
+   */
+  void adopt(Migration migration, AdoptedHandler adopted = {});
+
+  /**
+   * @brief Run a task once after a delay.
+   *
+   * @param delay Time from now until the task is due.
+   * @param task Task to run.
+   * @param label Name reported when this task causes a stall.
+   *
+   * @return Identifier usable with cancel().
+   */
+  TimerId runAfter(Clock::duration delay, Task task, std::string label = {});
+
+  /**
+   * @brief Cancel a pending timer.
+   *
+   * @return true if the timer was pending.
+   */
+  bool cancel(TimerId id) noexcept;
+
+  /**
+   * @brief Queue a task to run on the loop thread. Thread-safe.
+   *
+   * @param task Task to run during the next iteration.
+   * @param label Name reported when this task causes a stall.
+   */
+  void post(Task task, std::string label = {});
+
+  /// Make run() return after the current iteration. Thread-safe.
+  void stop() noexcept;
+
+  /**
+   * @brief Interrupt a blocking wait so the loop runs an iteration soon.
+   * Thread-safe; coalesces with other pending wakeups. Called on the loop
+   * thread after the iteration's posted tasks have started, it makes the
+   * next wait return immediately.
+   */
+  void wakeup() noexcept;
+
+  /**
+   * @brief Install a task run once per iteration, after posted tasks.
+   *
+   * Lets a component poll its own lock-free queues on the loop thread;
+   * producers call wakeup() after enqueueing so a sleeping loop notices.
+   * An empty task removes the hook.
+   */
+  void setIterationHook(Task hook, std::string label = {}) {
+    iteration_hook_ = {std::move(hook), std::move(label)};
+  }
+
+  /// Run iterations until stop() is called.
+  void run();
+
+  /**
+   * @brief Run a single iteration.
+   *
+   * @param timeout Longest time to wait for events; negative waits until
+   *                an event, timer or posted task.
+   *
+   * @return Number of callbacks invoked.
+   */
+  std::size_t runOnce(std::chrono::milliseconds timeout);
+
+  /// True when called from the thread currently running the loop.
+  [[nodiscard]] bool isInLoopThread() const noexcept;
+
+  /// Measurements so far.
+  [[nodiscard]] const Stats &stats() const noexcept { return stats_; }
+
+  /// Clear all measurements.
+  void resetStats() noexcept { stats_ = {}; }
+
+  /// Replace the stall handler; an empty handler silences stalls.
+  void setStallHandler(StallHandler handler) {
+    stall_handler_ = std::move(handler);
+  }
+
+  /// Name of the readiness backend in use ("epoll" or "poll").
+  [[nodiscard]] std::string_view backend() const noexcept;
+
+private:
+  struct Registration {
+    unsigned interest;
+    IoHandler handler;
+    std::string label;
+    BudgetedHandler budgeted;
+    IoBudget budget;
+    unsigned pending = 0; ///< Events carried over while requeued
+    bool queued = false;  ///< Present in requeued_
+  };
+
+  struct Handoff {
+    Handle fd;
+    std::shared_ptr<Registration> registration;
+    AdoptedHandler adopted;
+  };
+
+  struct Timer {
+    Task task;
+    std::string label;
+    Clock::time_point deadline;
+  };
+
+  struct TimerSlot {
+    Clock::time_point deadline;
+    TimerId id;
+
+    bool operator>(const TimerSlot &other) const noexcept {
+      return deadline != other.deadline ? deadline > other.deadline
+                                        : id > other.id;
+    }
+  };
+
+  struct Posted {
+    Task task;
+    std::string label;
+  };
+
+  /// Per-iteration accounting of callback time and the slowest callback.
+  struct Iteration {
+    std::chrono::nanoseconds callbacks{};
+    std::chrono::nanoseconds slowest{};
+    std::string culprit;
+    std::size_t invoked = 0;
+  };
+
+  template <typename F, typename L>
+  void invoke(Iteration &iteration, F &&callback, L &&label);
+
+  void insert(Handle fd, std::shared_ptr<Registration> registration);
+  void dispatch(Iteration &iteration, Handle fd,
+                const std::shared_ptr<Registration> &registration,
+                unsigned events);
+  int waitTimeout(std::chrono::milliseconds timeout);
+  void processTimers(Iteration &iteration);
+  void runPosted(Iteration &iteration);
+  void receiveHandoffs(Iteration &iteration);
+  void finishIteration(const PhaseTimes &phases, const Iteration &iteration);
+
+  Options options_;
+  std::unique_ptr<detail::EventPoller> poller_;
+
+  std::unordered_map<Handle, std::shared_ptr<Registration>> registrations_;
+  /// Budgeted connections that returned Pending, in service order.
+  std::vector<std::pair<Handle, std::shared_ptr<Registration>>> requeued_;
+
+  std::priority_queue<TimerSlot, std::vector<TimerSlot>, std::greater<>>
+      timer_queue_;
+  std::unordered_map<TimerId, Timer> timers_;
+  TimerId next_timer_id_ = 1;
+
+  std::mutex posted_mutex_;
+  std::vector<Posted> posted_;
+  detail::MpscQueue<Handoff> handoffs_;
+  Posted iteration_hook_;
+  std::atomic<bool> wakeup_pending_{false};
+  std::atomic<bool> stop_requested_{false};
+  std::atomic<std::thread::id> loop_thread_{};
+
+  Stats stats_;
+  StallHandler stall_handler_;
+};
+
+/**
+ * @brief A descriptor detached from one EventLoop, ready to be adopted by
+ * another. Move-only; dropping a non-empty migration drops the handler
+ * (and whatever it owns) without closing the descriptor itself.
+ */
+class EventLoop::Migration {
+public:
+  Migration() = default;
+  Migration(Migration &&) noexcept = default;
+  Migration &operator=(Migration &&) noexcept = default;
+  Migration(const Migration &) = delete;
+  Migration &operator=(const Migration &) = delete;
+
+  /// Descriptor being migrated.
+  [[nodiscard]] Handle fd() const noexcept { return fd_; }
+
+  /// True if this migration still carries a registration.
+  explicit operator bool() const noexcept { return registration_ != nullptr; }
+
+private:
+  friend class EventLoop;
+
+  Migration(Handle fd, std::shared_ptr<Registration> registration)
+      : fd_(fd), registration_(std::move(registration)) {}
+
+  Handle fd_ = detail::SocketDescriptorHandle::Invalid;
+  std::shared_ptr<Registration> registration_;
+};
+
+} // namespace net
@@ -0,0 +1,184 @@
+#pragma once
+#include "net/core/event_loop.h"
+#include "net/detail/fiber_context.h"
+#include "net/detail/fiber_stack.h"
+#include "net/detail/io_wait_hook.h"
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace net {
+
+/**
+ * @brief Runs stackful fibers on an EventLoop so blocking-style socket code
+ * is multiplexed on one thread.
+ *
+ * Each fiber gets a pooled, guard-paged stack. While a fiber runs, the
+ * scheduler installs a detail::IoWaitHook: a blocking-mode `TcpSocket`'s
+ * send(), receive() or accept() that would block instead registers the
+ * descriptor with the loop and switches to the next ready fiber, resuming
+ * once the descriptor is ready. Code written for thread-per-connection can
+ * therefore run unchanged inside spawn().
+ *
+ * connect() and name resolution still block the thread. All members must
+ * be used on the loop's thread.
+ *
+ * @note Available on POSIX platforms only.
+ */
+class FiberScheduler {
+public:
+  /// Receives an exception that escaped a fiber and the fiber's label.
+  using ErrorHandler =
+      std::function<void(std::exception_ptr error, const std::string &label)>;
+
+  /// Scheduler configuration.
+  struct Options {
+    /// Usable stack bytes per fiber (a guard page is added).
+    std::size_t stack_size = 64 * 1024;
+    /// Finished fibers' stacks kept for reuse.
+    std::size_t pooled_stacks = 64;
+  };
+
+  /// Counters since construction.
+  struct Stats {
+    std::uint64_t spawned = 0;
+    std::uint64_t completed = 0;
+    std::uint64_t failed = 0;     ///< Fibers whose body threw
+    std::uint64_t switches = 0;   ///< Resumptions of a fiber
+    std::uint64_t io_waits = 0;   ///< Calls parked on a descriptor
+    std::size_t stacks_mapped = 0;
+  };
+
+  /**
+   * @brief Attach to a loop; the loop must outlive the scheduler.
+   *
+   * @throws std::invalid_argument if stack_size is zero.
+   */
+  explicit FiberScheduler(EventLoop &loop, Options options);
+
+  /// Attach to a loop with default options.
+  explicit FiberScheduler(EventLoop &loop)
+      : FiberScheduler(loop, Options{}) {}
+
+  /**
+   * @brief Release all fibers. Suspended fibers are abandoned without
+   * unwinding their stacks, so objects they own are not destroyed.
+   */
+  ~FiberScheduler();
+
+  FiberScheduler(const FiberScheduler &) = delete;
+  FiberScheduler &operator=(const FiberScheduler &) = delete;
+
+  /**
+   * @brief Start a fiber; it first runs during the loop's next iteration.
+   *
+   * An exception escaping `body` ends only that fiber: it is caught on
+   * the fiber's stack and passed to the error handler once the fiber has
+   * been cleaned up, or kept for takeErrors() if there is no handler.
+   *
+   * @param body Code to run.
+   * @param label Name reported by the loop when this fiber causes a stall.
+   */
+  void spawn(std::function<void()> body, std::string label = {});
+
+  /**
+   * @brief Report fiber exceptions to `handler` as they happen.
+   *
+   * The handler runs on the loop thread outside any fiber; an exception it
+   * throws propagates out of the loop iteration. An empty handler restores
+   * collection for takeErrors().
+   */
+  void setErrorHandler(ErrorHandler handler) {
+    error_handler_ = std::move(handler);
+  }
+
+  /// Exceptions of fibers that failed while no handler was set, oldest
+  /// first; the list is cleared.
+  [[nodiscard]] std::vector<std::exception_ptr> takeErrors() {
+    return std::exchange(errors_, {});
+  }
+
+  /// Fibers spawned and not yet finished.
+  [[nodiscard]] std::size_t active() const noexcept { return fibers_.size(); }
+
+  /// Counters since construction.
+  [[nodiscard]] Stats stats() const noexcept;
+
+  /// True when called from inside a fiber.
+  [[nodiscard]] static bool inFiber() noexcept;
+
+  /**
+   * @brief Let other ready fibers run, then continue.
+   *
+   * @throws std::logic_error outside a fiber.
+   */
+  static void yield();
+
+  /**
+   * @brief Suspend the calling fiber for at least `duration`.
+   *
+   * @throws std::logic_error outside a fiber.
+   */
+  static void sleepFor(std::chrono::nanoseconds duration);
+
+  /**
+   * @brief Suspend the calling fiber until `fd` is readable or writable.
+   *
+   * @throws std::logic_error outside a fiber.
+   */
+  static void waitFor(EventLoop::Handle fd, bool writable);
+
+private:
+  struct Fiber {
+    detail::FiberContext context;
+    detail::FiberStackPool::Stack stack;
+    std::function<void()> body;
+    std::string label;
+    std::exception_ptr error;
+    FiberScheduler *scheduler = nullptr;
+    bool finished = false;
+  };
+
+  /// Fibers parked on one descriptor, at most one per direction.
+  struct Waiters {
+    Fiber *reader = nullptr;
+    Fiber *writer = nullptr;
+    bool registered = false; ///< Added to the loop by this scheduler
+  };
+
+  static thread_local Fiber *current_;
+
+  static void entry(void *fiber) noexcept;
+  static void hookWait(void *scheduler, EventLoop::Handle fd, bool writable);
+
+  void makeReady(Fiber *fiber);
+  void runReady();
+  void suspend(Fiber &fiber);
+  void park(Fiber &fiber, EventLoop::Handle fd, bool writable);
+  void onReady(EventLoop::Handle fd, unsigned events);
+  void updateInterest(EventLoop::Handle fd, Waiters &waiters);
+
+  EventLoop &loop_;
+  detail::FiberStackPool stacks_;
+  detail::FiberContext scheduler_context_;
+  detail::IoWaitHook hook_{&FiberScheduler::hookWait, this};
+
+  std::unordered_map<Fiber *, std::unique_ptr<Fiber>> fibers_;
+  std::deque<Fiber *> ready_;
+  std::unordered_map<EventLoop::Handle, Waiters> waiters_;
+  ErrorHandler error_handler_;
+  std::vector<std::exception_ptr> errors_;
+  bool run_posted_ = false;
+  std::shared_ptr<bool> alive_ = std::make_shared<bool>(true);
+  Stats stats_;
+};
+
+} // namespace net
@@ -0,0 +1,176 @@
+#pragma once
+#include "net/core/endpoint.h"
+#include "net/core/event_loop.h"
+#include "net/core/retry_budget.h"
+#include "net/core/upstream_health.h"
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <span>
+#include <system_error>
+
+namespace net {
+
+/**
+ * @brief Issues upstream requests with hedging and budgeted retries.
+ *
+ * call() starts an attempt on the first admitted candidate. If it has not
+ * answered after the hedge delay, a duplicate goes to the next candidate;
+ * the first attempt to succeed wins and every other attempt is cancelled.
+ * An attempt that fails while nothing else is in flight is retried on the
+ * next candidate. Each hedge or retry spends a RetryBudget token, so extra
+ * attempts stay a bounded fraction of traffic and stop entirely when an
+ * upstream degrades.
+ *
+ * The hedge delay is the `percentile` of successful attempt latencies
+ * over the last one or two `window`s, clamped to [min_delay, max_delay];
+ * until `min_samples` latencies are known it is max_delay.
+ *
+ * With an UpstreamHealth, candidates are admitted through it: ejected or
+ * saturated endpoints are skipped, outcomes are reported, and cancelled
+ * losers only release their permit.
+ *
+ * The client is transport-agnostic: an Attempt starts one request to one
+ * endpoint, reports its outcome through Done exactly once (possibly before
+ * returning) and returns a Cancel that aborts it. Cancel is never invoked
+ * after Done.
+ *
+ * All members must be called on the loop thread. The client, the loop and
+ * the health tracker must outlive outstanding calls.
+ *
+ * @note Available on POSIX platforms only.
+ */
+class HedgingClient {
+public:
+  using Clock = EventLoop::Clock;
+
+  /// Reports the outcome of one attempt; an empty code means success.
+  using Done = std::function<void(std::error_code)>;
+  /// Aborts one attempt.
+  using Cancel = std::function<void()>;
+  /// Starts one attempt against `endpoint`.
+  using Attempt = std::function<Cancel(const Endpoint &endpoint, Done done)>;
+
+  /// Client configuration.
+  struct Options {
+    /// Latency percentile after which a hedge is sent.
+    double percentile = 0.95;
+    /// Bounds for the hedge delay.
+    std::chrono::milliseconds min_delay{1};
+    std::chrono::milliseconds max_delay{1000};
+    /// Latencies needed before the percentile is trusted.
+    std::uint32_t min_samples = 100;
+    /// Age at which latency samples start to be forgotten.
+    std::chrono::milliseconds window{10000};
+    /// Attempts per call, including the first; 1 disables hedges and
+    /// retries.
+    std::uint32_t max_attempts = 2;
+  };
+
+  /// Outcome of one call().
+  struct Result {
+    /// Empty on success; the last attempt's error otherwise, or
+    /// resource_unavailable_try_again if no candidate was admitted.
+    std::error_code error;
+    /// Index into the candidates of the winning (or last) attempt.
+    std::size_t candidate = 0;
+    /// Attempts started.
+    std::uint32_t attempts = 0;
+    /// True if a hedge was sent.
+    bool hedged = false;
+    /// Time from call() to completion.
+    std::chrono::nanoseconds latency{0};
+  };
+
+  using Callback = std::function<void(const Result &)>;
+
+  /// Counters since construction.
+  struct Stats {
+    std::uint64_t calls = 0;
+    std::uint64_t failed = 0;
+    std::uint64_t hedges = 0;
+    std::uint64_t hedge_wins = 0;    ///< Calls won by a hedge
+    std::uint64_t retries = 0;
+    std::uint64_t cancelled = 0;     ///< Losing attempts aborted
+    std::uint64_t budget_denied = 0; ///< Hedges or retries not sent
+    std::uint64_t unavailable = 0;   ///< Calls with no admitted candidate
+  };
+
+  /**
+   * @brief Create a client on `loop`.
+   *
+   * @param budget Budget for hedges and retries; may be shared.
+   * @param health Optional tracker consulted for every attempt.
+   *
+   * @throws std::invalid_argument if budget is null, percentile is
+   * outside (0, 1], the delays are inverted, window is not positive or
+   * max_attempts is zero.
+   */
+  HedgingClient(EventLoop &loop, Options options,
+                std::shared_ptr<RetryBudget> budget,
+                UpstreamHealth *health = nullptr);
+
+  /// Create a client with default options and its own budget.
+  explicit HedgingClient(EventLoop &loop)
+      : HedgingClient(loop, Options{}, std::make_shared<RetryBudget>()) {}
+
+  HedgingClient(const HedgingClient &) = delete;
+  HedgingClient &operator=(const HedgingClient &) = delete;
+
+  /**
+   * @brief Start a request.
+   *
+   * @param candidates Endpoints in order of preference; attempts never
+   *                   repeat a candidate. Copied.
+   * @param attempt Starts one attempt.
+   * @param callback Called once with the outcome, never from within
+   *                 call() itself.
+   */
+  void call(std::span<const Endpoint> candidates, Attempt attempt,
+            Callback callback);
+
+  /// Feed a latency measured elsewhere into the hedge delay estimate.
+  void record(std::chrono::nanoseconds latency,
+              Clock::time_point now = Clock::now());
+
+  /// Delay after which a call sends its hedge.
+  [[nodiscard]] std::chrono::nanoseconds
+  hedgeDelay(Clock::time_point now = Clock::now());
+
+  /// Counters so far.
+  [[nodiscard]] const Stats &stats() const noexcept { return stats_; }
+
+private:
+  struct Call;
+  enum class AttemptKind : std::uint8_t { First, Hedge, Retry };
+
+  // Log-linear latency histogram: 8 sub-buckets per power of two of
+  // nanoseconds, about 12% resolution.
+  static constexpr std::size_t kSubBuckets = 8;
+  static constexpr std::size_t kBuckets = 62 * kSubBuckets;
+  using Histogram = std::array<std::uint32_t, kBuckets>;
+
+  bool startAttempt(const std::shared_ptr<Call> &call, AttemptKind kind);
+  void onDone(const std::shared_ptr<Call> &call, std::size_t index,
+              std::error_code error);
+  void onHedgeTimer(const std::shared_ptr<Call> &call);
+  void finish(const std::shared_ptr<Call> &call, std::error_code error,
+              std::size_t candidate);
+  void rotate(Clock::time_point now) noexcept;
+
+  EventLoop &loop_;
+  Options options_;
+  std::shared_ptr<RetryBudget> budget_;
+  UpstreamHealth *health_;
+  Stats stats_;
+  Histogram current_{};
+  Histogram previous_{};
+  std::uint64_t current_count_ = 0;
+  std::uint64_t previous_count_ = 0;
+  Clock::time_point window_start_;
+};
+
+} // namespace net
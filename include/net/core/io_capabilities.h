@@ -0,0 +1,112 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+namespace net {
+
+/**
+ * @brief Kernel I/O mechanisms found by probing the running system.
+ *
+ * Each flag is established by trying the mechanism (creating a ring,
+ * setting a socket option, issuing a call with arguments that fail in a
+ * telling way), not by comparing kernel versions, so backported and
+ * disabled features are reported correctly. A feature the build does not
+ * know about is reported as unavailable.
+ */
+struct IoCapabilities {
+  std::string kernel; ///< Kernel release string; empty if unknown
+
+  bool epoll = false;
+  bool io_uring = false; ///< A ring can be created (not blocked by policy)
+  bool io_uring_read_fixed = false;
+  bool io_uring_send = false;
+  bool io_uring_send_zc = false;
+  /// Multishot accept/recv have no opcode of their own; they are inferred
+  /// from IORING_OP_SOCKET and IORING_OP_SEND_ZC, added in the same
+  /// releases (5.19 and 6.0).
+  bool io_uring_multishot_accept = false;
+  bool io_uring_multishot_recv = false;
+
+  bool so_zerocopy = false;          ///< MSG_ZEROCOPY sends on TCP
+  bool tcp_zerocopy_receive = false; ///< TCP_ZEROCOPY_RECEIVE
+  bool accept4 = false;
+  bool reuseport = false;
+  bool reuseport_cbpf = false; ///< SO_ATTACH_REUSEPORT_CBPF
+};
+
+/// Readiness notification used by EventLoop.
+enum class PollerBackend : std::uint8_t { Epoll, Poll };
+
+/// Transfer path used by TcpFileSender.
+enum class FileSendBackend : std::uint8_t { IoUring, ReadSend };
+
+/// Receive path used by TcpZeroCopyReceiver.
+enum class ReceiveBackend : std::uint8_t { ZeroCopy, Copy };
+
+/// Call used to accept connections.
+enum class AcceptBackend : std::uint8_t { Accept4, Accept };
+
+/// Backend chosen for each feature.
+struct IoBackends {
+  PollerBackend poller = PollerBackend::Poll;
+  FileSendBackend file_send = FileSendBackend::ReadSend;
+  ReceiveBackend receive = ReceiveBackend::Copy;
+  AcceptBackend accept = AcceptBackend::Accept;
+};
+
+/**
+ * @brief Probe the running kernel. Takes a few system calls; prefer the
+ * cached ioCapabilities().
+ */
+[[nodiscard]] IoCapabilities probeIoCapabilities();
+
+/**
+ * @brief Capabilities probed once per process (thread-safe).
+ */
+[[nodiscard]] const IoCapabilities &ioCapabilities();
+
+/**
+ * @brief Pick the fastest available backend for each feature.
+ *
+ * `overrides` is a comma-separated list of `feature=backend` pairs, e.g.
+ * `"poller=poll,file_send=read_send"`. Features: poller (epoll, poll),
+ * file_send (io_uring, read_send), receive (zerocopy, copy), accept
+ * (accept4, accept). An override naming an unavailable backend falls back
+ * to the best available one.
+ *
+ * @throws std::invalid_argument for an unknown feature or backend name.
+ */
+[[nodiscard]] IoBackends selectIoBackends(const IoCapabilities &capabilities,
+                                          std::string_view overrides = {});
+
+/**
+ * @brief Backends used by the library.
+ *
+ * Selected on first use from ioCapabilities() and the NETLIB_IO_BACKENDS
+ * environment variable (same syntax as selectIoBackends() overrides; an
+ * invalid value is ignored). Objects read the selection when constructed.
+ */
+[[nodiscard]] IoBackends ioBackends();
+
+/**
+ * @brief Replace the process-wide selection, e.g. from a config file.
+ * Affects objects constructed afterwards. A backend that ioCapabilities()
+ * lacks falls back as in selectIoBackends().
+ */
+void setIoBackends(const IoBackends &backends);
+
+/// Backend names as accepted by selectIoBackends().
+[[nodiscard]] std::string_view toString(PollerBackend backend) noexcept;
+[[nodiscard]] std::string_view toString(FileSendBackend backend) noexcept;
+[[nodiscard]] std::string_view toString(ReceiveBackend backend) noexcept;
+[[nodiscard]] std::string_view toString(AcceptBackend backend) noexcept;
+
+/**
+ * @brief Human-readable report of probed capabilities and the chosen
+ * backends, one `name: value` line each, for startup logs.
+ */
+[[nodiscard]] std::string describeIo(const IoCapabilities &capabilities,
+                                     const IoBackends &backends);
+
+} // namespace net
@@ -0,0 +1,77 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace net {
+
+/// One packet read from a pcapng capture.
+struct PcapngPacket {
+  /// Capture time in nanoseconds since the Unix epoch; 0 for Simple
+  /// Packet Blocks, which carry no timestamp.
+  std::uint64_t timestamp_ns = 0;
+  std::uint32_t interface = 0;       ///< Interface index within the section
+  std::uint16_t link_type = 0;       ///< LINKTYPE_* of the interface
+  std::uint32_t original_length = 0; ///< Length on the wire
+  std::vector<std::byte> data;       ///< Captured bytes (may be truncated)
+};
+
+/**
+ * @brief Sequential reader of pcapng captures.
+ *
+ * Handles captures of either byte order, multiple sections and
+ * interfaces, and per-interface timestamp resolution (if_tsresol).
+ * Enhanced and Simple Packet Blocks are returned; other blocks are
+ * skipped. Reads one block at a time, so captures larger than memory can
+ * be processed. An all-zero block header ends the capture, so a file
+ * still preallocated by a live (or crashed) PcapngWriter reads up to its
+ * last packet.
+ */
+class PcapngReader {
+public:
+  /**
+   * @brief Open a capture and read its first section header.
+   *
+   * @throws std::system_error if the file cannot be opened.
+   * @throws std::runtime_error if it does not start with a pcapng section.
+   */
+  explicit PcapngReader(const std::string &path);
+
+  /**
+   * @brief Read the next packet.
+   *
+   * @return The packet, or std::nullopt at end of capture.
+   *
+   * @throws std::runtime_error on a malformed or truncated block.
+   */
+  std::optional<PcapngPacket> next();
+
+private:
+  struct Interface {
+    std::uint16_t link_type = 0;
+    std::uint32_t snap_length = 0;
+    /// Timestamp unit: 10^-exponent seconds, or 2^-exponent if binary.
+    std::uint8_t exponent = 6;
+    bool binary = false;
+  };
+
+  /// Read one block; false at a clean end of file or zero padding.
+  bool readBlock(std::uint32_t &type, std::vector<std::byte> &body);
+  void startSection(const std::vector<std::byte> &body);
+  void addInterface(const std::vector<std::byte> &body);
+
+  [[nodiscard]] std::uint16_t load16(const std::byte *p) const noexcept;
+  [[nodiscard]] std::uint32_t load32(const std::byte *p) const noexcept;
+  [[nodiscard]] static std::uint64_t
+  toNanoseconds(const Interface &interface, std::uint64_t ticks) noexcept;
+
+  std::ifstream in_;
+  bool swapped_ = false;
+  std::vector<Interface> interfaces_;
+  std::vector<std::byte> body_;
+};
+
+} // namespace net
@@ -0,0 +1,105 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string>
+
+namespace net {
+
+/**
+ * @brief Lock-free writer of raw IP packets into a memory-mapped pcapng
+ * file.
+ *
+ * The file is created with a fixed capacity and mapped shared. A packet is
+ * written by reserving its Enhanced Packet Block with one compare-exchange
+ * on the tail offset and copying straight into the mapping: no lock,
+ * system call or allocation per packet, so any number of threads can
+ * write concurrently. Packets that no longer fit are dropped and counted.
+ *
+ * The capture has a single interface of link type LINKTYPE_RAW (IPv4 or
+ * IPv6 packets without a link-layer header) and nanosecond timestamps.
+ * The destructor truncates the file to the bytes written; until then the
+ * unused tail of the mapping reads as zeros.
+ *
+ * @note Available on POSIX platforms only.
+ */
+class PcapngWriter {
+public:
+  /// Writer configuration.
+  struct Options {
+    /// Size of the mapping; bounds the file size.
+    std::size_t capacity = 64 * 1024 * 1024;
+    /// Bytes of each packet stored; longer packets are truncated.
+    std::uint32_t snap_length = 65535;
+  };
+
+  /// Counters since construction.
+  struct Stats {
+    std::uint64_t packets = 0; ///< Packets written
+    std::uint64_t dropped = 0; ///< Packets that did not fit
+    std::size_t bytes = 0;     ///< File bytes used, headers included
+  };
+
+  /// pcapng link type of the captured packets (LINKTYPE_RAW).
+  static constexpr std::uint16_t link_type = 101;
+
+  /**
+   * @brief Create (or truncate) `path`, size it to the capacity and write
+   * the section and interface headers.
+   *
+   * @throws std::invalid_argument if capacity cannot hold the headers or
+   * snap_length is zero.
+   * @throws std::system_error if the file cannot be created or mapped.
+   */
+  PcapngWriter(const std::string &path, Options options);
+
+  /// Create a capture with default options.
+  explicit PcapngWriter(const std::string &path)
+      : PcapngWriter(path, Options{}) {}
+
+  /**
+   * @brief Unmap and truncate the file to its used size. No write() may be
+   * in progress.
+   */
+  ~PcapngWriter();
+
+  PcapngWriter(const PcapngWriter &) = delete;
+  PcapngWriter &operator=(const PcapngWriter &) = delete;
+
+  /**
+   * @brief Append one packet made of `head` followed by `body`.
+   *
+   * The two parts let callers prepend synthesized headers to a payload
+   * without assembling them in a temporary buffer.
+   *
+   * @param timestamp_ns Capture time in nanoseconds since the Unix epoch.
+   *
+   * @return False if the packet was dropped because the file is full.
+   */
+  bool write(std::span<const std::byte> head, std::span<const std::byte> body,
+             std::uint64_t timestamp_ns) noexcept;
+
+  /// Append one complete packet stamped with the current time.
+  bool write(std::span<const std::byte> packet) noexcept {
+    return write(packet, {}, now());
+  }
+
+  /// Counters since construction.
+  [[nodiscard]] Stats stats() const noexcept;
+
+  /// Wall-clock time in nanoseconds since the Unix epoch.
+  [[nodiscard]] static std::uint64_t now() noexcept;
+
+private:
+  std::byte *base_ = nullptr;
+  std::size_t capacity_;
+  std::uint32_t snap_length_;
+  int fd_ = -1;
+
+  std::atomic<std::size_t> tail_{0};
+  std::atomic<std::uint64_t> packets_{0};
+  std::atomic<std::uint64_t> dropped_{0};
+};
+
+} // namespace net
@@ -0,0 +1,72 @@
+#pragma once
+#include <chrono>
+#include <mutex>
+
+namespace net {
+
+/**
+ * @brief Token bucket that caps retries and hedges at a fraction of
+ * traffic.
+ *
+ * Every original request deposits `ratio` tokens and every extra attempt
+ * (retry or hedge) withdraws a whole one, so in steady state extra
+ * attempts stay below `ratio` of the request rate. `min_per_second` tokens
+ * accrue over time regardless of traffic, which lets a low-volume client
+ * still retry, and the balance never exceeds `burst`. When an upstream
+ * degrades, its clients run the budget dry instead of multiplying the
+ * load on it.
+ *
+ * All members are thread-safe, so one budget can be shared by several
+ * clients of the same upstream.
+ */
+class RetryBudget {
+public:
+  using Clock = std::chrono::steady_clock;
+
+  /// Budget configuration.
+  struct Options {
+    /// Tokens deposited per original request.
+    double ratio = 0.1;
+    /// Tokens accrued per second independently of traffic.
+    double min_per_second = 10.0;
+    /// Largest balance; also the most extra attempts in a burst.
+    double burst = 100.0;
+  };
+
+  /**
+   * @brief Create a budget holding one second of `min_per_second`.
+   *
+   * @throws std::invalid_argument if ratio or min_per_second is negative
+   * or burst is below one.
+   */
+  explicit RetryBudget(Options options, Clock::time_point now = Clock::now());
+
+  /// Create a budget with default options.
+  RetryBudget() : RetryBudget(Options{}) {}
+
+  RetryBudget(const RetryBudget &) = delete;
+  RetryBudget &operator=(const RetryBudget &) = delete;
+
+  /// Credit one original request.
+  void deposit() noexcept;
+
+  /**
+   * @brief Take a token for one retry or hedge.
+   *
+   * @return false if the budget is exhausted; the attempt must not be made.
+   */
+  [[nodiscard]] bool tryWithdraw(Clock::time_point now = Clock::now()) noexcept;
+
+  /// Tokens currently available.
+  [[nodiscard]] double balance(Clock::time_point now = Clock::now()) noexcept;
+
+private:
+  void refillLocked(Clock::time_point now) noexcept;
+
+  Options options_;
+  std::mutex mutex_;
+  double balance_;
+  Clock::time_point refilled_;
+};
+
+} // namespace net
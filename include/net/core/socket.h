@@ -25,7 +25,8 @@ public:
    *
    * @param address_family IPv4/IPv6
    * @param socket_type    Stream/Dgram
-   * @param protocol_type  TCP/UDP
+   * @param protocol_type  TCP/UDP/MPTCP (MPTCP falls back to TCP if the
+   *                       kernel does not support it)
    * @param blocking       Blocking or non-blocking
    * @param inheritable    Whether the handle is inheritable
    *
@@ -96,12 +97,16 @@ public:
 protected:
   /**
    * @brief Constructs from an existing native handle (e.g., accept()).
+   *
+   * @param configured True if the handle already has the given blocking
+   * and inheritable flags (e.g. from accept4()), skipping the fcntl calls.
    */
   Socket(Handle handle, SocketFlags::AddressFamily address_family,
          SocketFlags::SocketType socket_type,
          SocketFlags::ProtocolType protocol_type,
          SocketFlags::BlockingType blocking,
-         SocketFlags::InheritableType inheritable) noexcept;
+         SocketFlags::InheritableType inheritable,
+         bool configured = false) noexcept;
 
   /**
    * @brief Low-level send wrapper for derived classes.
@@ -0,0 +1,197 @@
+#pragma once
+#include "net/core/buffer_pool.h"
+#include "net/core/endpoint.h"
+#include "net/core/event_loop.h"
+#include "net/detail/spsc_queue.h"
+#include "net/protocol/tcp/tcp_acceptor.h"
+#include "net/protocol/tcp/tcp_socket.h"
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <memory_resource>
+#include <thread>
+#include <vector>
+
+namespace net {
+
+/**
+ * @brief Shared-nothing runtime with one event loop thread per core.
+ *
+ * Every core owns its EventLoop, memory resource, BufferPool, listening
+ * sockets and the connections it accepts. Listeners are opened with
+ * SO_REUSEPORT, one per core on the same port, so the kernel spreads
+ * incoming connections without a shared accept queue. Cores talk to each
+ * other only through an N x N matrix of bounded SPSC queues: core i is the
+ * sole producer of queue (i, j) and core j its sole consumer, so message
+ * passing involves no locks and no contended atomics.
+ *
+ * @note Available on POSIX platforms only. Threads are pinned to CPUs on
+ * Linux when `Options::pin_threads` is set.
+ */
+class ThreadPerCoreRuntime {
+public:
+  class Core;
+
+  /// Work sent to a core; runs on that core's thread.
+  using Message = std::function<void(Core &)>;
+
+  /// Called on the accepting core for every new connection.
+  using AcceptHandler =
+      std::function<void(Core &, TcpSocket connection, const Endpoint &peer)>;
+
+  /// Runtime configuration.
+  struct Options {
+    /// Number of cores (threads); 0 uses std::thread::hardware_concurrency.
+    std::size_t cores = 0;
+    /// Pin core i to the i-th CPU the process may run on (Linux).
+    bool pin_threads = true;
+    /// Capacity of each inter-core queue.
+    std::size_t queue_capacity = 1024;
+    /// Size of buffers in each core's BufferPool.
+    std::size_t buffer_size = 16 * 1024;
+    /// Buffers preallocated per core.
+    std::size_t buffers_per_core = 64;
+    /// Options for every core's EventLoop.
+    EventLoop::Options loop;
+  };
+
+  /**
+   * @brief Per-core context. Only used on its own thread.
+   */
+  class Core {
+  public:
+    /// Index of this core in [0, coreCount()).
+    [[nodiscard]] std::size_t index() const noexcept { return index_; }
+
+    /// Number of cores in the runtime.
+    [[nodiscard]] std::size_t coreCount() const noexcept;
+
+    /// This core's event loop.
+    [[nodiscard]] EventLoop &loop() noexcept { return loop_; }
+
+    /// Unsynchronized memory resource for core-local allocations.
+    [[nodiscard]] std::pmr::memory_resource &memory() noexcept {
+      return memory_;
+    }
+
+    /// This core's buffer pool.
+    [[nodiscard]] BufferPool &buffers() noexcept { return buffers_; }
+
+    /**
+     * @brief Send a message to another core (or to this one).
+     *
+     * @return false if the queue to `target` is full; `message` is then
+     * left untouched so the caller can retry or shed.
+     *
+     * @throws std::out_of_range if target is not a valid core index.
+     */
+    bool send(std::size_t target, Message &&message);
+
+    /// Messages received by this core so far.
+    [[nodiscard]] std::uint64_t received() const noexcept {
+      return received_;
+    }
+
+    /// Received messages whose handler threw; the exception is dropped.
+    [[nodiscard]] std::uint64_t failed() const noexcept { return failed_; }
+
+  private:
+    friend class ThreadPerCoreRuntime;
+
+    Core(ThreadPerCoreRuntime &runtime, std::size_t index,
+         const Options &options);
+
+    void drainInbox();
+
+    ThreadPerCoreRuntime &runtime_;
+    std::size_t index_;
+    EventLoop loop_;
+    std::pmr::unsynchronized_pool_resource memory_;
+    BufferPool buffers_;
+    std::vector<std::unique_ptr<TcpSocket>> listeners_;
+    std::vector<std::unique_ptr<TcpAcceptor>> acceptors_;
+    std::uint64_t received_ = 0;
+    std::uint64_t failed_ = 0;
+  };
+
+  /**
+   * @brief Create the cores and their queues; no threads are started yet.
+   *
+   * @throws std::invalid_argument for a zero queue capacity or buffer size.
+   */
+  explicit ThreadPerCoreRuntime(Options options);
+
+  /// Create a runtime with default options.
+  ThreadPerCoreRuntime() : ThreadPerCoreRuntime(Options{}) {}
+
+  /// Stops and joins the core threads.
+  ~ThreadPerCoreRuntime();
+
+  ThreadPerCoreRuntime(const ThreadPerCoreRuntime &) = delete;
+  ThreadPerCoreRuntime &operator=(const ThreadPerCoreRuntime &) = delete;
+
+  /**
+   * @brief Open one SO_REUSEPORT listener per core on `endpoint`.
+   *
+   * Must be called before start(). A port of 0 is resolved by the first
+   * listener and shared by the rest.
+   *
+   * @param endpoint Local address to listen on.
+   * @param handler Receives connections on the core that accepted them.
+   *
+   * @return The bound endpoint.
+   *
+   * @throws std::logic_error if the runtime is already running.
+   * @throws std::system_error if a listener cannot be opened.
+   */
+  Endpoint listen(const Endpoint &endpoint, AcceptHandler handler);
+
+  /**
+   * @brief Start one thread per core.
+   *
+   * @param init Optional callback run first on every core's thread.
+   *
+   * @throws std::logic_error if already running.
+   */
+  void start(std::function<void(Core &)> init = {});
+
+  /// Stop all loops and join the threads. Idempotent.
+  void stop();
+
+  /**
+   * @brief Submit work from a thread outside the runtime.
+   *
+   * Goes through the target loop's post() queue rather than the SPSC
+   * matrix, which is reserved for core-to-core traffic.
+   *
+   * @throws std::out_of_range if core is not a valid core index.
+   */
+  void submit(std::size_t core, Message message);
+
+  /// Number of cores.
+  [[nodiscard]] std::size_t coreCount() const noexcept {
+    return cores_.size();
+  }
+
+  /// Access a core, e.g. for inspection after stop().
+  [[nodiscard]] Core &core(std::size_t index) { return *cores_.at(index); }
+
+  /// The core running on the calling thread, or nullptr outside the runtime.
+  [[nodiscard]] static Core *currentCore() noexcept;
+
+private:
+  detail::SpscQueue<Message> &queue(std::size_t from, std::size_t to) {
+    return *queues_[from * cores_.size() + to];
+  }
+
+  void runCore(Core &core, const std::function<void(Core &)> &init);
+
+  Options options_;
+  std::vector<std::unique_ptr<Core>> cores_;
+  /// Row-major N x N matrix; entry (from, to).
+  std::vector<std::unique_ptr<detail::SpscQueue<Message>>> queues_;
+  std::vector<std::thread> threads_;
+};
+
+} // namespace net
@@ -0,0 +1,220 @@
+#pragma once
+#include "net/core/endpoint.h"
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <unordered_map>
+
+namespace net {
+
+/**
+ * @brief Per-upstream health tracking: outlier ejection, half-open probing
+ * and a pending-request circuit breaker.
+ *
+ * Every outbound request takes a Permit for its upstream Endpoint and
+ * reports success (with its latency) or failure through it. An endpoint is
+ * ejected for a while when
+ *
+ *  - it fails `consecutive_failures` requests in a row, or
+ *  - over one analysis interval its mean latency exceeds `latency_factor`
+ *    times the median of the endpoints that served enough requests.
+ *
+ * Each further ejection lasts `base_ejection` longer, up to
+ * `max_ejection`; the penalty decays by one step per interval without an
+ * ejection. When an ejection expires the endpoint is half-open: only
+ * `half_open_probes` requests are let through, and the first outcome
+ * either restores it or ejects it again. Independently, tryAcquire()
+ * refuses requests once `max_pending` are in flight to an endpoint, so a
+ * slow upstream cannot absorb unbounded work.
+ *
+ * At most `max_ejection_fraction` of the known endpoints (but always at
+ * least one) are out of rotation at once, so a cluster-wide problem does
+ * not eject everything.
+ *
+ * All members are thread-safe. Permits must not outlive the tracker.
+ */
+class UpstreamHealth {
+public:
+  using Clock = std::chrono::steady_clock;
+
+  /// Rotation state of an endpoint.
+  enum class State : std::uint8_t {
+    Healthy,  ///< Serving normally
+    Ejected,  ///< Out of rotation until the ejection expires
+    HalfOpen, ///< Ejection expired; probes decide the next state
+  };
+
+  /// Tracker configuration.
+  struct Options {
+    /// Failures in a row that eject an endpoint; 0 disables.
+    std::uint32_t consecutive_failures = 5;
+    /// Duration of a first ejection and the increment for later ones.
+    std::chrono::milliseconds base_ejection{30000};
+    /// Longest ejection.
+    std::chrono::milliseconds max_ejection{300000};
+    /// Share of known endpoints that may be out of rotation at once.
+    double max_ejection_fraction = 0.5;
+    /// Length of one latency analysis window.
+    std::chrono::milliseconds interval{10000};
+    /// Successes an endpoint needs in a window to be judged on latency.
+    std::uint32_t min_requests = 20;
+    /// Endpoints that must qualify before any is judged on latency.
+    std::uint32_t min_endpoints = 3;
+    /// Mean latency over this multiple of the median ejects; 0 disables.
+    double latency_factor = 3.0;
+    /// Requests in flight per endpoint; 0 means unlimited.
+    std::uint32_t max_pending = 1024;
+    /// Requests let through at once while half-open.
+    std::uint32_t half_open_probes = 1;
+  };
+
+  /// Snapshot of one endpoint.
+  struct Stats {
+    State state = State::Healthy;
+    std::uint32_t pending = 0;
+    std::uint32_t consecutive_failures = 0;
+    std::uint32_t ejections = 0;    ///< Current backoff step
+    std::uint64_t successes = 0;
+    std::uint64_t failures = 0;
+    std::uint64_t overflows = 0;    ///< Requests refused by max_pending
+    std::uint64_t times_ejected = 0;
+    /// When the current ejection ends (meaningful while Ejected).
+    Clock::time_point ejected_until{};
+  };
+
+private:
+  struct Host;
+
+public:
+  /**
+   * @brief Admission for one request to one endpoint.
+   *
+   * Report the outcome with success() or failure(). A permit destroyed
+   * without an outcome (e.g. a cancelled hedge) only releases its pending
+   * slot.
+   */
+  class Permit {
+  public:
+    Permit(Permit &&other) noexcept;
+    Permit &operator=(Permit &&other) noexcept;
+    Permit(const Permit &) = delete;
+    Permit &operator=(const Permit &) = delete;
+    ~Permit();
+
+    /// Report success; latency is measured from tryAcquire().
+    void success(Clock::time_point now = Clock::now());
+
+    /// Report success with an externally measured latency.
+    void success(std::chrono::nanoseconds latency,
+                 Clock::time_point now = Clock::now());
+
+    /// Report a failure: connect error, reset, timeout or bad response.
+    void failure(Clock::time_point now = Clock::now());
+
+    /// True if this request probes a half-open endpoint.
+    [[nodiscard]] bool probe() const noexcept { return probe_; }
+
+    /// The endpoint this permit admits to.
+    [[nodiscard]] const Endpoint &endpoint() const noexcept;
+
+  private:
+    friend class UpstreamHealth;
+
+    Permit(UpstreamHealth *owner, std::shared_ptr<Host> host,
+           Clock::time_point started, bool probe) noexcept
+        : owner_(owner), host_(std::move(host)), started_(started),
+          probe_(probe) {}
+
+    UpstreamHealth *owner_ = nullptr;
+    std::shared_ptr<Host> host_;
+    Clock::time_point started_;
+    bool probe_ = false;
+  };
+
+  /**
+   * @brief Create a tracker.
+   *
+   * @throws std::invalid_argument if max_ejection_fraction is outside
+   * [0, 1], an interval or ejection time is not positive, max_ejection is
+   * below base_ejection, or half_open_probes is zero.
+   */
+  explicit UpstreamHealth(Options options);
+
+  /// Create a tracker with default options.
+  UpstreamHealth() : UpstreamHealth(Options{}) {}
+
+  UpstreamHealth(const UpstreamHealth &) = delete;
+  UpstreamHealth &operator=(const UpstreamHealth &) = delete;
+
+  /**
+   * @brief Admit a request to `endpoint`, tracking it if new.
+   *
+   * Also runs the latency analysis when an interval has elapsed.
+   *
+   * @return A permit, or std::nullopt if the endpoint is ejected, its
+   * probe slots are taken, or its circuit breaker is open.
+   */
+  [[nodiscard]] std::optional<Permit>
+  tryAcquire(const Endpoint &endpoint, Clock::time_point now = Clock::now());
+
+  /// Current state; unknown endpoints are Healthy.
+  [[nodiscard]] State state(const Endpoint &endpoint,
+                            Clock::time_point now = Clock::now()) const;
+
+  /// Snapshot of an endpoint; default values if unknown.
+  [[nodiscard]] Stats stats(const Endpoint &endpoint,
+                            Clock::time_point now = Clock::now()) const;
+
+  /// Endpoints currently Ejected or HalfOpen.
+  [[nodiscard]] std::size_t
+  unavailableCount(Clock::time_point now = Clock::now()) const;
+
+  /// Stop tracking an endpoint; outstanding permits stay valid.
+  void remove(const Endpoint &endpoint);
+
+  /**
+   * @brief Run the latency analysis if the current interval has elapsed.
+   *
+   * tryAcquire() calls this; call it directly when traffic is sparse.
+   */
+  void analyze(Clock::time_point now = Clock::now());
+
+private:
+  struct Host {
+    Endpoint endpoint;
+    State state = State::Healthy;
+    Clock::time_point ejected_until{};
+    std::uint32_t pending = 0;
+    std::uint32_t probing = 0;
+    std::uint32_t consecutive_failures = 0;
+    std::uint32_t ejections = 0;
+    bool ejected_this_interval = false;
+    std::uint64_t successes = 0;
+    std::uint64_t failures = 0;
+    std::uint64_t overflows = 0;
+    std::uint64_t times_ejected = 0;
+    // Current analysis window
+    std::uint64_t window_requests = 0;
+    std::chrono::nanoseconds window_latency{0};
+  };
+
+  enum class Outcome : std::uint8_t { Success, Failure, Cancelled };
+
+  void complete(Host &host, bool probe, Outcome outcome,
+                std::chrono::nanoseconds latency, Clock::time_point now);
+  void refresh(Host &host, Clock::time_point now) const;
+  bool eject(Host &host, Clock::time_point now, bool force);
+  void analyzeLocked(Clock::time_point now);
+  [[nodiscard]] std::size_t unavailableLocked(Clock::time_point now) const;
+
+  Options options_;
+  mutable std::mutex mutex_;
+  std::unordered_map<Endpoint, std::shared_ptr<Host>> hosts_;
+  Clock::time_point window_start_;
+  bool window_started_ = false;
+};
+
+} // namespace net
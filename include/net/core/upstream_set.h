@@ -0,0 +1,104 @@
+#pragma once
+#include "net/core/endpoint.h"
+#include "net/core/epoch.h"
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace net {
+
+/// An immutable list of upstream endpoints.
+struct UpstreamSet {
+  /// Incremented by every UpstreamSource::update().
+  std::uint64_t version = 0;
+  std::vector<Endpoint> endpoints;
+};
+
+/**
+ * @brief Parse an upstream list.
+ *
+ * One endpoint per line, `address:port` or `[v6 address]:port`. Blank
+ * lines and text after `#` are ignored. Duplicates are kept, so listing an
+ * endpoint twice doubles its share in a balancer.
+ *
+ * @throws std::invalid_argument naming the line of the first bad entry.
+ */
+std::vector<Endpoint> parseUpstreams(std::string_view text);
+
+/**
+ * @brief Read and parse an upstream file.
+ *
+ * @throws std::system_error if the file cannot be read.
+ * @throws std::invalid_argument on a bad entry.
+ */
+std::vector<Endpoint> loadUpstreams(const std::string &path);
+
+/**
+ * @brief Publishes the current UpstreamSet to request paths without locks.
+ *
+ * read() pins the current set for the lifetime of the returned Snapshot.
+ * It takes no lock and touches no shared reference count; update() swaps
+ * in a new set and retires the old one through the source's EpochDomain,
+ * which frees it once every reader that could still see it has left its
+ * snapshot. Readers never wait for writers; a long-held snapshot only
+ * delays freeing.
+ *
+ * Snapshots may nest but must be released on the thread that took them.
+ * update() calls serialize on a mutex.
+ */
+class UpstreamSource {
+public:
+  /// Read access to the set that was current when read() was called.
+  class Snapshot {
+  public:
+    const UpstreamSet &operator*() const noexcept { return *reader_; }
+    const UpstreamSet *operator->() const noexcept { return reader_.get(); }
+
+  private:
+    friend class UpstreamSource;
+    explicit Snapshot(EpochCell<UpstreamSet>::Reader reader) noexcept
+        : reader_(std::move(reader)) {}
+
+    EpochCell<UpstreamSet>::Reader reader_;
+  };
+
+  /// Start with `endpoints` as version 0.
+  explicit UpstreamSource(std::vector<Endpoint> endpoints = {});
+
+  /// Frees every set; no snapshot may be alive.
+  ~UpstreamSource() = default;
+
+  UpstreamSource(const UpstreamSource &) = delete;
+  UpstreamSource &operator=(const UpstreamSource &) = delete;
+
+  /// Pin the current set. Lock-free after a thread's first read.
+  [[nodiscard]] Snapshot read() const { return Snapshot(sets_.read()); }
+
+  /**
+   * @brief Publish a new set.
+   *
+   * Readers that start after this returns see the new set. Sets retired
+   * earlier are freed when no reader can hold them any more.
+   *
+   * @return The new version.
+   */
+  std::uint64_t update(std::vector<Endpoint> endpoints);
+
+  /// Free retired sets that no reader can hold any more.
+  void reclaim() { domain_.reclaim(); }
+
+  /// Retired sets still waiting for readers to move on.
+  [[nodiscard]] std::size_t retiredCount() const { return domain_.pending(); }
+
+private:
+  EpochDomain domain_;
+  EpochCell<UpstreamSet> sets_;
+  std::mutex mutex_;
+};
+
+} // namespace net
@@ -0,0 +1,98 @@
+#pragma once
+#include "net/core/event_loop.h"
+#include "net/core/upstream_set.h"
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <optional>
+#include <string>
+
+namespace net {
+
+/**
+ * @brief Reloads an UpstreamSource whenever its file changes.
+ *
+ * On Linux the directory holding the file is watched with inotify, so
+ * both in-place writes and the usual write-to-temp-and-rename replacement
+ * are noticed; elsewhere the file's modification time is polled. Changes
+ * are debounced, then the file is parsed and, if its endpoints differ,
+ * published with UpstreamSource::update(). A file that is missing or fails
+ * to parse leaves the current set in place and is reported to the error
+ * handler.
+ *
+ * All members must be called on the loop thread; the loop and the source
+ * must outlive the watcher.
+ *
+ * @note Available on POSIX platforms only.
+ */
+class UpstreamFileWatcher {
+public:
+  /// Watcher configuration.
+  struct Options {
+    /// Quiet time after the last change before the file is read.
+    std::chrono::milliseconds debounce{50};
+    /// Modification time check period where inotify is unavailable.
+    std::chrono::milliseconds poll_interval{1000};
+  };
+
+  /// Counters since construction.
+  struct Stats {
+    std::uint64_t reloads = 0;   ///< New sets published
+    std::uint64_t unchanged = 0; ///< Reads that found the same endpoints
+    std::uint64_t errors = 0;    ///< Reads or parses that failed
+  };
+
+  /// Receives the reason a reload failed.
+  using ErrorHandler = std::function<void(const std::string &message)>;
+
+  /**
+   * @brief Load `path` into `source` and start watching it.
+   *
+   * @throws std::system_error if the file cannot be read or watched.
+   * @throws std::invalid_argument if the file has a bad entry.
+   */
+  UpstreamFileWatcher(EventLoop &loop, std::string path,
+                      UpstreamSource &source, Options options);
+
+  /// Watch with default options.
+  UpstreamFileWatcher(EventLoop &loop, std::string path,
+                      UpstreamSource &source)
+      : UpstreamFileWatcher(loop, std::move(path), source, Options{}) {}
+
+  ~UpstreamFileWatcher();
+
+  UpstreamFileWatcher(const UpstreamFileWatcher &) = delete;
+  UpstreamFileWatcher &operator=(const UpstreamFileWatcher &) = delete;
+
+  /**
+   * @brief Read the file now.
+   *
+   * @return true if a new set was published.
+   */
+  bool reload();
+
+  void setErrorHandler(ErrorHandler handler) {
+    error_handler_ = std::move(handler);
+  }
+
+  [[nodiscard]] const std::string &path() const noexcept { return path_; }
+  [[nodiscard]] const Stats &stats() const noexcept { return stats_; }
+
+private:
+  void onNotify();
+  void schedule(std::chrono::milliseconds delay);
+  void poll();
+
+  EventLoop &loop_;
+  std::string path_;
+  std::string name_; ///< File name within the watched directory
+  UpstreamSource &source_;
+  Options options_;
+  ErrorHandler error_handler_;
+  Stats stats_;
+  int notify_fd_ = -1;
+  std::optional<EventLoop::TimerId> timer_;
+  std::int64_t mtime_ns_ = -1;
+};
+
+} // namespace net
@@ -0,0 +1,53 @@
+#pragma once
+#include <cstddef>
+#include <span>
+
+#if defined(__x86_64__) || defined(__aarch64__)
+#define NET_FIBER_ASM_SWITCH 1
+#else
+#include <ucontext.h>
+#endif
+
+namespace net::detail {
+
+/**
+ * @brief Saved CPU state of a suspended fiber (or of the thread that runs
+ * fibers).
+ *
+ * On x86-64 and AArch64 a switch is a hand-written routine that spills only
+ * the callee-saved registers (plus FP control state) onto the current stack
+ * and swaps stack pointers - no signal mask syscall as with swapcontext().
+ * Other architectures fall back to <ucontext.h>.
+ */
+class FiberContext {
+public:
+  /// Function a fresh context starts in; it must never return.
+  using Entry = void (*)(void *);
+
+  /**
+   * @brief Make this context start `entry(arg)` on `stack` when first
+   * switched to.
+   *
+   * @param stack Usable stack memory (lowest to highest address).
+   */
+  void prepare(std::span<std::byte> stack, Entry entry, void *arg) noexcept;
+
+  /**
+   * @brief Save the running state into `from` and resume `to`.
+   *
+   * Returns when some other context switches back to `from`.
+   */
+  static void switchTo(FiberContext &from, FiberContext &to) noexcept;
+
+private:
+#ifdef NET_FIBER_ASM_SWITCH
+  void *sp_ = nullptr;
+#else
+  friend void ucontext_trampoline();
+  ucontext_t context_{};
+  Entry entry_ = nullptr;
+  void *arg_ = nullptr;
+#endif
+};
+
+} // namespace net::detail
@@ -0,0 +1,68 @@
+#pragma once
+#include <cstddef>
+#include <span>
+#include <vector>
+
+namespace net::detail {
+
+/**
+ * @brief Pool of mmap'd fiber stacks, each with a PROT_NONE guard page.
+ *
+ * The guard page sits below the usable area, so a fiber overflowing its
+ * stack faults immediately instead of corrupting a neighbour. Released
+ * stacks are kept for reuse up to a limit; fresh stacks only cost address
+ * space until touched.
+ */
+class FiberStackPool {
+public:
+  /// A stack lease; `usable` excludes the guard page.
+  struct Stack {
+    void *mapping = nullptr;
+    std::size_t mapping_size = 0;
+    std::span<std::byte> usable;
+  };
+
+  /**
+   * @brief Create a pool.
+   *
+   * @param stack_size Usable bytes per stack, rounded up to whole pages.
+   * @param max_pooled Released stacks kept for reuse.
+   *
+   * @throws std::invalid_argument if stack_size is zero.
+   */
+  FiberStackPool(std::size_t stack_size, std::size_t max_pooled);
+  ~FiberStackPool();
+
+  FiberStackPool(const FiberStackPool &) = delete;
+  FiberStackPool &operator=(const FiberStackPool &) = delete;
+
+  /**
+   * @brief Take a stack from the pool or map a new one.
+   *
+   * @throws std::system_error if mmap or mprotect fails.
+   */
+  [[nodiscard]] Stack acquire();
+
+  /// Return a stack; unmapped if the pool is full.
+  void release(Stack stack) noexcept;
+
+  /// Usable size of every stack.
+  [[nodiscard]] std::size_t stackSize() const noexcept { return stack_size_; }
+
+  /// Stacks mapped over the pool's lifetime.
+  [[nodiscard]] std::size_t mapped() const noexcept { return mapped_; }
+
+  /// Stacks currently waiting for reuse.
+  [[nodiscard]] std::size_t pooled() const noexcept { return free_.size(); }
+
+private:
+  static void unmap(const Stack &stack) noexcept;
+
+  std::size_t page_size_;
+  std::size_t stack_size_;
+  std::size_t max_pooled_;
+  std::vector<Stack> free_;
+  std::size_t mapped_ = 0;
+};
+
+} // namespace net::detail
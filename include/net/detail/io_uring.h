@@ -0,0 +1,145 @@
+#pragma once
+#include <bitset>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <span>
+
+namespace net::detail {
+
+/// One reaped io_uring completion.
+struct IoUringCompletion {
+  std::uint64_t user_data = 0;
+  std::int32_t result = 0; ///< Bytes transferred, or -errno
+  std::uint32_t flags = 0;
+};
+
+/**
+ * @brief Minimal io_uring instance driven through the raw system calls.
+ *
+ * Maps the submission and completion rings and exposes just the operations
+ * the library issues. Single-threaded: one thread prepares, submits and
+ * reaps. Prepared entries reach the kernel only on submit().
+ *
+ * @note Linux only; elsewhere the constructor throws.
+ */
+class IoUring {
+public:
+  /**
+   * @brief Set up a ring.
+   *
+   * @param entries Submission queue size (rounded up by the kernel).
+   *
+   * @throws std::system_error if io_uring is unavailable (ENOSYS, EPERM
+   * under a seccomp or sysctl policy, or not_supported off Linux) or the
+   * rings cannot be mapped.
+   */
+  explicit IoUring(unsigned entries);
+  ~IoUring();
+
+  IoUring(const IoUring &) = delete;
+  IoUring &operator=(const IoUring &) = delete;
+
+  /**
+   * @brief Checks once per process whether a ring can be created.
+   */
+  [[nodiscard]] static bool available() noexcept;
+
+  /// Ring descriptor; readable while completions are pending.
+  [[nodiscard]] int fd() const noexcept { return fd_; }
+
+  /// IORING_FEAT_* bits reported by the kernel.
+  [[nodiscard]] std::uint32_t features() const noexcept { return features_; }
+
+  /**
+   * @brief Opcodes the kernel supports (IORING_REGISTER_PROBE), indexed by
+   * IORING_OP_* value. Empty on kernels without the probe (before 5.6).
+   */
+  [[nodiscard]] std::bitset<256> supportedOpcodes() const;
+
+  /// Free submission slots, counting entries prepared but not submitted.
+  [[nodiscard]] unsigned space() const noexcept;
+
+  /**
+   * @brief Register fixed buffers for READ_FIXED/WRITE_FIXED.
+   *
+   * Replaces no earlier registration; call once per ring.
+   *
+   * @throws std::system_error on failure (e.g. RLIMIT_MEMLOCK).
+   */
+  void registerBuffers(std::span<const std::span<std::byte>> buffers);
+
+  /**
+   * @brief Queue a read from `fd` at `offset` into registered buffer
+   * `index`; `buffer` must lie inside that buffer.
+   *
+   * @param link Run the next prepared entry only if this one completes in
+   * full (IOSQE_IO_LINK).
+   *
+   * @throws std::length_error if the submission queue is full.
+   */
+  void prepareReadFixed(int fd, std::span<std::byte> buffer,
+                        std::uint64_t offset, unsigned index,
+                        std::uint64_t user_data, bool link);
+
+  /**
+   * @brief Queue a send() on a socket.
+   *
+   * @throws std::length_error if the submission queue is full.
+   */
+  void prepareSend(int fd, std::span<const std::byte> data, int flags,
+                   std::uint64_t user_data, bool link);
+
+  /**
+   * @brief Queue a no-op; completes with result 0.
+   *
+   * @throws std::length_error if the submission queue is full.
+   */
+  void prepareNop(std::uint64_t user_data);
+
+  /**
+   * @brief Hand prepared entries to the kernel.
+   *
+   * @param wait_for Block until at least this many completions are
+   * available.
+   *
+   * @return Number of entries the kernel consumed.
+   *
+   * @throws std::system_error if io_uring_enter fails.
+   */
+  unsigned submit(unsigned wait_for = 0);
+
+  /**
+   * @brief Pop the oldest completion without blocking.
+   */
+  [[nodiscard]] std::optional<IoUringCompletion> peek() noexcept;
+
+private:
+  void *nextEntry(std::uint64_t user_data);
+  void release() noexcept;
+
+  int fd_ = -1;
+  std::uint32_t features_ = 0;
+  unsigned entries_ = 0;
+
+  void *sq_ring_ = nullptr;
+  std::size_t sq_ring_size_ = 0;
+  void *cq_ring_ = nullptr;
+  std::size_t cq_ring_size_ = 0;
+  void *sqes_ = nullptr;
+  std::size_t sqes_size_ = 0;
+
+  unsigned *sq_head_ = nullptr;
+  unsigned *sq_tail_ = nullptr;
+  unsigned sq_mask_ = 0;
+  unsigned *sq_array_ = nullptr;
+  unsigned *cq_head_ = nullptr;
+  unsigned *cq_tail_ = nullptr;
+  unsigned cq_mask_ = 0;
+  void *cqes_ = nullptr;
+
+  unsigned prepared_tail_ = 0;  ///< Local tail including unsubmitted entries
+  unsigned submitted_tail_ = 0; ///< Tail already consumed by the kernel
+};
+
+} // namespace net::detail
@@ -0,0 +1,26 @@
+#pragma once
+#include "net/detail/socket_handle.h"
+
+namespace net::detail {
+
+/**
+ * @brief Thread-local hook that lets blocking-mode socket calls yield.
+ *
+ * When a hook is installed on the calling thread, Socket::raw_send(),
+ * Socket::raw_recv() and TcpSocket::accept() on sockets in blocking mode
+ * no longer block the thread: they attempt the call without waiting and,
+ * if it would block, call `wait` and retry. A fiber scheduler installs a
+ * hook while a fiber runs so that `wait` suspends only that fiber.
+ * Sockets in non-blocking mode are unaffected and still report EAGAIN.
+ */
+struct IoWaitHook {
+  /// Suspend until `fd` is readable (`writable` false) or writable.
+  void (*wait)(void *context, SocketDescriptorHandle::Handle fd,
+               bool writable);
+  void *context;
+};
+
+/// Hook for the calling thread, or nullptr when calls block normally.
+inline thread_local IoWaitHook *io_wait_hook = nullptr;
+
+} // namespace net::detail
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+namespace net::detail {
+
+/**
+ * @brief Compressor for the LZ4 block format.
+ *
+ * Holds the match-finder hash table so repeated compress() calls reuse one
+ * allocation. Output is a single LZ4 block (no frame header), decodable by
+ * `lz4_decompress()` or any LZ4 implementation.
+ */
+class Lz4Compressor {
+public:
+  Lz4Compressor();
+
+  /**
+   * @brief Worst-case compressed size for an input of `size` bytes.
+   */
+  [[nodiscard]] static std::size_t bound(std::size_t size) noexcept {
+    return size + size / 255 + 16;
+  }
+
+  /**
+   * @brief Compress `input` into `output`.
+   *
+   * @param input Bytes to compress.
+   * @param output Destination; must hold at least `bound(input.size())`.
+   * @param acceleration 1 for the best ratio; larger values skip more
+   *                     positions when no match is found, trading ratio for
+   *                     speed.
+   *
+   * @return Number of bytes written to output.
+   *
+   * @throws std::length_error if output is smaller than bound().
+   */
+  std::size_t compress(std::span<const std::byte> input,
+                       std::span<std::byte> output, int acceleration = 1);
+
+private:
+  std::vector<std::uint32_t> table_; ///< Last position seen per 4-byte hash
+};
+
+/**
+ * @brief Decompress one LZ4 block.
+ *
+ * @param input Compressed block.
+ * @param output Destination; must be large enough for the decoded data.
+ *
+ * @return Number of bytes written to output.
+ *
+ * @throws std::runtime_error if the block is malformed or does not fit.
+ */
+std::size_t lz4_decompress(std::span<const std::byte> input,
+                           std::span<std::byte> output);
+
+} // namespace net::detail
@@ -0,0 +1,83 @@
+#pragma once
+#include <atomic>
+#include <optional>
+#include <utility>
+
+namespace net::detail {
+
+/**
+ * @brief Unbounded lock-free multi-producer single-consumer queue.
+ *
+ * Linked list with a stub node (Vyukov's MPSC design): producers append
+ * with one atomic exchange and never block each other; the single consumer
+ * pops without atomic read-modify-write operations. A push is visible to
+ * the consumer once it has fully completed; a concurrent push may make the
+ * queue briefly look empty, so producers should signal the consumer after
+ * pushing.
+ *
+ * @tparam T Movable value type.
+ */
+template <typename T> class MpscQueue {
+public:
+  MpscQueue() : head_(&stub_), tail_(&stub_) {}
+
+  MpscQueue(const MpscQueue &) = delete;
+  MpscQueue &operator=(const MpscQueue &) = delete;
+
+  ~MpscQueue() {
+    while (pop()) {
+    }
+    if (tail_ != &stub_) {
+      delete tail_;
+    }
+  }
+
+  /**
+   * @brief Append a value. Safe to call from any number of threads.
+   */
+  void push(T value) {
+    auto *node = new Node;
+    node->value.emplace(std::move(value));
+    Node *prev = head_.exchange(node, std::memory_order_acq_rel);
+    prev->next.store(node, std::memory_order_release);
+  }
+
+  /**
+   * @brief Remove the oldest value. Consumer thread only.
+   *
+   * @return The value, or std::nullopt if the queue is (momentarily) empty.
+   */
+  std::optional<T> pop() {
+    Node *tail = tail_;
+    Node *next = tail->next.load(std::memory_order_acquire);
+    if (next == nullptr) {
+      return std::nullopt;
+    }
+    T value = std::move(*next->value);
+    next->value.reset();
+    tail_ = next;
+    if (tail != &stub_) {
+      delete tail;
+    }
+    return value;
+  }
+
+  /**
+   * @brief True if no completed push is pending. Consumer thread only.
+   */
+  [[nodiscard]] bool empty() const noexcept {
+    return tail_->next.load(std::memory_order_acquire) == nullptr;
+  }
+
+private:
+  struct Node {
+    std::atomic<Node *> next{nullptr};
+    std::optional<T> value;
+  };
+
+  Node stub_;
+  std::atomic<Node *> head_; ///< Last pushed node (producers)
+  Node *tail_;               ///< Node before the oldest value (consumer)
+};
+
+} // namespace net::detail
@@ -40,6 +40,34 @@ inline bool is_in_progress(int err) {
 #endif // _WIN32
 }
 
+/**
+ * @brief Checks if a non-blocking socket operation would have blocked.
+ *
+ * @param err Error code to check.
+ * @return true for EAGAIN/EWOULDBLOCK (WSAEWOULDBLOCK on Windows).
+ */
+inline bool is_would_block(int err) {
+#ifdef _WIN32
+  return err == WSAEWOULDBLOCK;
+#else
+  return err == EAGAIN || err == EWOULDBLOCK;
+#endif // _WIN32
+}
+
+/**
+ * @brief Checks if an operation failed because descriptors ran out.
+ *
+ * @param err Error code to check.
+ * @return true for EMFILE/ENFILE (WSAEMFILE on Windows).
+ */
+inline bool is_descriptor_exhausted(int err) {
+#ifdef _WIN32
+  return err == WSAEMFILE;
+#else
+  return err == EMFILE || err == ENFILE;
+#endif // _WIN32
+}
+
 /**
  * @brief Checks if a socket operation was interrupted by a signal.
  *
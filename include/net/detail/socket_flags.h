@@ -39,8 +39,9 @@ struct SocketFlags {
    * Determines which protocol implementation is used by the socket.
    */
   enum class ProtocolType : std::uint8_t {
-    TCP, ///< Transmission Control Protocol
-    UDP  ///< User Datagram Protocol
+    TCP,  ///< Transmission Control Protocol
+    UDP,  ///< User Datagram Protocol
+    MPTCP ///< Multipath TCP (falls back to TCP where unsupported)
   };
 
   /**
@@ -0,0 +1,101 @@
+#pragma once
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <memory>
+#include <optional>
+#include <stdexcept>
+#include <utility>
+
+namespace net::detail {
+
+/**
+ * @brief Bounded lock-free single-producer single-consumer ring.
+ *
+ * Each side owns one index and keeps a cached copy of the other's, so in
+ * the common case push() and pop() touch only their own cache line and do
+ * one release store. Exactly one thread may push and one thread may pop.
+ *
+ * @tparam T Movable value type.
+ */
+template <typename T> class SpscQueue {
+public:
+  /**
+   * @brief Create a ring holding at least `capacity` values.
+   *
+   * @throws std::invalid_argument if capacity is zero.
+   */
+  explicit SpscQueue(std::size_t capacity)
+      : capacity_(capacity == 0 ? 0 : std::bit_ceil(capacity)),
+        mask_(capacity_ - 1),
+        slots_(std::make_unique<std::optional<T>[]>(capacity_)) {
+    if (capacity == 0) {
+      throw std::invalid_argument("SpscQueue capacity must be positive");
+    }
+  }
+
+  SpscQueue(const SpscQueue &) = delete;
+  SpscQueue &operator=(const SpscQueue &) = delete;
+
+  /**
+   * @brief Append a value. Producer thread only.
+   *
+   * @return false if the ring is full, in which case `value` is untouched.
+   */
+  bool push(T &&value) {
+    const std::size_t tail = tail_.load(std::memory_order_relaxed);
+    if (tail - cached_head_ == capacity_) {
+      cached_head_ = head_.load(std::memory_order_acquire);
+      if (tail - cached_head_ == capacity_) {
+        return false;
+      }
+    }
+    slots_[tail & mask_].emplace(std::move(value));
+    tail_.store(tail + 1, std::memory_order_release);
+    return true;
+  }
+
+  /**
+   * @brief Remove the oldest value. Consumer thread only.
+   *
+   * @return The value, or std::nullopt if the ring is empty.
+   */
+  std::optional<T> pop() {
+    const std::size_t head = head_.load(std::memory_order_relaxed);
+    if (head == cached_tail_) {
+      cached_tail_ = tail_.load(std::memory_order_acquire);
+      if (head == cached_tail_) {
+        return std::nullopt;
+      }
+    }
+    std::optional<T> &slot = slots_[head & mask_];
+    T value = std::move(*slot);
+    slot.reset();
+    head_.store(head + 1, std::memory_order_release);
+    return value;
+  }
+
+  /// True if there is nothing to pop. Consumer thread only.
+  [[nodiscard]] bool empty() const noexcept {
+    return head_.load(std::memory_order_relaxed) ==
+           tail_.load(std::memory_order_acquire);
+  }
+
+  /// Number of values the ring can hold.
+  [[nodiscard]] std::size_t capacity() const noexcept { return capacity_; }
+
+private:
+  static constexpr std::size_t kCacheLine = 64;
+
+  const std::size_t capacity_;
+  const std::size_t mask_;
+  std::unique_ptr<std::optional<T>[]> slots_;
+
+  alignas(kCacheLine) std::atomic<std::size_t> head_{0}; ///< Consumer index
+  std::size_t cached_tail_ = 0;                          ///< Consumer's copy
+
+  alignas(kCacheLine) std::atomic<std::size_t> tail_{0}; ///< Producer index
+  std::size_t cached_head_ = 0;                          ///< Producer's copy
+};
+
+} // namespace net::detail
@@ -0,0 +1,196 @@
+#pragma once
+#include "net/core/endpoint.h"
+#include "net/protocol/udp/udp_socket.h"
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <optional>
+#include <span>
+#include <vector>
+
+namespace net {
+
+/**
+ * @brief Reliable message transport over a connected UDP socket.
+ *
+ * Messages are split into datagram-sized fragments carrying 32-bit sequence
+ * numbers. The receiver acknowledges with a cumulative sequence number plus
+ * a 64-packet selective-acknowledgement bitmap; the sender retransmits
+ * fragments reported missing by later SACKs or by retransmission timeout,
+ * estimates RTT as in RFC 6298 and limits packets in flight with an AIMD
+ * congestion window.
+ *
+ * Ordered delivery hands messages out in send order. Unordered delivery
+ * hands out each message as soon as all its fragments arrived, so one lost
+ * datagram does not hold back unrelated messages.
+ *
+ * The channel is single-threaded and driven by `poll()`.
+ */
+class ReliableChannel {
+public:
+  using Clock = std::chrono::steady_clock;
+
+  /// Delivery order guarantee for received messages.
+  enum class Delivery : std::uint8_t {
+    Ordered,  ///< Messages are delivered in the order they were sent
+    Unordered ///< Messages are delivered as soon as they are complete
+  };
+
+  /// Tunables of a channel.
+  struct Options {
+    Delivery delivery = Delivery::Ordered;
+    std::size_t max_datagram = 1200;   ///< Datagram size incl. header
+    std::size_t max_window = 1024;     ///< Sequence numbers in flight
+    double initial_cwnd = 4.0;         ///< Initial congestion window (pkts)
+    std::chrono::milliseconds initial_rto{200};
+    std::chrono::milliseconds min_rto{20};
+    std::chrono::milliseconds max_rto{2000};
+  };
+
+  /// Counters describing the transport so far.
+  struct Stats {
+    std::uint64_t packets_sent = 0;       ///< Data packets incl. resends
+    std::uint64_t retransmissions = 0;    ///< Data packets sent again
+    std::uint64_t timeouts = 0;           ///< Retransmission timer expiries
+    std::uint64_t packets_received = 0;   ///< Data packets received
+    std::uint64_t duplicates = 0;         ///< Data packets already seen
+    std::uint64_t messages_delivered = 0; ///< Messages handed to receive()
+    double cwnd = 0.0;                    ///< Current congestion window
+    std::chrono::microseconds srtt{0};    ///< Smoothed round-trip time
+    std::chrono::microseconds rto{0};     ///< Current retransmission timeout
+  };
+
+  /**
+   * @brief Open a channel between `local` and `peer`.
+   *
+   * Creates a non-blocking UDP socket bound to `local` and connected to
+   * `peer`.
+   *
+   * @throws std::invalid_argument if max_datagram cannot hold a fragment.
+   * @throws std::system_error if the socket cannot be set up.
+   */
+  ReliableChannel(const Endpoint &local, const Endpoint &peer,
+                  Options options);
+
+  /**
+   * @brief Open a channel with default options.
+   */
+  ReliableChannel(const Endpoint &local, const Endpoint &peer)
+      : ReliableChannel(local, peer, Options{}) {}
+
+  ReliableChannel(ReliableChannel &&) noexcept = default;
+  ReliableChannel &operator=(ReliableChannel &&) noexcept = default;
+
+  ReliableChannel(const ReliableChannel &) = delete;
+  ReliableChannel &operator=(const ReliableChannel &) = delete;
+
+  /**
+   * @brief Queue a message for reliable transmission.
+   *
+   * Sends immediately as far as the congestion window allows; the rest goes
+   * out from later `poll()` calls.
+   *
+   * @param message Message payload (may be empty).
+   *
+   * @throws std::length_error if the message needs more than 65535 fragments.
+   * @throws std::system_error on socket failure.
+   */
+  void send(std::span<const std::byte> message);
+
+  /**
+   * @brief Pop the next delivered message, if any.
+   */
+  [[nodiscard]] std::optional<std::vector<std::byte>> receive();
+
+  /**
+   * @brief Drive the protocol once.
+   *
+   * Waits until a datagram arrives, the retransmission timer expires or
+   * `timeout` elapses; then processes input, handles timeouts and sends
+   * whatever the window allows.
+   *
+   * @param timeout Upper bound on the wait.
+   *
+   * @throws std::system_error on socket failure.
+   */
+  void poll(std::chrono::milliseconds timeout);
+
+  /**
+   * @brief Checks whether every queued message has been acknowledged.
+   */
+  [[nodiscard]] bool idle() const noexcept {
+    return window_.empty() && pending_.empty();
+  }
+
+  /**
+   * @brief Snapshot of transport counters.
+   */
+  [[nodiscard]] Stats stats() const noexcept;
+
+  /**
+   * @brief Local endpoint of the underlying socket.
+   */
+  [[nodiscard]] Endpoint localEndpoint() const {
+    return socket_.localEndpoint();
+  }
+
+private:
+  /// Fragment queued or in flight on the sending side.
+  struct Outgoing {
+    std::vector<std::byte> datagram; ///< Encoded header + payload
+    Clock::time_point sent_at{};     ///< Time of the latest transmission
+    std::uint32_t transmissions = 0; ///< Number of times sent
+    bool sacked = false;             ///< Selectively acknowledged
+    bool lost = false;               ///< Awaiting retransmission
+  };
+
+  /// Fragment buffered on the receiving side.
+  struct Incoming {
+    std::uint16_t index = 0;
+    std::uint16_t count = 1;
+    std::vector<std::byte> payload;
+    bool delivered = false;
+  };
+
+  void readInput();
+  void onData(std::span<const std::byte> datagram);
+  void onAck(std::span<const std::byte> datagram);
+  void sendAck();
+  void onTimeout(Clock::time_point now);
+  void flush();
+  void transmit(Outgoing &packet, Clock::time_point now);
+  void sampleRtt(std::chrono::microseconds sample);
+  void enterRecovery();
+  bool tryDeliver(std::uint32_t first);
+  void advanceReceiveWindow();
+  [[nodiscard]] std::size_t inFlight() const noexcept;
+  [[nodiscard]] std::optional<Clock::time_point> retransmitDeadline() const;
+
+  Options options_;
+  UdpSocket socket_;
+  Stats stats_;
+
+  // --- sender ---
+  std::deque<Outgoing> pending_;     ///< Fragments not yet assigned a window
+  std::deque<Outgoing> window_;      ///< Unacknowledged fragments
+  std::uint32_t window_base_ = 0;    ///< Sequence number of window_.front()
+  std::uint32_t next_seq_ = 0;       ///< Next sequence number to assign
+  std::uint32_t recovery_point_ = 0; ///< Losses below this share one cut
+  bool in_recovery_ = false;
+  double cwnd_;
+  double ssthresh_;
+  std::chrono::microseconds srtt_{0};
+  std::chrono::microseconds rttvar_{0};
+  std::chrono::microseconds rto_;
+  bool have_rtt_ = false;
+
+  // --- receiver ---
+  std::map<std::uint32_t, Incoming> reorder_; ///< Fragments >= expected_
+  std::uint32_t expected_ = 0;                ///< Next sequence to deliver
+  std::deque<std::vector<std::byte>> inbox_;  ///< Delivered messages
+  bool ack_pending_ = false;
+};
+
+} // namespace net
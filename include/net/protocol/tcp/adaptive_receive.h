@@ -0,0 +1,106 @@
+#pragma once
+#include "net/detail/default_init_allocator.h"
+#include "net/protocol/tcp/tcp_socket.h"
+#include <cstddef>
+#include <vector>
+
+namespace net {
+
+/**
+ * @brief Predicts a good size for a connection's next receive.
+ *
+ * Walks a table of sizes (16-byte steps up to 512, then powers of two):
+ * a read that fills the predicted size jumps four steps up, while two
+ * consecutive reads that would have fit one step lower move one step down.
+ * Bulk connections therefore quickly get large reads (few syscalls) and
+ * chatty ones settle on small buffers (little memory).
+ */
+class AdaptiveReceiveSizer {
+public:
+  /**
+   * @brief Construct a sizer.
+   *
+   * Bounds are rounded to the nearest table entries.
+   *
+   * @param minimum Smallest size ever predicted.
+   * @param initial First prediction.
+   * @param maximum Largest size ever predicted.
+   *
+   * @throws std::invalid_argument unless 0 < minimum <= initial <= maximum.
+   */
+  explicit AdaptiveReceiveSizer(std::size_t minimum = 64,
+                                std::size_t initial = 2048,
+                                std::size_t maximum = 65536);
+
+  /**
+   * @brief Size to use for the next receive.
+   */
+  [[nodiscard]] std::size_t nextSize() const noexcept;
+
+  /**
+   * @brief Size to use for the next receive given the queued byte count.
+   *
+   * @param queued Bytes the kernel reports as readable (FIONREAD); 0 if
+   *               unknown, in which case the prediction is used.
+   */
+  [[nodiscard]] std::size_t nextSize(std::size_t queued) const noexcept;
+
+  /**
+   * @brief Feed back how many bytes the last receive returned.
+   */
+  void record(std::size_t bytes_read) noexcept;
+
+private:
+  std::size_t min_index_;
+  std::size_t max_index_;
+  std::size_t index_;
+  bool decrease_now_ = false;
+};
+
+/// Byte buffer whose growth is not zero-filled, for receiveAvailable().
+using ReceiveBuffer =
+    std::vector<std::byte, detail::DefaultInitAllocator<std::byte>>;
+
+/// Limits on one `receiveAvailable()` call.
+struct ReceiveBudget {
+  std::size_t max_bytes = 256 * 1024; ///< Stop after this many bytes
+  std::size_t max_reads = 16;         ///< Stop after this many receives
+};
+
+/// Outcome of one `receiveAvailable()` call.
+struct ReceiveResult {
+  std::size_t bytes = 0;  ///< Bytes appended to the output
+  /// Syscalls issued: receives (including one that would block) and
+  /// FIONREAD queries.
+  std::size_t reads = 0;
+  bool drained = false;   ///< Receive queue was empty when we stopped
+  bool eof = false;       ///< Peer closed the connection
+};
+
+/**
+ * @brief Read whatever is queued on a socket, within a budget.
+ *
+ * Repeatedly receives into `out` (growing it by the sizer's prediction)
+ * until the socket would block, a read comes back short, FIONREAD reports
+ * the queue empty after a read, the peer closes the connection or the
+ * budget runs out. Intended for non-blocking
+ * sockets; on a blocking socket only the first read may wait.
+ *
+ * @param socket Socket to read from.
+ * @param sizer Per-connection size predictor, updated with every read.
+ * @param out Buffer the received bytes are appended to.
+ * @param budget Limits for this call.
+ * @param use_queued_hint Size reads with FIONREAD instead of prediction
+ *                        alone (one extra syscall per read).
+ *
+ * @return What happened; `drained == false && eof == false` means the
+ * budget ran out with data possibly still queued.
+ *
+ * @throws std::system_error on socket failure other than would-block.
+ */
+ReceiveResult receiveAvailable(TcpSocket &socket, AdaptiveReceiveSizer &sizer,
+                               ReceiveBuffer &out,
+                               ReceiveBudget budget = {},
+                               bool use_queued_hint = false);
+
+} // namespace net
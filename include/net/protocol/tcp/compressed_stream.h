@@ -0,0 +1,141 @@
+#pragma once
+#include "net/detail/lz4_block.h"
+#include "net/protocol/tcp/tcp_socket.h"
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+namespace net {
+
+/**
+ * @brief LZ4-compressing filter over a blocking TcpSocket stream.
+ *
+ * Outbound bytes are collected into blocks, compressed with a reused LZ4
+ * context and written as length-prefixed frames; inbound frames are
+ * decoded back into a plain byte stream. Blocks that do not shrink are sent
+ * stored, so incompressible data costs only the frame header.
+ *
+ * With adaptive level selection the filter times compression and socket
+ * writes per byte and moves along the acceleration ladder (from best ratio
+ * to stored) toward the level with the lowest combined cost, so a slow
+ * link gets stronger compression and a fast one gets cheaper compression.
+ *
+ * Both peers must use CompressedStream on the connection.
+ */
+class CompressedStream {
+public:
+  /// Tunables of the filter.
+  struct Options {
+    std::size_t block_size = 64 * 1024; ///< Raw bytes per frame
+    bool adaptive = true;               ///< Select the level automatically
+    std::size_t level = 0; ///< Initial ladder index (0 = best ratio)
+  };
+
+  /// Counters describing the filter so far.
+  struct Stats {
+    std::uint64_t raw_bytes_sent = 0;      ///< Application bytes sent
+    std::uint64_t wire_bytes_sent = 0;     ///< Frame bytes written
+    std::uint64_t raw_bytes_received = 0;  ///< Application bytes decoded
+    std::uint64_t wire_bytes_received = 0; ///< Frame bytes read
+    std::uint64_t blocks_sent = 0;         ///< Frames written
+    std::uint64_t stored_blocks_sent = 0;  ///< Frames sent uncompressed
+    std::size_t level = 0;                 ///< Current ladder index
+    double link_bytes_per_second = 0.0;    ///< Measured write throughput
+  };
+
+  /// Number of ladder levels; the last one stores blocks uncompressed.
+  static constexpr std::size_t kLevels = 7;
+
+  /**
+   * @brief Wrap a connected socket.
+   *
+   * @param socket Connected, blocking socket; must outlive the filter.
+   * @param options Filter options.
+   *
+   * @throws std::invalid_argument if block_size or level is out of range.
+   */
+  explicit CompressedStream(TcpSocket &socket, Options options);
+
+  /**
+   * @brief Wrap a connected socket with default options.
+   */
+  explicit CompressedStream(TcpSocket &socket)
+      : CompressedStream(socket, Options{}) {}
+
+  CompressedStream(const CompressedStream &) = delete;
+  CompressedStream &operator=(const CompressedStream &) = delete;
+
+  /**
+   * @brief Queue bytes for sending; full blocks are written immediately.
+   *
+   * @throws std::system_error on socket failure.
+   */
+  void send(std::span<const std::byte> data);
+
+  /**
+   * @brief Queue a chain of buffers as one contiguous stream.
+   *
+   * @throws std::system_error on socket failure.
+   */
+  void send(std::span<const std::span<const std::byte>> chain);
+
+  /**
+   * @brief Write any partially filled block.
+   *
+   * @throws std::system_error on socket failure.
+   */
+  void flush();
+
+  /**
+   * @brief Receive decoded bytes.
+   *
+   * @param buffer Destination buffer.
+   *
+   * @return Number of bytes stored; 0 once the peer closed the connection.
+   *
+   * @throws std::runtime_error on a malformed or truncated frame.
+   * @throws std::system_error on socket failure.
+   */
+  [[nodiscard]]
+  std::size_t receive(std::span<std::byte> buffer);
+
+  /**
+   * @brief Snapshot of filter counters.
+   */
+  [[nodiscard]] Stats stats() const noexcept;
+
+private:
+  /// Running per-level estimates used by the adaptive selector.
+  struct LevelCost {
+    double compress_ns_per_byte = 0.0; ///< CPU time per raw byte
+    double ratio = 1.0;                ///< Wire bytes per raw byte
+    bool measured = false;
+  };
+
+  void writeBlock();
+  void writeAll(std::span<const std::byte> data);
+  bool readExact(std::span<std::byte> buffer);
+  void adapt();
+  [[nodiscard]] double cost(std::size_t level) const noexcept;
+
+  TcpSocket &socket_;
+  Options options_;
+  Stats stats_;
+  detail::Lz4Compressor compressor_;
+
+  std::vector<std::byte> pending_;  ///< Raw bytes of the block being built
+  std::vector<std::byte> frame_;    ///< Encoded outbound frame
+  std::vector<std::byte> inbound_;  ///< Encoded inbound payload
+  std::vector<std::byte> decoded_;  ///< Decoded bytes not yet returned
+  std::size_t decoded_offset_ = 0;
+
+  std::array<LevelCost, kLevels> costs_{};
+  double link_ns_per_byte_ = 0.0;
+  std::size_t blocks_since_probe_ = 0;
+  bool probe_up_ = true;
+};
+
+} // namespace net
@@ -0,0 +1,66 @@
+#pragma once
+#include "net/protocol/tcp/tcp_socket.h"
+#include <cstddef>
+
+namespace net {
+
+/**
+ * @brief Raises a socket's SO_RCVLOWAT for a scope and restores it after.
+ *
+ * Intended for framing layers: once a header says N more bytes are needed,
+ * hold a guard set to N so the event loop is woken once the body is queued
+ * rather than on every segment, then let the guard restore the previous
+ * watermark for the next header.
+ *
+ * @code
+ *   ScopedReceiveLowWatermark lowat(socket, remaining);
+ *   // wait for readability, then read `remaining` bytes
+ * @endcode
+ */
+class ScopedReceiveLowWatermark {
+public:
+  /**
+   * @brief Save the current watermark and set a new one.
+   *
+   * @param socket Connected socket; must outlive the guard.
+   * @param bytes Watermark to apply while the guard is alive.
+   *
+   * @throws std::logic_error if socket is invalid.
+   * @throws std::system_error if the option cannot be read or set.
+   */
+  ScopedReceiveLowWatermark(TcpSocket &socket, std::size_t bytes)
+      : socket_(socket), previous_(socket.receiveLowWatermark()) {
+    socket_.setReceiveLowWatermark(bytes);
+  }
+
+  ScopedReceiveLowWatermark(const ScopedReceiveLowWatermark &) = delete;
+  ScopedReceiveLowWatermark &
+  operator=(const ScopedReceiveLowWatermark &) = delete;
+
+  /// Restore the saved watermark; failures (e.g. closed socket) are ignored.
+  ~ScopedReceiveLowWatermark() {
+    try {
+      if (socket_.is_valid()) {
+        socket_.setReceiveLowWatermark(previous_);
+      }
+    } catch (...) {
+    }
+  }
+
+  /**
+   * @brief Change the watermark while keeping the saved value, e.g. after a
+   * partial read shrank the number of missing bytes.
+   *
+   * @throws std::system_error if the option cannot be set.
+   */
+  void update(std::size_t bytes) { socket_.setReceiveLowWatermark(bytes); }
+
+  /// Watermark that will be restored on destruction.
+  [[nodiscard]] std::size_t previous() const noexcept { return previous_; }
+
+private:
+  TcpSocket &socket_;
+  std::size_t previous_;
+};
+
+} // namespace net
@@ -0,0 +1,26 @@
+#pragma once
+#include <cstddef>
+#include <span>
+
+namespace net {
+
+/**
+ * @brief Observer of the payload bytes a `TcpSocket` transfers.
+ *
+ * Installed with TcpSocket::setTap(). Each successful send() or receive()
+ * reports exactly the bytes the kernel accepted or delivered, in the
+ * order the application saw them. Callbacks run on the calling thread in
+ * the middle of the I/O call, so they must be cheap and must not throw.
+ */
+class SocketTap {
+public:
+  virtual ~SocketTap() = default;
+
+  /// Bytes handed to the kernel by a send().
+  virtual void onSend(std::span<const std::byte> data) noexcept = 0;
+
+  /// Bytes delivered by a receive().
+  virtual void onReceive(std::span<const std::byte> data) noexcept = 0;
+};
+
+} // namespace net
@@ -0,0 +1,106 @@
+#pragma once
+#include "net/core/endpoint.h"
+#include "net/protocol/tcp/tcp_socket.h"
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+
+namespace net {
+
+/**
+ * @brief Raise the soft RLIMIT_NOFILE towards the hard limit.
+ *
+ * Meant to be called once at startup so a busy server does not hit the
+ * (often small) default descriptor limit.
+ *
+ * @param desired Soft limit to request; 0 asks for the hard limit. The
+ *                value is capped by the hard limit (and OPEN_MAX on macOS).
+ *                The limit is never lowered.
+ *
+ * @return The soft limit in effect afterwards. On Windows, where sockets
+ * are not subject to a descriptor table limit, returns SIZE_MAX.
+ *
+ * @throws std::system_error if the limit cannot be read or changed.
+ */
+std::size_t raiseFileDescriptorLimit(std::size_t desired = 0);
+
+/**
+ * @brief Accept loop helper that sheds connections when descriptors run out.
+ *
+ * When a process hits EMFILE/ENFILE, the pending connection stays in the
+ * listen queue, so the listener remains readable and an event loop spins
+ * on accept() failures. The acceptor keeps one spare descriptor in reserve;
+ * on exhaustion it releases the spare, accepts the pending connection and
+ * closes it at once (the client sees the connection close), then reopens
+ * the spare. Overload becomes controlled shedding instead of a busy loop.
+ *
+ * The listener must outlive the acceptor.
+ */
+class TcpAcceptor {
+public:
+  /// Acceptor configuration.
+  struct Options {
+    /// Call raiseFileDescriptorLimit() on construction.
+    bool raise_descriptor_limit = true;
+  };
+
+  /// Counters describing accept outcomes so far.
+  struct Stats {
+    std::uint64_t accepted = 0;  ///< Connections handed to the caller
+    std::uint64_t shed = 0;      ///< Connections closed due to exhaustion
+    std::uint64_t exhausted = 0; ///< accept() failures with EMFILE/ENFILE
+    std::uint64_t reserve_failures = 0; ///< Times the spare could not reopen
+  };
+
+  /**
+   * @brief Wrap a listening socket.
+   *
+   * @param listener Socket on which listen() has been called.
+   * @param options Acceptor configuration.
+   *
+   * @throws std::logic_error if listener is invalid.
+   * @throws std::system_error if the spare descriptor cannot be opened.
+   */
+  explicit TcpAcceptor(TcpSocket &listener, Options options);
+
+  /// Wrap a listening socket with default options.
+  explicit TcpAcceptor(TcpSocket &listener)
+      : TcpAcceptor(listener, Options{}) {}
+
+  ~TcpAcceptor();
+
+  TcpAcceptor(const TcpAcceptor &) = delete;
+  TcpAcceptor &operator=(const TcpAcceptor &) = delete;
+
+  /**
+   * @brief Accept one connection.
+   *
+   * @param peer Endpoint structure to receive the peer address.
+   *
+   * @return The connection, or std::nullopt if a non-blocking listener has
+   * nothing pending or the pending connection was shed because descriptors
+   * ran out. Accepted sockets inherit blocking and inheritable flags from
+   * the listener, as with TcpSocket::accept().
+   *
+   * @throws std::system_error for other accept failures, or for exhaustion
+   * when no spare descriptor could be kept in reserve.
+   */
+  [[nodiscard]] std::optional<TcpSocket> accept(Endpoint &peer);
+
+  /// True while a spare descriptor is held for shedding.
+  [[nodiscard]] bool hasReserve() const noexcept;
+
+  /// Counters since construction.
+  [[nodiscard]] const Stats &stats() const noexcept { return stats_; }
+
+private:
+  bool openReserve() noexcept;
+  void closeReserve() noexcept;
+  std::optional<TcpSocket> shed();
+
+  TcpSocket &listener_;
+  int reserve_ = -1;
+  Stats stats_;
+};
+
+} // namespace net
@@ -0,0 +1,104 @@
+#pragma once
+#include "net/core/endpoint.h"
+#include "net/core/pcapng_writer.h"
+#include "net/protocol/tcp/socket_tap.h"
+#include "net/protocol/tcp/tcp_socket.h"
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <span>
+
+namespace net {
+
+/**
+ * @brief SocketTap that records a connection's payload into a pcapng
+ * capture as synthesized TCP/IP packets.
+ *
+ * Every send() and receive() becomes one or more IPv4 or IPv6 TCP segments
+ * between the connection's endpoints, with per-direction sequence numbers
+ * and acknowledgements derived from the bytes seen so far. The capture
+ * therefore holds exactly the stream the application observed, not what
+ * crossed the wire: retransmissions, segmentation and options are absent,
+ * and the TCP checksum is left zero to keep the per-call cost to two
+ * copies into the mapping.
+ *
+ * Any number of taps may share one writer.
+ *
+ * @note Available on POSIX platforms only.
+ */
+class TcpCaptureTap final : public SocketTap {
+public:
+  /// Tap configuration.
+  struct Options {
+    /// Start with a SYN, SYN-ACK, ACK exchange so analyzers see a
+    /// complete stream.
+    bool handshake = true;
+    /// The local side sent the SYN (only affects the handshake).
+    bool local_initiated = true;
+  };
+
+  /// Largest payload per synthesized segment: with IPv6 and TCP headers
+  /// the packet still fits the default 65535-byte snap length.
+  static constexpr std::size_t max_segment = 65535 - 40 - 20;
+
+  /**
+   * @brief Tap the connection between `local` and `remote`.
+   *
+   * @throws std::invalid_argument if writer is null or the endpoints are
+   * not both IPv4 or both IPv6.
+   */
+  TcpCaptureTap(std::shared_ptr<PcapngWriter> writer, const Endpoint &local,
+                const Endpoint &remote, Options options);
+
+  /// Tap with default options.
+  TcpCaptureTap(std::shared_ptr<PcapngWriter> writer, const Endpoint &local,
+                const Endpoint &remote)
+      : TcpCaptureTap(std::move(writer), local, remote, Options{}) {}
+
+  /**
+   * @brief Create a tap for a connected socket and install it.
+   *
+   * @return The installed tap.
+   *
+   * @throws std::logic_error if socket is invalid.
+   * @throws std::system_error if the socket is not connected.
+   */
+  static std::shared_ptr<TcpCaptureTap>
+  attach(TcpSocket &socket, std::shared_ptr<PcapngWriter> writer,
+         Options options);
+
+  /// Attach with default options.
+  static std::shared_ptr<TcpCaptureTap>
+  attach(TcpSocket &socket, std::shared_ptr<PcapngWriter> writer) {
+    return attach(socket, std::move(writer), Options{});
+  }
+
+  void onSend(std::span<const std::byte> data) noexcept override;
+  void onReceive(std::span<const std::byte> data) noexcept override;
+
+private:
+  /// One direction: addresses, ports and next sequence number.
+  struct Flow {
+    std::array<std::byte, 16> source{};
+    std::array<std::byte, 16> destination{};
+    std::uint16_t source_port = 0;
+    std::uint16_t destination_port = 0;
+    std::atomic<std::uint32_t> next_seq{0};
+  };
+
+  void record(Flow &flow, const Flow &reverse,
+              std::span<const std::byte> data) noexcept;
+  void segment(const Flow &flow, std::uint32_t seq, std::uint32_t ack,
+               std::uint8_t flags, std::span<const std::byte> payload,
+               std::uint64_t timestamp_ns) noexcept;
+  void synthesizeHandshake(Flow &client, Flow &server) noexcept;
+
+  std::shared_ptr<PcapngWriter> writer_;
+  bool ipv6_ = false;
+  Flow outbound_;
+  Flow inbound_;
+};
+
+} // namespace net
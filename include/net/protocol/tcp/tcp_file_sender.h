@@ -0,0 +1,169 @@
+#pragma once
+#include "net/detail/io_uring.h"
+#include "net/protocol/tcp/tcp_socket.h"
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace net {
+
+/**
+ * @brief Streams a file region to a TCP connection with linked io_uring
+ * chains.
+ *
+ * Each chain is one submission of `read(file) -> send(socket) -> read ->
+ * send ...` entries linked with IOSQE_IO_LINK, reading into registered
+ * buffers. The kernel runs the whole chain without returning to user
+ * space, so a cold read no longer stalls the thread once per chunk; the
+ * thread only waits for (or polls) the end of a chain.
+ *
+ * A short read or send breaks the chain; the sender resumes from the first
+ * unsent byte, re-reading it from the file. When io_uring is unavailable
+ * (other platforms, old kernels, sandboxes that forbid it) the sender
+ * falls back to pread() and TcpSocket::send(), one chunk per step.
+ *
+ * @note Available on POSIX platforms only.
+ */
+class TcpFileSender {
+public:
+  /// Sender configuration.
+  struct Options {
+    /// Bytes per read/send pair (one registered buffer).
+    std::size_t chunk_size = 64 * 1024;
+    /// Read/send pairs per chain; also the number of buffers.
+    std::size_t chain_length = 8;
+    /// Set false to always use the pread()/send() path.
+    bool use_io_uring = true;
+  };
+
+  /// Counters since construction.
+  struct Stats {
+    std::uint64_t bytes_read = 0;
+    std::uint64_t bytes_sent = 0;
+    std::uint64_t chains = 0;  ///< Chains (or fallback chunks) submitted
+    std::uint64_t resumes = 0; ///< Chains cut short by a partial transfer
+  };
+
+  /**
+   * @brief Attach to a connected socket.
+   *
+   * @param socket Connected socket; must outlive the sender.
+   *
+   * Uses the fallback path if a ring cannot be set up or its buffers
+   * cannot be registered (e.g. RLIMIT_MEMLOCK).
+   *
+   * @throws std::invalid_argument if a size is zero, chunk_size exceeds
+   * INT_MAX or chain_length exceeds 1024.
+   */
+  explicit TcpFileSender(TcpSocket &socket, Options options);
+
+  /// Attach with default options.
+  explicit TcpFileSender(TcpSocket &socket)
+      : TcpFileSender(socket, Options{}) {}
+
+  /**
+   * @brief Blocks until all in-flight operations of an abandoned transfer
+   * have completed, since they reference the sender's buffers.
+   */
+  ~TcpFileSender();
+
+  TcpFileSender(const TcpFileSender &) = delete;
+  TcpFileSender &operator=(const TcpFileSender &) = delete;
+
+  /**
+   * @brief Send `length` bytes of `file` starting at `offset`.
+   *
+   * Stops early at end of file. Blocks the calling thread until done.
+   *
+   * @return Bytes sent.
+   *
+   * @throws std::logic_error if a transfer started with start() is active.
+   * @throws std::system_error if a read or send fails.
+   */
+  std::uint64_t sendFile(int file, std::uint64_t offset, std::uint64_t length);
+
+  /**
+   * @brief Begin a transfer driven by advance(), for use from an event
+   * loop: register completionHandle() for readability and call advance()
+   * when it fires.
+   *
+   * @throws std::logic_error if a transfer is already active.
+   * @throws std::system_error if the file cannot be inspected.
+   */
+  void start(int file, std::uint64_t offset, std::uint64_t length);
+
+  /**
+   * @brief Reap finished operations and submit the next chain.
+   *
+   * Never waits on io_uring. On the fallback path it transfers one chunk
+   * using the socket's blocking mode; a non-blocking socket whose send
+   * buffer fills returns false with the unsent part of the chunk kept.
+   * There is no completion descriptor on the fallback path, so the caller
+   * waits for the socket to become writable before calling again.
+   *
+   * @return True once the transfer is complete (or no transfer is active).
+   *
+   * @throws std::system_error if a read or send fails; the transfer is
+   * abandoned.
+   */
+  bool advance();
+
+  /**
+   * @brief Descriptor that becomes readable when advance() has work, or -1
+   * on the fallback path, where the socket's writability drives advance().
+   */
+  [[nodiscard]] int completionHandle() const noexcept;
+
+  /// True while a transfer is active.
+  [[nodiscard]] bool busy() const noexcept { return active_; }
+
+  /// Bytes of the current (or last) transfer sent so far.
+  [[nodiscard]] std::uint64_t sent() const noexcept {
+    return next_offset_ - start_offset_;
+  }
+
+  /// True if transfers use io_uring chains.
+  [[nodiscard]] bool usingIoUring() const noexcept { return ring_ != nullptr; }
+
+  /// Counters since construction.
+  [[nodiscard]] Stats stats() const noexcept { return stats_; }
+
+private:
+  void submitChain();
+  void reap();
+  void finishChain();
+  bool advanceFallback();
+  void waitWritable() const;
+  void drainInFlight() noexcept;
+
+  TcpSocket &socket_;
+  Options options_;
+  std::unique_ptr<detail::IoUring> ring_;
+  std::vector<std::byte> buffers_;
+
+  bool active_ = false;
+  int file_ = -1;
+  std::uint64_t start_offset_ = 0;
+  std::uint64_t next_offset_ = 0; ///< First byte not yet sent
+  std::uint64_t end_offset_ = 0;
+  std::uint64_t read_cap_ = 0; ///< Known-readable bytes after a short read
+
+  /// Per chunk of the in-flight chain: planned length and op results.
+  struct Chunk {
+    std::uint64_t offset = 0;
+    std::size_t length = 0;
+    std::int32_t read_result = 0;
+    std::int32_t send_result = 0;
+  };
+  std::vector<Chunk> chain_;
+  std::size_t in_flight_ = 0;
+
+  /// Fallback: bytes of buffers_ read but not yet sent.
+  std::size_t pending_begin_ = 0;
+  std::size_t pending_end_ = 0;
+
+  Stats stats_;
+};
+
+} // namespace net
@@ -4,11 +4,42 @@
 #include "net/detail/platform_error.h"
 #include "net/detail/socket_flags.h"
 #include "net/detail/socket_handle.h"
+#include "net/protocol/tcp/socket_tap.h"
+#include <cstdint>
+#include <memory>
 #include <stdexcept>
 #include <system_error>
+#include <vector>
 
 namespace net {
 
+/**
+ * @brief Connection-level state of a Multipath TCP socket.
+ *
+ * Mirrors the fields of the kernel's `struct mptcp_info`.
+ */
+struct MptcpInfo {
+  std::uint8_t subflows = 0;          ///< Additional subflows in use
+  std::uint8_t subflows_max = 0;      ///< Path manager subflow limit
+  std::uint8_t add_addr_signal = 0;   ///< Addresses announced to the peer
+  std::uint8_t add_addr_accepted = 0; ///< Peer addresses accepted
+  std::uint8_t local_addr_used = 0;   ///< Local addresses in use
+  std::uint8_t local_addr_max = 0;    ///< Path manager local address limit
+  bool fallback = false;      ///< Connection fell back to plain TCP
+  std::uint32_t token = 0;    ///< Local MPTCP connection token
+  std::uint64_t write_seq = 0; ///< Next data sequence number to send
+  std::uint64_t snd_una = 0;   ///< Oldest unacknowledged data sequence
+  std::uint64_t rcv_nxt = 0;   ///< Next data sequence expected from peer
+};
+
+/**
+ * @brief Addresses of a single MPTCP subflow.
+ */
+struct MptcpSubflow {
+  Endpoint local;  ///< Local address of the subflow
+  Endpoint remote; ///< Remote address of the subflow
+};
+
 /**
  * @brief High-level TCP socket wrapper.
  *
@@ -36,11 +67,17 @@ public:
    * @param address_family IPv4/IPv6
    * @param blocking       Blocking or non-blocking
    * @param inheritable    Whether the handle is inheritable
+   * @param protocol       TCP, or MPTCP to request a multipath socket. MPTCP
+   *                       silently falls back to TCP when the kernel does not
+   *                       support it; check `isMultipath()` afterwards.
+   *
+   * @throws std::invalid_argument if protocol is not a stream protocol.
    */
   explicit TcpSocket(AddressFamily family = AddressFamily::IPV4,
                      BlockingType blocking = BlockingType::Blocking,
-                     InheritableType inheritable = InheritableType::Inheritable)
-      : Socket(family, SocketType::Stream, ProtocolType::TCP, blocking,
+                     InheritableType inheritable = InheritableType::Inheritable,
+                     ProtocolType protocol = ProtocolType::TCP)
+      : Socket(family, SocketType::Stream, streamProtocol(protocol), blocking,
                inheritable) {}
 
   TcpSocket(TcpSocket &&other) noexcept = default;
@@ -79,6 +116,21 @@ public:
    */
   void setReuseAddress(bool enable);
 
+  /**
+   * @brief Enable or disable SO_REUSEPORT.
+   *
+   * Lets several sockets bind the same address and port; on Linux the
+   * kernel then spreads incoming connections across the listeners, which
+   * allows one accepting socket per thread. Must be set before bind().
+   *
+   * @param enable True to share the port, false to disable.
+   *
+   * @throws std::logic_error if socket is invalid.
+   * @throws std::system_error if the option fails or is unsupported
+   * (Windows).
+   */
+  void setReusePort(bool enable);
+
   /**
    * @brief Start listening for incoming connections.
    *
@@ -110,6 +162,8 @@ public:
    * @return Number of bytes actually sent (may be less than buffer size).
    *
    * @throws std::system_error on failure.
+   *
+   * @note The sent bytes are reported to the installed tap, if any.
    */
   [[nodiscard]]
   std::size_t send(std::span<const std::byte> data);
@@ -122,10 +176,45 @@ public:
    * @return Number of bytes received. Returns 0 if peer closed the connection.
    *
    * @throws std::system_error on failure.
+   *
+   * @note The received bytes are reported to the installed tap, if any.
    */
   [[nodiscard]]
   std::size_t receive(std::span<std::byte> buffer);
 
+  /**
+   * @brief Number of bytes that can be received without blocking (FIONREAD).
+   *
+   * @return Bytes currently queued in the receive buffer.
+   *
+   * @throws std::logic_error if socket is invalid.
+   * @throws std::system_error if the query fails.
+   */
+  [[nodiscard]] std::size_t availableBytes() const;
+
+  /**
+   * @brief Set the receive low watermark (SO_RCVLOWAT).
+   *
+   * Readiness notification (poll/epoll) and blocking receives wait until at
+   * least this many bytes are queued, so a framing layer that knows how much
+   * of a message is still missing can sleep through the partial segments.
+   * End of stream and errors are still reported immediately.
+   *
+   * @param bytes Minimum number of queued bytes; 0 is treated as 1.
+   *
+   * @throws std::logic_error if socket is invalid.
+   * @throws std::system_error if the option is unsupported or rejected.
+   */
+  void setReceiveLowWatermark(std::size_t bytes);
+
+  /**
+   * @brief Current receive low watermark (SO_RCVLOWAT).
+   *
+   * @throws std::logic_error if socket is invalid.
+   * @throws std::system_error if the query fails.
+   */
+  [[nodiscard]] std::size_t receiveLowWatermark() const;
+
   /**
    * @brief Retrieve the local endpoint the socket is bound to.
    *
@@ -136,7 +225,73 @@ public:
    */
   Endpoint localEndpoint() const;
 
+  /**
+   * @brief Retrieve the endpoint of the connected peer.
+   *
+   * @return Endpoint representing the remote address and port.
+   *
+   * @throws std::logic_error if socket is invalid.
+   * @throws std::system_error if getpeername fails (e.g. not connected).
+   */
+  Endpoint remoteEndpoint() const;
+
+  /**
+   * @brief Install an observer for the bytes sent and received.
+   *
+   * Without a tap, send() and receive() pay a single branch. The tap moves
+   * with the socket; sockets returned by accept() start without one.
+   *
+   * @param tap Observer to install, or nullptr to remove the current one.
+   */
+  void setTap(std::shared_ptr<SocketTap> tap) noexcept {
+    tap_ = std::move(tap);
+  }
+
+  /// The installed tap, or nullptr.
+  [[nodiscard]] SocketTap *tap() const noexcept { return tap_.get(); }
+
+  /**
+   * @brief Checks whether this is a Multipath TCP socket.
+   *
+   * True when the socket was created with ProtocolType::MPTCP and the kernel
+   * accepted it. A connection may still fall back to TCP during the handshake
+   * if the peer does not speak MPTCP; see `MptcpInfo::fallback`.
+   */
+  [[nodiscard]] bool isMultipath() const noexcept {
+    return protocol_type() == ProtocolType::MPTCP;
+  }
+
+  /**
+   * @brief Query connection-level MPTCP state (MPTCP_INFO).
+   *
+   * @return Subflow counters and sequence state of the connection.
+   *
+   * @throws std::logic_error if socket is invalid or not an MPTCP socket.
+   * @throws std::system_error if the query fails.
+   */
+  [[nodiscard]] MptcpInfo multipathInfo() const;
+
+  /**
+   * @brief List the local/remote addresses of every MPTCP subflow
+   * (MPTCP_SUBFLOW_ADDRS).
+   *
+   * @return One entry per subflow, including the initial one.
+   *
+   * @throws std::logic_error if socket is invalid or not an MPTCP socket.
+   * @throws std::system_error if the query fails.
+   */
+  [[nodiscard]] std::vector<MptcpSubflow> subflows() const;
+
 private:
+  friend class TcpAcceptor;
+
+  /**
+   * @brief Validates the protocol passed to the public constructor.
+   *
+   * @throws std::invalid_argument for non-stream protocols.
+   */
+  static ProtocolType streamProtocol(ProtocolType protocol);
+
   /**
    * @brief Internal constructor used by accept().
    *
@@ -146,11 +301,28 @@ private:
    * @param family Address family (IPv4/IPv6).
    * @param blocking Blocking mode.
    * @param inheritable Handle inheritable flag.
+   * @param protocol Protocol of the listening socket (TCP/MPTCP).
+   * @param configured True if accept4() already applied the flags.
    */
   TcpSocket(Handle handle, AddressFamily family, BlockingType blocking,
-            InheritableType inheritable)
-      : Socket(handle, family, SocketType::Stream, ProtocolType::TCP, blocking,
-               inheritable) {}
+            InheritableType inheritable, ProtocolType protocol,
+            bool configured = false)
+      : Socket(handle, family, SocketType::Stream, protocol, blocking,
+               inheritable, configured) {}
+
+  /**
+   * @brief accept() on `listener`, applying the blocking and inheritable
+   * flags atomically with accept4() when that backend is selected.
+   *
+   * @param configured Set to true if accept4() applied the flags.
+   *
+   * @return The new handle, or Invalid with the error in errno.
+   */
+  static Handle acceptHandle(Handle listener, Endpoint &peer,
+                             BlockingType blocking,
+                             InheritableType inheritable, bool &configured);
+
+  std::shared_ptr<SocketTap> tap_;
 };
 
 } // namespace net
@@ -0,0 +1,108 @@
+#pragma once
+#include "net/protocol/tcp/tcp_socket.h"
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+namespace net {
+
+/**
+ * @brief Bytes produced by one `TcpZeroCopyReceiver::receive()` call.
+ *
+ * `mapped` precedes `copied` in stream order. Both views stay valid until
+ * the next call to receive() or the receiver's destruction.
+ */
+struct ZeroCopyChunk {
+  std::span<const std::byte> mapped; ///< Pages mapped from the socket
+  std::span<const std::byte> copied; ///< Remainder copied with recv()
+
+  /// Total number of stream bytes in the chunk.
+  [[nodiscard]] std::size_t size() const noexcept {
+    return mapped.size() + copied.size();
+  }
+
+  /// True once the peer has closed the connection and no data is left.
+  [[nodiscard]] bool empty() const noexcept { return size() == 0; }
+};
+
+/**
+ * @brief Memory-mapped receive path using TCP_ZEROCOPY_RECEIVE.
+ *
+ * Reserves a read-only mapping of the socket and asks the kernel to map
+ * page-aligned payload straight into it, so bulk data arrives without a
+ * kernel-to-user copy. Data the kernel cannot map (less than a page, or the
+ * unaligned tail of a segment) is read with a regular copying receive.
+ *
+ * On platforms or kernels without TCP_ZEROCOPY_RECEIVE every chunk is
+ * copied; `zeroCopyEnabled()` reports which path is active.
+ */
+class TcpZeroCopyReceiver {
+public:
+  /// Counters describing the receive path so far.
+  struct Stats {
+    std::uint64_t mapped_bytes = 0; ///< Bytes delivered through the mapping
+    std::uint64_t copied_bytes = 0; ///< Bytes delivered by recv()
+  };
+
+  /**
+   * @brief Attach to a connected socket.
+   *
+   * @param socket Connected socket; must outlive the receiver.
+   * @param region_size Bytes mapped per call, rounded up to whole pages.
+   * @param copy_size Size of the buffer for copied remainders.
+   *
+   * @throws std::invalid_argument if a size is zero.
+   */
+  explicit TcpZeroCopyReceiver(TcpSocket &socket,
+                               std::size_t region_size = 2 * 1024 * 1024,
+                               std::size_t copy_size = 64 * 1024);
+
+  ~TcpZeroCopyReceiver();
+
+  TcpZeroCopyReceiver(const TcpZeroCopyReceiver &) = delete;
+  TcpZeroCopyReceiver &operator=(const TcpZeroCopyReceiver &) = delete;
+
+  /**
+   * @brief Receive the next chunk of the stream.
+   *
+   * Waits for data according to the socket's blocking mode.
+   *
+   * @return Mapped and copied bytes; empty once the peer closed the
+   * connection.
+   *
+   * @throws std::system_error on failure (including EAGAIN on a
+   * non-blocking socket without data).
+   */
+  [[nodiscard]] ZeroCopyChunk receive();
+
+  /**
+   * @brief Checks whether the kernel accepted the mapped receive path.
+   */
+  [[nodiscard]] bool zeroCopyEnabled() const noexcept {
+    return region_ != nullptr;
+  }
+
+  /**
+   * @brief Snapshot of receive counters.
+   */
+  [[nodiscard]] Stats stats() const noexcept { return stats_; }
+
+private:
+  /**
+   * @brief One TCP_ZEROCOPY_RECEIVE attempt.
+   *
+   * @return True if the kernel mapped or announced data.
+   */
+  bool tryMap(ZeroCopyChunk &chunk);
+
+  void disableMapping() noexcept;
+
+  TcpSocket &socket_;
+  std::byte *region_ = nullptr;
+  std::size_t region_size_ = 0;
+  std::vector<std::byte> copy_buffer_;
+  Stats stats_;
+};
+
+} // namespace net
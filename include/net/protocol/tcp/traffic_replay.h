@@ -0,0 +1,131 @@
+#pragma once
+#include "net/core/endpoint.h"
+#include "net/core/pcapng_reader.h"
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string>
+#include <vector>
+
+namespace net {
+
+/// One application write in a recorded session.
+struct RecordedMessage {
+  /// Time since the session's first packet.
+  std::chrono::nanoseconds offset{0};
+  /// True if the client sent it, false if the server did.
+  bool from_client = true;
+  std::vector<std::byte> payload;
+};
+
+/// A reassembled TCP connection from a capture.
+struct RecordedSession {
+  Endpoint client;
+  Endpoint server;
+  /// Time of the first packet since the earliest session in the capture.
+  std::chrono::nanoseconds start{0};
+  /// Payload in stream order, both directions interleaved as captured.
+  std::vector<RecordedMessage> messages;
+
+  /// Total payload bytes sent by one side.
+  [[nodiscard]] std::uint64_t bytesFrom(bool client_side) const noexcept;
+};
+
+/**
+ * @brief Reassemble the TCP sessions in a capture.
+ *
+ * Understands raw IP (LINKTYPE_RAW, as written by TcpCaptureTap), Ethernet
+ * and Linux cooked captures. Each direction is reassembled by sequence
+ * number: retransmitted bytes are dropped and reordered segments wait for
+ * the gap to fill. Segments captured at the same instant in the same
+ * direction are merged back into one message, undoing the splitting of
+ * large writes. The client is the side that sent the SYN or, if the
+ * handshake was not captured, the first side to send payload. A SYN on a
+ * finished four-tuple starts a new session.
+ *
+ * @return Sessions with payload, ordered by start time.
+ *
+ * @throws std::runtime_error on a malformed capture.
+ */
+std::vector<RecordedSession> extractTcpSessions(PcapngReader &reader);
+
+/// Open `path` and extract its TCP sessions.
+std::vector<RecordedSession> loadTcpSessions(const std::string &path);
+
+/**
+ * @brief Replays recorded client traffic against a server and measures
+ * response latency.
+ *
+ * Every session opens its own non-blocking `TcpSocket` to the target at
+ * its recorded start time and sends the client's writes with their
+ * original sizes and spacing, scaled by `speed`. Causality is kept: a
+ * write recorded after the client had received N response bytes waits
+ * until the server has sent N bytes, so request/response protocols never
+ * run ahead of the server. Server payload is counted, not compared.
+ *
+ * A request is a run of consecutive client writes; its latency is the
+ * time from its first write to the last byte of the server's recorded
+ * answer. All sessions run on one EventLoop on the calling thread.
+ *
+ * @note Available on POSIX platforms only.
+ */
+class TrafficReplayer {
+public:
+  /// Replay configuration.
+  struct Options {
+    /// Timing scale: 1 keeps the recorded pace, 10 runs ten times faster,
+    /// 0 sends as soon as causality allows.
+    double speed = 1.0;
+    /// A session making no progress for this long fails.
+    std::chrono::milliseconds idle_timeout{10000};
+  };
+
+  /// Outcome of one run().
+  struct Report {
+    std::size_t sessions = 0;
+    std::size_t completed = 0; ///< Sessions that saw every response byte
+    std::size_t failed = 0;    ///< Refused, reset, closed early or idle
+    /// Writes sent that expect a response; those answered are timed.
+    std::uint64_t requests = 0;
+    std::uint64_t bytes_sent = 0;
+    std::uint64_t bytes_received = 0;
+    std::chrono::nanoseconds elapsed{0};
+    /// Per-request latencies, sorted ascending.
+    std::vector<std::chrono::nanoseconds> latencies;
+
+    /**
+     * @brief Nearest-rank latency percentile.
+     *
+     * @param fraction Percentile as a fraction, e.g. 0.99.
+     *
+     * @return The latency, or zero when nothing was measured.
+     */
+    [[nodiscard]] std::chrono::nanoseconds
+    percentile(double fraction) const noexcept;
+  };
+
+  /**
+   * @brief Replay against `target`.
+   *
+   * @throws std::invalid_argument if speed is negative or the timeout is
+   * not positive.
+   */
+  TrafficReplayer(const Endpoint &target, Options options);
+
+  /// Replay at the recorded pace.
+  explicit TrafficReplayer(const Endpoint &target)
+      : TrafficReplayer(target, Options{}) {}
+
+  /**
+   * @brief Replay `sessions` and wait until every one has completed or
+   * failed.
+   */
+  Report run(std::span<const RecordedSession> sessions) const;
+
+private:
+  Endpoint target_;
+  Options options_;
+};
+
+} // namespace net
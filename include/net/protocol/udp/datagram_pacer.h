@@ -0,0 +1,98 @@
+#pragma once
+#include "net/core/endpoint.h"
+#include "net/protocol/udp/udp_socket.h"
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+
+namespace net {
+
+/**
+ * @brief Spreads outgoing datagrams evenly at a configured byte rate.
+ *
+ * Each datagram is assigned a departure time that follows the previous one
+ * by `size / rate`. In Kernel mode the time is handed to the qdisc with
+ * SO_TXTIME so `sendTo()` never blocks; in UserSpace mode the pacer waits
+ * until the departure time itself before sending.
+ *
+ * Kernel mode only paces when the egress interface has an `fq` qdisc, or
+ * an `etf` qdisc configured for CLOCK_MONOTONIC. Under any other qdisc
+ * the kernel ignores the transmit time and datagrams leave immediately,
+ * unpaced; use UserSpace mode where the qdisc cannot be controlled.
+ */
+class DatagramPacer {
+public:
+  using Clock = std::chrono::steady_clock;
+
+  /// How departure times are enforced.
+  enum class Mode : std::uint8_t {
+    Kernel,   ///< SO_TXTIME with CLOCK_MONOTONIC, enforced by the qdisc
+    UserSpace ///< Sleep/spin in the caller until the departure time
+  };
+
+  /**
+   * @brief Construct a pacer for the given socket.
+   *
+   * Kernel mode enables SO_TXTIME on the socket and silently degrades to
+   * UserSpace mode where the option is unavailable; check `mode()`. A
+   * socket already using another transmit clock is switched to
+   * TransmitClock::Monotonic, the clock departure times are taken from.
+   *
+   * @param socket Socket to send on; must outlive the pacer.
+   * @param bytes_per_second Target rate in payload bytes per second.
+   * @param mode Preferred pacing mode.
+   *
+   * @throws std::invalid_argument if bytes_per_second is zero.
+   * @throws std::system_error if the socket's transmit clock cannot be
+   * switched.
+   */
+  DatagramPacer(UdpSocket &socket, std::uint64_t bytes_per_second,
+                Mode mode = Mode::Kernel);
+
+  /**
+   * @brief Send a datagram at its paced departure time.
+   *
+   * @param data Datagram payload.
+   * @param destination Remote endpoint.
+   *
+   * @return Number of bytes sent.
+   *
+   * @throws std::system_error on failure.
+   */
+  [[nodiscard]]
+  std::size_t sendTo(std::span<const std::byte> data,
+                     const Endpoint &destination);
+
+  /**
+   * @brief Change the target rate; applies from the next datagram.
+   *
+   * @throws std::invalid_argument if bytes_per_second is zero.
+   */
+  void setRate(std::uint64_t bytes_per_second);
+
+  /**
+   * @brief Allow up to `burst` worth of idle time to be spent as a burst.
+   *
+   * By default an idle pacer restarts at the current time, so no burst is
+   * ever sent faster than the configured rate.
+   */
+  void setMaxBurst(std::chrono::nanoseconds burst) noexcept { burst_ = burst; }
+
+  [[nodiscard]] std::uint64_t rate() const noexcept { return rate_; }
+  [[nodiscard]] Mode mode() const noexcept { return mode_; }
+
+private:
+  /**
+   * @brief Reserve the next departure slot for a datagram of `bytes`.
+   */
+  Clock::time_point reserve(std::size_t bytes);
+
+  UdpSocket &socket_;
+  std::uint64_t rate_;
+  Mode mode_;
+  std::chrono::nanoseconds burst_{0};
+  Clock::time_point next_{};
+};
+
+} // namespace net
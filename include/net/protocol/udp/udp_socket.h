@@ -0,0 +1,338 @@
+#pragma once
+#include "net/core/endpoint.h"
+#include "net/core/socket.h"
+#include "net/detail/ip_address.h"
+#include "net/detail/platform_error.h"
+#include "net/detail/socket_flags.h"
+#include "net/detail/socket_handle.h"
+#include <chrono>
+#include <cstddef>
+#include <span>
+#include <stdexcept>
+#include <system_error>
+
+namespace net {
+
+/**
+ * @brief One slot of a batched datagram receive.
+ *
+ * The caller provides `buffer`; `receiveBatch()` fills in the remaining
+ * fields for every slot it reports as received.
+ */
+struct ReceivedDatagram {
+  std::span<std::byte> buffer; ///< Storage for the payload (caller-owned)
+  std::size_t size = 0;        ///< Number of payload bytes stored in buffer
+  Endpoint peer;               ///< Sender of the datagram
+  bool truncated = false;      ///< Datagram was larger than buffer
+};
+
+/**
+ * @brief Clock that `UdpSocket::sendAt()` transmit times refer to.
+ */
+enum class TransmitClock : std::uint8_t {
+  Monotonic, ///< CLOCK_MONOTONIC, as paced by the `fq` qdisc
+  Tai        ///< CLOCK_TAI, as required by the `etf` qdisc
+};
+
+/**
+ * @brief High-level UDP socket wrapper.
+ *
+ * Provides a type-safe interface for UDP datagram sockets on top of
+ * the platform-independent base `Socket` class. Supports bind, connect,
+ * addressed and connected send/receive, multicast group membership
+ * (any-source and source-specific) and batched receive.
+ */
+class UdpSocket : public detail::Socket {
+
+public:
+  using AddressFamily = detail::SocketFlags::AddressFamily;
+  using BlockingType = detail::SocketFlags::BlockingType;
+  using InheritableType = detail::SocketFlags::InheritableType;
+  using ShutdownType = detail::SocketFlags::ShutdownType;
+  using SocketType = detail::SocketFlags::SocketType;
+  using ProtocolType = detail::SocketFlags::ProtocolType;
+  using Socket = detail::Socket;
+  using Handle = detail::SocketDescriptorHandle::Handle;
+
+  /**
+   * @brief Construct a UDP socket.
+   *
+   * Creates an unbound UDP datagram socket.
+   *
+   * @param address_family IPv4/IPv6
+   * @param blocking       Blocking or non-blocking
+   * @param inheritable    Whether the handle is inheritable
+   */
+  explicit UdpSocket(AddressFamily family = AddressFamily::IPV4,
+                     BlockingType blocking = BlockingType::Blocking,
+                     InheritableType inheritable = InheritableType::Inheritable)
+      : Socket(family, SocketType::Dgram, ProtocolType::UDP, blocking,
+               inheritable) {}
+
+  UdpSocket(UdpSocket &&other) noexcept = default;
+  UdpSocket &operator=(UdpSocket &&other) noexcept = default;
+
+  UdpSocket(const UdpSocket &) = delete;
+  UdpSocket &operator=(const UdpSocket &) = delete;
+
+  /**
+   * @brief Destructor closes the socket if valid.
+   */
+  ~UdpSocket() = default;
+
+  /**
+   * @brief Bind socket to a local endpoint.
+   *
+   * SO_REUSEADDR is left as configured; receivers that share a multicast
+   * port with others on the same host call `setReuseAddress(true)` first.
+   *
+   * @param ep Local endpoint (IP + port).
+   *
+   * @throws std::system_error on failure.
+   */
+  void bind(const Endpoint &ep);
+
+  /**
+   * @brief Set the default destination and filter incoming datagrams to it.
+   *
+   * @param ep Remote endpoint (IP + port).
+   *
+   * @throws std::system_error on failure.
+   */
+  void connect(const Endpoint &ep);
+
+  /**
+   * @brief Enable or disable SO_REUSEADDR.
+   *
+   * @param enable True to allow reuse, false to disable.
+   */
+  void setReuseAddress(bool enable);
+
+  /**
+   * @brief Set the kernel receive buffer size (SO_RCVBUF).
+   *
+   * High-rate receivers need a large buffer to absorb bursts between reads.
+   *
+   * @param bytes Requested size in bytes (the kernel may adjust it).
+   *
+   * @throws std::system_error on failure.
+   */
+  void setReceiveBufferSize(int bytes);
+
+  /**
+   * @brief Send a datagram on a connected socket.
+   *
+   * @param data Datagram payload.
+   *
+   * @return Number of bytes sent.
+   *
+   * @throws std::system_error on failure.
+   */
+  [[nodiscard]]
+  std::size_t send(std::span<const std::byte> data);
+
+  /**
+   * @brief Send a datagram to the given endpoint.
+   *
+   * @param data Datagram payload.
+   * @param destination Remote endpoint.
+   *
+   * @return Number of bytes sent.
+   *
+   * @throws std::system_error on failure.
+   */
+  [[nodiscard]]
+  std::size_t sendTo(std::span<const std::byte> data,
+                     const Endpoint &destination);
+
+  /**
+   * @brief Receive a datagram on a connected socket.
+   *
+   * @param buffer Buffer to store the payload; excess bytes are discarded.
+   *
+   * @return Number of bytes received.
+   *
+   * @throws std::system_error on failure.
+   */
+  [[nodiscard]]
+  std::size_t receive(std::span<std::byte> buffer);
+
+  /**
+   * @brief Receive a datagram and report its sender.
+   *
+   * @param buffer Buffer to store the payload; excess bytes are discarded.
+   * @param peer Endpoint receiving the sender address.
+   *
+   * @return Number of bytes received.
+   *
+   * @throws std::system_error on failure.
+   */
+  [[nodiscard]]
+  std::size_t receiveFrom(std::span<std::byte> buffer, Endpoint &peer);
+
+  /**
+   * @brief Receive up to `datagrams.size()` datagrams in one call.
+   *
+   * Uses recvmmsg() on Linux; elsewhere falls back to repeated recvfrom()
+   * calls. Waits only for the first datagram (as blocking as the socket is)
+   * and then takes whatever else is already queued.
+   *
+   * @param datagrams Slots with caller-provided buffers.
+   *
+   * @return Number of leading slots that were filled.
+   *
+   * @throws std::system_error if no datagram could be received.
+   */
+  [[nodiscard]]
+  std::size_t receiveBatch(std::span<ReceivedDatagram> datagrams);
+
+  /**
+   * @brief Retrieve the local endpoint the socket is bound to.
+   *
+   * @return Endpoint representing the local address and port.
+   *
+   * @throws std::logic_error if socket is invalid.
+   * @throws std::system_error if getsockname fails.
+   */
+  Endpoint localEndpoint() const;
+
+  /**
+   * @brief Join an any-source multicast group
+   * (IP_ADD_MEMBERSHIP / IPV6_JOIN_GROUP).
+   *
+   * @param group Multicast group address; must match the socket family.
+   * @param interface_index Interface to join on (0 lets the kernel choose).
+   *
+   * @throws std::invalid_argument if the group family does not match.
+   * @throws std::system_error on failure.
+   */
+  void joinGroup(const detail::IpAddress &group, unsigned interface_index = 0);
+
+  /**
+   * @brief Leave an any-source multicast group.
+   *
+   * @param group Multicast group address previously joined.
+   * @param interface_index Interface the group was joined on.
+   *
+   * @throws std::system_error on failure.
+   */
+  void leaveGroup(const detail::IpAddress &group, unsigned interface_index = 0);
+
+  /**
+   * @brief Join a source-specific multicast channel
+   * (MCAST_JOIN_SOURCE_GROUP).
+   *
+   * @param group Multicast group address.
+   * @param source Only datagrams from this sender are delivered.
+   * @param interface_index Interface to join on (0 lets the kernel choose).
+   *
+   * @throws std::invalid_argument if the address families do not match.
+   * @throws std::system_error on failure.
+   */
+  void joinSourceGroup(const detail::IpAddress &group,
+                       const detail::IpAddress &source,
+                       unsigned interface_index = 0);
+
+  /**
+   * @brief Leave a source-specific multicast channel.
+   *
+   * @throws std::system_error on failure.
+   */
+  void leaveSourceGroup(const detail::IpAddress &group,
+                        const detail::IpAddress &source,
+                        unsigned interface_index = 0);
+
+  /**
+   * @brief Select the interface used for outgoing multicast datagrams.
+   *
+   * @param interface_index Interface index (0 restores the default route).
+   *
+   * @throws std::system_error on failure.
+   */
+  void setMulticastInterface(unsigned interface_index);
+
+  /**
+   * @brief Enable or disable local delivery of our own multicast datagrams.
+   *
+   * @param enable True to loop sent datagrams back to local members.
+   *
+   * @throws std::system_error on failure.
+   */
+  void setMulticastLoopback(bool enable);
+
+  /**
+   * @brief Set the TTL (IPv4) or hop limit (IPv6) of outgoing multicast.
+   *
+   * @param hops 0-255; 1 keeps traffic on the local network.
+   *
+   * @throws std::invalid_argument if hops is out of range.
+   * @throws std::system_error on failure.
+   */
+  void setMulticastTtl(int hops);
+
+  /**
+   * @brief Enable per-datagram transmit times (SO_TXTIME).
+   *
+   * Once enabled, `sendAt()` attaches a departure time to each datagram and
+   * the egress qdisc holds it until then. Only the `fq` (monotonic clock) and
+   * `etf` (TAI clock) qdiscs honour the time; others send immediately.
+   *
+   * @param clock Clock the transmit times are expressed in.
+   * @param deadline_mode Let `etf` send early rather than drop late packets.
+   *
+   * @throws std::system_error if unsupported (non-Linux or kernel < 4.19).
+   */
+  void enableTransmitTime(TransmitClock clock = TransmitClock::Monotonic,
+                          bool deadline_mode = false);
+
+  /**
+   * @brief Checks whether `enableTransmitTime()` succeeded on this socket.
+   */
+  [[nodiscard]] bool transmitTimeEnabled() const noexcept {
+    return txtime_enabled_;
+  }
+
+  /**
+   * @brief Clock that `sendAt()` departure times refer to; meaningful only
+   * while `transmitTimeEnabled()`.
+   */
+  [[nodiscard]] TransmitClock transmitClock() const noexcept {
+    return txtime_clock_;
+  }
+
+  /**
+   * @brief Send a datagram scheduled to leave at the given time.
+   *
+   * @param data Datagram payload.
+   * @param destination Remote endpoint.
+   * @param departure Transmit time since the epoch of the configured clock.
+   *
+   * @return Number of bytes queued.
+   *
+   * @throws std::logic_error if transmit times are not enabled.
+   * @throws std::system_error on failure.
+   */
+  [[nodiscard]]
+  std::size_t sendAt(std::span<const std::byte> data,
+                     const Endpoint &destination,
+                     std::chrono::nanoseconds departure);
+
+private:
+  /**
+   * @brief setsockopt() wrapper that throws std::system_error on failure.
+   */
+  void setOption(int level, int name, const void *value,
+                 detail::socket_length_t length, const char *what);
+
+  /**
+   * @brief Shared implementation of (MCAST_)JOIN/LEAVE requests.
+   */
+  void changeMembership(const detail::IpAddress &group,
+                        const detail::IpAddress *source,
+                        unsigned interface_index, bool join);
+
+  bool txtime_enabled_ = false; ///< SO_TXTIME configured on the socket
+  TransmitClock txtime_clock_ = TransmitClock::Monotonic; ///< Its clock
+};
+
+} // namespace net
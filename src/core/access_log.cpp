@@ -0,0 +1,290 @@
+#include "net/core/access_log.h"
+#include <algorithm>
+#include <cerrno>
+#include <charconv>
+#include <cstring>
+#include <stdexcept>
+
+#include <unistd.h>
+
+namespace net {
+
+namespace {
+
+std::atomic<std::uint64_t> next_logger_id{1};
+
+/// Last ring used by this thread for each logger it has logged to.
+struct ProducerCacheEntry {
+  std::uint64_t logger = 0;
+  void *producer = nullptr;
+};
+thread_local std::vector<ProducerCacheEntry> producer_cache;
+
+/// Days since 1970-01-01 to a civil date (Howard Hinnant's algorithm).
+void civilFromDays(std::int64_t days, int &year, unsigned &month,
+                   unsigned &day) noexcept {
+  days += 719468;
+  const std::int64_t era = (days >= 0 ? days : days - 146096) / 146097;
+  const auto doe = static_cast<unsigned>(days - era * 146097);
+  const unsigned yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+  const unsigned doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+  const unsigned mp = (5 * doy + 2) / 153;
+  day = doy - (153 * mp + 2) / 5 + 1;
+  month = mp < 10 ? mp + 3 : mp - 9;
+  year = static_cast<int>(yoe + era * 400 + (month <= 2));
+}
+
+char *putDigits(char *out, std::uint64_t value, int width) noexcept {
+  for (int i = width - 1; i >= 0; --i) {
+    out[i] = static_cast<char>('0' + value % 10);
+    value /= 10;
+  }
+  return out + width;
+}
+
+char *putNumber(char *out, std::uint64_t value) noexcept {
+  // Callers reserve 20 characters, enough for any 64-bit value.
+  return std::to_chars(out, out + 20, value).ptr;
+}
+
+char *putText(char *out, std::string_view text) noexcept {
+  std::memcpy(out, text.data(), text.size());
+  return out + text.size();
+}
+
+/// Unbounded formatting into a buffer of at least max_line_length.
+std::size_t formatLine(const AccessRecord &record, char *const start) noexcept {
+  char *out = start;
+
+  std::int64_t seconds = record.timestamp_ns / 1'000'000'000;
+  std::int64_t nanos = record.timestamp_ns % 1'000'000'000;
+  if (nanos < 0) {
+    nanos += 1'000'000'000;
+    --seconds;
+  }
+  std::int64_t days = seconds / 86400;
+  std::int64_t of_day = seconds % 86400;
+  if (of_day < 0) {
+    of_day += 86400;
+    --days;
+  }
+  int year = 0;
+  unsigned month = 0;
+  unsigned day = 0;
+  civilFromDays(days, year, month, day);
+
+  out = putDigits(out, static_cast<std::uint64_t>(std::clamp(year, 0, 9999)),
+                  4);
+  *out++ = '-';
+  out = putDigits(out, month, 2);
+  *out++ = '-';
+  out = putDigits(out, day, 2);
+  *out++ = 'T';
+  out = putDigits(out, static_cast<std::uint64_t>(of_day / 3600), 2);
+  *out++ = ':';
+  out = putDigits(out, static_cast<std::uint64_t>(of_day / 60 % 60), 2);
+  *out++ = ':';
+  out = putDigits(out, static_cast<std::uint64_t>(of_day % 60), 2);
+  *out++ = '.';
+  out = putDigits(out, static_cast<std::uint64_t>(nanos / 1000), 6);
+  *out++ = 'Z';
+  *out++ = ' ';
+
+  const std::size_t peer = record.peer.format_to(
+      std::span(out, Endpoint::max_string_length));
+  if (peer == 0) {
+    *out++ = '-';
+  }
+  out += peer;
+
+  out = putText(out, " \"");
+  for (char c : record.targetView()) {
+    // Keep one record per line and the quoting unambiguous.
+    const bool printable = c >= 0x20 && c < 0x7f && c != '"' && c != '\\';
+    *out++ = printable ? c : '?';
+  }
+  out = putText(out, "\" ");
+  out = putNumber(out, record.status);
+  *out++ = ' ';
+  out = putNumber(out, record.duration_us);
+  out = putText(out, "us in=");
+  out = putNumber(out, record.bytes_in);
+  out = putText(out, " out=");
+  out = putNumber(out, record.bytes_out);
+  *out++ = '\n';
+  return static_cast<std::size_t>(out - start);
+}
+
+} // namespace
+
+void AccessRecord::setTarget(std::string_view text) noexcept {
+  target.fill('\0');
+  const std::size_t length = std::min(text.size(), target.size());
+  std::memcpy(target.data(), text.data(), length);
+}
+
+std::string_view AccessRecord::targetView() const noexcept {
+  const auto *end = std::find(target.begin(), target.end(), '\0');
+  return {target.data(), static_cast<std::size_t>(end - target.begin())};
+}
+
+AccessLogger::AccessLogger(int fd, Options options)
+    : fd_(fd), options_(options), id_(next_logger_id.fetch_add(1)) {
+  if (options_.ring_capacity == 0) {
+    throw std::invalid_argument("AccessLogger ring_capacity must be positive");
+  }
+  if (options_.batch_bytes < max_line_length) {
+    throw std::invalid_argument("AccessLogger batch_bytes is too small");
+  }
+  batch_.resize(options_.batch_bytes);
+  thread_ = std::thread([this] { run(); });
+}
+
+AccessLogger::~AccessLogger() {
+  {
+    std::lock_guard lock(mutex_);
+    stopping_ = true;
+  }
+  wake_.notify_one();
+  thread_.join();
+}
+
+AccessLogger::Producer &AccessLogger::localProducer() {
+  if (!producer_cache.empty() && producer_cache.back().logger == id_) {
+    return *static_cast<Producer *>(producer_cache.back().producer);
+  }
+  for (auto &entry : producer_cache) {
+    if (entry.logger == id_) {
+      std::swap(entry, producer_cache.back());
+      return *static_cast<Producer *>(producer_cache.back().producer);
+    }
+  }
+
+  // First record from this thread: register a ring. It lives as long as
+  // the logger, so records survive the thread's exit.
+  auto producer = std::make_unique<Producer>(options_.ring_capacity);
+  Producer &registered = *producer;
+  {
+    std::lock_guard lock(mutex_);
+    producers_.push_back(std::move(producer));
+  }
+  producer_cache.push_back({id_, &registered});
+  return registered;
+}
+
+bool AccessLogger::log(const AccessRecord &record) {
+  Producer &producer = localProducer();
+  AccessRecord copy = record;
+  if (copy.timestamp_ns == 0) {
+    copy.timestamp_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                            std::chrono::system_clock::now().time_since_epoch())
+                            .count();
+  }
+  // Counters have a single writer, so plain load/store suffices.
+  if (!producer.ring.push(std::move(copy))) {
+    producer.dropped.store(
+        producer.dropped.load(std::memory_order_relaxed) + 1,
+        std::memory_order_relaxed);
+    return false;
+  }
+  producer.logged.store(producer.logged.load(std::memory_order_relaxed) + 1,
+                        std::memory_order_relaxed);
+  return true;
+}
+
+void AccessLogger::flush() {
+  std::unique_lock lock(mutex_);
+  const std::uint64_t ticket = ++flush_requested_;
+  wake_.notify_one();
+  flushed_cv_.wait(lock, [&] { return flush_done_ >= ticket; });
+}
+
+AccessLogger::Stats AccessLogger::stats() const noexcept {
+  Stats stats;
+  {
+    std::lock_guard lock(mutex_);
+    for (const auto &producer : producers_) {
+      stats.logged += producer->logged.load(std::memory_order_relaxed);
+      stats.dropped += producer->dropped.load(std::memory_order_relaxed);
+    }
+  }
+  stats.written = written_.load(std::memory_order_relaxed);
+  stats.writes = writes_.load(std::memory_order_relaxed);
+  stats.write_errors = write_errors_.load(std::memory_order_relaxed);
+  return stats;
+}
+
+std::size_t AccessLogger::format(const AccessRecord &record,
+                                 std::span<char> out) noexcept {
+  if (out.size() >= max_line_length) {
+    return formatLine(record, out.data());
+  }
+  char line[max_line_length];
+  const std::size_t length = formatLine(record, line);
+  if (length > out.size()) {
+    return 0;
+  }
+  std::memcpy(out.data(), line, length);
+  return length;
+}
+
+void AccessLogger::run() {
+  std::unique_lock lock(mutex_);
+  for (;;) {
+    wake_.wait_for(lock, options_.flush_interval, [&] {
+      return stopping_ || flush_done_ != flush_requested_;
+    });
+    const std::uint64_t requested = flush_requested_;
+    const bool stop = stopping_;
+    draining_.clear();
+    for (const auto &producer : producers_) {
+      draining_.push_back(producer.get());
+    }
+    lock.unlock();
+
+    drain();
+    writeBatch();
+
+    lock.lock();
+    flush_done_ = requested;
+    flushed_cv_.notify_all();
+    if (stop) {
+      return;
+    }
+  }
+}
+
+void AccessLogger::drain() {
+  for (Producer *producer : draining_) {
+    while (auto record = producer->ring.pop()) {
+      if (batch_.size() - batch_used_ < max_line_length) {
+        writeBatch();
+      }
+      batch_used_ += formatLine(*record, batch_.data() + batch_used_);
+      ++batch_records_;
+    }
+  }
+}
+
+void AccessLogger::writeBatch() {
+  std::size_t offset = 0;
+  while (offset < batch_used_) {
+    const ssize_t n = ::write(fd_, batch_.data() + offset, batch_used_ - offset);
+    if (n < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      write_errors_.fetch_add(1, std::memory_order_relaxed);
+      break; // the rest of the batch is lost
+    }
+    offset += static_cast<std::size_t>(n);
+    writes_.fetch_add(1, std::memory_order_relaxed);
+  }
+  if (offset == batch_used_) {
+    written_.fetch_add(batch_records_, std::memory_order_relaxed);
+  }
+  batch_used_ = 0;
+  batch_records_ = 0;
+}
+
+} // namespace net
@@ -0,0 +1,76 @@
+#include "net/core/buffer_pool.h"
+#include <stdexcept>
+#include <utility>
+
+namespace net {
+
+BufferPool::Buffer::Buffer(Buffer &&other) noexcept
+    : pool_(std::exchange(other.pool_, nullptr)),
+      data_(std::exchange(other.data_, nullptr)),
+      size_(std::exchange(other.size_, 0)) {}
+
+BufferPool::Buffer &BufferPool::Buffer::operator=(Buffer &&other) noexcept {
+  if (this != &other) {
+    reset();
+    pool_ = std::exchange(other.pool_, nullptr);
+    data_ = std::exchange(other.data_, nullptr);
+    size_ = std::exchange(other.size_, 0);
+  }
+  return *this;
+}
+
+void BufferPool::Buffer::reset() noexcept {
+  if (data_ != nullptr) {
+    pool_->release(data_);
+    pool_ = nullptr;
+    data_ = nullptr;
+    size_ = 0;
+  }
+}
+
+BufferPool::BufferPool(std::size_t buffer_size, std::size_t preallocate,
+                       std::pmr::memory_resource *upstream)
+    : buffer_size_(buffer_size), upstream_(upstream) {
+  if (buffer_size_ == 0) {
+    throw std::invalid_argument("BufferPool buffer_size must be positive");
+  }
+  free_.reserve(preallocate);
+  for (std::size_t i = 0; i < preallocate; ++i) {
+    free_.push_back(static_cast<std::byte *>(upstream_->allocate(buffer_size_)));
+    ++allocated_;
+  }
+}
+
+BufferPool::~BufferPool() {
+  for (std::byte *data : free_) {
+    upstream_->deallocate(data, buffer_size_);
+  }
+}
+
+BufferPool::Buffer BufferPool::acquire() {
+  std::byte *data;
+  if (free_.empty()) {
+    data = static_cast<std::byte *>(upstream_->allocate(buffer_size_));
+    ++allocated_;
+  } else {
+    data = free_.back();
+    free_.pop_back();
+  }
+  return Buffer(this, data, buffer_size_);
+}
+
+void BufferPool::release(std::byte *data) noexcept {
+  // Keep room for every allocated buffer so push_back() cannot throw.
+  if (free_.capacity() < allocated_) {
+    try {
+      free_.reserve(allocated_);
+    } catch (...) {
+      upstream_->deallocate(data, buffer_size_);
+      --allocated_;
+      return;
+    }
+  }
+  free_.push_back(data);
+}
+
+} // namespace net
@@ -1,5 +1,6 @@
 #include "net/core/socket.h"
 #include "net/detail/socket_flags.h"
+#include "net/detail/io_wait_hook.h"
 #include "net/detail/socket_handle.h"
 #include <arpa/inet.h> // inet_pton
 #include <cerrno>
@@ -33,6 +34,13 @@ Socket::Socket(SocketFlags::AddressFamily address_family,
   }
 #endif
 
+#ifndef __linux__
+  // MPTCP sockets are a Linux extension; use plain TCP elsewhere.
+  if (protocol_type_ == SocketFlags::ProtocolType::MPTCP) {
+    protocol_type_ = SocketFlags::ProtocolType::TCP;
+  }
+#endif
+
   int domain = SocketFlags::toNative(address_family_);
   int protocol = SocketFlags::toNative(protocol_type_);
 
@@ -40,6 +48,18 @@ Socket::Socket(SocketFlags::AddressFamily address_family,
     handle_ = ::socket(domain, type_flags, protocol);
   } while (!handle_.isValid() && errno == EINTR);
 
+  // Kernels built without MPTCP (or with net.mptcp.enabled=0) reject the
+  // protocol; degrade to a plain TCP socket in that case.
+  if (!handle_.isValid() && protocol_type_ == SocketFlags::ProtocolType::MPTCP &&
+      (errno == EPROTONOSUPPORT || errno == ENOPROTOOPT || errno == EINVAL)) {
+    protocol_type_ = SocketFlags::ProtocolType::TCP;
+    protocol = SocketFlags::toNative(protocol_type_);
+
+    do {
+      handle_ = ::socket(domain, type_flags, protocol);
+    } while (!handle_.isValid() && errno == EINTR);
+  }
+
   if (!handle_.isValid()) {
     throw std::system_error(errno, std::generic_category(), "socket() failed");
   }
@@ -105,18 +125,36 @@ void Socket::setInheritable(
 }
 
 std::size_t Socket::raw_send(std::span<const std::byte> data) {
+  int flags = 0;
+#ifdef MSG_NOSIGNAL
+  flags |= MSG_NOSIGNAL;
+#endif
+  // With an I/O wait hook installed, blocking sockets must not block the
+  // thread: try without waiting and let the hook park the caller.
+  IoWaitHook *hook =
+      blocking_ == SocketFlags::BlockingType::Blocking ? io_wait_hook : nullptr;
+  if (hook != nullptr) {
+    flags |= MSG_DONTWAIT;
+  }
+
   ssize_t result;
 
-  do {
+  for (;;) {
     result = ::send(handle_, // or handle_ if implicit conversion
                     reinterpret_cast<const void *>(data.data()), data.size(),
-#ifdef MSG_NOSIGNAL
-                    MSG_NOSIGNAL
-#else
-                    0
-#endif
-    );
-  } while (result < 0 && errno == EINTR);
+                    flags);
+    if (result >= 0) {
+      break;
+    }
+    if (errno == EINTR) {
+      continue;
+    }
+    if (hook != nullptr && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+      hook->wait(hook->context, handle_, true);
+      continue;
+    }
+    break;
+  }
 
   if (result < 0) {
     throw std::system_error(errno, std::generic_category(), "send() failed");
@@ -126,12 +164,30 @@ std::size_t Socket::raw_send(std::span<const std::byte> data) {
 }
 
 std::size_t Socket::raw_recv(std::span<std::byte> buffer) {
+  int flags = 0;
+  IoWaitHook *hook =
+      blocking_ == SocketFlags::BlockingType::Blocking ? io_wait_hook : nullptr;
+  if (hook != nullptr) {
+    flags |= MSG_DONTWAIT;
+  }
+
   ssize_t result;
 
-  do {
+  for (;;) {
     result = ::recv(handle_, reinterpret_cast<void *>(buffer.data()),
-                    buffer.size(), 0);
-  } while (result < 0 && errno == EINTR);
+                    buffer.size(), flags);
+    if (result >= 0) {
+      break;
+    }
+    if (errno == EINTR) {
+      continue;
+    }
+    if (hook != nullptr && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+      hook->wait(hook->context, handle_, false);
+      continue;
+    }
+    break;
+  }
 
   if (result < 0) {
     throw std::system_error(errno, std::generic_category(), "recv() failed");
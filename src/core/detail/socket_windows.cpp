@@ -36,6 +36,11 @@ Socket::Socket(SocketFlags::AddressFamily address_family,
     flags |= WSA_FLAG_NO_HANDLE_INHERIT;
   }
 
+  // Winsock has no MPTCP sockets; use plain TCP instead.
+  if (protocol_type_ == SocketFlags::ProtocolType::MPTCP) {
+    protocol_type_ = SocketFlags::ProtocolType::TCP;
+  }
+
   int domain = SocketFlags::toNative(address_family);
   int type = SocketFlags::toNative(socket_type);
   int protocol = SocketFlags::toNative(protocol_type_);
@@ -1,4 +1,6 @@
 #include "net/core/endpoint.h"
+#include <algorithm>
+#include <charconv>
 #include <cstring>
 #include <stdexcept>
 
@@ -46,33 +48,118 @@ std::uint16_t Endpoint::port() const noexcept {
   return 0;
 }
 
-std::string Endpoint::to_string() const {
-  char buffer[INET6_ADDRSTRLEN] = {};
+std::size_t Endpoint::format_to(std::span<char> out) const noexcept {
+  char *first = out.data();
+  char *const last = out.data() + out.size();
+  std::uint16_t port = 0;
 
   if (storage_.ss_family == AF_INET) {
     const auto *addr = reinterpret_cast<const sockaddr_in *>(&storage_);
-
-    if (::inet_ntop(AF_INET, &addr->sin_addr, buffer, sizeof(buffer)) ==
+    const auto *octets = reinterpret_cast<const unsigned char *>(&addr->sin_addr);
+    for (int i = 0; i < 4; ++i) {
+      if (i > 0) {
+        if (first == last) {
+          return 0;
+        }
+        *first++ = '.';
+      }
+      auto result = std::to_chars(first, last, octets[i]);
+      if (result.ec != std::errc{}) {
+        return 0;
+      }
+      first = result.ptr;
+    }
+    port = ntohs(addr->sin_port);
+  } else if (storage_.ss_family == AF_INET6) {
+    const auto *addr = reinterpret_cast<const sockaddr_in6 *>(&storage_);
+    char buffer[INET6_ADDRSTRLEN] = {};
+    if (::inet_ntop(AF_INET6, &addr->sin6_addr, buffer, sizeof(buffer)) ==
         nullptr) {
-      throw std::runtime_error("inet_ntop failed");
+      return 0;
     }
+    const std::size_t length = std::strlen(buffer);
+    if (static_cast<std::size_t>(last - first) < length + 2) {
+      return 0;
+    }
+    *first++ = '[';
+    std::memcpy(first, buffer, length);
+    first += length;
+    *first++ = ']';
+    port = ntohs(addr->sin6_port);
+  } else {
+    return 0;
+  }
+
+  if (first == last) {
+    return 0;
+  }
+  *first++ = ':';
+  auto result = std::to_chars(first, last, port);
+  if (result.ec != std::errc{}) {
+    return 0;
+  }
+  return static_cast<std::size_t>(result.ptr - out.data());
+}
 
-    return std::string(buffer) + ":" + std::to_string(ntohs(addr->sin_port));
+std::string Endpoint::to_string() const {
+  if (storage_.ss_family != AF_INET && storage_.ss_family != AF_INET6) {
+    throw std::logic_error("Unknown address family in Endpoint");
   }
 
+  char buffer[max_string_length];
+  const std::size_t length = format_to(buffer);
+  if (length == 0) {
+    throw std::runtime_error("inet_ntop failed");
+  }
+  return std::string(buffer, length);
+}
+
+bool Endpoint::operator==(const Endpoint &other) const noexcept {
+  if (storage_.ss_family != other.storage_.ss_family) {
+    return false;
+  }
+  if (storage_.ss_family == AF_INET) {
+    const auto *a = reinterpret_cast<const sockaddr_in *>(&storage_);
+    const auto *b = reinterpret_cast<const sockaddr_in *>(&other.storage_);
+    return a->sin_port == b->sin_port &&
+           std::memcmp(&a->sin_addr, &b->sin_addr, sizeof(in_addr)) == 0;
+  }
   if (storage_.ss_family == AF_INET6) {
-    const auto *addr = reinterpret_cast<const sockaddr_in6 *>(&storage_);
+    const auto *a = reinterpret_cast<const sockaddr_in6 *>(&storage_);
+    const auto *b = reinterpret_cast<const sockaddr_in6 *>(&other.storage_);
+    return a->sin6_port == b->sin6_port &&
+           a->sin6_scope_id == b->sin6_scope_id &&
+           std::memcmp(&a->sin6_addr, &b->sin6_addr, sizeof(in6_addr)) == 0;
+  }
+  return size_ == other.size_ &&
+         std::memcmp(&storage_, &other.storage_,
+                     std::min<std::size_t>(size_, sizeof(storage_))) == 0;
+}
 
-    if (::inet_ntop(AF_INET6, &addr->sin6_addr, buffer, sizeof(buffer)) ==
-        nullptr) {
-      throw std::runtime_error("inet_ntop failed");
+std::size_t Endpoint::hash() const noexcept {
+  // FNV-1a over the fields operator== compares.
+  std::uint64_t h = 14695981039346656037ull;
+  auto mix = [&h](const void *data, std::size_t size) {
+    const auto *bytes = static_cast<const unsigned char *>(data);
+    for (std::size_t i = 0; i < size; ++i) {
+      h = (h ^ bytes[i]) * 1099511628211ull;
     }
+  };
 
-    return "[" + std::string(buffer) +
-           "]:" + std::to_string(ntohs(addr->sin6_port));
+  mix(&storage_.ss_family, sizeof(storage_.ss_family));
+  if (storage_.ss_family == AF_INET) {
+    const auto *addr = reinterpret_cast<const sockaddr_in *>(&storage_);
+    mix(&addr->sin_port, sizeof(addr->sin_port));
+    mix(&addr->sin_addr, sizeof(in_addr));
+  } else if (storage_.ss_family == AF_INET6) {
+    const auto *addr = reinterpret_cast<const sockaddr_in6 *>(&storage_);
+    mix(&addr->sin6_port, sizeof(addr->sin6_port));
+    mix(&addr->sin6_addr, sizeof(in6_addr));
+    mix(&addr->sin6_scope_id, sizeof(addr->sin6_scope_id));
+  } else {
+    mix(&storage_, std::min<std::size_t>(size_, sizeof(storage_)));
   }
-
-  throw std::logic_error("Unknown address family in Endpoint");
+  return static_cast<std::size_t>(h);
 }
 
 } // namespace net
@@ -0,0 +1,241 @@
+#include "net/core/epoch.h"
+#include <algorithm>
+#include <limits>
+#include <thread>
+
+namespace net {
+
+namespace detail {
+
+/// One reader thread's announcement. Only the epoch and in_use flag are
+/// shared; the rest is touched by the owning thread alone.
+struct alignas(64) EpochSlot {
+  std::atomic<std::uint64_t> epoch{0};
+  std::atomic<bool> in_use{false};
+  unsigned depth = 0;
+  bool online = false;
+};
+
+} // namespace detail
+
+namespace {
+
+constexpr std::uint64_t idle_epoch = 0;
+
+std::atomic<std::uint64_t> next_domain_id{1};
+
+/// The calling thread's slots, one per domain it has read from. A slot
+/// whose only owner is this list belongs to a destroyed domain.
+struct ThreadSlots {
+  struct Entry {
+    std::uint64_t domain;
+    std::shared_ptr<detail::EpochSlot> slot;
+  };
+
+  std::vector<Entry> entries;
+  std::uint64_t cached_domain = 0;
+  detail::EpochSlot *cached_slot = nullptr;
+
+  ~ThreadSlots() {
+    for (Entry &entry : entries) {
+      entry.slot->depth = 0;
+      entry.slot->online = false;
+      entry.slot->epoch.store(idle_epoch, std::memory_order_release);
+      entry.slot->in_use.store(false, std::memory_order_release);
+    }
+  }
+};
+
+ThreadSlots &threadSlots() {
+  thread_local ThreadSlots slots;
+  return slots;
+}
+
+detail::EpochSlot *findSlot(std::uint64_t domain) noexcept {
+  ThreadSlots &slots = threadSlots();
+  if (slots.cached_domain == domain) {
+    return slots.cached_slot;
+  }
+  for (const auto &entry : slots.entries) {
+    if (entry.domain == domain) {
+      slots.cached_domain = domain;
+      slots.cached_slot = entry.slot.get();
+      return entry.slot.get();
+    }
+  }
+  return nullptr;
+}
+
+} // namespace
+
+// ---- Guard ----
+
+void EpochDomain::Guard::release() noexcept {
+  detail::EpochSlot *slot = std::exchange(slot_, nullptr);
+  if (slot != nullptr && --slot->depth == 0 && !slot->online) {
+    // Release: the section's reads finish before a writer can see idle.
+    slot->epoch.store(idle_epoch, std::memory_order_release);
+  }
+}
+
+// ---- EpochDomain ----
+
+EpochDomain::EpochDomain()
+    : id_(next_domain_id.fetch_add(1, std::memory_order_relaxed)) {}
+
+EpochDomain::~EpochDomain() {
+  for (const Retired &retired : retired_) {
+    retired.deleter(retired.object);
+  }
+}
+
+EpochDomain::Guard EpochDomain::pin() {
+  detail::EpochSlot *s = slot();
+  if (s->depth++ == 0 && !s->online) {
+    announce(*s);
+  }
+  return Guard(s);
+}
+
+void EpochDomain::online() {
+  detail::EpochSlot *s = slot();
+  if (s->online) {
+    return;
+  }
+  s->online = true;
+  if (s->depth == 0) {
+    announce(*s);
+  }
+}
+
+void EpochDomain::quiescent() noexcept {
+  detail::EpochSlot *s = findSlot(id_);
+  if (s != nullptr && s->online && s->depth == 0) {
+    announce(*s);
+  }
+}
+
+void EpochDomain::offline() noexcept {
+  detail::EpochSlot *s = findSlot(id_);
+  if (s == nullptr || !s->online) {
+    return;
+  }
+  s->online = false;
+  if (s->depth == 0) {
+    s->epoch.store(idle_epoch, std::memory_order_release);
+  }
+}
+
+void EpochDomain::retire(void *object, void (*deleter)(void *)) {
+  {
+    std::lock_guard lock(mutex_);
+    retired_.reserve(retired_.size() + 1);
+    // Order the caller's unlinking before the epoch bump, so a reader
+    // that observes the new epoch cannot reach the object.
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    const std::uint64_t epoch =
+        epoch_.fetch_add(1, std::memory_order_seq_cst) + 1;
+    retired_.push_back({object, deleter, epoch});
+  }
+  reclaim();
+}
+
+std::size_t EpochDomain::reclaim() {
+  std::vector<Retired> ready;
+  {
+    std::lock_guard lock(mutex_);
+    if (retired_.empty()) {
+      return 0;
+    }
+    const std::uint64_t oldest = oldestReader();
+    const auto safe = std::stable_partition(
+        retired_.begin(), retired_.end(),
+        [oldest](const Retired &retired) { return retired.epoch > oldest; });
+    ready.assign(safe, retired_.end());
+    retired_.erase(safe, retired_.end());
+  }
+  // Deleters run unlocked so they may retire further objects.
+  for (const Retired &retired : ready) {
+    retired.deleter(retired.object);
+  }
+  return ready.size();
+}
+
+void EpochDomain::synchronize() {
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  const std::uint64_t target =
+      epoch_.fetch_add(1, std::memory_order_seq_cst) + 1;
+  for (;;) {
+    {
+      std::lock_guard lock(mutex_);
+      if (oldestReader() >= target) {
+        break;
+      }
+    }
+    std::this_thread::yield();
+  }
+  reclaim();
+}
+
+std::size_t EpochDomain::pending() const {
+  std::lock_guard lock(mutex_);
+  return retired_.size();
+}
+
+detail::EpochSlot *EpochDomain::slot() {
+  detail::EpochSlot *s = findSlot(id_);
+  return s != nullptr ? s : registerThread();
+}
+
+detail::EpochSlot *EpochDomain::registerThread() {
+  std::shared_ptr<detail::EpochSlot> claimed;
+  {
+    std::lock_guard lock(mutex_);
+    for (const auto &candidate : slots_) {
+      bool expected = false;
+      if (candidate->in_use.compare_exchange_strong(
+              expected, true, std::memory_order_acquire)) {
+        claimed = candidate;
+        break;
+      }
+    }
+    if (!claimed) {
+      claimed = std::make_shared<detail::EpochSlot>();
+      claimed->in_use.store(true, std::memory_order_relaxed);
+      slots_.push_back(claimed);
+    }
+  }
+
+  ThreadSlots &slots = threadSlots();
+  std::erase_if(slots.entries, [](const ThreadSlots::Entry &entry) {
+    return entry.slot.use_count() == 1; // domain destroyed
+  });
+  slots.entries.push_back({id_, claimed});
+  slots.cached_domain = id_;
+  slots.cached_slot = claimed.get();
+  return claimed.get();
+}
+
+void EpochDomain::announce(detail::EpochSlot &slot) noexcept {
+  // Release: for a quiescent() caller, earlier reads finish before a
+  // writer can see the newer epoch.
+  slot.epoch.store(epoch_.load(std::memory_order_seq_cst),
+                   std::memory_order_release);
+  // Make the announcement visible before any protected load; pairs with
+  // the fences in retire() and oldestReader().
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+}
+
+std::uint64_t EpochDomain::oldestReader() const {
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  std::uint64_t oldest = std::numeric_limits<std::uint64_t>::max();
+  for (const auto &slot : slots_) {
+    const std::uint64_t epoch = slot->epoch.load(std::memory_order_acquire);
+    if (epoch != idle_epoch) {
+      oldest = std::min(oldest, epoch);
+    }
+  }
+  return oldest;
+}
+
+} // namespace net
@@ -0,0 +1,719 @@
+#include "net/core/event_loop.h"
+#include "net/core/io_capabilities.h"
+#include "net/detail/platform_error.h"
+#include <algorithm>
+#include <cstdio>
+#include <iterator>
+#include <limits>
+#include <span>
+#include <stdexcept>
+#include <system_error>
+#include <utility>
+
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+
+#ifdef __linux__
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#endif
+
+namespace net {
+
+namespace detail {
+
+/**
+ * @brief Readiness backend used by EventLoop.
+ *
+ * Owns the wakeup channel: wakeup() may be called from any thread and makes
+ * a concurrent wait() return; wakeup notifications are never reported as
+ * ready descriptors.
+ */
+class EventPoller {
+public:
+  struct Ready {
+    EventLoop::Handle fd;
+    unsigned events;
+  };
+
+  virtual ~EventPoller() = default;
+
+  virtual void add(EventLoop::Handle fd, unsigned interest) = 0;
+  virtual void modify(EventLoop::Handle fd, unsigned interest) = 0;
+  virtual void remove(EventLoop::Handle fd) noexcept = 0;
+
+  /// Wait up to timeout_ms (-1 = forever) and collect ready descriptors.
+  virtual std::span<const Ready> wait(int timeout_ms) = 0;
+
+  virtual void wakeup() noexcept = 0;
+
+  [[nodiscard]] virtual std::string_view name() const noexcept = 0;
+
+protected:
+  std::vector<Ready> ready_;
+};
+
+namespace {
+
+[[noreturn]] void throw_last_error(const char *what) {
+  throw std::system_error(last_socket_error(), socket_category(), what);
+}
+
+#ifdef __linux__
+
+class EpollPoller final : public EventPoller {
+public:
+  explicit EpollPoller(std::size_t max_events) : events_(max_events) {
+    epoll_fd_ = ::epoll_create1(EPOLL_CLOEXEC);
+    if (epoll_fd_ < 0) {
+      throw_last_error("epoll_create1 failed");
+    }
+    wake_fd_ = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (wake_fd_ < 0) {
+      ::close(epoll_fd_);
+      throw_last_error("eventfd failed");
+    }
+    epoll_event ev{};
+    ev.events = EPOLLIN;
+    ev.data.fd = wake_fd_;
+    if (::epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, wake_fd_, &ev) < 0) {
+      ::close(wake_fd_);
+      ::close(epoll_fd_);
+      throw_last_error("epoll_ctl(wakeup) failed");
+    }
+  }
+
+  ~EpollPoller() override {
+    ::close(wake_fd_);
+    ::close(epoll_fd_);
+  }
+
+  void add(EventLoop::Handle fd, unsigned interest) override {
+    control(EPOLL_CTL_ADD, fd, interest, "epoll_ctl(ADD) failed");
+  }
+
+  void modify(EventLoop::Handle fd, unsigned interest) override {
+    control(EPOLL_CTL_MOD, fd, interest, "epoll_ctl(MOD) failed");
+  }
+
+  void remove(EventLoop::Handle fd) noexcept override {
+    ::epoll_ctl(epoll_fd_, EPOLL_CTL_DEL, fd, nullptr);
+  }
+
+  std::span<const Ready> wait(int timeout_ms) override {
+    ready_.clear();
+    const int n = ::epoll_wait(epoll_fd_, events_.data(),
+                               static_cast<int>(events_.size()), timeout_ms);
+    if (n < 0) {
+      if (is_interrupted(last_socket_error())) {
+        return ready_;
+      }
+      throw_last_error("epoll_wait failed");
+    }
+    for (int i = 0; i < n; ++i) {
+      const epoll_event &ev = events_[static_cast<std::size_t>(i)];
+      if (ev.data.fd == wake_fd_) {
+        std::uint64_t count;
+        [[maybe_unused]] auto r = ::read(wake_fd_, &count, sizeof(count));
+        continue;
+      }
+      unsigned events = 0;
+      if (ev.events & (EPOLLIN | EPOLLPRI | EPOLLRDHUP)) {
+        events |= EventLoop::Readable;
+      }
+      if (ev.events & EPOLLOUT) {
+        events |= EventLoop::Writable;
+      }
+      if (ev.events & EPOLLERR) {
+        events |= EventLoop::Error;
+      }
+      if (ev.events & EPOLLHUP) {
+        events |= EventLoop::Hangup;
+      }
+      ready_.push_back({ev.data.fd, events});
+    }
+    return ready_;
+  }
+
+  void wakeup() noexcept override {
+    const std::uint64_t one = 1;
+    [[maybe_unused]] auto r = ::write(wake_fd_, &one, sizeof(one));
+  }
+
+  [[nodiscard]] std::string_view name() const noexcept override {
+    return "epoll";
+  }
+
+private:
+  void control(int op, EventLoop::Handle fd, unsigned interest,
+               const char *what) {
+    epoll_event ev{};
+    ev.events = 0;
+    if (interest & EventLoop::Readable) {
+      ev.events |= EPOLLIN | EPOLLRDHUP;
+    }
+    if (interest & EventLoop::Writable) {
+      ev.events |= EPOLLOUT;
+    }
+    if (interest & EventLoop::EdgeTriggered) {
+      ev.events |= EPOLLET;
+    }
+    ev.data.fd = fd;
+    if (::epoll_ctl(epoll_fd_, op, fd, &ev) < 0) {
+      throw_last_error(what);
+    }
+  }
+
+  int epoll_fd_ = -1;
+  int wake_fd_ = -1;
+  std::vector<epoll_event> events_;
+};
+
+#endif // __linux__
+
+class PollPoller final : public EventPoller {
+public:
+  PollPoller() {
+    if (::pipe(wake_pipe_) < 0) {
+      throw_last_error("pipe failed");
+    }
+    for (int fd : wake_pipe_) {
+      ::fcntl(fd, F_SETFL, ::fcntl(fd, F_GETFL) | O_NONBLOCK);
+      ::fcntl(fd, F_SETFD, FD_CLOEXEC);
+    }
+    fds_.push_back({wake_pipe_[0], POLLIN, 0});
+  }
+
+  ~PollPoller() override {
+    ::close(wake_pipe_[0]);
+    ::close(wake_pipe_[1]);
+  }
+
+  void add(EventLoop::Handle fd, unsigned interest) override {
+    index_.emplace(fd, fds_.size());
+    fds_.push_back({fd, toPoll(interest), 0});
+  }
+
+  void modify(EventLoop::Handle fd, unsigned interest) override {
+    fds_[index_.at(fd)].events = toPoll(interest);
+  }
+
+  void remove(EventLoop::Handle fd) noexcept override {
+    auto found = index_.find(fd);
+    if (found == index_.end()) {
+      return;
+    }
+    const std::size_t slot = found->second;
+    index_.erase(found);
+    if (slot != fds_.size() - 1) {
+      fds_[slot] = fds_.back();
+      index_[fds_[slot].fd] = slot;
+    }
+    fds_.pop_back();
+  }
+
+  std::span<const Ready> wait(int timeout_ms) override {
+    ready_.clear();
+    const int n = ::poll(fds_.data(), fds_.size(), timeout_ms);
+    if (n < 0) {
+      if (is_interrupted(last_socket_error())) {
+        return ready_;
+      }
+      throw_last_error("poll failed");
+    }
+    if (n == 0) {
+      return ready_;
+    }
+    for (const pollfd &pfd : fds_) {
+      if (pfd.revents == 0) {
+        continue;
+      }
+      if (pfd.fd == wake_pipe_[0]) {
+        char drain[64];
+        while (::read(wake_pipe_[0], drain, sizeof(drain)) > 0) {
+        }
+        continue;
+      }
+      unsigned events = 0;
+      if (pfd.revents & (POLLIN | POLLPRI)) {
+        events |= EventLoop::Readable;
+      }
+      if (pfd.revents & POLLOUT) {
+        events |= EventLoop::Writable;
+      }
+      if (pfd.revents & (POLLERR | POLLNVAL)) {
+        events |= EventLoop::Error;
+      }
+      if (pfd.revents & POLLHUP) {
+        events |= EventLoop::Hangup;
+      }
+      ready_.push_back({pfd.fd, events});
+    }
+    return ready_;
+  }
+
+  void wakeup() noexcept override {
+    const char byte = 1;
+    [[maybe_unused]] auto r = ::write(wake_pipe_[1], &byte, 1);
+  }
+
+  [[nodiscard]] std::string_view name() const noexcept override {
+    return "poll";
+  }
+
+private:
+  static short toPoll(unsigned interest) noexcept {
+    short events = 0;
+    if (interest & EventLoop::Readable) {
+      events |= POLLIN;
+    }
+    if (interest & EventLoop::Writable) {
+      events |= POLLOUT;
+    }
+    return events;
+  }
+
+  int wake_pipe_[2] = {-1, -1};
+  std::vector<pollfd> fds_;
+  std::unordered_map<EventLoop::Handle, std::size_t> index_;
+};
+
+void print_stall(const EventLoop::StallReport &report) {
+  using std::chrono::duration_cast;
+  using std::chrono::microseconds;
+  auto us = [](std::chrono::nanoseconds d) {
+    return static_cast<long long>(duration_cast<microseconds>(d).count());
+  };
+  std::fprintf(stderr,
+               "net::EventLoop stall: %lld us busy (dispatch %lld us, timers "
+               "%lld us, callbacks %lld us); slowest callback '%.*s' took "
+               "%lld us\n",
+               us(report.phases.busy()), us(report.phases.dispatch),
+               us(report.phases.timers), us(report.phases.callbacks),
+               static_cast<int>(report.culprit.size()), report.culprit.data(),
+               us(report.culprit_time));
+}
+
+} // namespace
+
+} // namespace detail
+
+EventLoop::EventLoop(Options options)
+    : options_(options), stall_handler_(detail::print_stall) {
+  if (options_.max_events == 0) {
+    throw std::invalid_argument("EventLoop max_events must be positive");
+  }
+#ifdef __linux__
+  if (!options_.force_poll && ioBackends().poller == PollerBackend::Epoll) {
+    poller_ = std::make_unique<detail::EpollPoller>(options_.max_events);
+  }
+#endif
+  if (!poller_) {
+    poller_ = std::make_unique<detail::PollPoller>();
+  }
+}
+
+EventLoop::~EventLoop() = default;
+
+std::string_view EventLoop::backend() const noexcept {
+  return poller_->name();
+}
+
+void EventLoop::add(Handle fd, unsigned interest, IoHandler handler,
+                    std::string label) {
+  if (!handler) {
+    throw std::invalid_argument("EventLoop::add requires a handler");
+  }
+  auto registration = std::make_shared<Registration>();
+  registration->interest = interest;
+  registration->handler = std::move(handler);
+  registration->label = std::move(label);
+  insert(fd, std::move(registration));
+}
+
+void EventLoop::addBudgeted(Handle fd, unsigned interest,
+                            BudgetedHandler handler, std::string label,
+                            std::optional<IoBudget> budget) {
+  if (!handler) {
+    throw std::invalid_argument("EventLoop::addBudgeted requires a handler");
+  }
+  auto registration = std::make_shared<Registration>();
+  registration->interest = interest;
+  registration->budgeted = std::move(handler);
+  registration->label = std::move(label);
+  registration->budget = budget.value_or(options_.io_budget);
+  insert(fd, std::move(registration));
+}
+
+void EventLoop::insert(Handle fd, std::shared_ptr<Registration> registration) {
+  if (fd == detail::SocketDescriptorHandle::Invalid) {
+    throw std::invalid_argument("EventLoop::add on invalid descriptor");
+  }
+  if (registrations_.contains(fd)) {
+    throw std::invalid_argument("descriptor already registered");
+  }
+  poller_->add(fd, registration->interest);
+  registrations_.emplace(fd, std::move(registration));
+}
+
+void EventLoop::modify(Handle fd, unsigned interest) {
+  auto found = registrations_.find(fd);
+  if (found == registrations_.end()) {
+    throw std::invalid_argument("descriptor not registered");
+  }
+  if (found->second->interest != interest) {
+    poller_->modify(fd, interest);
+    found->second->interest = interest;
+  }
+}
+
+void EventLoop::remove(Handle fd) noexcept {
+  auto found = registrations_.find(fd);
+  if (found == registrations_.end()) {
+    return;
+  }
+  poller_->remove(fd);
+  registrations_.erase(found);
+}
+
+bool EventLoop::contains(Handle fd) const noexcept {
+  return registrations_.contains(fd);
+}
+
+EventLoop::TimerId EventLoop::runAfter(Clock::duration delay, Task task,
+                                       std::string label) {
+  const TimerId id = next_timer_id_++;
+  const auto deadline = Clock::now() + std::max(delay, Clock::duration{});
+  timers_.emplace(id, Timer{std::move(task), std::move(label), deadline});
+  timer_queue_.push({deadline, id});
+  return id;
+}
+
+bool EventLoop::cancel(TimerId id) noexcept {
+  // The queue slot is skipped lazily once it reaches the top.
+  return timers_.erase(id) != 0;
+}
+
+void EventLoop::post(Task task, std::string label) {
+  {
+    std::lock_guard lock(posted_mutex_);
+    posted_.push_back({std::move(task), std::move(label)});
+  }
+  wakeup();
+}
+
+void EventLoop::wakeup() noexcept {
+  if (isInLoopThread()) {
+    // Work queued by this iteration's hook or posted tasks: the next wait
+    // must not block, and nothing else would interrupt it.
+    wakeup_pending_.store(true);
+  } else if (!wakeup_pending_.exchange(true)) {
+    poller_->wakeup();
+  }
+}
+
+EventLoop::Migration EventLoop::detach(Handle fd) {
+  auto found = registrations_.find(fd);
+  if (found == registrations_.end()) {
+    throw std::invalid_argument("descriptor not registered");
+  }
+  std::shared_ptr<Registration> registration = std::move(found->second);
+  registrations_.erase(found);
+  poller_->remove(fd);
+
+  if (registration->queued) {
+    // Owed events stay in `pending` and are replayed by the adopting loop.
+    std::erase_if(requeued_, [&](const auto &entry) {
+      return entry.second == registration;
+    });
+    registration->queued = false;
+  }
+  return Migration(fd, std::move(registration));
+}
+
+void EventLoop::adopt(Migration migration, AdoptedHandler adopted) {
+  if (!migration) {
+    throw std::invalid_argument("EventLoop::adopt on empty migration");
+  }
+  handoffs_.push({migration.fd_, std::move(migration.registration_),
+                  std::move(adopted)});
+  wakeup();
+}
+
+void EventLoop::receiveHandoffs(Iteration &iteration) {
+  while (auto handoff = handoffs_.pop()) {
+    auto &registration = handoff->registration;
+    insert(handoff->fd, registration);
+    // Readiness consumed by the source loop (or, with edge triggering,
+    // reported there and never again) must not be lost: dispatch the
+    // handler once with its interest set and let it find out what is ready.
+    registration->pending |= registration->interest & (Readable | Writable);
+    registration->queued = true;
+    requeued_.emplace_back(handoff->fd, registration);
+    if (handoff->adopted) {
+      invoke(
+          iteration, [&] { handoff->adopted(*this); },
+          [] { return std::string("adopted handler"); });
+    }
+  }
+}
+
+void EventLoop::stop() noexcept {
+  stop_requested_.store(true);
+  poller_->wakeup();
+}
+
+void EventLoop::run() {
+  while (!stop_requested_.exchange(false)) {
+    runOnce(std::chrono::milliseconds(-1));
+  }
+}
+
+bool EventLoop::isInLoopThread() const noexcept {
+  return loop_thread_.load(std::memory_order_relaxed) ==
+         std::this_thread::get_id();
+}
+
+template <typename F, typename L>
+void EventLoop::invoke(Iteration &iteration, F &&callback, L &&label) {
+  const auto start = Clock::now();
+  callback();
+  const auto elapsed = Clock::now() - start;
+  iteration.callbacks += elapsed;
+  ++iteration.invoked;
+  if (elapsed > iteration.slowest) {
+    iteration.slowest = elapsed;
+    iteration.culprit = label();
+  }
+}
+
+void EventLoop::dispatch(Iteration &iteration, Handle fd,
+                         const std::shared_ptr<Registration> &registration,
+                         unsigned events) {
+  auto label = [&] {
+    return registration->label.empty() ? "fd " + std::to_string(fd)
+                                       : registration->label;
+  };
+
+  if (!registration->budgeted) {
+    invoke(iteration, [&] { registration->handler(events); }, label);
+    return;
+  }
+
+  IoBudget budget = registration->budget;
+  IoStatus status = IoStatus::Done;
+  invoke(
+      iteration, [&] { status = registration->budgeted(events, budget); },
+      label);
+
+  if (status == IoStatus::Pending) {
+    // The handler may have removed or migrated itself; only requeue a
+    // registration this loop still owns.
+    auto found = registrations_.find(fd);
+    if (found != registrations_.end() && found->second == registration &&
+        !registration->queued) {
+      registration->pending |= events;
+      registration->queued = true;
+      requeued_.emplace_back(fd, registration);
+      ++stats_.requeued;
+    }
+  }
+}
+
+int EventLoop::waitTimeout(std::chrono::milliseconds timeout) {
+  if (!requeued_.empty() || !handoffs_.empty() || wakeup_pending_.load()) {
+    return 0;
+  }
+  {
+    std::lock_guard lock(posted_mutex_);
+    if (!posted_.empty()) {
+      return 0;
+    }
+  }
+
+  std::int64_t wait_ms = timeout.count() < 0 ? -1 : timeout.count();
+
+  while (!timer_queue_.empty() && !timers_.contains(timer_queue_.top().id)) {
+    timer_queue_.pop();
+  }
+  if (!timer_queue_.empty()) {
+    // Round up so the loop never wakes just before a deadline and spins.
+    const auto until = std::chrono::ceil<std::chrono::milliseconds>(
+        timer_queue_.top().deadline - Clock::now());
+    const std::int64_t timer_ms = std::max<std::int64_t>(until.count(), 0);
+    wait_ms = wait_ms < 0 ? timer_ms : std::min(wait_ms, timer_ms);
+  }
+
+  return static_cast<int>(
+      std::min<std::int64_t>(wait_ms, std::numeric_limits<int>::max()));
+}
+
+void EventLoop::processTimers(Iteration &iteration) {
+  const auto now = Clock::now();
+  while (!timer_queue_.empty() && timer_queue_.top().deadline <= now) {
+    const TimerId id = timer_queue_.top().id;
+    timer_queue_.pop();
+
+    auto node = timers_.extract(id);
+    if (node.empty()) {
+      continue; // cancelled
+    }
+    Timer &timer = node.mapped();
+
+    const auto lag = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        Clock::now() - timer.deadline);
+    stats_.lag_last = lag;
+    stats_.lag_max = std::max(stats_.lag_max, lag);
+    stats_.lag_total += lag;
+    ++stats_.lag_samples;
+
+    invoke(
+        iteration, [&] { timer.task(); },
+        [&] { return timer.label.empty() ? std::string("timer") : timer.label; });
+  }
+}
+
+void EventLoop::runPosted(Iteration &iteration) {
+  std::vector<Posted> batch;
+  {
+    std::lock_guard lock(posted_mutex_);
+    batch.swap(posted_);
+  }
+  // If a task throws, the rest of the batch goes back to the front of the
+  // queue so the next iteration still runs it, in order.
+  struct Restore {
+    EventLoop &loop;
+    std::vector<Posted> &batch;
+    std::size_t next = 0;
+    ~Restore() {
+      if (next >= batch.size()) {
+        return;
+      }
+      std::lock_guard lock(loop.posted_mutex_);
+      loop.posted_.insert(loop.posted_.begin(),
+                          std::make_move_iterator(batch.begin() + next),
+                          std::make_move_iterator(batch.end()));
+    }
+  } restore{*this, batch};
+
+  while (restore.next < batch.size()) {
+    Posted &posted = batch[restore.next++];
+    invoke(
+        iteration, [&] { posted.task(); },
+        [&] {
+          return posted.label.empty() ? std::string("posted task")
+                                      : posted.label;
+        });
+  }
+}
+
+std::size_t EventLoop::runOnce(std::chrono::milliseconds timeout) {
+  loop_thread_.store(std::this_thread::get_id(), std::memory_order_relaxed);
+  struct ThreadReset {
+    std::atomic<std::thread::id> &thread;
+    ~ThreadReset() { thread.store({}, std::memory_order_relaxed); }
+  } reset{loop_thread_};
+
+  Iteration iteration;
+  PhaseTimes phases;
+
+  const int wait_ms = waitTimeout(timeout);
+  const auto wait_start = Clock::now();
+  const auto ready = poller_->wait(wait_ms);
+  const auto dispatch_start = Clock::now();
+  phases.wait = dispatch_start - wait_start;
+
+  // Connections requeued by earlier iterations run after the newly ready
+  // ones; taking the list first lets handlers requeue themselves again.
+  auto requeued = std::move(requeued_);
+  requeued_.clear();
+  // If a handler throws, the requeued entries not yet served go back ahead
+  // of any requeued since; they are still marked queued and would
+  // otherwise never run again.
+  struct Restore {
+    decltype(requeued_) &target;
+    decltype(requeued_) &taken;
+    std::size_t next = 0;
+    ~Restore() {
+      if (next < taken.size()) {
+        target.insert(target.begin(),
+                      std::make_move_iterator(taken.begin() + next),
+                      std::make_move_iterator(taken.end()));
+      }
+    }
+  } restore{requeued_, requeued};
+
+  for (const auto &event : ready) {
+    auto found = registrations_.find(event.fd);
+    if (found == registrations_.end()) {
+      continue; // removed by an earlier handler in this iteration
+    }
+    if (found->second->queued) {
+      found->second->pending |= event.events;
+      continue;
+    }
+    // Keep the registration alive even if the handler removes itself.
+    std::shared_ptr<Registration> registration = found->second;
+    dispatch(iteration, event.fd, registration, event.events);
+  }
+
+  while (restore.next < requeued.size()) {
+    auto &[fd, registration] = requeued[restore.next++];
+    auto found = registrations_.find(fd);
+    if (found == registrations_.end() || found->second != registration) {
+      continue; // removed, replaced or migrated since it was requeued
+    }
+    registration->queued = false;
+    dispatch(iteration, fd, registration,
+             std::exchange(registration->pending, 0u));
+  }
+
+  const auto timers_start = Clock::now();
+  const auto io_callbacks = iteration.callbacks;
+  processTimers(iteration);
+  const auto posted_start = Clock::now();
+  const auto timer_callbacks = iteration.callbacks - io_callbacks;
+  // Cleared before draining so a concurrent producer wakes us again; the
+  // exchange pairs with the producer's so its enqueued work is visible.
+  wakeup_pending_.exchange(false);
+  receiveHandoffs(iteration);
+  runPosted(iteration);
+  if (iteration_hook_.task) {
+    invoke(iteration, iteration_hook_.task, [&] {
+      return iteration_hook_.label.empty() ? std::string("iteration hook")
+                                           : iteration_hook_.label;
+    });
+  }
+  const auto end = Clock::now();
+  const auto posted_callbacks =
+      iteration.callbacks - io_callbacks - timer_callbacks;
+
+  phases.dispatch = (timers_start - dispatch_start) - io_callbacks +
+                    (end - posted_start) - posted_callbacks;
+  phases.timers = (posted_start - timers_start) - timer_callbacks;
+  phases.callbacks = iteration.callbacks;
+
+  finishIteration(phases, iteration);
+  return iteration.invoked;
+}
+
+void EventLoop::finishIteration(const PhaseTimes &phases,
+                                const Iteration &iteration) {
+  ++stats_.iterations;
+  stats_.last = phases;
+  stats_.total.wait += phases.wait;
+  stats_.total.dispatch += phases.dispatch;
+  stats_.total.timers += phases.timers;
+  stats_.total.callbacks += phases.callbacks;
+
+  if (options_.stall_threshold > std::chrono::nanoseconds::zero() &&
+      phases.busy() > options_.stall_threshold) {
+    ++stats_.stalls;
+    if (stall_handler_) {
+      stall_handler_(StallReport{phases, iteration.culprit, iteration.slowest});
+    }
+  }
+}
+
+} // namespace net
@@ -0,0 +1,245 @@
+#include "net/core/fiber_scheduler.h"
+#include <stdexcept>
+#include <utility>
+
+namespace net {
+
+thread_local FiberScheduler::Fiber *FiberScheduler::current_ = nullptr;
+
+FiberScheduler::FiberScheduler(EventLoop &loop, Options options)
+    : loop_(loop), stacks_(options.stack_size, options.pooled_stacks) {}
+
+FiberScheduler::~FiberScheduler() {
+  // Pending loop callbacks (posted runs, timers, readiness) check this flag.
+  *alive_ = false;
+  for (const auto &[fd, waiters] : waiters_) {
+    loop_.remove(fd);
+  }
+  for (auto &[raw, fiber] : fibers_) {
+    stacks_.release(fiber->stack);
+  }
+}
+
+void FiberScheduler::spawn(std::function<void()> body, std::string label) {
+  if (!body) {
+    throw std::invalid_argument("FiberScheduler::spawn requires a body");
+  }
+  auto fiber = std::make_unique<Fiber>();
+  fiber->stack = stacks_.acquire();
+  fiber->body = std::move(body);
+  fiber->label = std::move(label);
+  fiber->scheduler = this;
+  fiber->context.prepare(fiber->stack.usable, &FiberScheduler::entry,
+                         fiber.get());
+
+  Fiber *raw = fiber.get();
+  fibers_.emplace(raw, std::move(fiber));
+  ++stats_.spawned;
+  makeReady(raw);
+}
+
+FiberScheduler::Stats FiberScheduler::stats() const noexcept {
+  Stats stats = stats_;
+  stats.stacks_mapped = stacks_.mapped();
+  return stats;
+}
+
+bool FiberScheduler::inFiber() noexcept { return current_ != nullptr; }
+
+void FiberScheduler::entry(void *raw) noexcept {
+  auto *fiber = static_cast<Fiber *>(raw);
+  try {
+    fiber->body();
+  } catch (...) {
+    fiber->error = std::current_exception();
+  }
+  fiber->body = nullptr;
+  fiber->finished = true;
+  detail::FiberContext::switchTo(fiber->context,
+                                 fiber->scheduler->scheduler_context_);
+  // Never resumed: the scheduler recycles the stack.
+}
+
+void FiberScheduler::makeReady(Fiber *fiber) {
+  ready_.push_back(fiber);
+  if (!run_posted_) {
+    run_posted_ = true;
+    loop_.post(
+        [this, alive = alive_] {
+          if (*alive) {
+            runReady();
+          }
+        },
+        "fiber scheduler");
+  }
+}
+
+void FiberScheduler::runReady() {
+  run_posted_ = false;
+  detail::IoWaitHook *previous_hook = detail::io_wait_hook;
+  std::vector<std::pair<std::exception_ptr, std::string>> failures;
+
+  // Only run fibers that were ready on entry; ones that yield or become
+  // ready meanwhile wait for the next iteration so I/O is polled between.
+  for (std::size_t n = ready_.size(); n > 0 && !ready_.empty(); --n) {
+    Fiber *fiber = ready_.front();
+    ready_.pop_front();
+
+    current_ = fiber;
+    detail::io_wait_hook = &hook_;
+    ++stats_.switches;
+    detail::FiberContext::switchTo(scheduler_context_, fiber->context);
+    detail::io_wait_hook = previous_hook;
+    current_ = nullptr;
+
+    if (fiber->finished) {
+      if (fiber->error) {
+        ++stats_.failed;
+        failures.emplace_back(fiber->error, std::move(fiber->label));
+      }
+      stacks_.release(fiber->stack);
+      fibers_.erase(fiber);
+      ++stats_.completed;
+    }
+  }
+
+  if (!ready_.empty() && !run_posted_) {
+    run_posted_ = true;
+    loop_.post(
+        [this, alive = alive_] {
+          if (*alive) {
+            runReady();
+          }
+        },
+        "fiber scheduler");
+  }
+  // Reported last, so a throwing handler cannot strand ready fibers.
+  for (auto &[error, label] : failures) {
+    if (error_handler_) {
+      error_handler_(error, label);
+    } else {
+      errors_.push_back(std::move(error));
+    }
+  }
+}
+
+void FiberScheduler::suspend(Fiber &fiber) {
+  detail::FiberContext::switchTo(fiber.context, scheduler_context_);
+}
+
+void FiberScheduler::yield() {
+  Fiber *fiber = current_;
+  if (fiber == nullptr) {
+    throw std::logic_error("FiberScheduler::yield outside a fiber");
+  }
+  fiber->scheduler->makeReady(fiber);
+  fiber->scheduler->suspend(*fiber);
+}
+
+void FiberScheduler::sleepFor(std::chrono::nanoseconds duration) {
+  Fiber *fiber = current_;
+  if (fiber == nullptr) {
+    throw std::logic_error("FiberScheduler::sleepFor outside a fiber");
+  }
+  FiberScheduler *scheduler = fiber->scheduler;
+  scheduler->loop_.runAfter(
+      duration,
+      [scheduler, fiber, alive = scheduler->alive_] {
+        if (*alive) {
+          scheduler->makeReady(fiber);
+        }
+      },
+      fiber->label.empty() ? "fiber sleep" : fiber->label);
+  scheduler->suspend(*fiber);
+}
+
+void FiberScheduler::waitFor(EventLoop::Handle fd, bool writable) {
+  Fiber *fiber = current_;
+  if (fiber == nullptr) {
+    throw std::logic_error("FiberScheduler::waitFor outside a fiber");
+  }
+  fiber->scheduler->park(*fiber, fd, writable);
+}
+
+void FiberScheduler::hookWait(void *scheduler, EventLoop::Handle fd,
+                              bool writable) {
+  static_cast<FiberScheduler *>(scheduler)->park(*current_, fd, writable);
+}
+
+void FiberScheduler::park(Fiber &fiber, EventLoop::Handle fd, bool writable) {
+  auto [found, inserted] = waiters_.try_emplace(fd);
+  Waiters &waiters = found->second;
+  Fiber *&slot = writable ? waiters.writer : waiters.reader;
+  if (slot != nullptr) {
+    throw std::logic_error("another fiber is already waiting on descriptor");
+  }
+  if (!waiters.registered && loop_.contains(fd)) {
+    // Someone else's registration; modifying or removing it would break
+    // their handler.
+    if (inserted) {
+      waiters_.erase(found);
+    }
+    throw std::logic_error("descriptor is registered with the loop elsewhere");
+  }
+  slot = &fiber;
+  try {
+    updateInterest(fd, waiters);
+  } catch (...) {
+    slot = nullptr;
+    if (!waiters.registered) {
+      waiters_.erase(fd);
+    }
+    throw;
+  }
+  ++stats_.io_waits;
+  suspend(fiber);
+}
+
+void FiberScheduler::onReady(EventLoop::Handle fd, unsigned events) {
+  auto found = waiters_.find(fd);
+  if (found == waiters_.end()) {
+    return;
+  }
+  Waiters &waiters = found->second;
+  constexpr unsigned kFailure = EventLoop::Error | EventLoop::Hangup;
+  if (waiters.reader != nullptr &&
+      (events & (EventLoop::Readable | kFailure)) != 0) {
+    makeReady(std::exchange(waiters.reader, nullptr));
+  }
+  if (waiters.writer != nullptr &&
+      (events & (EventLoop::Writable | kFailure)) != 0) {
+    makeReady(std::exchange(waiters.writer, nullptr));
+  }
+  updateInterest(fd, waiters);
+}
+
+void FiberScheduler::updateInterest(EventLoop::Handle fd, Waiters &waiters) {
+  unsigned interest = 0;
+  if (waiters.reader != nullptr) {
+    interest |= EventLoop::Readable;
+  }
+  if (waiters.writer != nullptr) {
+    interest |= EventLoop::Writable;
+  }
+
+  if (interest == 0) {
+    if (waiters.registered) {
+      loop_.remove(fd);
+    }
+    waiters_.erase(fd);
+  } else if (waiters.registered) {
+    loop_.modify(fd, interest);
+  } else {
+    loop_.add(
+        fd, interest,
+        [this, fd, alive = alive_](unsigned events) {
+          if (*alive) {
+            onReady(fd, events);
+          }
+        },
+        "fiber io");
+    waiters.registered = true;
+  }
+}
+
+} // namespace net
@@ -0,0 +1,309 @@
+#include "net/core/hedging_client.h"
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <optional>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace net {
+
+namespace {
+
+std::size_t bucketOf(std::uint64_t ns) noexcept {
+  constexpr std::uint64_t sub = 8;
+  if (ns < sub) {
+    return static_cast<std::size_t>(ns);
+  }
+  const auto exponent = static_cast<std::uint64_t>(std::bit_width(ns) - 1);
+  const std::uint64_t minor = (ns >> (exponent - 3)) & (sub - 1);
+  return static_cast<std::size_t>((exponent - 2) * sub + minor);
+}
+
+/// Largest latency that falls into `bucket`.
+std::uint64_t bucketLimit(std::size_t bucket) noexcept {
+  constexpr std::size_t sub = 8;
+  if (bucket < sub) {
+    return bucket;
+  }
+  const std::size_t exponent = bucket / sub + 2;
+  const std::uint64_t minor = bucket % sub;
+  return ((sub + minor + 1) << (exponent - 3)) - 1;
+}
+
+} // namespace
+
+struct HedgingClient::Call {
+  struct Try {
+    std::size_t candidate = 0;
+    AttemptKind kind = AttemptKind::First;
+    Clock::time_point started;
+    std::optional<UpstreamHealth::Permit> permit;
+    Cancel cancel;
+    bool active = false;
+  };
+
+  std::vector<Endpoint> candidates;
+  Attempt attempt;
+  Callback callback;
+  Clock::time_point started;
+  std::size_t next = 0; ///< First candidate not tried yet
+  std::vector<Try> tries;
+  std::size_t active = 0;
+  std::optional<EventLoop::TimerId> timer;
+  bool hedged = false;
+  bool finished = false;
+  bool in_call = false; ///< Still inside call(); defer the callback
+};
+
+HedgingClient::HedgingClient(EventLoop &loop, Options options,
+                             std::shared_ptr<RetryBudget> budget,
+                             UpstreamHealth *health)
+    : loop_(loop), options_(options), budget_(std::move(budget)),
+      health_(health), window_start_(Clock::now()) {
+  if (!budget_) {
+    throw std::invalid_argument("hedging client needs a retry budget");
+  }
+  if (!(options_.percentile > 0.0 && options_.percentile <= 1.0)) {
+    throw std::invalid_argument("hedge percentile must be in (0, 1]");
+  }
+  if (options_.min_delay.count() < 0 ||
+      options_.max_delay < options_.min_delay ||
+      options_.window.count() <= 0) {
+    throw std::invalid_argument("invalid hedge delay bounds or window");
+  }
+  if (options_.max_attempts == 0) {
+    throw std::invalid_argument("max_attempts must be positive");
+  }
+}
+
+void HedgingClient::call(std::span<const Endpoint> candidates,
+                         Attempt attempt, Callback callback) {
+  auto call = std::make_shared<Call>();
+  call->candidates.assign(candidates.begin(), candidates.end());
+  call->attempt = std::move(attempt);
+  call->callback = std::move(callback);
+  call->started = Clock::now();
+  call->in_call = true;
+
+  ++stats_.calls;
+  budget_->deposit();
+  if (!startAttempt(call, AttemptKind::First)) {
+    ++stats_.unavailable;
+    finish(call, std::make_error_code(std::errc::resource_unavailable_try_again),
+           0);
+  }
+  call->in_call = false;
+}
+
+bool HedgingClient::startAttempt(const std::shared_ptr<Call> &call,
+                                 AttemptKind kind) {
+  const Clock::time_point now = Clock::now();
+
+  std::optional<UpstreamHealth::Permit> permit;
+  std::size_t candidate = call->next;
+  for (; candidate < call->candidates.size(); ++candidate) {
+    if (health_ == nullptr) {
+      break;
+    }
+    permit = health_->tryAcquire(call->candidates[candidate], now);
+    if (permit) {
+      break;
+    }
+  }
+  if (candidate >= call->candidates.size()) {
+    call->next = candidate;
+    return false;
+  }
+  if (kind != AttemptKind::First && !budget_->tryWithdraw(now)) {
+    ++stats_.budget_denied;
+    return false; // the permit is released unused
+  }
+  call->next = candidate + 1;
+
+  if (kind == AttemptKind::Hedge) {
+    ++stats_.hedges;
+    call->hedged = true;
+  } else if (kind == AttemptKind::Retry) {
+    ++stats_.retries;
+  }
+
+  const std::size_t index = call->tries.size();
+  Call::Try &attempt = call->tries.emplace_back();
+  attempt.candidate = candidate;
+  attempt.kind = kind;
+  attempt.started = now;
+  attempt.permit = std::move(permit);
+  attempt.active = true;
+  ++call->active;
+
+  // Hedge relative to the newest attempt while more are allowed.
+  if (call->timer) {
+    loop_.cancel(*call->timer);
+    call->timer.reset();
+  }
+  if (call->tries.size() < options_.max_attempts &&
+      call->next < call->candidates.size()) {
+    call->timer = loop_.runAfter(
+        hedgeDelay(now), [this, call] { onHedgeTimer(call); }, "hedge");
+  }
+
+  Cancel cancel = call->attempt(
+      call->candidates[candidate],
+      [this, call, index](std::error_code error) {
+        onDone(call, index, error);
+      });
+  // The attempt may have completed (and the call finished) synchronously.
+  if (call->tries[index].active) {
+    call->tries[index].cancel = std::move(cancel);
+  }
+  return true;
+}
+
+void HedgingClient::onDone(const std::shared_ptr<Call> &call,
+                           std::size_t index, std::error_code error) {
+  Call::Try &attempt = call->tries[index];
+  if (!attempt.active) {
+    return; // cancelled, or reported twice
+  }
+  attempt.active = false;
+  attempt.cancel = nullptr;
+  --call->active;
+
+  const Clock::time_point now = Clock::now();
+  const auto latency = std::chrono::duration_cast<std::chrono::nanoseconds>(
+      now - attempt.started);
+  const std::size_t candidate = attempt.candidate;
+
+  if (!error) {
+    if (attempt.permit) {
+      attempt.permit->success(latency, now);
+    }
+    if (attempt.kind == AttemptKind::Hedge) {
+      ++stats_.hedge_wins;
+    }
+    record(latency, now);
+    finish(call, {}, candidate);
+    return;
+  }
+
+  if (attempt.permit) {
+    attempt.permit->failure(now);
+    attempt.permit.reset();
+  }
+  if (call->active > 0) {
+    return; // a hedge is still in flight
+  }
+  if (call->tries.size() < options_.max_attempts &&
+      startAttempt(call, AttemptKind::Retry)) {
+    return;
+  }
+  if (!call->finished) {
+    finish(call, error, candidate);
+  }
+}
+
+void HedgingClient::onHedgeTimer(const std::shared_ptr<Call> &call) {
+  call->timer.reset();
+  if (call->finished || call->tries.size() >= options_.max_attempts) {
+    return;
+  }
+  startAttempt(call, AttemptKind::Hedge);
+}
+
+void HedgingClient::finish(const std::shared_ptr<Call> &call,
+                           std::error_code error, std::size_t candidate) {
+  call->finished = true;
+  if (call->timer) {
+    loop_.cancel(*call->timer);
+    call->timer.reset();
+  }
+
+  for (Call::Try &attempt : call->tries) {
+    if (!attempt.active) {
+      continue;
+    }
+    attempt.active = false;
+    --call->active;
+    attempt.permit.reset();
+    ++stats_.cancelled;
+    if (Cancel cancel = std::move(attempt.cancel)) {
+      cancel();
+    }
+  }
+
+  if (error) {
+    ++stats_.failed;
+  }
+  Result result;
+  result.error = error;
+  result.candidate = candidate;
+  result.attempts = static_cast<std::uint32_t>(call->tries.size());
+  result.hedged = call->hedged;
+  result.latency = std::chrono::duration_cast<std::chrono::nanoseconds>(
+      Clock::now() - call->started);
+
+  Callback callback = std::move(call->callback);
+  if (!callback) {
+    return;
+  }
+  if (call->in_call) {
+    loop_.post([callback = std::move(callback), result] { callback(result); },
+               "hedged call");
+  } else {
+    callback(result);
+  }
+}
+
+void HedgingClient::record(std::chrono::nanoseconds latency,
+                           Clock::time_point now) {
+  rotate(now);
+  const auto ns = static_cast<std::uint64_t>(std::max<std::int64_t>(
+      latency.count(), 0));
+  ++current_[std::min(bucketOf(ns), kBuckets - 1)];
+  ++current_count_;
+}
+
+std::chrono::nanoseconds HedgingClient::hedgeDelay(Clock::time_point now) {
+  rotate(now);
+  const std::uint64_t total = current_count_ + previous_count_;
+  if (total == 0 || total < options_.min_samples) {
+    return options_.max_delay;
+  }
+
+  const auto rank = static_cast<std::uint64_t>(
+      std::ceil(options_.percentile * static_cast<double>(total)));
+  std::uint64_t seen = 0;
+  std::uint64_t limit = 0;
+  for (std::size_t bucket = 0; bucket < kBuckets; ++bucket) {
+    seen += std::uint64_t{current_[bucket]} + previous_[bucket];
+    if (seen >= rank) {
+      limit = bucketLimit(bucket);
+      break;
+    }
+  }
+  return std::clamp<std::chrono::nanoseconds>(
+      std::chrono::nanoseconds(static_cast<std::int64_t>(
+          std::min<std::uint64_t>(limit, INT64_MAX))),
+      options_.min_delay, options_.max_delay);
+}
+
+void HedgingClient::rotate(Clock::time_point now) noexcept {
+  const auto age = now - window_start_;
+  if (age < options_.window) {
+    return;
+  }
+  if (age >= 2 * options_.window) {
+    previous_.fill(0);
+    previous_count_ = 0;
+  } else {
+    previous_ = current_;
+    previous_count_ = current_count_;
+  }
+  current_.fill(0);
+  current_count_ = 0;
+  window_start_ = now;
+}
+
+} // namespace net
@@ -0,0 +1,323 @@
+#include "net/core/io_capabilities.h"
+#include <atomic>
+#include <cstdlib>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+
+#ifndef _WIN32
+#include <cerrno>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <sys/utsname.h>
+#include <unistd.h>
+#endif
+
+#ifdef __linux__
+#include "net/detail/io_uring.h"
+#include <linux/filter.h>
+#include <linux/io_uring.h>
+#include <sys/epoll.h>
+#endif
+
+namespace net {
+
+namespace {
+
+#ifndef _WIN32
+
+/// Probe socket closed on scope exit.
+class ProbeSocket {
+public:
+  ProbeSocket() : fd_(::socket(AF_INET, SOCK_STREAM, 0)) {}
+  ~ProbeSocket() {
+    if (fd_ >= 0) {
+      ::close(fd_);
+    }
+  }
+  ProbeSocket(const ProbeSocket &) = delete;
+  ProbeSocket &operator=(const ProbeSocket &) = delete;
+
+  [[nodiscard]] int fd() const noexcept { return fd_; }
+
+private:
+  int fd_;
+};
+
+[[maybe_unused]] bool setFlag(int fd, int level, int name) {
+  int on = 1;
+  return ::setsockopt(fd, level, name, &on, sizeof(on)) == 0;
+}
+
+void probeSockets(IoCapabilities &caps) {
+#ifdef SO_REUSEPORT
+  {
+    ProbeSocket socket;
+    caps.reuseport = socket.fd() >= 0 &&
+                     setFlag(socket.fd(), SOL_SOCKET, SO_REUSEPORT);
+#ifdef SO_ATTACH_REUSEPORT_CBPF
+    if (caps.reuseport) {
+      // "return 0": always pick the first socket of the group.
+      sock_filter code[] = {BPF_STMT(BPF_RET | BPF_K, 0)};
+      sock_fprog program{1, code};
+      caps.reuseport_cbpf =
+          ::setsockopt(socket.fd(), SOL_SOCKET, SO_ATTACH_REUSEPORT_CBPF,
+                       &program, sizeof(program)) == 0;
+    }
+#endif
+  }
+#endif
+
+#ifdef SO_ZEROCOPY
+  {
+    ProbeSocket socket;
+    caps.so_zerocopy =
+        socket.fd() >= 0 && setFlag(socket.fd(), SOL_SOCKET, SO_ZEROCOPY);
+  }
+#endif
+
+#ifdef TCP_ZEROCOPY_RECEIVE
+  {
+    // On an unconnected socket a supporting kernel rejects the request
+    // itself (ENOTCONN, EINVAL); an unknown option is ENOPROTOOPT.
+    ProbeSocket socket;
+    tcp_zerocopy_receive request{};
+    socklen_t length = sizeof(request);
+    caps.tcp_zerocopy_receive =
+        socket.fd() >= 0 &&
+        (::getsockopt(socket.fd(), IPPROTO_TCP, TCP_ZEROCOPY_RECEIVE,
+                      &request, &length) == 0 ||
+         (errno != ENOPROTOOPT && errno != EOPNOTSUPP));
+  }
+#endif
+
+#if defined(__linux__) && defined(SOCK_CLOEXEC)
+  {
+    // Not listening: EINVAL if accept4 exists, ENOSYS if not.
+    ProbeSocket socket;
+    caps.accept4 = socket.fd() >= 0 &&
+                   ::accept4(socket.fd(), nullptr, nullptr, SOCK_CLOEXEC) < 0 &&
+                   errno != ENOSYS;
+  }
+#endif
+}
+
+#endif // !_WIN32
+
+#ifdef __linux__
+
+void probeIoUring(IoCapabilities &caps) {
+  if (!detail::IoUring::available()) {
+    return;
+  }
+  caps.io_uring = true;
+  try {
+    detail::IoUring ring(2);
+    const auto ops = ring.supportedOpcodes();
+    caps.io_uring_read_fixed = ops.test(IORING_OP_READ_FIXED);
+    caps.io_uring_send = ops.test(IORING_OP_SEND);
+    caps.io_uring_send_zc = ops.test(IORING_OP_SEND_ZC);
+    caps.io_uring_multishot_accept = ops.test(IORING_OP_SOCKET);
+    caps.io_uring_multishot_recv = ops.test(IORING_OP_SEND_ZC);
+  } catch (const std::system_error &) {
+    caps.io_uring = false;
+  }
+}
+
+#endif
+
+IoBackends bestBackends(const IoCapabilities &caps) {
+  IoBackends best;
+  best.poller = caps.epoll ? PollerBackend::Epoll : PollerBackend::Poll;
+  best.file_send =
+      caps.io_uring && caps.io_uring_read_fixed && caps.io_uring_send
+          ? FileSendBackend::IoUring
+          : FileSendBackend::ReadSend;
+  best.receive = caps.tcp_zerocopy_receive ? ReceiveBackend::ZeroCopy
+                                           : ReceiveBackend::Copy;
+  best.accept = caps.accept4 ? AcceptBackend::Accept4 : AcceptBackend::Accept;
+  return best;
+}
+
+/// Each feature's fallback backend works everywhere; a request for a fast
+/// path the kernel lacks resolves to whatever is best.
+IoBackends resolveBackends(IoBackends chosen, const IoBackends &best) {
+  if (chosen.poller == PollerBackend::Epoll) {
+    chosen.poller = best.poller;
+  }
+  if (chosen.file_send == FileSendBackend::IoUring) {
+    chosen.file_send = best.file_send;
+  }
+  if (chosen.receive == ReceiveBackend::ZeroCopy) {
+    chosen.receive = best.receive;
+  }
+  if (chosen.accept == AcceptBackend::Accept4) {
+    chosen.accept = best.accept;
+  }
+  return chosen;
+}
+
+std::string_view trim(std::string_view text) {
+  const auto first = text.find_first_not_of(" \t");
+  if (first == std::string_view::npos) {
+    return {};
+  }
+  const auto last = text.find_last_not_of(" \t");
+  return text.substr(first, last - first + 1);
+}
+
+template <typename Backend>
+Backend parseBackend(std::string_view feature, std::string_view name,
+                     std::initializer_list<Backend> choices) {
+  for (Backend choice : choices) {
+    if (toString(choice) == name) {
+      return choice;
+    }
+  }
+  throw std::invalid_argument("unknown " + std::string(feature) +
+                              " backend: " + std::string(name));
+}
+
+IoBackends initialBackends() {
+  const IoCapabilities &caps = ioCapabilities();
+  if (const char *overrides = std::getenv("NETLIB_IO_BACKENDS")) {
+    try {
+      return selectIoBackends(caps, overrides);
+    } catch (const std::invalid_argument &) {
+      // Misconfiguration must not stop the process; use the defaults.
+    }
+  }
+  return selectIoBackends(caps);
+}
+
+std::atomic<IoBackends> &selection() {
+  static std::atomic<IoBackends> backends{initialBackends()};
+  return backends;
+}
+
+const char *yesNo(bool value) { return value ? "yes" : "no"; }
+
+} // namespace
+
+IoCapabilities probeIoCapabilities() {
+  IoCapabilities caps;
+#ifndef _WIN32
+  utsname name{};
+  if (::uname(&name) == 0) {
+    caps.kernel = name.release;
+  }
+  probeSockets(caps);
+#endif
+#ifdef __linux__
+  const int epoll = ::epoll_create1(EPOLL_CLOEXEC);
+  if (epoll >= 0) {
+    caps.epoll = true;
+    ::close(epoll);
+  }
+  probeIoUring(caps);
+#endif
+  return caps;
+}
+
+const IoCapabilities &ioCapabilities() {
+  static const IoCapabilities capabilities = probeIoCapabilities();
+  return capabilities;
+}
+
+IoBackends selectIoBackends(const IoCapabilities &capabilities,
+                            std::string_view overrides) {
+  const IoBackends best = bestBackends(capabilities);
+  IoBackends chosen = best;
+
+  while (!overrides.empty()) {
+    const auto comma = overrides.find(',');
+    const std::string_view item = trim(overrides.substr(0, comma));
+    overrides = comma == std::string_view::npos ? std::string_view{}
+                                                : overrides.substr(comma + 1);
+    if (item.empty()) {
+      continue;
+    }
+    const auto equals = item.find('=');
+    if (equals == std::string_view::npos) {
+      throw std::invalid_argument("I/O backend override needs feature=name: " +
+                                  std::string(item));
+    }
+    const std::string_view feature = trim(item.substr(0, equals));
+    const std::string_view name = trim(item.substr(equals + 1));
+
+    if (feature == "poller") {
+      chosen.poller = parseBackend(feature, name,
+                                   {PollerBackend::Epoll, PollerBackend::Poll});
+    } else if (feature == "file_send") {
+      chosen.file_send = parseBackend(
+          feature, name, {FileSendBackend::IoUring, FileSendBackend::ReadSend});
+    } else if (feature == "receive") {
+      chosen.receive = parseBackend(
+          feature, name, {ReceiveBackend::ZeroCopy, ReceiveBackend::Copy});
+    } else if (feature == "accept") {
+      chosen.accept = parseBackend(
+          feature, name, {AcceptBackend::Accept4, AcceptBackend::Accept});
+    } else {
+      throw std::invalid_argument("unknown I/O feature: " +
+                                  std::string(feature));
+    }
+  }
+
+  return resolveBackends(chosen, best);
+}
+
+IoBackends ioBackends() {
+  return selection().load(std::memory_order_acquire);
+}
+
+void setIoBackends(const IoBackends &backends) {
+  selection().store(
+      resolveBackends(backends, bestBackends(ioCapabilities())),
+      std::memory_order_release);
+}
+
+std::string_view toString(PollerBackend backend) noexcept {
+  return backend == PollerBackend::Epoll ? "epoll" : "poll";
+}
+
+std::string_view toString(FileSendBackend backend) noexcept {
+  return backend == FileSendBackend::IoUring ? "io_uring" : "read_send";
+}
+
+std::string_view toString(ReceiveBackend backend) noexcept {
+  return backend == ReceiveBackend::ZeroCopy ? "zerocopy" : "copy";
+}
+
+std::string_view toString(AcceptBackend backend) noexcept {
+  return backend == AcceptBackend::Accept4 ? "accept4" : "accept";
+}
+
+std::string describeIo(const IoCapabilities &capabilities,
+                       const IoBackends &backends) {
+  const IoCapabilities &c = capabilities;
+  std::string report;
+  auto line = [&report](std::string_view name, std::string_view value) {
+    report.append(name).append(": ").append(value).append("\n");
+  };
+  line("kernel", c.kernel.empty() ? "unknown" : c.kernel);
+  line("epoll", yesNo(c.epoll));
+  line("io_uring", yesNo(c.io_uring));
+  line("io_uring.read_fixed", yesNo(c.io_uring_read_fixed));
+  line("io_uring.send", yesNo(c.io_uring_send));
+  line("io_uring.send_zc", yesNo(c.io_uring_send_zc));
+  line("io_uring.multishot_accept", yesNo(c.io_uring_multishot_accept));
+  line("io_uring.multishot_recv", yesNo(c.io_uring_multishot_recv));
+  line("so_zerocopy", yesNo(c.so_zerocopy));
+  line("tcp_zerocopy_receive", yesNo(c.tcp_zerocopy_receive));
+  line("accept4", yesNo(c.accept4));
+  line("reuseport", yesNo(c.reuseport));
+  line("reuseport_cbpf", yesNo(c.reuseport_cbpf));
+  line("backend.poller", toString(backends.poller));
+  line("backend.file_send", toString(backends.file_send));
+  line("backend.receive", toString(backends.receive));
+  line("backend.accept", toString(backends.accept));
+  return report;
+}
+
+} // namespace net
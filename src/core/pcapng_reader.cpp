@@ -0,0 +1,237 @@
+#include "net/core/pcapng_reader.h"
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cerrno>
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+#include <system_error>
+
+namespace net {
+
+namespace {
+
+constexpr std::uint32_t section_header_type = 0x0A0D0D0A;
+constexpr std::uint32_t interface_description_type = 0x00000001;
+constexpr std::uint32_t simple_packet_type = 0x00000003;
+constexpr std::uint32_t enhanced_packet_type = 0x00000006;
+constexpr std::uint32_t byte_order_magic = 0x1A2B3C4D;
+
+constexpr std::uint16_t option_end = 0;
+constexpr std::uint16_t option_if_tsresol = 9;
+
+/// Refuse absurd block lengths instead of allocating them.
+constexpr std::uint32_t max_block_length = 256 * 1024 * 1024;
+
+constexpr std::uint64_t pow10(unsigned exponent) noexcept {
+  std::uint64_t value = 1;
+  while (exponent-- > 0) {
+    value *= 10;
+  }
+  return value;
+}
+
+} // namespace
+
+PcapngReader::PcapngReader(const std::string &path)
+    : in_(path, std::ios::binary) {
+  if (!in_) {
+    throw std::system_error(errno, std::generic_category(),
+                            "open(pcapng file) failed");
+  }
+  std::uint32_t first = 0;
+  in_.read(reinterpret_cast<char *>(&first), sizeof(first));
+  if (in_.gcount() != sizeof(first) || first != section_header_type) {
+    throw std::runtime_error("pcapng: missing section header");
+  }
+  in_.seekg(0);
+
+  std::uint32_t type = 0;
+  readBlock(type, body_);
+  startSection(body_);
+}
+
+std::optional<PcapngPacket> PcapngReader::next() {
+  std::uint32_t type = 0;
+  while (readBlock(type, body_)) {
+    switch (type) {
+    case section_header_type:
+      startSection(body_);
+      break;
+    case interface_description_type:
+      addInterface(body_);
+      break;
+    case enhanced_packet_type: {
+      if (body_.size() < 20) {
+        throw std::runtime_error("pcapng: truncated packet block");
+      }
+      PcapngPacket packet;
+      packet.interface = load32(body_.data());
+      if (packet.interface >= interfaces_.size()) {
+        throw std::runtime_error("pcapng: packet for unknown interface");
+      }
+      const Interface &interface = interfaces_[packet.interface];
+      const std::uint64_t ticks =
+          (static_cast<std::uint64_t>(load32(body_.data() + 4)) << 32) |
+          load32(body_.data() + 8);
+      const std::uint32_t captured = load32(body_.data() + 12);
+      if (captured > body_.size() - 20) {
+        throw std::runtime_error("pcapng: packet data out of bounds");
+      }
+      packet.timestamp_ns = toNanoseconds(interface, ticks);
+      packet.link_type = interface.link_type;
+      packet.original_length = load32(body_.data() + 16);
+      packet.data.assign(body_.begin() + 20, body_.begin() + 20 + captured);
+      return packet;
+    }
+    case simple_packet_type: {
+      if (body_.size() < 4 || interfaces_.empty()) {
+        throw std::runtime_error("pcapng: malformed simple packet block");
+      }
+      // The captured length is implied by the block and the snap length.
+      PcapngPacket packet;
+      packet.link_type = interfaces_.front().link_type;
+      packet.original_length = load32(body_.data());
+      std::size_t captured =
+          std::min<std::size_t>(packet.original_length, body_.size() - 4);
+      if (interfaces_.front().snap_length != 0) {
+        captured = std::min<std::size_t>(captured,
+                                         interfaces_.front().snap_length);
+      }
+      packet.data.assign(body_.begin() + 4, body_.begin() + 4 + captured);
+      return packet;
+    }
+    default:
+      break; // statistics, name resolution, custom blocks...
+    }
+  }
+  return std::nullopt;
+}
+
+bool PcapngReader::readBlock(std::uint32_t &type,
+                             std::vector<std::byte> &body) {
+  std::array<std::byte, 8> header{};
+  in_.read(reinterpret_cast<char *>(header.data()), header.size());
+  if (in_.gcount() == 0 && in_.eof()) {
+    return false;
+  }
+  if (in_.gcount() != static_cast<std::streamsize>(header.size())) {
+    throw std::runtime_error("pcapng: truncated block header");
+  }
+  // Type 0 with length 0 is no valid block: it is the zero-filled tail of
+  // a preallocated capture (PcapngWriter before its destructor truncates).
+  if (std::ranges::all_of(header,
+                          [](std::byte b) { return b == std::byte{0}; })) {
+    return false;
+  }
+
+  std::uint32_t raw_type = 0;
+  std::memcpy(&raw_type, header.data(), sizeof(raw_type));
+
+  std::size_t prefix = 0;
+  if (raw_type == section_header_type) {
+    // A section header's type reads the same in both byte orders; its
+    // magic decides how this and every later block is decoded.
+    std::array<std::byte, 4> magic{};
+    in_.read(reinterpret_cast<char *>(magic.data()), magic.size());
+    if (in_.gcount() != static_cast<std::streamsize>(magic.size())) {
+      throw std::runtime_error("pcapng: truncated section header");
+    }
+    std::uint32_t value = 0;
+    std::memcpy(&value, magic.data(), sizeof(value));
+    if (value == byte_order_magic) {
+      swapped_ = false;
+    } else if (value == std::byteswap(byte_order_magic)) {
+      swapped_ = true;
+    } else {
+      throw std::runtime_error("pcapng: bad byte-order magic");
+    }
+    body.assign(magic.begin(), magic.end());
+    prefix = magic.size();
+  }
+
+  type = load32(header.data());
+  const std::uint32_t length = load32(header.data() + 4);
+  if (length < 12 + prefix || length % 4 != 0) {
+    throw std::runtime_error("pcapng: invalid block length");
+  }
+  if (length > max_block_length) {
+    throw std::runtime_error("pcapng: block too large");
+  }
+
+  body.resize(length - 12);
+  const auto remaining = static_cast<std::streamsize>(body.size() - prefix);
+  in_.read(reinterpret_cast<char *>(body.data() + prefix), remaining);
+  std::array<std::byte, 4> trailer{};
+  in_.read(reinterpret_cast<char *>(trailer.data()), trailer.size());
+  if (!in_) {
+    throw std::runtime_error("pcapng: truncated block");
+  }
+  if (load32(trailer.data()) != length) {
+    throw std::runtime_error("pcapng: block length mismatch");
+  }
+  return true;
+}
+
+void PcapngReader::startSection(const std::vector<std::byte> &body) {
+  // magic, major, minor, section length
+  if (body.size() < 16 || load16(body.data() + 4) != 1) {
+    throw std::runtime_error("pcapng: unsupported section version");
+  }
+  interfaces_.clear();
+}
+
+void PcapngReader::addInterface(const std::vector<std::byte> &body) {
+  if (body.size() < 8) {
+    throw std::runtime_error("pcapng: truncated interface description");
+  }
+  Interface interface;
+  interface.link_type = load16(body.data());
+  interface.snap_length = load32(body.data() + 4);
+
+  std::size_t offset = 8;
+  while (offset + 4 <= body.size()) {
+    const std::uint16_t code = load16(body.data() + offset);
+    const std::uint16_t length = load16(body.data() + offset + 2);
+    if (code == option_end || offset + 4 + length > body.size()) {
+      break;
+    }
+    if (code == option_if_tsresol && length >= 1) {
+      const auto value = std::to_integer<std::uint8_t>(body[offset + 4]);
+      interface.binary = (value & 0x80) != 0;
+      interface.exponent = value & 0x7F;
+    }
+    offset += 4 + ((length + 3u) & ~3u);
+  }
+  interfaces_.push_back(interface);
+}
+
+std::uint16_t PcapngReader::load16(const std::byte *p) const noexcept {
+  std::uint16_t value = 0;
+  std::memcpy(&value, p, sizeof(value));
+  return swapped_ ? std::byteswap(value) : value;
+}
+
+std::uint32_t PcapngReader::load32(const std::byte *p) const noexcept {
+  std::uint32_t value = 0;
+  std::memcpy(&value, p, sizeof(value));
+  return swapped_ ? std::byteswap(value) : value;
+}
+
+std::uint64_t PcapngReader::toNanoseconds(const Interface &interface,
+                                          std::uint64_t ticks) noexcept {
+  if (interface.binary) {
+    return static_cast<std::uint64_t>(static_cast<long double>(ticks) * 1e9L /
+                                      std::ldexp(1.0L, interface.exponent));
+  }
+  if (interface.exponent <= 9) {
+    return ticks * pow10(9 - interface.exponent);
+  }
+  if (interface.exponent >= 29) {
+    return 0; // finer than 10^-28 s: any 64-bit tick count is below 1 ns
+  }
+  return ticks / pow10(interface.exponent - 9);
+}
+
+} // namespace net
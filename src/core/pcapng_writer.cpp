@@ -0,0 +1,162 @@
+#include "net/core/pcapng_writer.h"
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <stdexcept>
+#include <system_error>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+namespace net {
+
+namespace {
+
+constexpr std::uint32_t section_header_type = 0x0A0D0D0A;
+constexpr std::uint32_t interface_description_type = 0x00000001;
+constexpr std::uint32_t enhanced_packet_type = 0x00000006;
+constexpr std::uint32_t byte_order_magic = 0x1A2B3C4D;
+
+constexpr std::size_t section_header_size = 28;
+constexpr std::size_t interface_description_size = 32;
+/// Enhanced Packet Block without data: 28 bytes of header, 4 of trailer.
+constexpr std::size_t packet_overhead = 32;
+
+constexpr std::uint16_t option_end = 0;
+constexpr std::uint16_t option_if_tsresol = 9;
+constexpr std::uint8_t nanosecond_resolution = 9;
+
+constexpr std::size_t padded(std::size_t length) noexcept {
+  return (length + 3) & ~std::size_t{3};
+}
+
+/// Store a host-order integer; pcapng readers use the byte-order magic.
+template <typename T> std::byte *put(std::byte *out, T value) noexcept {
+  std::memcpy(out, &value, sizeof(value));
+  return out + sizeof(value);
+}
+
+} // namespace
+
+PcapngWriter::PcapngWriter(const std::string &path, Options options)
+    : capacity_(options.capacity), snap_length_(options.snap_length) {
+  if (capacity_ < section_header_size + interface_description_size) {
+    throw std::invalid_argument("pcapng capacity too small for headers");
+  }
+  if (snap_length_ == 0) {
+    throw std::invalid_argument("pcapng snap length must be positive");
+  }
+
+  fd_ = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+  if (fd_ < 0) {
+    throw std::system_error(errno, std::generic_category(),
+                            "open(pcapng file) failed");
+  }
+  if (::ftruncate(fd_, static_cast<off_t>(capacity_)) != 0) {
+    const int err = errno;
+    ::close(fd_);
+    throw std::system_error(err, std::generic_category(),
+                            "ftruncate(pcapng file) failed");
+  }
+  void *mapping = ::mmap(nullptr, capacity_, PROT_READ | PROT_WRITE,
+                         MAP_SHARED, fd_, 0);
+  if (mapping == MAP_FAILED) {
+    const int err = errno;
+    ::close(fd_);
+    throw std::system_error(err, std::generic_category(),
+                            "mmap(pcapng file) failed");
+  }
+  base_ = static_cast<std::byte *>(mapping);
+
+  // Section Header Block; the section length is left unspecified (-1).
+  std::byte *out = base_;
+  out = put(out, section_header_type);
+  out = put(out, static_cast<std::uint32_t>(section_header_size));
+  out = put(out, byte_order_magic);
+  out = put(out, std::uint16_t{1});
+  out = put(out, std::uint16_t{0});
+  out = put(out, std::int64_t{-1});
+  out = put(out, static_cast<std::uint32_t>(section_header_size));
+
+  // Interface Description Block with if_tsresol = 10^-9.
+  out = put(out, interface_description_type);
+  out = put(out, static_cast<std::uint32_t>(interface_description_size));
+  out = put(out, link_type);
+  out = put(out, std::uint16_t{0});
+  out = put(out, snap_length_);
+  out = put(out, option_if_tsresol);
+  out = put(out, std::uint16_t{1});
+  out = put(out, nanosecond_resolution);
+  out += 3; // option padding, already zero
+  out = put(out, option_end);
+  out = put(out, std::uint16_t{0});
+  out = put(out, static_cast<std::uint32_t>(interface_description_size));
+
+  tail_.store(static_cast<std::size_t>(out - base_), std::memory_order_relaxed);
+}
+
+PcapngWriter::~PcapngWriter() {
+  ::munmap(base_, capacity_);
+  (void)::ftruncate(fd_,
+                    static_cast<off_t>(tail_.load(std::memory_order_relaxed)));
+  ::close(fd_);
+}
+
+bool PcapngWriter::write(std::span<const std::byte> head,
+                         std::span<const std::byte> body,
+                         std::uint64_t timestamp_ns) noexcept {
+  const std::size_t original = head.size() + body.size();
+  const std::size_t captured =
+      std::min<std::size_t>(original, snap_length_);
+  const std::size_t block = packet_overhead + padded(captured);
+
+  // Reserve the block. Compare-exchange rather than fetch_add so a packet
+  // that does not fit leaves the tail untouched for smaller ones.
+  std::size_t offset = tail_.load(std::memory_order_relaxed);
+  do {
+    if (block > capacity_ - offset) {
+      dropped_.fetch_add(1, std::memory_order_relaxed);
+      return false;
+    }
+  } while (!tail_.compare_exchange_weak(offset, offset + block,
+                                        std::memory_order_relaxed));
+
+  std::byte *out = base_ + offset;
+  out = put(out, enhanced_packet_type);
+  out = put(out, static_cast<std::uint32_t>(block));
+  out = put(out, std::uint32_t{0}); // interface id
+  out = put(out, static_cast<std::uint32_t>(timestamp_ns >> 32));
+  out = put(out, static_cast<std::uint32_t>(timestamp_ns));
+  out = put(out, static_cast<std::uint32_t>(captured));
+  out = put(out, static_cast<std::uint32_t>(original));
+
+  const std::size_t from_head = std::min(head.size(), captured);
+  std::memcpy(out, head.data(), from_head);
+  if (captured > from_head) {
+    std::memcpy(out + from_head, body.data(), captured - from_head);
+  }
+  out += padded(captured); // padding is still zero from ftruncate
+  put(out, static_cast<std::uint32_t>(block));
+
+  packets_.fetch_add(1, std::memory_order_relaxed);
+  return true;
+}
+
+PcapngWriter::Stats PcapngWriter::stats() const noexcept {
+  Stats stats;
+  stats.packets = packets_.load(std::memory_order_relaxed);
+  stats.dropped = dropped_.load(std::memory_order_relaxed);
+  stats.bytes = tail_.load(std::memory_order_relaxed);
+  return stats;
+}
+
+std::uint64_t PcapngWriter::now() noexcept {
+  return static_cast<std::uint64_t>(
+      std::chrono::duration_cast<std::chrono::nanoseconds>(
+          std::chrono::system_clock::now().time_since_epoch())
+          .count());
+}
+
+} // namespace net
@@ -0,0 +1,51 @@
+#include "net/core/retry_budget.h"
+#include <algorithm>
+#include <stdexcept>
+
+namespace net {
+
+RetryBudget::RetryBudget(Options options, Clock::time_point now)
+    : options_(options), refilled_(now) {
+  if (!(options_.ratio >= 0.0) || !(options_.min_per_second >= 0.0)) {
+    throw std::invalid_argument(
+        "retry budget ratio and rate must not be negative");
+  }
+  if (!(options_.burst >= 1.0)) {
+    throw std::invalid_argument("retry budget burst must be at least one");
+  }
+  balance_ = std::min(options_.min_per_second, options_.burst);
+}
+
+void RetryBudget::deposit() noexcept {
+  std::lock_guard lock(mutex_);
+  balance_ = std::min(balance_ + options_.ratio, options_.burst);
+}
+
+bool RetryBudget::tryWithdraw(Clock::time_point now) noexcept {
+  std::lock_guard lock(mutex_);
+  refillLocked(now);
+  if (balance_ < 1.0) {
+    return false;
+  }
+  balance_ -= 1.0;
+  return true;
+}
+
+double RetryBudget::balance(Clock::time_point now) noexcept {
+  std::lock_guard lock(mutex_);
+  refillLocked(now);
+  return balance_;
+}
+
+void RetryBudget::refillLocked(Clock::time_point now) noexcept {
+  if (now <= refilled_) {
+    return;
+  }
+  const std::chrono::duration<double> elapsed = now - refilled_;
+  balance_ =
+      std::min(balance_ + elapsed.count() * options_.min_per_second,
+               options_.burst);
+  refilled_ = now;
+}
+
+} // namespace net
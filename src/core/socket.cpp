@@ -6,12 +6,15 @@ Socket::Socket(Handle handle, SocketFlags::AddressFamily address_family,
                SocketFlags::SocketType socket_type,
                SocketFlags::ProtocolType protocol_type,
                SocketFlags::BlockingType blocking,
-               SocketFlags::InheritableType inheritable) noexcept
+               SocketFlags::InheritableType inheritable,
+               bool configured) noexcept
     : address_family_(address_family), socket_type_(socket_type),
       protocol_type_(protocol_type), blocking_(blocking),
       inheritable_(inheritable), handle_(handle) {
-  setBlocking(blocking);
-  setInheritable(inheritable);
+  if (!configured) {
+    setBlocking(blocking);
+    setInheritable(inheritable);
+  }
 }
 
 Socket::Socket(Socket &&other) noexcept
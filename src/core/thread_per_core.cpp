@@ -0,0 +1,197 @@
+#include "net/core/thread_per_core.h"
+#include <algorithm>
+#include <stdexcept>
+#include <utility>
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+namespace net {
+
+namespace {
+
+thread_local ThreadPerCoreRuntime::Core *current_core = nullptr;
+
+/// Pin the calling thread to the `index`-th CPU it is allowed to run on.
+void pin_current_thread(std::size_t index) {
+#ifdef __linux__
+  cpu_set_t allowed;
+  CPU_ZERO(&allowed);
+  if (::sched_getaffinity(0, sizeof(allowed), &allowed) != 0) {
+    return;
+  }
+  std::vector<int> cpus;
+  for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+    if (CPU_ISSET(cpu, &allowed)) {
+      cpus.push_back(cpu);
+    }
+  }
+  if (cpus.empty()) {
+    return;
+  }
+  cpu_set_t target;
+  CPU_ZERO(&target);
+  CPU_SET(cpus[index % cpus.size()], &target);
+  // Best effort: an unpinned core still works, just with less locality.
+  ::pthread_setaffinity_np(::pthread_self(), sizeof(target), &target);
+#else
+  (void)index;
+#endif
+}
+
+} // namespace
+
+ThreadPerCoreRuntime::Core::Core(ThreadPerCoreRuntime &runtime,
+                                 std::size_t index, const Options &options)
+    : runtime_(runtime), index_(index), loop_(options.loop),
+      buffers_(options.buffer_size, options.buffers_per_core, &memory_) {
+  loop_.setIterationHook([this] { drainInbox(); }, "core inbox");
+}
+
+std::size_t ThreadPerCoreRuntime::Core::coreCount() const noexcept {
+  return runtime_.coreCount();
+}
+
+bool ThreadPerCoreRuntime::Core::send(std::size_t target, Message &&message) {
+  if (target >= runtime_.coreCount()) {
+    throw std::out_of_range("ThreadPerCoreRuntime core index out of range");
+  }
+  if (!runtime_.queue(index_, target).push(std::move(message))) {
+    return false;
+  }
+  // For a message to this core sent while its inbox is being drained,
+  // this keeps the next wait from blocking on an already-queued message.
+  runtime_.cores_[target]->loop_.wakeup();
+  return true;
+}
+
+void ThreadPerCoreRuntime::Core::drainInbox() {
+  const std::size_t cores = runtime_.coreCount();
+  for (std::size_t from = 0; from < cores; ++from) {
+    auto &inbox = runtime_.queue(from, index_);
+    while (auto message = inbox.pop()) {
+      ++received_;
+      try {
+        (*message)(*this);
+      } catch (...) {
+        // One bad message must not take the core's loop down with it.
+        ++failed_;
+      }
+    }
+  }
+}
+
+ThreadPerCoreRuntime::ThreadPerCoreRuntime(Options options)
+    : options_(std::move(options)) {
+  if (options_.queue_capacity == 0) {
+    throw std::invalid_argument("queue_capacity must be positive");
+  }
+  std::size_t cores = options_.cores;
+  if (cores == 0) {
+    cores = std::max(1u, std::thread::hardware_concurrency());
+  }
+
+  cores_.reserve(cores);
+  for (std::size_t i = 0; i < cores; ++i) {
+    cores_.push_back(std::unique_ptr<Core>(new Core(*this, i, options_)));
+  }
+  queues_.reserve(cores * cores);
+  for (std::size_t i = 0; i < cores * cores; ++i) {
+    queues_.push_back(std::make_unique<detail::SpscQueue<Message>>(
+        options_.queue_capacity));
+  }
+}
+
+ThreadPerCoreRuntime::~ThreadPerCoreRuntime() { stop(); }
+
+Endpoint ThreadPerCoreRuntime::listen(const Endpoint &endpoint,
+                                      AcceptHandler handler) {
+  if (!threads_.empty()) {
+    throw std::logic_error("ThreadPerCoreRuntime::listen while running");
+  }
+  const auto family = endpoint.data()->sa_family == AF_INET6
+                          ? TcpSocket::AddressFamily::IPV6
+                          : TcpSocket::AddressFamily::IPV4;
+  auto shared = std::make_shared<AcceptHandler>(std::move(handler));
+
+  Endpoint bound = endpoint;
+  for (auto &core : cores_) {
+    auto listener = std::make_unique<TcpSocket>(
+        family, TcpSocket::BlockingType::NonBlocking);
+    listener->setReusePort(true);
+    listener->bind(bound);
+    listener->listen();
+    if (core->index_ == 0) {
+      bound = listener->localEndpoint();
+    }
+
+    auto acceptor = std::make_unique<TcpAcceptor>(
+        *listener,
+        TcpAcceptor::Options{.raise_descriptor_limit = core->index_ == 0});
+    Core *owner = core.get();
+    TcpAcceptor *accepting = acceptor.get();
+    core->loop_.add(
+        listener->native_handle(), EventLoop::Readable,
+        [owner, accepting, shared](unsigned) {
+          Endpoint peer;
+          while (auto connection = accepting->accept(peer)) {
+            (*shared)(*owner, std::move(*connection), peer);
+            peer = Endpoint{};
+          }
+        },
+        "accept");
+
+    core->listeners_.push_back(std::move(listener));
+    core->acceptors_.push_back(std::move(acceptor));
+  }
+  return bound;
+}
+
+void ThreadPerCoreRuntime::start(std::function<void(Core &)> init) {
+  if (!threads_.empty()) {
+    throw std::logic_error("ThreadPerCoreRuntime already running");
+  }
+  threads_.reserve(cores_.size());
+  for (auto &core : cores_) {
+    threads_.emplace_back(
+        [this, owner = core.get(), init] { runCore(*owner, init); });
+  }
+}
+
+void ThreadPerCoreRuntime::runCore(Core &core,
+                                   const std::function<void(Core &)> &init) {
+  current_core = &core;
+  if (options_.pin_threads) {
+    pin_current_thread(core.index_);
+  }
+  if (init) {
+    init(core);
+  }
+  core.loop_.run();
+  current_core = nullptr;
+}
+
+void ThreadPerCoreRuntime::stop() {
+  for (auto &core : cores_) {
+    core->loop_.stop();
+  }
+  for (auto &thread : threads_) {
+    thread.join();
+  }
+  threads_.clear();
+}
+
+void ThreadPerCoreRuntime::submit(std::size_t core, Message message) {
+  Core *target = cores_.at(core).get();
+  target->loop_.post([target, message = std::move(message)] {
+    message(*target);
+  }, "submitted message");
+}
+
+ThreadPerCoreRuntime::Core *ThreadPerCoreRuntime::currentCore() noexcept {
+  return current_core;
+}
+
+} // namespace net
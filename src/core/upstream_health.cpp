@@ -0,0 +1,297 @@
+#include "net/core/upstream_health.h"
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace net {
+
+// ---- Permit ----
+
+UpstreamHealth::Permit::Permit(Permit &&other) noexcept
+    : owner_(std::exchange(other.owner_, nullptr)),
+      host_(std::move(other.host_)), started_(other.started_),
+      probe_(other.probe_) {}
+
+UpstreamHealth::Permit &
+UpstreamHealth::Permit::operator=(Permit &&other) noexcept {
+  if (this != &other) {
+    if (owner_ != nullptr) {
+      owner_->complete(*host_, probe_, Outcome::Cancelled, {}, Clock::now());
+    }
+    owner_ = std::exchange(other.owner_, nullptr);
+    host_ = std::move(other.host_);
+    started_ = other.started_;
+    probe_ = other.probe_;
+  }
+  return *this;
+}
+
+UpstreamHealth::Permit::~Permit() {
+  if (owner_ != nullptr) {
+    owner_->complete(*host_, probe_, Outcome::Cancelled, {}, Clock::now());
+  }
+}
+
+void UpstreamHealth::Permit::success(Clock::time_point now) {
+  success(std::chrono::duration_cast<std::chrono::nanoseconds>(now - started_),
+          now);
+}
+
+void UpstreamHealth::Permit::success(std::chrono::nanoseconds latency,
+                                     Clock::time_point now) {
+  if (owner_ == nullptr) {
+    throw std::logic_error("outcome already reported for this permit");
+  }
+  std::exchange(owner_, nullptr)
+      ->complete(*host_, probe_, Outcome::Success, latency, now);
+}
+
+void UpstreamHealth::Permit::failure(Clock::time_point now) {
+  if (owner_ == nullptr) {
+    throw std::logic_error("outcome already reported for this permit");
+  }
+  std::exchange(owner_, nullptr)
+      ->complete(*host_, probe_, Outcome::Failure, {}, now);
+}
+
+const Endpoint &UpstreamHealth::Permit::endpoint() const noexcept {
+  return host_->endpoint;
+}
+
+// ---- UpstreamHealth ----
+
+UpstreamHealth::UpstreamHealth(Options options) : options_(options) {
+  if (!(options_.max_ejection_fraction >= 0.0 &&
+        options_.max_ejection_fraction <= 1.0)) {
+    throw std::invalid_argument("max_ejection_fraction must be in [0, 1]");
+  }
+  if (options_.interval.count() <= 0 || options_.base_ejection.count() <= 0 ||
+      options_.max_ejection < options_.base_ejection) {
+    throw std::invalid_argument("interval and ejection times must be "
+                                "positive, max_ejection >= base_ejection");
+  }
+  if (options_.half_open_probes == 0) {
+    throw std::invalid_argument("half_open_probes must be positive");
+  }
+}
+
+std::optional<UpstreamHealth::Permit>
+UpstreamHealth::tryAcquire(const Endpoint &endpoint, Clock::time_point now) {
+  std::lock_guard lock(mutex_);
+  analyzeLocked(now);
+
+  auto &slot = hosts_[endpoint];
+  if (!slot) {
+    slot = std::make_shared<Host>();
+    slot->endpoint = endpoint;
+  }
+  Host &host = *slot;
+  refresh(host, now);
+
+  switch (host.state) {
+  case State::Ejected:
+    return std::nullopt;
+  case State::HalfOpen:
+    if (host.probing >= options_.half_open_probes) {
+      return std::nullopt;
+    }
+    ++host.probing;
+    ++host.pending;
+    return Permit(this, slot, now, true);
+  case State::Healthy:
+    break;
+  }
+
+  if (options_.max_pending != 0 && host.pending >= options_.max_pending) {
+    ++host.overflows;
+    return std::nullopt;
+  }
+  ++host.pending;
+  return Permit(this, slot, now, false);
+}
+
+UpstreamHealth::State UpstreamHealth::state(const Endpoint &endpoint,
+                                            Clock::time_point now) const {
+  return stats(endpoint, now).state;
+}
+
+UpstreamHealth::Stats UpstreamHealth::stats(const Endpoint &endpoint,
+                                            Clock::time_point now) const {
+  std::lock_guard lock(mutex_);
+  auto found = hosts_.find(endpoint);
+  if (found == hosts_.end()) {
+    return {};
+  }
+  Host &host = *found->second;
+  refresh(host, now);
+
+  Stats stats;
+  stats.state = host.state;
+  stats.pending = host.pending;
+  stats.consecutive_failures = host.consecutive_failures;
+  stats.ejections = host.ejections;
+  stats.successes = host.successes;
+  stats.failures = host.failures;
+  stats.overflows = host.overflows;
+  stats.times_ejected = host.times_ejected;
+  stats.ejected_until = host.ejected_until;
+  return stats;
+}
+
+std::size_t UpstreamHealth::unavailableCount(Clock::time_point now) const {
+  std::lock_guard lock(mutex_);
+  return unavailableLocked(now);
+}
+
+void UpstreamHealth::remove(const Endpoint &endpoint) {
+  std::lock_guard lock(mutex_);
+  hosts_.erase(endpoint);
+}
+
+void UpstreamHealth::analyze(Clock::time_point now) {
+  std::lock_guard lock(mutex_);
+  analyzeLocked(now);
+}
+
+void UpstreamHealth::complete(Host &host, bool probe, Outcome outcome,
+                              std::chrono::nanoseconds latency,
+                              Clock::time_point now) {
+  std::lock_guard lock(mutex_);
+  --host.pending;
+  if (probe) {
+    --host.probing;
+  }
+  if (outcome == Outcome::Cancelled) {
+    return;
+  }
+  refresh(host, now);
+
+  switch (outcome) {
+  case Outcome::Cancelled:
+    return;
+  case Outcome::Success:
+    ++host.successes;
+    host.consecutive_failures = 0;
+    ++host.window_requests;
+    host.window_latency += latency;
+    if (probe && host.state == State::HalfOpen) {
+      host.state = State::Healthy;
+    }
+    return;
+  case Outcome::Failure:
+    ++host.failures;
+    ++host.consecutive_failures;
+    if (probe && host.state == State::HalfOpen) {
+      eject(host, now, true); // it already counts as unavailable
+    } else if (host.state == State::Healthy &&
+               options_.consecutive_failures != 0 &&
+               host.consecutive_failures >= options_.consecutive_failures) {
+      eject(host, now, false);
+    }
+    return;
+  }
+}
+
+void UpstreamHealth::refresh(Host &host, Clock::time_point now) const {
+  if (host.state == State::Ejected && now >= host.ejected_until) {
+    host.state = State::HalfOpen;
+  }
+}
+
+bool UpstreamHealth::eject(Host &host, Clock::time_point now, bool force) {
+  if (!force) {
+    const auto allowed = std::max<std::size_t>(
+        1, static_cast<std::size_t>(std::floor(
+               options_.max_ejection_fraction *
+               static_cast<double>(hosts_.size()))));
+    if (unavailableLocked(now) >= allowed) {
+      return false;
+    }
+  }
+  ++host.ejections;
+  ++host.times_ejected;
+  host.ejected_this_interval = true;
+  host.consecutive_failures = 0;
+  const auto duration = std::min<Clock::duration>(
+      options_.base_ejection * host.ejections, options_.max_ejection);
+  host.state = State::Ejected;
+  host.ejected_until = now + duration;
+  return true;
+}
+
+void UpstreamHealth::analyzeLocked(Clock::time_point now) {
+  if (!window_started_) {
+    window_started_ = true;
+    window_start_ = now;
+    return;
+  }
+  if (now - window_start_ < options_.interval) {
+    return;
+  }
+
+  if (options_.latency_factor > 0) {
+    struct Candidate {
+      Host *host;
+      double mean;
+    };
+    std::vector<Candidate> candidates;
+    for (auto &[endpoint, host] : hosts_) {
+      refresh(*host, now);
+      if (host->state == State::Healthy &&
+          host->window_requests >= options_.min_requests &&
+          host->window_requests > 0) {
+        candidates.push_back(
+            {host.get(), static_cast<double>(host->window_latency.count()) /
+                             static_cast<double>(host->window_requests)});
+      }
+    }
+
+    if (!candidates.empty() && candidates.size() >= options_.min_endpoints) {
+      std::vector<double> means;
+      means.reserve(candidates.size());
+      for (const Candidate &candidate : candidates) {
+        means.push_back(candidate.mean);
+      }
+      auto middle = means.begin() + static_cast<std::ptrdiff_t>(means.size() / 2);
+      std::nth_element(means.begin(), middle, means.end());
+      const double threshold = *middle * options_.latency_factor;
+
+      // Worst first, so the ejection limit keeps the best of the outliers.
+      std::sort(candidates.begin(), candidates.end(),
+                [](const Candidate &a, const Candidate &b) {
+                  return a.mean > b.mean;
+                });
+      for (const Candidate &candidate : candidates) {
+        if (candidate.mean <= threshold || !eject(*candidate.host, now, false)) {
+          break;
+        }
+      }
+    }
+  }
+
+  for (auto &[endpoint, host] : hosts_) {
+    if (!host->ejected_this_interval && host->state == State::Healthy &&
+        host->ejections > 0) {
+      --host->ejections;
+    }
+    host->ejected_this_interval = false;
+    host->window_requests = 0;
+    host->window_latency = std::chrono::nanoseconds::zero();
+  }
+  window_start_ = now;
+}
+
+std::size_t UpstreamHealth::unavailableLocked(Clock::time_point now) const {
+  std::size_t count = 0;
+  for (const auto &[endpoint, host] : hosts_) {
+    refresh(*host, now);
+    if (host->state != State::Healthy) {
+      ++count;
+    }
+  }
+  return count;
+}
+
+} // namespace net
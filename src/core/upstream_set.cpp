@@ -0,0 +1,109 @@
+#include "net/core/upstream_set.h"
+#include <cerrno>
+#include <charconv>
+#include <fstream>
+#include <limits>
+#include <sstream>
+#include <stdexcept>
+#include <system_error>
+
+namespace net {
+
+namespace {
+
+std::string_view trim(std::string_view text) noexcept {
+  const auto first = text.find_first_not_of(" \t\r");
+  if (first == std::string_view::npos) {
+    return {};
+  }
+  const auto last = text.find_last_not_of(" \t\r");
+  return text.substr(first, last - first + 1);
+}
+
+Endpoint parseEntry(std::string_view entry) {
+  std::string_view address;
+  std::string_view port;
+  if (entry.front() == '[') {
+    const auto close = entry.find(']');
+    if (close == std::string_view::npos || close + 1 >= entry.size() ||
+        entry[close + 1] != ':') {
+      throw std::invalid_argument("expected [address]:port");
+    }
+    address = entry.substr(1, close - 1);
+    port = entry.substr(close + 2);
+  } else {
+    const auto colon = entry.rfind(':');
+    if (colon == std::string_view::npos ||
+        entry.find(':') != colon) { // bare IPv6 needs brackets
+      throw std::invalid_argument("expected address:port");
+    }
+    address = entry.substr(0, colon);
+    port = entry.substr(colon + 1);
+  }
+
+  unsigned value = 0;
+  const auto [end, ec] =
+      std::from_chars(port.data(), port.data() + port.size(), value);
+  if (ec != std::errc{} || end != port.data() + port.size() || value == 0 ||
+      value > std::numeric_limits<std::uint16_t>::max()) {
+    throw std::invalid_argument("invalid port");
+  }
+  return Endpoint(std::string(address), static_cast<std::uint16_t>(value));
+}
+
+} // namespace
+
+std::vector<Endpoint> parseUpstreams(std::string_view text) {
+  std::vector<Endpoint> endpoints;
+  std::size_t line_number = 0;
+  while (!text.empty()) {
+    ++line_number;
+    const auto newline = text.find('\n');
+    std::string_view line = text.substr(0, newline);
+    text.remove_prefix(newline == std::string_view::npos ? text.size()
+                                                         : newline + 1);
+
+    line = trim(line.substr(0, line.find('#')));
+    if (line.empty()) {
+      continue;
+    }
+    try {
+      endpoints.push_back(parseEntry(line));
+    } catch (const std::invalid_argument &e) {
+      throw std::invalid_argument("upstreams:" + std::to_string(line_number) +
+                                  ": " + e.what() + ": " + std::string(line));
+    }
+  }
+  return endpoints;
+}
+
+std::vector<Endpoint> loadUpstreams(const std::string &path) {
+  std::ifstream in(path, std::ios::binary);
+  if (!in) {
+    throw std::system_error(errno, std::generic_category(),
+                            "open(upstream file) failed");
+  }
+  std::ostringstream contents;
+  contents << in.rdbuf();
+  if (in.bad()) {
+    throw std::system_error(errno, std::generic_category(),
+                            "read(upstream file) failed");
+  }
+  return parseUpstreams(contents.str());
+}
+
+// ---- UpstreamSource ----
+
+UpstreamSource::UpstreamSource(std::vector<Endpoint> endpoints)
+    : sets_(domain_, std::make_unique<const UpstreamSet>(
+                         UpstreamSet{0, std::move(endpoints)})) {}
+
+std::uint64_t UpstreamSource::update(std::vector<Endpoint> endpoints) {
+  std::lock_guard lock(mutex_);
+  const std::uint64_t version = sets_.load()->version + 1;
+  sets_.publish(std::make_unique<const UpstreamSet>(
+      UpstreamSet{version, std::move(endpoints)}));
+  return version;
+}
+
+} // namespace net
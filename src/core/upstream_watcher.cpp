@@ -0,0 +1,169 @@
+#include "net/core/upstream_watcher.h"
+#include <cerrno>
+#include <cstring>
+#include <exception>
+#include <filesystem>
+#include <system_error>
+#include <unistd.h>
+
+#ifdef __linux__
+#include <sys/inotify.h>
+#endif
+
+namespace net {
+
+namespace {
+
+/// Modification time of `path` in nanoseconds, or -1 if it cannot be read.
+std::int64_t modificationTime(const std::string &path) noexcept {
+  std::error_code ec;
+  const auto time = std::filesystem::last_write_time(path, ec);
+  if (ec) {
+    return -1;
+  }
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             time.time_since_epoch())
+      .count();
+}
+
+} // namespace
+
+UpstreamFileWatcher::UpstreamFileWatcher(EventLoop &loop, std::string path,
+                                         UpstreamSource &source,
+                                         Options options)
+    : loop_(loop), path_(std::move(path)), source_(source),
+      options_(options) {
+  const std::filesystem::path file(path_);
+  name_ = file.filename().string();
+  std::string directory = file.parent_path().string();
+  if (directory.empty()) {
+    directory = ".";
+  }
+
+#ifdef __linux__
+  // Watch before the first read so no change can slip in between.
+  notify_fd_ = ::inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+  if (notify_fd_ < 0) {
+    throw std::system_error(errno, std::generic_category(),
+                            "inotify_init1 failed");
+  }
+  if (::inotify_add_watch(notify_fd_, directory.c_str(),
+                          IN_CLOSE_WRITE | IN_MOVED_TO | IN_DELETE |
+                              IN_MOVED_FROM) < 0) {
+    const int error = errno;
+    ::close(notify_fd_);
+    throw std::system_error(error, std::generic_category(),
+                            "inotify_add_watch failed");
+  }
+#endif
+
+  try {
+    mtime_ns_ = modificationTime(path_);
+    std::vector<Endpoint> endpoints = loadUpstreams(path_);
+    if (source_.read()->endpoints != endpoints) {
+      source_.update(std::move(endpoints));
+      ++stats_.reloads;
+    }
+#ifdef __linux__
+    loop_.add(notify_fd_, EventLoop::Readable,
+              [this](unsigned) { onNotify(); }, "upstream watcher");
+#else
+    schedule(options_.poll_interval);
+#endif
+  } catch (...) {
+    if (notify_fd_ >= 0) {
+      ::close(notify_fd_);
+    }
+    throw;
+  }
+}
+
+UpstreamFileWatcher::~UpstreamFileWatcher() {
+  if (timer_) {
+    loop_.cancel(*timer_);
+  }
+  if (notify_fd_ >= 0) {
+    loop_.remove(notify_fd_);
+    ::close(notify_fd_);
+  }
+}
+
+bool UpstreamFileWatcher::reload() {
+  try {
+    mtime_ns_ = modificationTime(path_);
+    std::vector<Endpoint> endpoints = loadUpstreams(path_);
+    if (source_.read()->endpoints == endpoints) {
+      ++stats_.unchanged;
+      return false;
+    }
+    source_.update(std::move(endpoints));
+    ++stats_.reloads;
+    return true;
+  } catch (const std::exception &e) {
+    ++stats_.errors;
+    if (error_handler_) {
+      error_handler_(path_ + ": " + e.what());
+    }
+    return false;
+  }
+}
+
+void UpstreamFileWatcher::onNotify() {
+#ifdef __linux__
+  alignas(inotify_event) char buffer[4096];
+  bool changed = false;
+  for (;;) {
+    const ssize_t n = ::read(notify_fd_, buffer, sizeof(buffer));
+    if (n < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      break; // drained (EAGAIN)
+    }
+    if (n == 0) {
+      break;
+    }
+    for (ssize_t offset = 0; offset < n;) {
+      inotify_event event;
+      std::memcpy(&event, buffer + offset, sizeof(event));
+      const char *name = buffer + offset + sizeof(event);
+      if ((event.mask & IN_Q_OVERFLOW) != 0 ||
+          (event.len > 0 && name_ == name)) {
+        changed = true;
+      }
+      offset += static_cast<ssize_t>(sizeof(event) + event.len);
+    }
+  }
+  if (changed) {
+    // Quiet period: every change pushes the read back, so a burst of
+    // writes is read once, after the last.
+    if (timer_) {
+      loop_.cancel(*timer_);
+    }
+    schedule(options_.debounce);
+  }
+#endif
+}
+
+void UpstreamFileWatcher::schedule(std::chrono::milliseconds delay) {
+  timer_ = loop_.runAfter(
+      delay,
+      [this] {
+        timer_.reset();
+        poll();
+      },
+      "upstream reload");
+}
+
+void UpstreamFileWatcher::poll() {
+#ifdef __linux__
+  reload();
+#else
+  if (modificationTime(path_) != mtime_ns_) {
+    reload();
+  }
+  schedule(options_.poll_interval);
+#endif
+}
+
+} // namespace net
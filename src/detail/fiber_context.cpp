@@ -0,0 +1,181 @@
+#include "net/detail/fiber_context.h"
+#include <cstdint>
+
+#ifdef __APPLE__
+#define NET_FIBER_SYMBOL(name) "_" #name
+#define NET_FIBER_TYPE(name)
+#define NET_FIBER_SIZE(name)
+#else
+#define NET_FIBER_SYMBOL(name) #name
+#define NET_FIBER_TYPE(name) ".type " #name ", %function\n"
+#define NET_FIBER_SIZE(name) ".size " #name ", .-" #name "\n"
+#endif
+
+extern "C" {
+void net_fiber_switch(void **from_sp, void *to_sp);
+void net_fiber_trampoline();
+}
+
+#if defined(__x86_64__)
+
+// System V x86-64: rbx, rbp, r12-r15 are callee-saved, as are the MXCSR
+// control bits and the x87 control word.
+//
+// Frame layout, from the saved stack pointer upwards:
+//   [0] mxcsr (low 4 bytes) | x87 control word (next 2 bytes)
+//   [1] r15  [2] r14  [3] r13  [4] r12  [5] rbx  [6] rbp  [7] return address
+asm(R"(
+.text
+.globl )" NET_FIBER_SYMBOL(net_fiber_switch) R"(
+)" NET_FIBER_TYPE(net_fiber_switch) R"(
+.p2align 4
+)" NET_FIBER_SYMBOL(net_fiber_switch) R"(:
+    pushq %rbp
+    pushq %rbx
+    pushq %r12
+    pushq %r13
+    pushq %r14
+    pushq %r15
+    subq $8, %rsp
+    stmxcsr (%rsp)
+    fnstcw 4(%rsp)
+    movq %rsp, (%rdi)
+    movq %rsi, %rsp
+    ldmxcsr (%rsp)
+    fldcw 4(%rsp)
+    addq $8, %rsp
+    popq %r15
+    popq %r14
+    popq %r13
+    popq %r12
+    popq %rbx
+    popq %rbp
+    ret
+)" NET_FIBER_SIZE(net_fiber_switch) R"(
+
+.globl )" NET_FIBER_SYMBOL(net_fiber_trampoline) R"(
+)" NET_FIBER_TYPE(net_fiber_trampoline) R"(
+.p2align 4
+)" NET_FIBER_SYMBOL(net_fiber_trampoline) R"(:
+    movq %r12, %rdi
+    callq *%r13
+    ud2
+)" NET_FIBER_SIZE(net_fiber_trampoline));
+
+#elif defined(__aarch64__)
+
+// AAPCS64: x19-x28, fp (x29), lr (x30) and the low halves of v8-v15 are
+// callee-saved. The 176-byte frame keeps the stack 16-byte aligned:
+//   x19..x28 at 0..72, fp/lr at 80/88, d8..d15 at 96..152.
+asm(R"(
+.text
+.globl )" NET_FIBER_SYMBOL(net_fiber_switch) R"(
+)" NET_FIBER_TYPE(net_fiber_switch) R"(
+.p2align 4
+)" NET_FIBER_SYMBOL(net_fiber_switch) R"(:
+    sub sp, sp, #176
+    stp x19, x20, [sp, #0]
+    stp x21, x22, [sp, #16]
+    stp x23, x24, [sp, #32]
+    stp x25, x26, [sp, #48]
+    stp x27, x28, [sp, #64]
+    stp x29, x30, [sp, #80]
+    stp d8, d9, [sp, #96]
+    stp d10, d11, [sp, #112]
+    stp d12, d13, [sp, #128]
+    stp d14, d15, [sp, #144]
+    mov x2, sp
+    str x2, [x0]
+    mov sp, x1
+    ldp x19, x20, [sp, #0]
+    ldp x21, x22, [sp, #16]
+    ldp x23, x24, [sp, #32]
+    ldp x25, x26, [sp, #48]
+    ldp x27, x28, [sp, #64]
+    ldp x29, x30, [sp, #80]
+    ldp d8, d9, [sp, #96]
+    ldp d10, d11, [sp, #112]
+    ldp d12, d13, [sp, #128]
+    ldp d14, d15, [sp, #144]
+    add sp, sp, #176
+    ret
+)" NET_FIBER_SIZE(net_fiber_switch) R"(
+
+.globl )" NET_FIBER_SYMBOL(net_fiber_trampoline) R"(
+)" NET_FIBER_TYPE(net_fiber_trampoline) R"(
+.p2align 4
+)" NET_FIBER_SYMBOL(net_fiber_trampoline) R"(:
+    mov x0, x19
+    blr x20
+    brk #0
+)" NET_FIBER_SIZE(net_fiber_trampoline));
+
+#endif
+
+namespace net::detail {
+
+#ifdef NET_FIBER_ASM_SWITCH
+
+void FiberContext::prepare(std::span<std::byte> stack, Entry entry,
+                           void *arg) noexcept {
+  auto top = reinterpret_cast<std::uintptr_t>(stack.data() + stack.size());
+  top &= ~std::uintptr_t{15};
+
+#if defined(__x86_64__)
+  // After `ret` into the trampoline the stack pointer is top - 16, which is
+  // 16-byte aligned as the call it makes requires.
+  auto *frame = reinterpret_cast<std::uint64_t *>(top - 16 - 64);
+  frame[0] = 0x1F80 | (std::uint64_t{0x037F} << 32); // default MXCSR / FCW
+  frame[1] = 0;                                      // r15
+  frame[2] = 0;                                      // r14
+  frame[3] = reinterpret_cast<std::uint64_t>(entry); // r13
+  frame[4] = reinterpret_cast<std::uint64_t>(arg);   // r12
+  frame[5] = 0;                                      // rbx
+  frame[6] = 0;                                      // rbp
+  frame[7] = reinterpret_cast<std::uint64_t>(&net_fiber_trampoline);
+#elif defined(__aarch64__)
+  auto *frame = reinterpret_cast<std::uint64_t *>(top - 176);
+  for (int i = 0; i < 22; ++i) {
+    frame[i] = 0;
+  }
+  frame[0] = reinterpret_cast<std::uint64_t>(arg);    // x19
+  frame[1] = reinterpret_cast<std::uint64_t>(entry);  // x20
+  frame[11] = reinterpret_cast<std::uint64_t>(&net_fiber_trampoline); // lr
+#endif
+  sp_ = frame;
+}
+
+void FiberContext::switchTo(FiberContext &from, FiberContext &to) noexcept {
+  net_fiber_switch(&from.sp_, to.sp_);
+}
+
+#else // ucontext fallback
+
+namespace {
+thread_local FiberContext *starting = nullptr;
+} // namespace
+
+void ucontext_trampoline() {
+  FiberContext *context = starting;
+  context->entry_(context->arg_);
+}
+
+void FiberContext::prepare(std::span<std::byte> stack, Entry entry,
+                           void *arg) noexcept {
+  ::getcontext(&context_);
+  context_.uc_stack.ss_sp = stack.data();
+  context_.uc_stack.ss_size = stack.size();
+  context_.uc_link = nullptr;
+  entry_ = entry;
+  arg_ = arg;
+  ::makecontext(&context_, ucontext_trampoline, 0);
+}
+
+void FiberContext::switchTo(FiberContext &from, FiberContext &to) noexcept {
+  starting = &to;
+  ::swapcontext(&from.context_, &to.context_);
+}
+
+#endif
+
+} // namespace net::detail
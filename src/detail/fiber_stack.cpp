@@ -0,0 +1,75 @@
+#include "net/detail/fiber_stack.h"
+#include <cerrno>
+#include <stdexcept>
+#include <system_error>
+
+#include <sys/mman.h>
+#include <unistd.h>
+
+namespace net::detail {
+
+FiberStackPool::FiberStackPool(std::size_t stack_size, std::size_t max_pooled)
+    : page_size_(static_cast<std::size_t>(::sysconf(_SC_PAGESIZE))),
+      max_pooled_(max_pooled) {
+  if (stack_size == 0) {
+    throw std::invalid_argument("fiber stack size must be positive");
+  }
+  stack_size_ = (stack_size + page_size_ - 1) / page_size_ * page_size_;
+  free_.reserve(max_pooled_);
+}
+
+FiberStackPool::~FiberStackPool() {
+  for (const Stack &stack : free_) {
+    unmap(stack);
+  }
+}
+
+FiberStackPool::Stack FiberStackPool::acquire() {
+  if (!free_.empty()) {
+    Stack stack = free_.back();
+    free_.pop_back();
+    return stack;
+  }
+
+  const std::size_t size = stack_size_ + page_size_;
+  int flags = MAP_PRIVATE | MAP_ANONYMOUS;
+#ifdef MAP_STACK
+  flags |= MAP_STACK;
+#endif
+#ifdef MAP_NORESERVE
+  flags |= MAP_NORESERVE;
+#endif
+  void *mapping = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, flags, -1, 0);
+  if (mapping == MAP_FAILED) {
+    throw std::system_error(errno, std::generic_category(),
+                            "mmap(fiber stack) failed");
+  }
+  // Stacks grow down: the guard page is the lowest page of the mapping.
+  if (::mprotect(mapping, page_size_, PROT_NONE) != 0) {
+    const int err = errno;
+    ::munmap(mapping, size);
+    throw std::system_error(err, std::generic_category(),
+                            "mprotect(fiber guard page) failed");
+  }
+  ++mapped_;
+
+  auto *base = static_cast<std::byte *>(mapping);
+  return Stack{mapping, size, {base + page_size_, stack_size_}};
+}
+
+void FiberStackPool::release(Stack stack) noexcept {
+  if (stack.mapping == nullptr) {
+    return;
+  }
+  if (free_.size() < max_pooled_) {
+    free_.push_back(stack);
+  } else {
+    unmap(stack);
+  }
+}
+
+void FiberStackPool::unmap(const Stack &stack) noexcept {
+  ::munmap(stack.mapping, stack.mapping_size);
+}
+
+} // namespace net::detail
@@ -0,0 +1,282 @@
+#include "net/detail/io_uring.h"
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <system_error>
+#include <vector>
+
+#ifdef __linux__
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#endif
+
+namespace net::detail {
+
+#ifdef __linux__
+
+namespace {
+
+int ioUringSetup(unsigned entries, io_uring_params &params) {
+  return static_cast<int>(::syscall(__NR_io_uring_setup, entries, &params));
+}
+
+int ioUringEnter(int fd, unsigned to_submit, unsigned min_complete,
+                 unsigned flags) {
+  return static_cast<int>(::syscall(__NR_io_uring_enter, fd, to_submit,
+                                    min_complete, flags, nullptr, 0));
+}
+
+int ioUringRegister(int fd, unsigned opcode, const void *arg,
+                    unsigned count) {
+  return static_cast<int>(
+      ::syscall(__NR_io_uring_register, fd, opcode, arg, count));
+}
+
+// Ring indices are shared with the kernel, which updates them concurrently.
+unsigned loadAcquire(unsigned *value) noexcept {
+  return std::atomic_ref<unsigned>(*value).load(std::memory_order_acquire);
+}
+
+void storeRelease(unsigned *value, unsigned next) noexcept {
+  std::atomic_ref<unsigned>(*value).store(next, std::memory_order_release);
+}
+
+template <typename T> T *at(void *base, std::uint32_t offset) noexcept {
+  return reinterpret_cast<T *>(static_cast<std::byte *>(base) + offset);
+}
+
+void *mapRing(int fd, std::size_t size, off_t offset) {
+  void *ring = ::mmap(nullptr, size, PROT_READ | PROT_WRITE,
+                      MAP_SHARED | MAP_POPULATE, fd, offset);
+  if (ring == MAP_FAILED) {
+    throw std::system_error(errno, std::generic_category(),
+                            "mmap(io_uring) failed");
+  }
+  return ring;
+}
+
+} // namespace
+
+IoUring::IoUring(unsigned entries) {
+  io_uring_params params{};
+  fd_ = ioUringSetup(entries, params);
+  if (fd_ < 0) {
+    throw std::system_error(errno, std::generic_category(),
+                            "io_uring_setup failed");
+  }
+  features_ = params.features;
+  entries_ = params.sq_entries;
+
+  try {
+    sq_ring_size_ = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    cq_ring_size_ =
+        params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+    if ((features_ & IORING_FEAT_SINGLE_MMAP) != 0) {
+      sq_ring_size_ = cq_ring_size_ = std::max(sq_ring_size_, cq_ring_size_);
+    }
+    sq_ring_ = mapRing(fd_, sq_ring_size_, IORING_OFF_SQ_RING);
+    if ((features_ & IORING_FEAT_SINGLE_MMAP) != 0) {
+      cq_ring_ = sq_ring_;
+    } else {
+      cq_ring_ = mapRing(fd_, cq_ring_size_, IORING_OFF_CQ_RING);
+    }
+    sqes_size_ = params.sq_entries * sizeof(io_uring_sqe);
+    sqes_ = mapRing(fd_, sqes_size_, IORING_OFF_SQES);
+  } catch (...) {
+    release();
+    throw;
+  }
+
+  sq_head_ = at<unsigned>(sq_ring_, params.sq_off.head);
+  sq_tail_ = at<unsigned>(sq_ring_, params.sq_off.tail);
+  sq_mask_ = *at<unsigned>(sq_ring_, params.sq_off.ring_mask);
+  sq_array_ = at<unsigned>(sq_ring_, params.sq_off.array);
+  cq_head_ = at<unsigned>(cq_ring_, params.cq_off.head);
+  cq_tail_ = at<unsigned>(cq_ring_, params.cq_off.tail);
+  cq_mask_ = *at<unsigned>(cq_ring_, params.cq_off.ring_mask);
+  cqes_ = at<io_uring_cqe>(cq_ring_, params.cq_off.cqes);
+
+  prepared_tail_ = submitted_tail_ = *sq_tail_;
+}
+
+IoUring::~IoUring() { release(); }
+
+void IoUring::release() noexcept {
+  if (sqes_ != nullptr) {
+    ::munmap(sqes_, sqes_size_);
+  }
+  if (cq_ring_ != nullptr && cq_ring_ != sq_ring_) {
+    ::munmap(cq_ring_, cq_ring_size_);
+  }
+  if (sq_ring_ != nullptr) {
+    ::munmap(sq_ring_, sq_ring_size_);
+  }
+  if (fd_ >= 0) {
+    ::close(fd_);
+  }
+  sqes_ = cq_ring_ = sq_ring_ = nullptr;
+  fd_ = -1;
+}
+
+bool IoUring::available() noexcept {
+  static const bool result = [] {
+    try {
+      IoUring probe(2);
+      return true;
+    } catch (...) {
+      return false;
+    }
+  }();
+  return result;
+}
+
+unsigned IoUring::space() const noexcept {
+  return entries_ - (prepared_tail_ - loadAcquire(sq_head_));
+}
+
+void IoUring::registerBuffers(std::span<const std::span<std::byte>> buffers) {
+  std::vector<iovec> iovecs;
+  iovecs.reserve(buffers.size());
+  for (auto buffer : buffers) {
+    iovecs.push_back({buffer.data(), buffer.size()});
+  }
+  if (ioUringRegister(fd_, IORING_REGISTER_BUFFERS, iovecs.data(),
+                      static_cast<unsigned>(iovecs.size())) < 0) {
+    throw std::system_error(errno, std::generic_category(),
+                            "io_uring_register(buffers) failed");
+  }
+}
+
+std::bitset<256> IoUring::supportedOpcodes() const {
+  constexpr unsigned kOps = 256;
+  std::vector<std::byte> storage(sizeof(io_uring_probe) +
+                                 kOps * sizeof(io_uring_probe_op));
+  auto *probe = reinterpret_cast<io_uring_probe *>(storage.data());
+
+  std::bitset<256> supported;
+  if (ioUringRegister(fd_, IORING_REGISTER_PROBE, probe, kOps) < 0) {
+    return supported;
+  }
+  for (unsigned i = 0; i < probe->ops_len && i < kOps; ++i) {
+    if ((probe->ops[i].flags & IO_URING_OP_SUPPORTED) != 0) {
+      supported.set(probe->ops[i].op);
+    }
+  }
+  return supported;
+}
+
+void *IoUring::nextEntry(std::uint64_t user_data) {
+  if (space() == 0) {
+    throw std::length_error("io_uring submission queue is full");
+  }
+  const unsigned index = prepared_tail_ & sq_mask_;
+  auto *sqe = static_cast<io_uring_sqe *>(sqes_) + index;
+  std::memset(sqe, 0, sizeof(*sqe));
+  sqe->user_data = user_data;
+  sq_array_[index] = index;
+  ++prepared_tail_;
+  return sqe;
+}
+
+void IoUring::prepareReadFixed(int fd, std::span<std::byte> buffer,
+                               std::uint64_t offset, unsigned index,
+                               std::uint64_t user_data, bool link) {
+  auto *sqe = static_cast<io_uring_sqe *>(nextEntry(user_data));
+  sqe->opcode = IORING_OP_READ_FIXED;
+  sqe->fd = fd;
+  sqe->off = offset;
+  sqe->addr = reinterpret_cast<std::uint64_t>(buffer.data());
+  sqe->len = static_cast<std::uint32_t>(buffer.size());
+  sqe->buf_index = static_cast<std::uint16_t>(index);
+  sqe->flags = link ? IOSQE_IO_LINK : 0;
+}
+
+void IoUring::prepareSend(int fd, std::span<const std::byte> data, int flags,
+                          std::uint64_t user_data, bool link) {
+  auto *sqe = static_cast<io_uring_sqe *>(nextEntry(user_data));
+  sqe->opcode = IORING_OP_SEND;
+  sqe->fd = fd;
+  sqe->addr = reinterpret_cast<std::uint64_t>(data.data());
+  sqe->len = static_cast<std::uint32_t>(data.size());
+  sqe->msg_flags = static_cast<std::uint32_t>(flags);
+  sqe->flags = link ? IOSQE_IO_LINK : 0;
+}
+
+void IoUring::prepareNop(std::uint64_t user_data) {
+  auto *sqe = static_cast<io_uring_sqe *>(nextEntry(user_data));
+  sqe->opcode = IORING_OP_NOP;
+}
+
+unsigned IoUring::submit(unsigned wait_for) {
+  storeRelease(sq_tail_, prepared_tail_);
+  unsigned consumed = 0;
+  for (;;) {
+    const unsigned pending = prepared_tail_ - submitted_tail_;
+    const int result = ioUringEnter(fd_, pending, wait_for,
+                                    wait_for > 0 ? IORING_ENTER_GETEVENTS : 0);
+    if (result >= 0) {
+      submitted_tail_ += static_cast<unsigned>(result);
+      consumed += static_cast<unsigned>(result);
+      return consumed;
+    }
+    if (errno != EINTR) {
+      throw std::system_error(errno, std::generic_category(),
+                              "io_uring_enter failed");
+    }
+  }
+}
+
+std::optional<IoUringCompletion> IoUring::peek() noexcept {
+  const unsigned head = *cq_head_;
+  if (head == loadAcquire(cq_tail_)) {
+    return std::nullopt;
+  }
+  const auto &cqe = static_cast<io_uring_cqe *>(cqes_)[head & cq_mask_];
+  IoUringCompletion completion{cqe.user_data, cqe.res, cqe.flags};
+  storeRelease(cq_head_, head + 1);
+  return completion;
+}
+
+#else // !__linux__
+
+IoUring::IoUring(unsigned) {
+  throw std::system_error(std::make_error_code(std::errc::not_supported),
+                          "io_uring is not supported on this platform");
+}
+
+IoUring::~IoUring() = default;
+
+void IoUring::release() noexcept {}
+
+bool IoUring::available() noexcept { return false; }
+
+std::bitset<256> IoUring::supportedOpcodes() const { return {}; }
+
+unsigned IoUring::space() const noexcept { return 0; }
+
+void IoUring::registerBuffers(std::span<const std::span<std::byte>>) {}
+
+void *IoUring::nextEntry(std::uint64_t) { return nullptr; }
+
+void IoUring::prepareReadFixed(int, std::span<std::byte>, std::uint64_t,
+                               unsigned, std::uint64_t, bool) {}
+
+void IoUring::prepareSend(int, std::span<const std::byte>, int,
+                          std::uint64_t, bool) {}
+
+void IoUring::prepareNop(std::uint64_t) {}
+
+unsigned IoUring::submit(unsigned) { return 0; }
+
+std::optional<IoUringCompletion> IoUring::peek() noexcept {
+  return std::nullopt;
+}
+
+#endif
+
+} // namespace net::detail
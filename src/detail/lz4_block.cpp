@@ -0,0 +1,218 @@
+#include "net/detail/lz4_block.h"
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+namespace net::detail {
+
+namespace {
+
+constexpr int kHashLog = 12;
+constexpr std::uint32_t kEmpty = 0xFFFFFFFFu;
+constexpr std::size_t kMinMatch = 4;
+constexpr std::size_t kLastLiterals = 5; // block must end in literals
+constexpr std::size_t kMatchFindLimit = 12;
+constexpr std::size_t kMaxOffset = 65535;
+
+std::uint32_t read32(const std::byte *p) {
+  std::uint32_t value;
+  std::memcpy(&value, p, sizeof(value));
+  return value;
+}
+
+std::uint32_t hash(std::uint32_t sequence) {
+  return (sequence * 2654435761u) >> (32 - kHashLog);
+}
+
+std::byte *write_length(std::byte *op, std::size_t length) {
+  while (length >= 255) {
+    *op++ = std::byte{255};
+    length -= 255;
+  }
+  *op++ = static_cast<std::byte>(length);
+  return op;
+}
+
+std::byte *write_sequence(std::byte *op, const std::byte *literals,
+                          std::size_t literal_length, std::size_t offset,
+                          std::size_t match_length) {
+  std::byte *token = op++;
+  const std::size_t lit_code = std::min<std::size_t>(literal_length, 15);
+  *token = static_cast<std::byte>(lit_code << 4);
+  if (literal_length >= 15) {
+    op = write_length(op, literal_length - 15);
+  }
+  if (literal_length > 0) { // literals is null for an empty input
+    std::memcpy(op, literals, literal_length);
+  }
+  op += literal_length;
+
+  if (match_length == 0) {
+    return op; // final literal-only sequence
+  }
+
+  *op++ = static_cast<std::byte>(offset & 0xFF);
+  *op++ = static_cast<std::byte>(offset >> 8);
+
+  const std::size_t match_code = match_length - kMinMatch;
+  *token |= static_cast<std::byte>(std::min<std::size_t>(match_code, 15));
+  if (match_code >= 15) {
+    op = write_length(op, match_code - 15);
+  }
+  return op;
+}
+
+std::size_t read_length(const std::byte *&ip, const std::byte *end) {
+  std::size_t length = 0;
+  std::byte b;
+  do {
+    if (ip >= end) {
+      throw std::runtime_error("lz4: truncated length");
+    }
+    b = *ip++;
+    length += std::to_integer<std::size_t>(b);
+  } while (b == std::byte{255});
+  return length;
+}
+
+} // namespace
+
+Lz4Compressor::Lz4Compressor() : table_(std::size_t{1} << kHashLog, kEmpty) {}
+
+std::size_t Lz4Compressor::compress(std::span<const std::byte> input,
+                                    std::span<std::byte> output,
+                                    int acceleration) {
+  if (output.size() < bound(input.size())) {
+    throw std::length_error("lz4: output buffer smaller than bound()");
+  }
+  acceleration = std::max(acceleration, 1);
+
+  const std::byte *base = input.data();
+  const std::size_t size = input.size();
+  std::byte *op = output.data();
+
+  if (size < kMatchFindLimit + 1) {
+    op = write_sequence(op, base, size, 0, 0);
+    return static_cast<std::size_t>(op - output.data());
+  }
+
+  // Positions are block-relative, so the table must not leak across calls.
+  std::fill(table_.begin(), table_.end(), kEmpty);
+
+  const std::size_t match_limit = size - kLastLiterals;
+  const std::size_t search_limit = size - kMatchFindLimit;
+  std::size_t anchor = 0;
+  std::size_t ip = 0;
+
+  while (ip < search_limit) {
+    const std::uint32_t sequence = read32(base + ip);
+    const std::uint32_t h = hash(sequence);
+    const std::uint32_t candidate = table_[h];
+    table_[h] = static_cast<std::uint32_t>(ip);
+
+    if (candidate == kEmpty || ip - candidate > kMaxOffset ||
+        read32(base + candidate) != sequence) {
+      // Skip faster through incompressible regions.
+      ip += static_cast<std::size_t>(acceleration) + ((ip - anchor) >> 6);
+      continue;
+    }
+
+    std::size_t length = kMinMatch;
+    while (ip + length < match_limit &&
+           base[candidate + length] == base[ip + length]) {
+      ++length;
+    }
+
+    op = write_sequence(op, base + anchor, ip - anchor, ip - candidate,
+                        length);
+    ip += length;
+    anchor = ip;
+
+    if (ip >= 2 && ip - 2 < search_limit) {
+      table_[hash(read32(base + ip - 2))] = static_cast<std::uint32_t>(ip - 2);
+    }
+  }
+
+  op = write_sequence(op, base + anchor, size - anchor, 0, 0);
+  return static_cast<std::size_t>(op - output.data());
+}
+
+std::size_t lz4_decompress(std::span<const std::byte> input,
+                           std::span<std::byte> output) {
+  const std::byte *ip = input.data();
+  const std::byte *const in_end = ip + input.size();
+  std::byte *op = output.data();
+  std::byte *const out_begin = op;
+  std::byte *const out_end = op + output.size();
+
+  if (input.empty()) {
+    throw std::runtime_error("lz4: empty block");
+  }
+
+  for (;;) {
+    const auto token = std::to_integer<unsigned>(*ip++);
+
+    std::size_t literal_length = token >> 4;
+    if (literal_length == 15) {
+      literal_length += read_length(ip, in_end);
+    }
+    if (literal_length > static_cast<std::size_t>(in_end - ip) ||
+        literal_length > static_cast<std::size_t>(out_end - op)) {
+      throw std::runtime_error("lz4: literal run out of bounds");
+    }
+    if (literal_length > 0) { // op is null for an empty output
+      std::memcpy(op, ip, literal_length);
+    }
+    ip += literal_length;
+    op += literal_length;
+
+    if (ip == in_end) {
+      break; // last sequence carries literals only
+    }
+
+    if (in_end - ip < 2) {
+      throw std::runtime_error("lz4: truncated offset");
+    }
+    const std::size_t offset = std::to_integer<std::size_t>(ip[0]) |
+                               (std::to_integer<std::size_t>(ip[1]) << 8);
+    ip += 2;
+    if (offset == 0 || offset > static_cast<std::size_t>(op - out_begin)) {
+      throw std::runtime_error("lz4: match offset out of bounds");
+    }
+
+    std::size_t match_length = token & 15;
+    if (match_length == 15) {
+      match_length += read_length(ip, in_end);
+    }
+    match_length += kMinMatch;
+    if (match_length > static_cast<std::size_t>(out_end - op)) {
+      throw std::runtime_error("lz4: match out of bounds");
+    }
+
+    // A match may overlap its own output. Chunks no longer than the offset
+    // only read bytes already written, so copy as wide as the offset allows.
+    const std::byte *match = op - offset;
+    if (offset >= match_length) {
+      std::memcpy(op, match, match_length);
+    } else {
+      std::size_t i = 0;
+      if (offset >= 8) {
+        for (; i + 8 <= match_length; i += 8) {
+          std::memcpy(op + i, match + i, 8);
+        }
+      }
+      for (; i < match_length; ++i) {
+        op[i] = match[i];
+      }
+    }
+    op += match_length;
+
+    if (ip >= in_end) {
+      throw std::runtime_error("lz4: block does not end with literals");
+    }
+  }
+
+  return static_cast<std::size_t>(op - out_begin);
+}
+
+} // namespace net::detail
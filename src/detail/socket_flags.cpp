@@ -35,6 +35,14 @@ int SocketFlags::toNative(ProtocolType pt) {
     return IPPROTO_TCP;
   case ProtocolType::UDP:
     return IPPROTO_UDP;
+  case ProtocolType::MPTCP:
+#if defined(IPPROTO_MPTCP)
+    return IPPROTO_MPTCP;
+#elif defined(__linux__)
+    return 262; // IPPROTO_MPTCP, missing from older libc headers
+#else
+    return IPPROTO_TCP; // no MPTCP sockets on this platform
+#endif
   }
   std::unreachable();
 }
@@ -0,0 +1,511 @@
+#include "net/protocol/rudp/reliable_channel.h"
+#include "net/detail/platform_error.h"
+#include <algorithm>
+#include <array>
+#include <stdexcept>
+#include <system_error>
+
+#ifndef _WIN32
+#include <poll.h>
+#else
+#include <winsock2.h>
+#endif
+
+namespace net {
+
+namespace {
+
+constexpr std::byte kData{1};
+constexpr std::byte kAck{2};
+constexpr std::size_t kDataHeader = 10; // type, pad, index, count, seq
+constexpr std::size_t kAckHeader = 14;  // type, pad, cumulative, bitmap
+constexpr std::size_t kSackBits = 64;
+constexpr std::uint32_t kDupThreshold = 3;
+
+void put16(std::byte *out, std::uint16_t value) {
+  out[0] = static_cast<std::byte>(value >> 8);
+  out[1] = static_cast<std::byte>(value);
+}
+
+void put32(std::byte *out, std::uint32_t value) {
+  put16(out, static_cast<std::uint16_t>(value >> 16));
+  put16(out + 2, static_cast<std::uint16_t>(value));
+}
+
+std::uint16_t get16(const std::byte *in) {
+  return static_cast<std::uint16_t>((std::to_integer<unsigned>(in[0]) << 8) |
+                                    std::to_integer<unsigned>(in[1]));
+}
+
+std::uint32_t get32(const std::byte *in) {
+  return (static_cast<std::uint32_t>(get16(in)) << 16) | get16(in + 2);
+}
+
+/// Serial-number comparison (RFC 1982) for 32-bit sequence numbers.
+bool seq_before(std::uint32_t a, std::uint32_t b) {
+  return static_cast<std::int32_t>(a - b) < 0;
+}
+
+/// Waits until the socket is readable or the timeout elapses.
+bool wait_readable(detail::Socket::Handle handle,
+                   std::chrono::milliseconds timeout) {
+#ifdef _WIN32
+  WSAPOLLFD entry{handle, POLLRDNORM, 0};
+  int result = ::WSAPoll(&entry, 1, static_cast<INT>(timeout.count()));
+#else
+  pollfd entry{handle, POLLIN, 0};
+  int result;
+  do {
+    result = ::poll(&entry, 1, static_cast<int>(timeout.count()));
+  } while (result < 0 && detail::is_interrupted(detail::last_socket_error()));
+#endif
+  if (result < 0) {
+    throw std::system_error(detail::last_socket_error(),
+                            detail::socket_category(), "poll() failed");
+  }
+  return result > 0;
+}
+
+bool is_connection_refused(int err) {
+#ifdef _WIN32
+  return err == WSAECONNRESET || err == WSAECONNREFUSED;
+#else
+  return err == ECONNREFUSED;
+#endif
+}
+
+UdpSocket::AddressFamily family_of(const Endpoint &ep) {
+  return ep.data()->sa_family == AF_INET6 ? UdpSocket::AddressFamily::IPV6
+                                          : UdpSocket::AddressFamily::IPV4;
+}
+
+} // namespace
+
+ReliableChannel::ReliableChannel(const Endpoint &local, const Endpoint &peer,
+                                 Options options)
+    : options_(options),
+      socket_(family_of(local), UdpSocket::BlockingType::NonBlocking),
+      cwnd_(options.initial_cwnd), ssthresh_(double(options.max_window)),
+      rto_(options.initial_rto) {
+  if (options_.max_datagram <= kDataHeader ||
+      options_.max_datagram < kAckHeader) {
+    throw std::invalid_argument("ReliableChannel max_datagram too small");
+  }
+  if (options_.max_window == 0 || options_.max_window > (1u << 30)) {
+    throw std::invalid_argument("ReliableChannel max_window out of range");
+  }
+  socket_.bind(local);
+  socket_.connect(peer);
+}
+
+void ReliableChannel::send(std::span<const std::byte> message) {
+  const std::size_t chunk = options_.max_datagram - kDataHeader;
+  const std::size_t count =
+      std::max<std::size_t>(1, (message.size() + chunk - 1) / chunk);
+  if (count > 0xFFFF) {
+    throw std::length_error("ReliableChannel message too large");
+  }
+
+  for (std::size_t index = 0; index < count; ++index) {
+    const std::size_t offset = std::min(index * chunk, message.size());
+    auto payload =
+        message.subspan(offset, std::min(chunk, message.size() - offset));
+
+    Outgoing packet;
+    packet.datagram.resize(kDataHeader + payload.size());
+    packet.datagram[0] = kData;
+    put16(packet.datagram.data() + 2, static_cast<std::uint16_t>(index));
+    put16(packet.datagram.data() + 4, static_cast<std::uint16_t>(count));
+    put32(packet.datagram.data() + 6, next_seq_++);
+    std::copy(payload.begin(), payload.end(),
+              packet.datagram.begin() + kDataHeader);
+    pending_.push_back(std::move(packet));
+  }
+
+  flush();
+}
+
+std::optional<std::vector<std::byte>> ReliableChannel::receive() {
+  if (inbox_.empty()) {
+    return std::nullopt;
+  }
+  auto message = std::move(inbox_.front());
+  inbox_.pop_front();
+  return message;
+}
+
+void ReliableChannel::poll(std::chrono::milliseconds timeout) {
+  auto wait = timeout;
+  if (auto deadline = retransmitDeadline()) {
+    auto remaining = std::chrono::ceil<std::chrono::milliseconds>(
+        *deadline - Clock::now());
+    wait = std::clamp(remaining, std::chrono::milliseconds(0), timeout);
+  }
+
+  if (wait_readable(socket_.native_handle(), wait)) {
+    readInput();
+  }
+  onTimeout(Clock::now());
+  flush();
+}
+
+ReliableChannel::Stats ReliableChannel::stats() const noexcept {
+  Stats result = stats_;
+  result.cwnd = cwnd_;
+  result.srtt = srtt_;
+  result.rto = rto_;
+  return result;
+}
+
+void ReliableChannel::readInput() {
+  std::vector<std::byte> buffer(options_.max_datagram);
+
+  for (;;) {
+    std::size_t n;
+    try {
+      n = socket_.receive(buffer);
+    } catch (const std::system_error &e) {
+      const int err = e.code().value();
+      if (detail::is_would_block(err)) {
+        break;
+      }
+      if (is_connection_refused(err)) {
+        continue; // peer not up yet; its datagrams will be retransmitted
+      }
+      throw;
+    }
+
+    auto datagram = std::span<const std::byte>(buffer).first(n);
+    if (datagram.empty()) {
+      continue;
+    }
+    if (datagram[0] == kData && datagram.size() >= kDataHeader) {
+      onData(datagram);
+    } else if (datagram[0] == kAck && datagram.size() >= kAckHeader) {
+      onAck(datagram);
+    }
+  }
+
+  if (ack_pending_) {
+    sendAck();
+  }
+}
+
+void ReliableChannel::onData(std::span<const std::byte> datagram) {
+  const std::uint16_t index = get16(datagram.data() + 2);
+  const std::uint16_t count = get16(datagram.data() + 4);
+  const std::uint32_t seq = get32(datagram.data() + 6);
+
+  if (count == 0 || index >= count) {
+    return;
+  }
+
+  ++stats_.packets_received;
+  ack_pending_ = true;
+
+  if (seq_before(seq, expected_) || reorder_.contains(seq)) {
+    ++stats_.duplicates;
+    return;
+  }
+  if (seq - expected_ >= options_.max_window) {
+    return; // beyond the receive window; sender will retransmit
+  }
+
+  auto payload = datagram.subspan(kDataHeader);
+  reorder_.emplace(seq, Incoming{index, count,
+                                 std::vector<std::byte>(payload.begin(),
+                                                        payload.end()),
+                                 false});
+
+  if (options_.delivery == Delivery::Unordered) {
+    tryDeliver(seq - index);
+  }
+  advanceReceiveWindow();
+}
+
+bool ReliableChannel::tryDeliver(std::uint32_t first) {
+  if (seq_before(first, expected_)) {
+    return false;
+  }
+
+  auto head = reorder_.find(first);
+  if (head == reorder_.end() || head->second.delivered ||
+      head->second.index != 0) {
+    return false;
+  }
+
+  const std::uint16_t count = head->second.count;
+  std::size_t size = 0;
+  for (std::uint16_t k = 0; k < count; ++k) {
+    auto it = reorder_.find(first + k);
+    if (it == reorder_.end() || it->second.index != k ||
+        it->second.count != count) {
+      return false;
+    }
+    size += it->second.payload.size();
+  }
+
+  std::vector<std::byte> message;
+  message.reserve(size);
+  for (std::uint16_t k = 0; k < count; ++k) {
+    auto &fragment = reorder_.find(first + k)->second;
+    message.insert(message.end(), fragment.payload.begin(),
+                   fragment.payload.end());
+    fragment.payload = {};
+    fragment.delivered = true;
+  }
+
+  inbox_.push_back(std::move(message));
+  ++stats_.messages_delivered;
+  return true;
+}
+
+void ReliableChannel::advanceReceiveWindow() {
+  for (;;) {
+    auto it = reorder_.find(expected_);
+    if (it == reorder_.end()) {
+      break;
+    }
+    if (!it->second.delivered) {
+      if (options_.delivery == Delivery::Unordered || !tryDeliver(expected_)) {
+        break;
+      }
+    }
+    reorder_.erase(it);
+    ++expected_;
+  }
+}
+
+void ReliableChannel::sendAck() {
+  // Bit i covers expected_ + i: in ordered mode the head of the window may
+  // already be buffered while a later fragment of its message is missing.
+  std::uint64_t bitmap = 0;
+  for (std::size_t i = 0; i < kSackBits; ++i) {
+    if (reorder_.contains(expected_ + static_cast<std::uint32_t>(i))) {
+      bitmap |= std::uint64_t{1} << i;
+    }
+  }
+
+  std::array<std::byte, kAckHeader> ack{};
+  ack[0] = kAck;
+  put32(ack.data() + 2, expected_);
+  put32(ack.data() + 6, static_cast<std::uint32_t>(bitmap >> 32));
+  put32(ack.data() + 10, static_cast<std::uint32_t>(bitmap));
+
+  try {
+    (void)socket_.send(ack);
+    ack_pending_ = false;
+  } catch (const std::system_error &e) {
+    const int err = e.code().value();
+    if (!detail::is_would_block(err) && !is_connection_refused(err)) {
+      throw;
+    }
+  }
+}
+
+void ReliableChannel::onAck(std::span<const std::byte> datagram) {
+  const auto now = Clock::now();
+  const std::uint32_t cumulative = get32(datagram.data() + 2);
+  const std::uint64_t bitmap =
+      (static_cast<std::uint64_t>(get32(datagram.data() + 6)) << 32) |
+      get32(datagram.data() + 10);
+
+  const std::uint32_t window_end =
+      window_base_ + static_cast<std::uint32_t>(window_.size());
+  if (seq_before(window_end, cumulative)) {
+    return; // acknowledges data we never sent
+  }
+
+  std::optional<std::chrono::microseconds> sample;
+  std::size_t newly_acked = 0;
+
+  // Karn's rule: only packets sent exactly once yield RTT samples.
+  auto consider = [&](const Outgoing &packet) {
+    if (packet.transmissions == 1) {
+      sample = std::chrono::duration_cast<std::chrono::microseconds>(
+          now - packet.sent_at);
+    }
+  };
+
+  while (!window_.empty() && seq_before(window_base_, cumulative)) {
+    if (!window_.front().sacked) {
+      consider(window_.front());
+      ++newly_acked;
+    }
+    window_.pop_front();
+    ++window_base_;
+  }
+
+  std::optional<std::uint32_t> highest_sacked;
+  for (std::size_t i = 0; i < kSackBits; ++i) {
+    if ((bitmap & (std::uint64_t{1} << i)) == 0) {
+      continue;
+    }
+    const std::uint32_t seq = cumulative + static_cast<std::uint32_t>(i);
+    const std::uint32_t offset = seq - window_base_;
+    if (offset >= window_.size()) {
+      continue;
+    }
+    auto &packet = window_[offset];
+    if (!packet.sacked) {
+      consider(packet);
+      packet.sacked = true;
+      packet.lost = false;
+      ++newly_acked;
+    }
+    highest_sacked = seq;
+  }
+
+  if (sample) {
+    sampleRtt(*sample);
+  }
+
+  if (highest_sacked) {
+    bool loss = false;
+    const std::uint32_t span = *highest_sacked - window_base_;
+    for (std::uint32_t offset = 0; offset < span; ++offset) {
+      auto &packet = window_[offset];
+      const std::uint32_t seq = window_base_ + offset;
+      // Give a resent packet one RTT to be acknowledged before giving up on
+      // it again.
+      if (!packet.sacked && !packet.lost && packet.transmissions > 0 &&
+          *highest_sacked - seq >= kDupThreshold &&
+          now - packet.sent_at >= srtt_) {
+        packet.lost = true;
+        loss = true;
+      }
+    }
+    if (loss) {
+      enterRecovery();
+    }
+  }
+
+  if (in_recovery_ && !seq_before(window_base_, recovery_point_)) {
+    in_recovery_ = false;
+  }
+
+  if (newly_acked > 0 && !in_recovery_) {
+    if (cwnd_ < ssthresh_) {
+      cwnd_ += double(newly_acked);
+    } else {
+      cwnd_ += double(newly_acked) / cwnd_;
+    }
+    cwnd_ = std::min(cwnd_, double(options_.max_window));
+  }
+}
+
+void ReliableChannel::enterRecovery() {
+  // One multiplicative decrease per window of data.
+  if (in_recovery_ || seq_before(window_base_, recovery_point_)) {
+    return;
+  }
+  ssthresh_ = std::max(cwnd_ / 2.0, 2.0);
+  cwnd_ = ssthresh_;
+  in_recovery_ = true;
+  recovery_point_ = window_base_ + static_cast<std::uint32_t>(window_.size());
+}
+
+void ReliableChannel::sampleRtt(std::chrono::microseconds sample) {
+  using std::chrono::microseconds;
+
+  if (!have_rtt_) {
+    srtt_ = sample;
+    rttvar_ = sample / 2;
+    have_rtt_ = true;
+  } else {
+    const auto delta = srtt_ > sample ? srtt_ - sample : sample - srtt_;
+    rttvar_ = (3 * rttvar_ + delta) / 4;
+    srtt_ = (7 * srtt_ + sample) / 8;
+  }
+
+  const auto rto = srtt_ + std::max(microseconds(1000), 4 * rttvar_);
+  rto_ = std::clamp<microseconds>(rto, options_.min_rto, options_.max_rto);
+}
+
+std::optional<ReliableChannel::Clock::time_point>
+ReliableChannel::retransmitDeadline() const {
+  std::optional<Clock::time_point> oldest;
+  for (const auto &packet : window_) {
+    if (packet.transmissions > 0 && !packet.sacked && !packet.lost &&
+        (!oldest || packet.sent_at < *oldest)) {
+      oldest = packet.sent_at;
+    }
+  }
+  if (!oldest) {
+    return std::nullopt;
+  }
+  return *oldest + rto_;
+}
+
+void ReliableChannel::onTimeout(Clock::time_point now) {
+  auto deadline = retransmitDeadline();
+  if (!deadline || now < *deadline) {
+    return;
+  }
+
+  ++stats_.timeouts;
+  ssthresh_ = std::max(cwnd_ / 2.0, 2.0);
+  cwnd_ = 1.0;
+  rto_ = std::min<std::chrono::microseconds>(rto_ * 2, options_.max_rto);
+  // Restart in slow start; recovery_point_ keeps SACK losses from the same
+  // window from cutting the window again.
+  in_recovery_ = false;
+  recovery_point_ = window_base_ + static_cast<std::uint32_t>(window_.size());
+
+  for (auto &packet : window_) {
+    if (packet.transmissions > 0 && !packet.sacked) {
+      packet.lost = true;
+    }
+  }
+}
+
+std::size_t ReliableChannel::inFlight() const noexcept {
+  return static_cast<std::size_t>(
+      std::count_if(window_.begin(), window_.end(), [](const Outgoing &p) {
+        return p.transmissions > 0 && !p.sacked && !p.lost;
+      }));
+}
+
+void ReliableChannel::transmit(Outgoing &packet, Clock::time_point now) {
+  try {
+    (void)socket_.send(packet.datagram);
+  } catch (const std::system_error &e) {
+    const int err = e.code().value();
+    if (!detail::is_would_block(err) && !is_connection_refused(err)) {
+      throw;
+    }
+    // Treated as a loss: the retransmission timer recovers it.
+  }
+
+  packet.sent_at = now;
+  if (packet.transmissions++ > 0) {
+    ++stats_.retransmissions;
+  }
+  ++stats_.packets_sent;
+}
+
+void ReliableChannel::flush() {
+  const auto now = Clock::now();
+  std::size_t in_flight = inFlight();
+
+  for (auto &packet : window_) {
+    if (double(in_flight) >= cwnd_) {
+      return;
+    }
+    if (packet.lost) {
+      packet.lost = false;
+      transmit(packet, now);
+      ++in_flight;
+    }
+  }
+
+  while (!pending_.empty() && window_.size() < options_.max_window &&
+         double(in_flight) < cwnd_) {
+    window_.push_back(std::move(pending_.front()));
+    pending_.pop_front();
+    transmit(window_.back(), now);
+    ++in_flight;
+  }
+}
+
+} // namespace net
@@ -0,0 +1,139 @@
+#include "net/protocol/tcp/adaptive_receive.h"
+#include "net/detail/platform_error.h"
+#include <algorithm>
+#include <array>
+#include <stdexcept>
+#include <system_error>
+
+namespace net {
+
+namespace {
+
+constexpr std::size_t kIndexIncrement = 4;
+constexpr std::size_t kIndexDecrement = 1;
+
+/// 16, 32, ..., 496, then 512, 1024, ... up to 512 MiB.
+constexpr auto kSizeTable = [] {
+  std::array<std::size_t, 31 + 21> table{};
+  std::size_t i = 0;
+  for (std::size_t size = 16; size < 512; size += 16) {
+    table[i++] = size;
+  }
+  for (std::size_t size = 512; i < table.size(); size <<= 1) {
+    table[i++] = size;
+  }
+  return table;
+}();
+
+/// Index of the smallest table entry >= size (clamped to the last entry).
+std::size_t index_of(std::size_t size) {
+  auto it = std::lower_bound(kSizeTable.begin(), kSizeTable.end(), size);
+  if (it == kSizeTable.end()) {
+    --it;
+  }
+  return static_cast<std::size_t>(it - kSizeTable.begin());
+}
+
+} // namespace
+
+AdaptiveReceiveSizer::AdaptiveReceiveSizer(std::size_t minimum,
+                                           std::size_t initial,
+                                           std::size_t maximum) {
+  if (minimum == 0 || minimum > initial || initial > maximum) {
+    throw std::invalid_argument(
+        "AdaptiveReceiveSizer requires 0 < minimum <= initial <= maximum");
+  }
+  min_index_ = index_of(minimum);
+  max_index_ = index_of(maximum);
+  index_ = std::clamp(index_of(initial), min_index_, max_index_);
+}
+
+std::size_t AdaptiveReceiveSizer::nextSize() const noexcept {
+  return kSizeTable[index_];
+}
+
+std::size_t AdaptiveReceiveSizer::nextSize(std::size_t queued) const noexcept {
+  if (queued == 0) {
+    return nextSize();
+  }
+  return std::clamp(queued, kSizeTable[min_index_], kSizeTable[max_index_]);
+}
+
+void AdaptiveReceiveSizer::record(std::size_t bytes_read) noexcept {
+  const std::size_t lower =
+      index_ > kIndexDecrement ? index_ - kIndexDecrement : 0;
+
+  if (bytes_read <= kSizeTable[lower]) {
+    // Shrink only after two small reads in a row to avoid oscillating.
+    if (decrease_now_) {
+      index_ = std::max(lower, min_index_);
+      decrease_now_ = false;
+    } else {
+      decrease_now_ = true;
+    }
+  } else if (bytes_read >= nextSize()) {
+    index_ = std::min(index_ + kIndexIncrement, max_index_);
+    decrease_now_ = false;
+  }
+}
+
+ReceiveResult receiveAvailable(TcpSocket &socket, AdaptiveReceiveSizer &sizer,
+                               ReceiveBuffer &out, ReceiveBudget budget,
+                               bool use_queued_hint) {
+  ReceiveResult result;
+  std::size_t receives = 0;
+
+  while (receives < budget.max_reads && result.bytes < budget.max_bytes) {
+    std::size_t queued = 0;
+    if (use_queued_hint) {
+      queued = socket.availableBytes();
+      ++result.reads;
+      // After a read, an empty queue means drained. Before one, readiness
+      // with nothing queued is a pending FIN or error that only recv reports.
+      if (queued == 0 && result.bytes > 0) {
+        result.drained = true;
+        return result;
+      }
+    }
+    const std::size_t want =
+        std::min(sizer.nextSize(queued), budget.max_bytes - result.bytes);
+
+    const std::size_t offset = out.size();
+    out.resize(offset + want);
+
+    std::size_t n;
+    ++receives;
+    ++result.reads;
+    try {
+      n = socket.receive(std::span(out).subspan(offset, want));
+    } catch (const std::system_error &e) {
+      out.resize(offset);
+      if (detail::is_would_block(e.code().value())) {
+        result.drained = true;
+        return result;
+      }
+      throw;
+    }
+
+    out.resize(offset + n);
+
+    if (n == 0) {
+      result.eof = true;
+      return result;
+    }
+
+    sizer.record(n);
+    result.bytes += n;
+
+    // A short read on a stream socket means the queue is empty; skip the
+    // extra syscall that would only report EAGAIN.
+    if (n < want) {
+      result.drained = true;
+      return result;
+    }
+  }
+
+  return result;
+}
+
+} // namespace net
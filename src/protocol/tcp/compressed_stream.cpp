@@ -0,0 +1,246 @@
+#include "net/protocol/tcp/compressed_stream.h"
+#include <algorithm>
+#include <stdexcept>
+
+namespace net {
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+// Frame header: method (1 byte), raw size (u32 BE), payload size (u32 BE).
+constexpr std::size_t kHeaderSize = 9;
+constexpr std::byte kStored{0};
+constexpr std::byte kLz4{1};
+constexpr std::size_t kMaxBlock = 16 * 1024 * 1024;
+
+// Acceleration per ladder level; the final level stores blocks.
+constexpr std::array<int, CompressedStream::kLevels - 1> kAcceleration{
+    1, 2, 4, 8, 16, 32};
+
+constexpr std::size_t kProbeInterval = 16; // blocks between neighbour probes
+constexpr double kSmoothing = 0.2;         // EWMA weight of a new sample
+
+void put32(std::byte *out, std::uint32_t value) {
+  for (int i = 3; i >= 0; --i) {
+    out[i] = static_cast<std::byte>(value & 0xFF);
+    value >>= 8;
+  }
+}
+
+std::uint32_t get32(const std::byte *in) {
+  std::uint32_t value = 0;
+  for (int i = 0; i < 4; ++i) {
+    value = (value << 8) | std::to_integer<std::uint32_t>(in[i]);
+  }
+  return value;
+}
+
+double smooth(double current, double sample, bool first) {
+  return first ? sample : current + kSmoothing * (sample - current);
+}
+
+double ns_since(Clock::time_point start) {
+  return double(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                    Clock::now() - start)
+                    .count());
+}
+
+} // namespace
+
+CompressedStream::CompressedStream(TcpSocket &socket, Options options)
+    : socket_(socket), options_(options) {
+  if (options_.block_size == 0 || options_.block_size > kMaxBlock) {
+    throw std::invalid_argument("CompressedStream block_size out of range");
+  }
+  if (options_.level >= kLevels) {
+    throw std::invalid_argument("CompressedStream level out of range");
+  }
+  stats_.level = options_.level;
+  pending_.reserve(options_.block_size);
+  frame_.resize(kHeaderSize + detail::Lz4Compressor::bound(options_.block_size));
+}
+
+void CompressedStream::send(std::span<const std::byte> data) {
+  while (!data.empty()) {
+    const std::size_t room = options_.block_size - pending_.size();
+    const std::size_t take = std::min(room, data.size());
+    pending_.insert(pending_.end(), data.begin(), data.begin() + take);
+    data = data.subspan(take);
+
+    if (pending_.size() == options_.block_size) {
+      writeBlock();
+    }
+  }
+}
+
+void CompressedStream::send(
+    std::span<const std::span<const std::byte>> chain) {
+  for (auto link : chain) {
+    send(link);
+  }
+}
+
+void CompressedStream::flush() {
+  if (!pending_.empty()) {
+    writeBlock();
+  }
+}
+
+void CompressedStream::writeBlock() {
+  const std::size_t raw_size = pending_.size();
+  const std::size_t level = stats_.level;
+  std::byte method = kStored;
+  std::size_t payload_size = raw_size;
+
+  const auto start = Clock::now();
+  if (level < kAcceleration.size()) {
+    const std::size_t compressed = compressor_.compress(
+        pending_, std::span(frame_).subspan(kHeaderSize), kAcceleration[level]);
+    if (compressed < raw_size) {
+      method = kLz4;
+      payload_size = compressed;
+    }
+  }
+  const double compress_ns = ns_since(start);
+
+  if (method == kStored) {
+    std::copy(pending_.begin(), pending_.end(), frame_.begin() + kHeaderSize);
+    ++stats_.stored_blocks_sent;
+  }
+
+  frame_[0] = method;
+  put32(frame_.data() + 1, static_cast<std::uint32_t>(raw_size));
+  put32(frame_.data() + 5, static_cast<std::uint32_t>(payload_size));
+
+  const std::size_t wire_size = kHeaderSize + payload_size;
+  const auto write_start = Clock::now();
+  writeAll(std::span(frame_).first(wire_size));
+  const double write_ns = ns_since(write_start);
+
+  auto &estimate = costs_[level];
+  estimate.compress_ns_per_byte =
+      smooth(estimate.compress_ns_per_byte,
+             compress_ns / double(raw_size), !estimate.measured);
+  estimate.ratio = smooth(estimate.ratio, double(wire_size) / double(raw_size),
+                          !estimate.measured);
+  estimate.measured = true;
+  link_ns_per_byte_ = smooth(link_ns_per_byte_, write_ns / double(wire_size),
+                             stats_.blocks_sent == 0);
+
+  stats_.raw_bytes_sent += raw_size;
+  stats_.wire_bytes_sent += wire_size;
+  ++stats_.blocks_sent;
+  pending_.clear();
+
+  adapt();
+}
+
+double CompressedStream::cost(std::size_t level) const noexcept {
+  // Per raw byte: compress it, then push its share of the frame.
+  const auto &c = costs_[level];
+  return c.compress_ns_per_byte + c.ratio * link_ns_per_byte_;
+}
+
+void CompressedStream::adapt() {
+  if (!options_.adaptive) {
+    return;
+  }
+
+  const std::size_t current = stats_.level;
+
+  // Periodically try a neighbour so estimates follow changing conditions.
+  if (++blocks_since_probe_ >= kProbeInterval) {
+    blocks_since_probe_ = 0;
+    probe_up_ = !probe_up_;
+    if (probe_up_ && current + 1 < kLevels) {
+      stats_.level = current + 1;
+    } else if (!probe_up_ && current > 0) {
+      stats_.level = current - 1;
+    }
+    return;
+  }
+
+  std::size_t best = current;
+  for (std::size_t candidate : {current - 1, current + 1}) {
+    if (candidate < kLevels && costs_[candidate].measured &&
+        cost(candidate) < cost(best)) {
+      best = candidate;
+    }
+  }
+  stats_.level = best;
+}
+
+void CompressedStream::writeAll(std::span<const std::byte> data) {
+  while (!data.empty()) {
+    const std::size_t n = socket_.send(data);
+    data = data.subspan(n);
+  }
+}
+
+bool CompressedStream::readExact(std::span<std::byte> buffer) {
+  std::size_t total = 0;
+  while (total < buffer.size()) {
+    const std::size_t n = socket_.receive(buffer.subspan(total));
+    if (n == 0) {
+      if (total == 0) {
+        return false;
+      }
+      throw std::runtime_error("CompressedStream: truncated frame");
+    }
+    total += n;
+  }
+  stats_.wire_bytes_received += total;
+  return true;
+}
+
+std::size_t CompressedStream::receive(std::span<std::byte> buffer) {
+  while (decoded_offset_ == decoded_.size()) {
+    std::array<std::byte, kHeaderSize> header{};
+    if (!readExact(header)) {
+      return 0;
+    }
+
+    const std::byte method = header[0];
+    const std::uint32_t raw_size = get32(header.data() + 1);
+    const std::uint32_t payload_size = get32(header.data() + 5);
+    if (raw_size > kMaxBlock ||
+        payload_size > detail::Lz4Compressor::bound(raw_size) ||
+        (method != kStored && method != kLz4) ||
+        (method == kStored && payload_size != raw_size)) {
+      throw std::runtime_error("CompressedStream: malformed frame header");
+    }
+
+    decoded_.resize(raw_size);
+    decoded_offset_ = 0;
+
+    if (method == kStored) {
+      if (!readExact(decoded_)) {
+        throw std::runtime_error("CompressedStream: truncated frame");
+      }
+    } else {
+      inbound_.resize(payload_size);
+      if (!readExact(inbound_)) {
+        throw std::runtime_error("CompressedStream: truncated frame");
+      }
+      if (detail::lz4_decompress(inbound_, decoded_) != raw_size) {
+        throw std::runtime_error("CompressedStream: size mismatch");
+      }
+    }
+    stats_.raw_bytes_received += raw_size;
+  }
+
+  const std::size_t n = std::min(buffer.size(), decoded_.size() - decoded_offset_);
+  std::copy_n(decoded_.begin() + decoded_offset_, n, buffer.begin());
+  decoded_offset_ += n;
+  return n;
+}
+
+CompressedStream::Stats CompressedStream::stats() const noexcept {
+  Stats result = stats_;
+  result.link_bytes_per_second =
+      link_ns_per_byte_ > 0.0 ? 1e9 / link_ns_per_byte_ : 0.0;
+  return result;
+}
+
+} // namespace net
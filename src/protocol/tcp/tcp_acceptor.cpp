@@ -0,0 +1,158 @@
+#include "net/protocol/tcp/tcp_acceptor.h"
+#include "net/detail/platform_error.h"
+#include "net/detail/syscall_helpers.h"
+#include <algorithm>
+#include <limits>
+#include <stdexcept>
+#include <system_error>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/resource.h>
+#include <unistd.h>
+#endif
+
+#ifdef __APPLE__
+#include <climits>
+#endif
+
+namespace net {
+
+std::size_t raiseFileDescriptorLimit(std::size_t desired) {
+#ifdef _WIN32
+  (void)desired;
+  return std::numeric_limits<std::size_t>::max();
+#else
+  rlimit limit{};
+  if (::getrlimit(RLIMIT_NOFILE, &limit) < 0) {
+    throw std::system_error(errno, std::generic_category(),
+                            "getrlimit(RLIMIT_NOFILE) failed");
+  }
+
+  rlim_t target = limit.rlim_max;
+  if (desired != 0 && static_cast<rlim_t>(desired) < target) {
+    target = static_cast<rlim_t>(desired);
+  }
+#ifdef __APPLE__
+  // macOS rejects soft limits above OPEN_MAX even with an unlimited hard one.
+  target = std::min<rlim_t>(target, OPEN_MAX);
+#endif
+
+  if (target > limit.rlim_cur) {
+    limit.rlim_cur = target;
+    if (::setrlimit(RLIMIT_NOFILE, &limit) < 0) {
+      throw std::system_error(errno, std::generic_category(),
+                              "setrlimit(RLIMIT_NOFILE) failed");
+    }
+  }
+
+  if (limit.rlim_cur == RLIM_INFINITY) {
+    return std::numeric_limits<std::size_t>::max();
+  }
+  return static_cast<std::size_t>(limit.rlim_cur);
+#endif
+}
+
+TcpAcceptor::TcpAcceptor(TcpSocket &listener, Options options)
+    : listener_(listener) {
+  if (!listener_.is_valid()) {
+    throw std::logic_error("TcpAcceptor on invalid socket");
+  }
+  if (options.raise_descriptor_limit) {
+    raiseFileDescriptorLimit();
+  }
+#ifndef _WIN32
+  if (!openReserve()) {
+    throw std::system_error(errno, std::generic_category(),
+                            "open reserve descriptor failed");
+  }
+#endif
+}
+
+TcpAcceptor::~TcpAcceptor() { closeReserve(); }
+
+bool TcpAcceptor::hasReserve() const noexcept { return reserve_ >= 0; }
+
+bool TcpAcceptor::openReserve() noexcept {
+#ifdef _WIN32
+  // Windows sockets are not drawn from a descriptor table, so there is
+  // nothing useful to hold in reserve.
+  return false;
+#else
+  if (reserve_ < 0) {
+    reserve_ = ::open("/dev/null", O_RDONLY | O_CLOEXEC);
+  }
+  return reserve_ >= 0;
+#endif
+}
+
+void TcpAcceptor::closeReserve() noexcept {
+#ifndef _WIN32
+  if (reserve_ >= 0) {
+    ::close(reserve_);
+    reserve_ = -1;
+  }
+#endif
+}
+
+std::optional<TcpSocket> TcpAcceptor::accept(Endpoint &peer) {
+  if (!listener_.is_valid()) {
+    throw std::logic_error("accept on invalid socket");
+  }
+
+  // A previous shed may have lost the spare to another thread; try again
+  // now that descriptors may have been released.
+  openReserve();
+
+  bool configured = false;
+  auto handle = TcpSocket::acceptHandle(listener_.native_handle(), peer,
+                                        listener_.blocking(),
+                                        listener_.inheritable(), configured);
+
+  if (handle == detail::SocketDescriptorHandle::Invalid) {
+    const int err = detail::last_socket_error();
+    if (detail::is_would_block(err)) {
+      return std::nullopt;
+    }
+    if (!detail::is_descriptor_exhausted(err)) {
+      throw std::system_error(err, detail::socket_category(),
+                              "tcp accept failed");
+    }
+    ++stats_.exhausted;
+    if (!hasReserve()) {
+      throw std::system_error(err, detail::socket_category(),
+                              "tcp accept failed");
+    }
+    return shed();
+  }
+
+  ++stats_.accepted;
+  return TcpSocket(handle, listener_.address_family(), listener_.blocking(),
+                   listener_.inheritable(), listener_.protocol_type(),
+                   configured);
+}
+
+std::optional<TcpSocket> TcpAcceptor::shed() {
+  closeReserve();
+
+  Endpoint discarded;
+  bool configured = false;
+  auto handle = TcpSocket::acceptHandle(listener_.native_handle(), discarded,
+                                        listener_.blocking(),
+                                        listener_.inheritable(), configured);
+
+  if (handle != detail::SocketDescriptorHandle::Invalid) {
+    // Closed immediately when it goes out of scope.
+    TcpSocket discard(handle, listener_.address_family(),
+                      listener_.blocking(), listener_.inheritable(),
+                      listener_.protocol_type(), configured);
+    ++stats_.shed;
+  }
+
+  if (!openReserve()) {
+    ++stats_.reserve_failures;
+  }
+  return std::nullopt;
+}
+
+} // namespace net
@@ -0,0 +1,179 @@
+#include "net/protocol/tcp/tcp_capture_tap.h"
+#include <cstring>
+#include <stdexcept>
+
+#include <netinet/in.h>
+
+namespace net {
+
+namespace {
+
+constexpr std::uint8_t tcp_syn = 0x02;
+constexpr std::uint8_t tcp_psh = 0x08;
+constexpr std::uint8_t tcp_ack = 0x10;
+
+constexpr std::size_t ipv4_header_size = 20;
+constexpr std::size_t ipv6_header_size = 40;
+constexpr std::size_t tcp_header_size = 20;
+
+std::byte *put16(std::byte *out, std::uint16_t value) noexcept {
+  out[0] = static_cast<std::byte>(value >> 8);
+  out[1] = static_cast<std::byte>(value);
+  return out + 2;
+}
+
+std::byte *put32(std::byte *out, std::uint32_t value) noexcept {
+  out = put16(out, static_cast<std::uint16_t>(value >> 16));
+  return put16(out, static_cast<std::uint16_t>(value));
+}
+
+std::uint16_t ipv4Checksum(const std::byte *header) noexcept {
+  std::uint32_t sum = 0;
+  for (std::size_t i = 0; i < ipv4_header_size; i += 2) {
+    sum += (std::to_integer<std::uint32_t>(header[i]) << 8) |
+           std::to_integer<std::uint32_t>(header[i + 1]);
+  }
+  while ((sum >> 16) != 0) {
+    sum = (sum & 0xFFFF) + (sum >> 16);
+  }
+  return static_cast<std::uint16_t>(~sum);
+}
+
+} // namespace
+
+TcpCaptureTap::TcpCaptureTap(std::shared_ptr<PcapngWriter> writer,
+                             const Endpoint &local, const Endpoint &remote,
+                             Options options)
+    : writer_(std::move(writer)) {
+  if (!writer_) {
+    throw std::invalid_argument("TcpCaptureTap requires a writer");
+  }
+  const auto family = local.data()->sa_family;
+  if (family != remote.data()->sa_family ||
+      (family != AF_INET && family != AF_INET6)) {
+    throw std::invalid_argument(
+        "TcpCaptureTap endpoints must both be IPv4 or both IPv6");
+  }
+  ipv6_ = family == AF_INET6;
+
+  auto copyAddress = [this](const Endpoint &endpoint,
+                            std::array<std::byte, 16> &out) {
+    if (ipv6_) {
+      const auto *address =
+          reinterpret_cast<const sockaddr_in6 *>(endpoint.data());
+      std::memcpy(out.data(), &address->sin6_addr, 16);
+    } else {
+      const auto *address =
+          reinterpret_cast<const sockaddr_in *>(endpoint.data());
+      std::memcpy(out.data(), &address->sin_addr, 4);
+    }
+  };
+  copyAddress(local, outbound_.source);
+  copyAddress(remote, outbound_.destination);
+  outbound_.source_port = local.port();
+  outbound_.destination_port = remote.port();
+
+  inbound_.source = outbound_.destination;
+  inbound_.destination = outbound_.source;
+  inbound_.source_port = outbound_.destination_port;
+  inbound_.destination_port = outbound_.source_port;
+
+  if (options.handshake) {
+    if (options.local_initiated) {
+      synthesizeHandshake(outbound_, inbound_);
+    } else {
+      synthesizeHandshake(inbound_, outbound_);
+    }
+  }
+}
+
+std::shared_ptr<TcpCaptureTap>
+TcpCaptureTap::attach(TcpSocket &socket, std::shared_ptr<PcapngWriter> writer,
+                      Options options) {
+  auto tap = std::make_shared<TcpCaptureTap>(
+      std::move(writer), socket.localEndpoint(), socket.remoteEndpoint(),
+      options);
+  socket.setTap(tap);
+  return tap;
+}
+
+void TcpCaptureTap::onSend(std::span<const std::byte> data) noexcept {
+  record(outbound_, inbound_, data);
+}
+
+void TcpCaptureTap::onReceive(std::span<const std::byte> data) noexcept {
+  record(inbound_, outbound_, data);
+}
+
+void TcpCaptureTap::record(Flow &flow, const Flow &reverse,
+                           std::span<const std::byte> data) noexcept {
+  // Claim the sequence range up front so concurrent calls in one direction
+  // still produce a consistent stream.
+  std::uint32_t seq = flow.next_seq.fetch_add(
+      static_cast<std::uint32_t>(data.size()), std::memory_order_relaxed);
+  const std::uint32_t ack = reverse.next_seq.load(std::memory_order_relaxed);
+  const std::uint64_t timestamp = PcapngWriter::now();
+
+  while (!data.empty()) {
+    const std::size_t length = std::min(data.size(), max_segment);
+    segment(flow, seq, ack, tcp_psh | tcp_ack, data.first(length), timestamp);
+    seq += static_cast<std::uint32_t>(length);
+    data = data.subspan(length);
+  }
+}
+
+void TcpCaptureTap::synthesizeHandshake(Flow &client, Flow &server) noexcept {
+  const std::uint64_t timestamp = PcapngWriter::now();
+  segment(client, 0, 0, tcp_syn, {}, timestamp);
+  segment(server, 0, 1, tcp_syn | tcp_ack, {}, timestamp);
+  segment(client, 1, 1, tcp_ack, {}, timestamp);
+  // SYN consumes one sequence number in each direction.
+  client.next_seq.store(1, std::memory_order_relaxed);
+  server.next_seq.store(1, std::memory_order_relaxed);
+}
+
+void TcpCaptureTap::segment(const Flow &flow, std::uint32_t seq,
+                            std::uint32_t ack, std::uint8_t flags,
+                            std::span<const std::byte> payload,
+                            std::uint64_t timestamp_ns) noexcept {
+  std::array<std::byte, ipv6_header_size + tcp_header_size> header{};
+  std::byte *out = header.data();
+  const std::size_t tcp_length = tcp_header_size + payload.size();
+
+  if (ipv6_) {
+    out = put32(out, 0x60000000); // version 6, no traffic class or label
+    out = put16(out, static_cast<std::uint16_t>(tcp_length));
+    *out++ = std::byte{IPPROTO_TCP};
+    *out++ = std::byte{64}; // hop limit
+    std::memcpy(out, flow.source.data(), 16);
+    std::memcpy(out + 16, flow.destination.data(), 16);
+    out += 32;
+  } else {
+    std::byte *ip = out;
+    *out++ = std::byte{0x45}; // version 4, 5-word header
+    *out++ = std::byte{0};
+    out = put16(out, static_cast<std::uint16_t>(ipv4_header_size + tcp_length));
+    out = put16(out, 0);      // identification
+    out = put16(out, 0x4000); // don't fragment
+    *out++ = std::byte{64};   // TTL
+    *out++ = std::byte{IPPROTO_TCP};
+    out += 2; // checksum, filled in below
+    std::memcpy(out, flow.source.data(), 4);
+    std::memcpy(out + 4, flow.destination.data(), 4);
+    out += 8;
+    put16(ip + 10, ipv4Checksum(ip));
+  }
+
+  out = put16(out, flow.source_port);
+  out = put16(out, flow.destination_port);
+  out = put32(out, seq);
+  out = put32(out, (flags & tcp_ack) != 0 ? ack : 0);
+  *out++ = std::byte{(tcp_header_size / 4) << 4};
+  *out++ = std::byte{flags};
+  out = put16(out, 0xFFFF); // window
+  out += 4;                 // checksum and urgent pointer left zero
+
+  writer_->write(std::span(header.data(), out), payload, timestamp_ns);
+}
+
+} // namespace net
@@ -0,0 +1,292 @@
+#include "net/protocol/tcp/tcp_file_sender.h"
+#include "net/core/io_capabilities.h"
+#include "net/detail/platform_error.h"
+#include <algorithm>
+#include <cerrno>
+#include <climits>
+#include <stdexcept>
+#include <system_error>
+
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace net {
+
+namespace {
+
+constexpr std::size_t kMaxChainLength = 1024;
+
+int sendFlags() noexcept {
+  int flags = MSG_WAITALL;
+#ifdef MSG_NOSIGNAL
+  flags |= MSG_NOSIGNAL;
+#endif
+  return flags;
+}
+
+} // namespace
+
+TcpFileSender::TcpFileSender(TcpSocket &socket, Options options)
+    : socket_(socket), options_(options) {
+  if (options_.chunk_size == 0 || options_.chain_length == 0) {
+    throw std::invalid_argument("TcpFileSender sizes must be positive");
+  }
+  if (options_.chunk_size > static_cast<std::size_t>(INT_MAX) ||
+      options_.chain_length > kMaxChainLength) {
+    throw std::invalid_argument("TcpFileSender chunk or chain too large");
+  }
+
+  if (options_.use_io_uring &&
+      ioBackends().file_send == FileSendBackend::IoUring) {
+    try {
+      ring_ = std::make_unique<detail::IoUring>(
+          static_cast<unsigned>(2 * options_.chain_length));
+      buffers_.resize(options_.chunk_size * options_.chain_length);
+      std::vector<std::span<std::byte>> registered;
+      for (std::size_t i = 0; i < options_.chain_length; ++i) {
+        registered.push_back(std::span(buffers_).subspan(
+            i * options_.chunk_size, options_.chunk_size));
+      }
+      ring_->registerBuffers(registered);
+    } catch (const std::system_error &) {
+      ring_.reset();
+    }
+  }
+  if (!ring_) {
+    buffers_.assign(options_.chunk_size, std::byte{0});
+    buffers_.shrink_to_fit();
+  }
+  chain_.reserve(options_.chain_length);
+}
+
+TcpFileSender::~TcpFileSender() { drainInFlight(); }
+
+void TcpFileSender::drainInFlight() noexcept {
+  while (ring_ && in_flight_ > 0) {
+    try {
+      ring_->submit(1);
+    } catch (const std::system_error &) {
+      return;
+    }
+    reap();
+  }
+}
+
+int TcpFileSender::completionHandle() const noexcept {
+  return ring_ ? ring_->fd() : -1;
+}
+
+std::uint64_t TcpFileSender::sendFile(int file, std::uint64_t offset,
+                                      std::uint64_t length) {
+  start(file, offset, length);
+  while (!advance()) {
+    if (ring_) {
+      ring_->submit(1);
+    } else if (pending_begin_ < pending_end_) {
+      waitWritable(); // non-blocking socket with a full send buffer
+    }
+  }
+  return sent();
+}
+
+void TcpFileSender::start(int file, std::uint64_t offset,
+                          std::uint64_t length) {
+  if (active_) {
+    throw std::logic_error("TcpFileSender transfer already in progress");
+  }
+
+  std::uint64_t end = length > UINT64_MAX - offset ? UINT64_MAX
+                                                   : offset + length;
+  struct stat info{};
+  if (::fstat(file, &info) != 0) {
+    throw std::system_error(errno, std::generic_category(),
+                            "fstat(file) failed");
+  }
+  if (S_ISREG(info.st_mode)) {
+    end = std::min<std::uint64_t>(end, static_cast<std::uint64_t>(
+                                           std::max<off_t>(info.st_size, 0)));
+  }
+
+  file_ = file;
+  start_offset_ = next_offset_ = offset;
+  end_offset_ = std::max(end, offset);
+  read_cap_ = 0;
+  pending_begin_ = pending_end_ = 0;
+  active_ = next_offset_ < end_offset_;
+
+  if (active_ && ring_) {
+    submitChain();
+  }
+}
+
+bool TcpFileSender::advance() {
+  if (!active_) {
+    return true;
+  }
+  try {
+    if (!ring_) {
+      return advanceFallback();
+    }
+    reap();
+    if (in_flight_ > 0) {
+      return false;
+    }
+    finishChain();
+    if (next_offset_ >= end_offset_) {
+      active_ = false;
+      return true;
+    }
+    submitChain();
+    return false;
+  } catch (...) {
+    active_ = false;
+    throw;
+  }
+}
+
+void TcpFileSender::submitChain() {
+  chain_.clear();
+  std::uint64_t offset = next_offset_;
+  while (chain_.size() < options_.chain_length && offset < end_offset_) {
+    std::size_t length = static_cast<std::size_t>(
+        std::min<std::uint64_t>(options_.chunk_size, end_offset_ - offset));
+    if (chain_.empty() && read_cap_ > 0) {
+      length = static_cast<std::size_t>(
+          std::min<std::uint64_t>(length, read_cap_));
+    }
+    chain_.push_back({offset, length, 0, 0});
+    offset += length;
+  }
+
+  // read -> send -> read -> send ...: every entry but the last links to
+  // the next, so sends stay in file order and a failure cancels the rest.
+  const int socket = static_cast<int>(socket_.native_handle());
+  for (std::size_t i = 0; i < chain_.size(); ++i) {
+    auto buffer = std::span(buffers_).subspan(i * options_.chunk_size,
+                                              chain_[i].length);
+    const bool last = i + 1 == chain_.size();
+    ring_->prepareReadFixed(file_, buffer, chain_[i].offset,
+                            static_cast<unsigned>(i), 2 * i, true);
+    ring_->prepareSend(socket, buffer, sendFlags(), 2 * i + 1, !last);
+  }
+  in_flight_ = 2 * chain_.size();
+  ring_->submit();
+  ++stats_.chains;
+}
+
+void TcpFileSender::reap() {
+  while (auto completion = ring_->peek()) {
+    Chunk &chunk = chain_[completion->user_data / 2];
+    if ((completion->user_data & 1) != 0) {
+      chunk.send_result = completion->result;
+    } else {
+      chunk.read_result = completion->result;
+    }
+    --in_flight_;
+  }
+}
+
+void TcpFileSender::finishChain() {
+  for (std::size_t i = 0; i < chain_.size(); ++i) {
+    const Chunk &chunk = chain_[i];
+    const std::int32_t read_bytes = chunk.read_result;
+    const std::int32_t sent_bytes = chunk.send_result;
+    if (read_bytes < 0 && read_bytes != -ECANCELED) {
+      throw std::system_error(-read_bytes, std::generic_category(),
+                              "io_uring file read failed");
+    }
+    if (read_bytes == -ECANCELED) {
+      break;
+    }
+    if (read_bytes == 0) {
+      end_offset_ = chunk.offset; // file shrank
+      break;
+    }
+    stats_.bytes_read += static_cast<std::uint64_t>(read_bytes);
+
+    if (sent_bytes < 0 && sent_bytes != -ECANCELED) {
+      throw std::system_error(-sent_bytes, std::generic_category(),
+                              "io_uring send failed");
+    }
+    if (sent_bytes == -ECANCELED) {
+      // A short read cut the chain before its send: those bytes exist, so
+      // the next chain starts with a read of exactly that size.
+      read_cap_ = static_cast<std::uint64_t>(read_bytes);
+      ++stats_.resumes;
+      break;
+    }
+    // The ring sends past TcpSocket::send(), so report to its tap here.
+    if (SocketTap *tap = socket_.tap(); tap != nullptr && sent_bytes > 0) {
+      tap->onSend(std::span(buffers_).subspan(
+          i * options_.chunk_size, static_cast<std::size_t>(sent_bytes)));
+    }
+    next_offset_ += static_cast<std::uint64_t>(sent_bytes);
+    stats_.bytes_sent += static_cast<std::uint64_t>(sent_bytes);
+    read_cap_ = 0;
+    if (static_cast<std::size_t>(sent_bytes) < chunk.length) {
+      ++stats_.resumes;
+      break;
+    }
+  }
+}
+
+void TcpFileSender::waitWritable() const {
+  pollfd pfd{socket_.native_handle(), POLLOUT, 0};
+  while (::poll(&pfd, 1, -1) < 0) {
+    if (errno != EINTR) {
+      throw std::system_error(errno, std::generic_category(),
+                              "poll(socket) failed");
+    }
+  }
+}
+
+bool TcpFileSender::advanceFallback() {
+  if (pending_begin_ == pending_end_) {
+    const auto length = static_cast<std::size_t>(std::min<std::uint64_t>(
+        buffers_.size(), end_offset_ - next_offset_));
+    ssize_t n;
+    do {
+      n = ::pread(file_, buffers_.data(), length,
+                  static_cast<off_t>(next_offset_));
+    } while (n < 0 && errno == EINTR);
+    if (n < 0) {
+      throw std::system_error(errno, std::generic_category(),
+                              "pread(file) failed");
+    }
+    if (n == 0) {
+      end_offset_ = next_offset_;
+      active_ = false;
+      return true;
+    }
+    pending_begin_ = 0;
+    pending_end_ = static_cast<std::size_t>(n);
+    stats_.bytes_read += static_cast<std::uint64_t>(n);
+    ++stats_.chains;
+  }
+
+  while (pending_begin_ < pending_end_) {
+    std::size_t sent = 0;
+    try {
+      sent = socket_.send(std::span<const std::byte>(buffers_).subspan(
+          pending_begin_, pending_end_ - pending_begin_));
+    } catch (const std::system_error &error) {
+      if (!detail::is_would_block(error.code().value())) {
+        throw;
+      }
+      return false; // the rest is sent once the socket is writable
+    }
+    pending_begin_ += sent;
+    next_offset_ += sent;
+    stats_.bytes_sent += sent;
+  }
+
+  if (next_offset_ >= end_offset_) {
+    active_ = false;
+    return true;
+  }
+  return false;
+}
+
+} // namespace net
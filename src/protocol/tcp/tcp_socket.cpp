@@ -1,10 +1,32 @@
+#include "net/core/io_capabilities.h"
+#include "net/detail/io_wait_hook.h"
 #include "net/detail/platform_error.h"
 #include "net/detail/syscall_helpers.h"
+#include <algorithm>
+#include <cstring>
+#include <limits>
 #include <net/protocol/tcp/tcp_socket.h>
 #include <system_error>
 
+#ifndef _WIN32
+#include <poll.h>
+#include <sys/ioctl.h>
+#endif
+
+#ifdef __linux__
+#include <netinet/in.h>
+#include <linux/mptcp.h>
+#endif
+
 namespace net {
 
+TcpSocket::ProtocolType TcpSocket::streamProtocol(ProtocolType protocol) {
+  if (protocol != ProtocolType::TCP && protocol != ProtocolType::MPTCP) {
+    throw std::invalid_argument("TcpSocket requires TCP or MPTCP protocol");
+  }
+  return protocol;
+}
+
 void TcpSocket::connect(const Endpoint &ep) {
   if (!is_valid()) {
     throw std::logic_error("connect on invalid socket");
@@ -52,6 +74,25 @@ void TcpSocket::setReuseAddress(bool enable) {
   }
 }
 
+void TcpSocket::setReusePort(bool enable) {
+  if (!is_valid()) {
+    throw std::logic_error("setReusePort on invalid socket");
+  }
+#ifdef SO_REUSEPORT
+  int opt = enable ? 1 : 0;
+  if (::setsockopt(native_handle(), SOL_SOCKET, SO_REUSEPORT,
+                   reinterpret_cast<const char *>(&opt), sizeof(opt)) < 0) {
+    throw std::system_error(detail::last_socket_error(),
+                            detail::socket_category(),
+                            "setsockopt(SO_REUSEPORT) failed");
+  }
+#else
+  (void)enable;
+  throw std::system_error(std::make_error_code(std::errc::not_supported),
+                          "SO_REUSEPORT is not supported on this platform");
+#endif
+}
+
 void TcpSocket::listen(int backlog) {
   if (!is_valid()) {
     throw std::logic_error("listen on invalid socket");
@@ -66,21 +107,125 @@ TcpSocket TcpSocket::accept(Endpoint &peer) {
   if (!is_valid())
     throw std::logic_error("accept on invalid socket");
 
-  auto new_handle = detail::retry_if_interrupted(
-      [&] { return ::accept(native_handle(), peer.data(), peer.size_ptr()); });
+#ifndef _WIN32
+  // Under an I/O wait hook (e.g. inside a fiber), wait for a pending
+  // connection without blocking the thread.
+  if (detail::io_wait_hook != nullptr &&
+      blocking() == BlockingType::Blocking) {
+    for (;;) {
+      pollfd pfd{native_handle(), POLLIN, 0};
+      const int ready =
+          detail::retry_if_interrupted([&] { return ::poll(&pfd, 1, 0); });
+      if (ready != 0) {
+        break; // pending connection, or an error accept() will report
+      }
+      detail::io_wait_hook->wait(detail::io_wait_hook->context,
+                                 native_handle(), false);
+    }
+  }
+#endif
+
+  bool configured = false;
+  auto new_handle = acceptHandle(native_handle(), peer, blocking(),
+                                 inheritable(), configured);
 
   if (new_handle == detail::SocketDescriptorHandle::Invalid) {
     throw std::system_error(detail::last_socket_error(),
                             detail::socket_category(), "tcp accept failed");
   }
-  return TcpSocket(new_handle, address_family(), blocking(), inheritable());
+  return TcpSocket(new_handle, address_family(), blocking(), inheritable(),
+                   protocol_type(), configured);
+}
+
+TcpSocket::Handle TcpSocket::acceptHandle(Handle listener, Endpoint &peer,
+                                          BlockingType blocking,
+                                          InheritableType inheritable,
+                                          bool &configured) {
+  configured = false;
+#if defined(__linux__) && defined(SOCK_CLOEXEC)
+  if (ioBackends().accept == AcceptBackend::Accept4) {
+    int flags = 0;
+    if (blocking == BlockingType::NonBlocking) {
+      flags |= SOCK_NONBLOCK;
+    }
+    if (inheritable == InheritableType::NonInheritable) {
+      flags |= SOCK_CLOEXEC;
+    }
+    auto handle = detail::retry_if_interrupted([&] {
+      return ::accept4(listener, peer.data(), peer.size_ptr(), flags);
+    });
+    configured = handle != detail::SocketDescriptorHandle::Invalid;
+    return handle;
+  }
+#else
+  (void)blocking;
+  (void)inheritable;
+#endif
+  return detail::retry_if_interrupted(
+      [&] { return ::accept(listener, peer.data(), peer.size_ptr()); });
 }
 
 std::size_t TcpSocket::send(std::span<const std::byte> data) {
-  return raw_send(data);
+  const std::size_t n = raw_send(data);
+  if (tap_ && n > 0) {
+    tap_->onSend(data.first(n));
+  }
+  return n;
 }
 std::size_t TcpSocket::receive(std::span<std::byte> buffer) {
-  return raw_recv(buffer);
+  const std::size_t n = raw_recv(buffer);
+  if (tap_ && n > 0) {
+    tap_->onReceive(buffer.first(n));
+  }
+  return n;
+}
+
+std::size_t TcpSocket::availableBytes() const {
+  if (!is_valid()) {
+    throw std::logic_error("availableBytes on invalid socket");
+  }
+
+#ifdef _WIN32
+  u_long queued = 0;
+  if (::ioctlsocket(native_handle(), FIONREAD, &queued) == SOCKET_ERROR) {
+#else
+  int queued = 0;
+  if (::ioctl(native_handle(), FIONREAD, &queued) < 0) {
+#endif
+    throw std::system_error(detail::last_socket_error(),
+                            detail::socket_category(),
+                            "ioctl(FIONREAD) failed");
+  }
+  return static_cast<std::size_t>(queued);
+}
+
+void TcpSocket::setReceiveLowWatermark(std::size_t bytes) {
+  if (!is_valid()) {
+    throw std::logic_error("setReceiveLowWatermark on invalid socket");
+  }
+  int opt = static_cast<int>(std::clamp<std::size_t>(
+      bytes, 1, static_cast<std::size_t>(std::numeric_limits<int>::max())));
+  if (::setsockopt(native_handle(), SOL_SOCKET, SO_RCVLOWAT,
+                   reinterpret_cast<const char *>(&opt), sizeof(opt)) < 0) {
+    throw std::system_error(detail::last_socket_error(),
+                            detail::socket_category(),
+                            "setsockopt(SO_RCVLOWAT) failed");
+  }
+}
+
+std::size_t TcpSocket::receiveLowWatermark() const {
+  if (!is_valid()) {
+    throw std::logic_error("receiveLowWatermark on invalid socket");
+  }
+  int opt = 0;
+  detail::socket_length_t len = sizeof(opt);
+  if (::getsockopt(native_handle(), SOL_SOCKET, SO_RCVLOWAT,
+                   reinterpret_cast<char *>(&opt), &len) < 0) {
+    throw std::system_error(detail::last_socket_error(),
+                            detail::socket_category(),
+                            "getsockopt(SO_RCVLOWAT) failed");
+  }
+  return static_cast<std::size_t>(opt);
 }
 
 Endpoint TcpSocket::localEndpoint() const {
@@ -104,4 +249,126 @@ Endpoint TcpSocket::localEndpoint() const {
   return endpoint;
 }
 
+Endpoint TcpSocket::remoteEndpoint() const {
+  if (!is_valid()) {
+    throw std::logic_error("remoteEndpoint on invalid socket");
+  }
+
+  Endpoint endpoint;
+  detail::socket_length_t len = sizeof(sockaddr_storage);
+
+  if (::getpeername(native_handle(), endpoint.data(), &len) < 0) {
+    throw std::system_error(detail::last_socket_error(),
+                            detail::socket_category(), "getpeername failed");
+  }
+  endpoint.set_size(len);
+
+  return endpoint;
+}
+
+MptcpInfo TcpSocket::multipathInfo() const {
+  if (!is_valid()) {
+    throw std::logic_error("multipathInfo on invalid socket");
+  }
+  if (!isMultipath()) {
+    throw std::logic_error("multipathInfo on non-MPTCP socket");
+  }
+
+  MptcpInfo info;
+#ifdef __linux__
+  mptcp_info native{};
+  socklen_t len = sizeof(native);
+
+  if (::getsockopt(native_handle(), SOL_MPTCP, MPTCP_INFO, &native, &len) < 0) {
+    throw std::system_error(detail::last_socket_error(),
+                            detail::socket_category(),
+                            "getsockopt(MPTCP_INFO) failed");
+  }
+
+  // Older kernels report an empty structure once the connection has fallen
+  // back to plain TCP.
+  if (len == 0) {
+    info.fallback = true;
+    return info;
+  }
+
+  info.subflows = native.mptcpi_subflows;
+  info.subflows_max = native.mptcpi_subflows_max;
+  info.add_addr_signal = native.mptcpi_add_addr_signal;
+  info.add_addr_accepted = native.mptcpi_add_addr_accepted;
+  info.local_addr_used = native.mptcpi_local_addr_used;
+  info.local_addr_max = native.mptcpi_local_addr_max;
+  info.fallback = (native.mptcpi_flags & MPTCP_INFO_FLAG_FALLBACK) != 0;
+  info.token = native.mptcpi_token;
+  info.write_seq = native.mptcpi_write_seq;
+  info.snd_una = native.mptcpi_snd_una;
+  info.rcv_nxt = native.mptcpi_rcv_nxt;
+#endif
+  return info;
+}
+
+std::vector<MptcpSubflow> TcpSocket::subflows() const {
+  if (!is_valid()) {
+    throw std::logic_error("subflows on invalid socket");
+  }
+  if (!isMultipath()) {
+    throw std::logic_error("subflows on non-MPTCP socket");
+  }
+
+  std::vector<MptcpSubflow> result;
+#ifdef __linux__
+  // Header followed by an array of per-subflow address pairs; grow the array
+  // until the kernel reports no more subflows than we have room for.
+  std::size_t capacity = 4;
+
+  for (;;) {
+    std::vector<std::byte> buffer(sizeof(mptcp_subflow_data) +
+                                  capacity * sizeof(mptcp_subflow_addrs));
+    mptcp_subflow_data header{};
+    header.size_subflow_data = sizeof(mptcp_subflow_data);
+    header.size_user = sizeof(mptcp_subflow_addrs);
+    std::memcpy(buffer.data(), &header, sizeof(header));
+
+    auto len = static_cast<socklen_t>(buffer.size());
+    if (::getsockopt(native_handle(), SOL_MPTCP, MPTCP_SUBFLOW_ADDRS,
+                     buffer.data(), &len) < 0) {
+      throw std::system_error(detail::last_socket_error(),
+                              detail::socket_category(),
+                              "getsockopt(MPTCP_SUBFLOW_ADDRS) failed");
+    }
+
+    std::memcpy(&header, buffer.data(), sizeof(header));
+    if (header.num_subflows > capacity) {
+      capacity = header.num_subflows;
+      continue;
+    }
+
+    const std::size_t element_size =
+        std::min<std::size_t>(header.size_kernel, sizeof(mptcp_subflow_addrs));
+    const std::byte *entry = buffer.data() + header.size_subflow_data;
+
+    for (std::uint32_t i = 0; i < header.num_subflows; ++i) {
+      mptcp_subflow_addrs addrs{};
+      std::memcpy(&addrs, entry + i * header.size_user, element_size);
+
+      MptcpSubflow subflow;
+      auto local_len = addrs.sa_local.sa_family == AF_INET6
+                           ? sizeof(sockaddr_in6)
+                           : sizeof(sockaddr_in);
+      auto remote_len = addrs.sa_remote.sa_family == AF_INET6
+                            ? sizeof(sockaddr_in6)
+                            : sizeof(sockaddr_in);
+      std::memcpy(subflow.local.data(), &addrs.ss_local, local_len);
+      subflow.local.set_size(static_cast<detail::socket_length_t>(local_len));
+      std::memcpy(subflow.remote.data(), &addrs.ss_remote, remote_len);
+      subflow.remote.set_size(
+          static_cast<detail::socket_length_t>(remote_len));
+      result.push_back(subflow);
+    }
+    break;
+  }
+#endif
+  return result;
+}
+
 } // namespace net
@@ -0,0 +1,138 @@
+#include "net/protocol/tcp/tcp_zerocopy_receiver.h"
+#include "net/core/io_capabilities.h"
+#include "net/detail/platform_error.h"
+#include <algorithm>
+#include <stdexcept>
+#include <system_error>
+
+#ifdef __linux__
+#include <linux/tcp.h>
+#include <poll.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+namespace net {
+
+TcpZeroCopyReceiver::TcpZeroCopyReceiver(TcpSocket &socket,
+                                         std::size_t region_size,
+                                         std::size_t copy_size)
+    : socket_(socket), copy_buffer_(copy_size) {
+  if (region_size == 0 || copy_size == 0) {
+    throw std::invalid_argument("TcpZeroCopyReceiver sizes must be positive");
+  }
+
+#if defined(__linux__) && defined(TCP_ZEROCOPY_RECEIVE)
+  if (ioBackends().receive != ReceiveBackend::ZeroCopy) {
+    return;
+  }
+  const auto page = static_cast<std::size_t>(::sysconf(_SC_PAGESIZE));
+  region_size_ = (region_size + page - 1) / page * page;
+
+  // Mapping a TCP socket reserves address space the kernel fills with
+  // receive-queue pages; failure just means no zero-copy support.
+  void *region = ::mmap(nullptr, region_size_, PROT_READ, MAP_SHARED,
+                        socket_.native_handle(), 0);
+  if (region != MAP_FAILED) {
+    region_ = static_cast<std::byte *>(region);
+  }
+#endif
+}
+
+TcpZeroCopyReceiver::~TcpZeroCopyReceiver() { disableMapping(); }
+
+void TcpZeroCopyReceiver::disableMapping() noexcept {
+#ifdef __linux__
+  if (region_ != nullptr) {
+    ::munmap(region_, region_size_);
+  }
+#endif
+  region_ = nullptr;
+}
+
+bool TcpZeroCopyReceiver::tryMap(ZeroCopyChunk &chunk) {
+#if defined(__linux__) && defined(TCP_ZEROCOPY_RECEIVE)
+  tcp_zerocopy_receive request{};
+  request.address = reinterpret_cast<std::uint64_t>(region_);
+  request.length = static_cast<std::uint32_t>(region_size_);
+  socklen_t length = sizeof(request);
+
+  int result;
+  do {
+    result = ::getsockopt(socket_.native_handle(), IPPROTO_TCP,
+                          TCP_ZEROCOPY_RECEIVE, &request, &length);
+  } while (result < 0 && errno == EINTR);
+
+  if (result < 0) {
+    // The kernel refuses mapped receive for this socket (unsupported
+    // protocol, device or mapping). Copy from now on; genuine connection
+    // errors resurface on the copying recv().
+    disableMapping();
+    return false;
+  }
+  if (request.err != 0) {
+    throw std::system_error(request.err, std::generic_category(),
+                            "tcp zerocopy receive failed");
+  }
+
+  chunk.mapped = {region_, request.length};
+  stats_.mapped_bytes += request.length;
+  if (SocketTap *tap = socket_.tap(); tap != nullptr && !chunk.mapped.empty()) {
+    tap->onReceive(chunk.mapped);
+  }
+
+  // The kernel stops mapping at the first unaligned byte; copy up to the
+  // point where mapping can resume.
+  if (request.recv_skip_hint > 0) {
+    const std::size_t want =
+        std::min<std::size_t>(request.recv_skip_hint, copy_buffer_.size());
+    const std::size_t n = socket_.receive(std::span(copy_buffer_).first(want));
+    chunk.copied = {copy_buffer_.data(), n};
+    stats_.copied_bytes += n;
+  }
+
+  return !chunk.empty();
+#else
+  (void)chunk;
+  return false;
+#endif
+}
+
+ZeroCopyChunk TcpZeroCopyReceiver::receive() {
+  if (!socket_.is_valid()) {
+    throw std::logic_error("receive on invalid socket");
+  }
+
+  ZeroCopyChunk chunk;
+
+#ifdef __linux__
+  if (zeroCopyEnabled()) {
+    if (tryMap(chunk)) {
+      return chunk;
+    }
+
+    // Nothing queued yet. Wait for readiness so the next attempt can map the
+    // data instead of a blocking recv() copying it.
+    if (zeroCopyEnabled() &&
+        socket_.blocking() == TcpSocket::BlockingType::Blocking) {
+      pollfd entry{socket_.native_handle(), POLLIN, 0};
+      int ready;
+      do {
+        ready = ::poll(&entry, 1, -1);
+      } while (ready < 0 && errno == EINTR);
+
+      if (ready > 0 && tryMap(chunk)) {
+        return chunk;
+      }
+    }
+  }
+#endif
+
+  // End of stream, too little data to map, or no zero-copy support.
+  const std::size_t n = socket_.receive(copy_buffer_);
+  chunk.copied = {copy_buffer_.data(), n};
+  stats_.copied_bytes += n;
+  return chunk;
+}
+
+} // namespace net
@@ -0,0 +1,735 @@
+#include "net/protocol/tcp/traffic_replay.h"
+#include "net/core/event_loop.h"
+#include "net/detail/ip_address.h"
+#include "net/detail/platform_error.h"
+#include "net/protocol/tcp/tcp_socket.h"
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <deque>
+#include <limits>
+#include <map>
+#include <memory>
+#include <optional>
+#include <stdexcept>
+#include <system_error>
+
+#include <sys/socket.h>
+
+namespace net {
+
+namespace {
+
+// ---- Capture decoding ----
+
+constexpr std::uint16_t linktype_ethernet = 1;
+constexpr std::uint16_t linktype_raw = 101;
+constexpr std::uint16_t linktype_linux_sll = 113;
+constexpr std::uint16_t linktype_ipv4 = 228;
+constexpr std::uint16_t linktype_ipv6 = 229;
+constexpr std::uint16_t linktype_linux_sll2 = 276;
+
+constexpr std::uint16_t ethertype_ipv4 = 0x0800;
+constexpr std::uint16_t ethertype_ipv6 = 0x86DD;
+constexpr std::uint16_t ethertype_vlan = 0x8100;
+constexpr std::uint16_t ethertype_qinq = 0x88A8;
+
+constexpr std::uint8_t tcp_fin = 0x01;
+constexpr std::uint8_t tcp_syn = 0x02;
+constexpr std::uint8_t tcp_rst = 0x04;
+constexpr std::uint8_t tcp_ack = 0x10;
+
+std::uint16_t load16(std::span<const std::byte> data, std::size_t at) {
+  return static_cast<std::uint16_t>(
+      (std::to_integer<unsigned>(data[at]) << 8) |
+      std::to_integer<unsigned>(data[at + 1]));
+}
+
+std::uint32_t load32(std::span<const std::byte> data, std::size_t at) {
+  return (static_cast<std::uint32_t>(load16(data, at)) << 16) |
+         load16(data, at + 2);
+}
+
+/// The fields of a TCP segment that reassembly needs.
+struct Segment {
+  bool ipv6 = false;
+  std::array<std::byte, 16> source{};
+  std::array<std::byte, 16> destination{};
+  std::uint16_t source_port = 0;
+  std::uint16_t destination_port = 0;
+  std::uint32_t seq = 0;
+  std::uint8_t flags = 0;
+  std::span<const std::byte> payload;
+};
+
+/// Strip the link layer; empty if the packet is not IP.
+std::span<const std::byte> ipPayload(const PcapngPacket &packet) {
+  std::span<const std::byte> data = packet.data;
+  std::uint16_t ethertype = 0;
+  switch (packet.link_type) {
+  case linktype_raw:
+  case linktype_ipv4:
+  case linktype_ipv6:
+    return data;
+  case linktype_ethernet:
+    if (data.size() < 14) {
+      return {};
+    }
+    ethertype = load16(data, 12);
+    data = data.subspan(14);
+    while ((ethertype == ethertype_vlan || ethertype == ethertype_qinq) &&
+           data.size() >= 4) {
+      ethertype = load16(data, 2);
+      data = data.subspan(4);
+    }
+    break;
+  case linktype_linux_sll:
+    if (data.size() < 16) {
+      return {};
+    }
+    ethertype = load16(data, 14);
+    data = data.subspan(16);
+    break;
+  case linktype_linux_sll2:
+    if (data.size() < 20) {
+      return {};
+    }
+    ethertype = load16(data, 0);
+    data = data.subspan(20);
+    break;
+  default:
+    return {};
+  }
+  if (ethertype != ethertype_ipv4 && ethertype != ethertype_ipv6) {
+    return {};
+  }
+  return data;
+}
+
+std::optional<Segment> decodeTcp(const PcapngPacket &packet) {
+  const std::span<const std::byte> ip = ipPayload(packet);
+  if (ip.empty()) {
+    return std::nullopt;
+  }
+
+  Segment segment;
+  std::span<const std::byte> tcp;
+  const unsigned version = std::to_integer<unsigned>(ip[0]) >> 4;
+  if (version == 4) {
+    const std::size_t header = (std::to_integer<std::size_t>(ip[0]) & 0xF) * 4;
+    if (header < 20 || ip.size() < header ||
+        std::to_integer<unsigned>(ip[9]) != IPPROTO_TCP ||
+        (load16(ip, 6) & 0x3FFF) != 0) { // fragments are not reassembled
+      return std::nullopt;
+    }
+    const std::size_t end = std::min<std::size_t>(load16(ip, 2), ip.size());
+    if (end < header) {
+      return std::nullopt;
+    }
+    std::copy_n(ip.begin() + 12, 4, segment.source.begin());
+    std::copy_n(ip.begin() + 16, 4, segment.destination.begin());
+    tcp = ip.subspan(header, end - header);
+  } else if (version == 6) {
+    // Extension headers are not followed.
+    if (ip.size() < 40 || std::to_integer<unsigned>(ip[6]) != IPPROTO_TCP) {
+      return std::nullopt;
+    }
+    segment.ipv6 = true;
+    const std::size_t end =
+        std::min<std::size_t>(40 + std::size_t{load16(ip, 4)}, ip.size());
+    std::copy_n(ip.begin() + 8, 16, segment.source.begin());
+    std::copy_n(ip.begin() + 24, 16, segment.destination.begin());
+    tcp = ip.subspan(40, end - 40);
+  } else {
+    return std::nullopt;
+  }
+
+  if (tcp.size() < 20) {
+    return std::nullopt;
+  }
+  const std::size_t offset = (std::to_integer<std::size_t>(tcp[12]) >> 4) * 4;
+  if (offset < 20 || offset > tcp.size()) {
+    return std::nullopt;
+  }
+  segment.source_port = load16(tcp, 0);
+  segment.destination_port = load16(tcp, 2);
+  segment.seq = load32(tcp, 4);
+  segment.flags = std::to_integer<std::uint8_t>(tcp[13]);
+  segment.payload = tcp.subspan(offset);
+  return segment;
+}
+
+// ---- Reassembly ----
+
+/// One side of a connection, as a lookup key.
+std::string sideKey(bool ipv6, const std::array<std::byte, 16> &address,
+                    std::uint16_t port) {
+  std::string key(1, ipv6 ? '6' : '4');
+  key.append(reinterpret_cast<const char *>(address.data()), ipv6 ? 16 : 4);
+  key.push_back(static_cast<char>(port >> 8));
+  key.push_back(static_cast<char>(port));
+  return key;
+}
+
+Endpoint makeEndpoint(bool ipv6, const std::array<std::byte, 16> &address,
+                      std::uint16_t port) {
+  return Endpoint(detail::IpAddress(address.data(),
+                                    ipv6 ? detail::IpAddress::Type::IPv6
+                                         : detail::IpAddress::Type::IPv4),
+                  port);
+}
+
+/// Bytes of one direction, delivered in sequence order.
+struct Stream {
+  bool started = false;
+  std::uint32_t base = 0;     ///< Sequence number of stream byte 0
+  std::uint64_t delivered = 0; ///< Stream bytes delivered so far
+  std::map<std::uint64_t, std::vector<std::byte>> pending;
+};
+
+struct Message {
+  std::uint64_t timestamp = 0;
+  int side = 0;
+  std::vector<std::byte> payload;
+};
+
+struct Connection {
+  Endpoint endpoints[2];
+  std::string keys[2];
+  Stream streams[2];
+  std::uint64_t first_timestamp = 0;
+  int client = -1; ///< Side that sent the SYN, if seen
+  bool finished = false;
+  std::vector<Message> messages;
+};
+
+void appendMessage(Connection &connection, int side, std::uint64_t timestamp,
+                   std::span<const std::byte> bytes) {
+  if (bytes.empty()) {
+    return;
+  }
+  auto &messages = connection.messages;
+  // Segments stamped together in one direction come from a single write.
+  if (!messages.empty() && messages.back().side == side &&
+      messages.back().timestamp == timestamp) {
+    messages.back().payload.insert(messages.back().payload.end(),
+                                   bytes.begin(), bytes.end());
+    return;
+  }
+  messages.push_back({timestamp, side, {bytes.begin(), bytes.end()}});
+}
+
+void deliver(Connection &connection, int side, std::uint64_t timestamp,
+             std::uint32_t seq, std::span<const std::byte> payload) {
+  Stream &stream = connection.streams[side];
+  if (!stream.started) {
+    stream.started = true;
+    stream.base = seq;
+  }
+  if (payload.empty()) {
+    return;
+  }
+
+  // Place the segment in the 4 GiB window centred on the delivery point.
+  const auto relative = static_cast<std::uint32_t>(seq - stream.base);
+  const auto delta = static_cast<std::int32_t>(
+      relative - static_cast<std::uint32_t>(stream.delivered));
+  const auto position = static_cast<std::int64_t>(stream.delivered) + delta;
+  if (position < 0) {
+    return; // older than the stream itself
+  }
+  auto start = static_cast<std::uint64_t>(position);
+
+  if (start > stream.delivered) {
+    auto &held = stream.pending[start];
+    if (payload.size() > held.size()) {
+      held.assign(payload.begin(), payload.end());
+    }
+    return;
+  }
+
+  auto consume = [&](std::uint64_t at, std::span<const std::byte> bytes) {
+    if (at + bytes.size() <= stream.delivered) {
+      return; // retransmission
+    }
+    bytes = bytes.subspan(static_cast<std::size_t>(stream.delivered - at));
+    appendMessage(connection, side, timestamp, bytes);
+    stream.delivered += bytes.size();
+  };
+  consume(start, payload);
+
+  while (!stream.pending.empty() &&
+         stream.pending.begin()->first <= stream.delivered) {
+    auto node = stream.pending.extract(stream.pending.begin());
+    consume(node.key(), node.mapped());
+  }
+}
+
+/// Deliver what is still held back behind gaps that never filled.
+void flushPending(Connection &connection, int side) {
+  Stream &stream = connection.streams[side];
+  for (auto &[position, bytes] : stream.pending) {
+    if (position + bytes.size() <= stream.delivered) {
+      continue;
+    }
+    const auto skip = position < stream.delivered
+                          ? static_cast<std::size_t>(stream.delivered - position)
+                          : 0;
+    const std::uint64_t timestamp =
+        connection.messages.empty() ? connection.first_timestamp
+                                    : connection.messages.back().timestamp;
+    appendMessage(connection, side, timestamp,
+                  std::span(bytes).subspan(skip));
+    stream.delivered = position + bytes.size();
+  }
+  stream.pending.clear();
+}
+
+} // namespace
+
+std::uint64_t RecordedSession::bytesFrom(bool client_side) const noexcept {
+  std::uint64_t total = 0;
+  for (const RecordedMessage &message : messages) {
+    if (message.from_client == client_side) {
+      total += message.payload.size();
+    }
+  }
+  return total;
+}
+
+std::vector<RecordedSession> extractTcpSessions(PcapngReader &reader) {
+  std::vector<Connection> connections;
+  std::map<std::string, std::size_t> active; // four-tuple -> connection
+
+  while (auto packet = reader.next()) {
+    const std::optional<Segment> segment = decodeTcp(*packet);
+    if (!segment) {
+      continue;
+    }
+    std::string source =
+        sideKey(segment->ipv6, segment->source, segment->source_port);
+    std::string destination = sideKey(segment->ipv6, segment->destination,
+                                      segment->destination_port);
+    std::string key = std::min(source, destination);
+    key += std::max(source, destination);
+
+    const bool syn = (segment->flags & tcp_syn) != 0;
+    const bool ack = (segment->flags & tcp_ack) != 0;
+
+    auto found = active.find(key);
+    if (found != active.end() && syn && !ack) {
+      // Port reuse: a fresh SYN on a connection that carried data or was
+      // closed begins a new session.
+      const Connection &previous = connections[found->second];
+      if (previous.finished || !previous.messages.empty()) {
+        active.erase(found);
+        found = active.end();
+      }
+    }
+    if (found == active.end()) {
+      Connection connection;
+      connection.endpoints[0] = makeEndpoint(segment->ipv6, segment->source,
+                                             segment->source_port);
+      connection.endpoints[1] = makeEndpoint(
+          segment->ipv6, segment->destination, segment->destination_port);
+      connection.keys[0] = source;
+      connection.keys[1] = destination;
+      connection.first_timestamp = packet->timestamp_ns;
+      connections.push_back(std::move(connection));
+      found = active.emplace(key, connections.size() - 1).first;
+    }
+
+    Connection &connection = connections[found->second];
+    const int side = connection.keys[0] == source ? 0 : 1;
+    std::uint32_t seq = segment->seq;
+    if (syn) {
+      // The SYN occupies one sequence number; data starts after it.
+      seq += 1;
+      if (!ack) {
+        connection.client = side;
+      }
+      Stream &stream = connection.streams[side];
+      if (stream.delivered == 0 && stream.pending.empty()) {
+        stream.started = true;
+        stream.base = seq;
+      }
+    }
+    deliver(connection, side, packet->timestamp_ns, seq, segment->payload);
+    if ((segment->flags & (tcp_fin | tcp_rst)) != 0) {
+      connection.finished = true;
+    }
+  }
+
+  std::vector<RecordedSession> sessions;
+  std::uint64_t earliest = std::numeric_limits<std::uint64_t>::max();
+  for (Connection &connection : connections) {
+    flushPending(connection, 0);
+    flushPending(connection, 1);
+    if (!connection.messages.empty()) {
+      earliest = std::min(earliest, connection.first_timestamp);
+    }
+  }
+
+  for (Connection &connection : connections) {
+    if (connection.messages.empty()) {
+      continue;
+    }
+    const int client = connection.client >= 0 ? connection.client
+                                              : connection.messages[0].side;
+    RecordedSession session;
+    session.client = connection.endpoints[client];
+    session.server = connection.endpoints[1 - client];
+    session.start =
+        std::chrono::nanoseconds(connection.first_timestamp - earliest);
+
+    // Offsets never run backwards, even if the capture's clock did.
+    std::uint64_t last = connection.first_timestamp;
+    for (Message &message : connection.messages) {
+      last = std::max(last, message.timestamp);
+      session.messages.push_back(
+          {std::chrono::nanoseconds(last - connection.first_timestamp),
+           message.side == client, std::move(message.payload)});
+    }
+    sessions.push_back(std::move(session));
+  }
+
+  std::stable_sort(sessions.begin(), sessions.end(),
+                   [](const RecordedSession &a, const RecordedSession &b) {
+                     return a.start < b.start;
+                   });
+  return sessions;
+}
+
+std::vector<RecordedSession> loadTcpSessions(const std::string &path) {
+  PcapngReader reader(path);
+  return extractTcpSessions(reader);
+}
+
+// ---- Replay ----
+
+namespace {
+
+using Clock = EventLoop::Clock;
+
+/// A client write and what must happen before it is sent.
+struct PlannedWrite {
+  std::chrono::nanoseconds offset{0};
+  /// Server bytes the client had received when it wrote this.
+  std::uint64_t after_received = 0;
+  std::span<const std::byte> data;
+  /// First write of a request: server bytes that complete its answer.
+  /// Equal to after_received when the request got no answer.
+  std::optional<std::uint64_t> response_target;
+};
+
+struct Plan {
+  std::chrono::nanoseconds start{0};
+  std::vector<PlannedWrite> writes;
+  std::uint64_t response_bytes = 0;
+};
+
+Plan makePlan(const RecordedSession &session) {
+  Plan plan;
+  plan.start = session.start;
+  bool previous_from_client = false;
+  std::optional<std::size_t> request;
+  for (const RecordedMessage &message : session.messages) {
+    if (message.from_client) {
+      PlannedWrite write;
+      write.offset = message.offset;
+      write.after_received = plan.response_bytes;
+      write.data = message.payload;
+      if (!previous_from_client) {
+        write.response_target = plan.response_bytes;
+        request = plan.writes.size();
+      }
+      plan.writes.push_back(write);
+    } else {
+      plan.response_bytes += message.payload.size();
+      if (request) {
+        plan.writes[*request].response_target = plan.response_bytes;
+      }
+    }
+    previous_from_client = message.from_client;
+  }
+  return plan;
+}
+
+bool wouldBlock(const std::system_error &error) {
+  return detail::is_would_block(error.code().value());
+}
+
+/// State of one run(): every session multiplexed on a private loop.
+class ReplayRun {
+public:
+  ReplayRun(const Endpoint &target, const TrafficReplayer::Options &options,
+            std::span<const RecordedSession> recorded)
+      : target_(target), options_(options), scratch_(64 * 1024) {
+    plans_.reserve(recorded.size());
+    for (const RecordedSession &session : recorded) {
+      plans_.push_back(makePlan(session));
+    }
+    sessions_.resize(plans_.size());
+  }
+
+  TrafficReplayer::Report run() {
+    report_.sessions = plans_.size();
+    const Clock::time_point begin = Clock::now();
+    if (!plans_.empty()) {
+      remaining_ = plans_.size();
+      for (std::size_t i = 0; i < plans_.size(); ++i) {
+        loop_.runAfter(scaled(plans_[i].start), [this, i] { open(i); },
+                       "replay open");
+      }
+      scheduleSweep();
+      loop_.run();
+    }
+    report_.elapsed = Clock::now() - begin;
+    std::sort(report_.latencies.begin(), report_.latencies.end());
+    return std::move(report_);
+  }
+
+private:
+  struct Outstanding {
+    Clock::time_point started;
+    std::uint64_t target = 0;
+  };
+
+  struct Session {
+    TcpSocket socket;
+    Clock::time_point start;
+    Clock::time_point last_progress;
+    std::size_t next_write = 0;
+    std::size_t partial = 0; ///< Bytes of the next write already sent
+    std::uint64_t received = 0;
+    std::deque<Outstanding> outstanding;
+    std::optional<EventLoop::TimerId> timer;
+    bool want_write = true;
+  };
+
+  [[nodiscard]] Clock::duration scaled(std::chrono::nanoseconds d) const {
+    if (options_.speed == 0) {
+      return Clock::duration::zero();
+    }
+    return std::chrono::duration_cast<Clock::duration>(
+        std::chrono::duration<double, std::nano>(
+            static_cast<double>(d.count()) / options_.speed));
+  }
+
+  void open(std::size_t index) {
+    auto session = std::make_unique<Session>();
+    session->socket = TcpSocket(target_.data()->sa_family == AF_INET6
+                                    ? TcpSocket::AddressFamily::IPV6
+                                    : TcpSocket::AddressFamily::IPV4,
+                                TcpSocket::BlockingType::NonBlocking);
+    session->start = session->last_progress = Clock::now();
+    try {
+      session->socket.connect(target_);
+    } catch (const std::system_error &) {
+      ++report_.failed;
+      done();
+      return;
+    }
+    loop_.add(session->socket.native_handle(),
+              EventLoop::Readable | EventLoop::Writable,
+              [this, index](unsigned events) { step(index, events); },
+              "replay session");
+    sessions_[index] = std::move(session);
+    step(index, 0);
+  }
+
+  /// React to readiness (or a timer when events is 0).
+  void step(std::size_t index, unsigned events) {
+    Session *session = sessions_[index].get();
+    if (session == nullptr) {
+      return;
+    }
+    try {
+      if ((events & (EventLoop::Readable | EventLoop::Hangup |
+                     EventLoop::Error)) != 0 &&
+          !readAvailable(*session)) {
+        finish(index, session->next_write == plans_[index].writes.size() &&
+                          session->received >= plans_[index].response_bytes);
+        return;
+      }
+      pump(index, *session);
+    } catch (const std::system_error &) {
+      finish(index, false); // refused or reset
+    }
+  }
+
+  /// Drain the socket; false once the server has closed.
+  bool readAvailable(Session &session) {
+    for (;;) {
+      std::size_t n = 0;
+      try {
+        n = session.socket.receive(scratch_);
+      } catch (const std::system_error &error) {
+        if (wouldBlock(error)) {
+          return true;
+        }
+        throw;
+      }
+      if (n == 0) {
+        return false;
+      }
+      const Clock::time_point now = Clock::now();
+      session.received += n;
+      session.last_progress = now;
+      report_.bytes_received += n;
+      while (!session.outstanding.empty() &&
+             session.received >= session.outstanding.front().target) {
+        report_.latencies.push_back(now - session.outstanding.front().started);
+        session.outstanding.pop_front();
+      }
+    }
+  }
+
+  void pump(std::size_t index, Session &session) {
+    const Plan &plan = plans_[index];
+    bool blocked = false;
+    while (session.next_write < plan.writes.size()) {
+      const PlannedWrite &write = plan.writes[session.next_write];
+      if (session.received < write.after_received) {
+        break; // the client had seen more of the answer at this point
+      }
+      const Clock::time_point now = Clock::now();
+      const Clock::time_point due = session.start + scaled(write.offset);
+      if (now < due) {
+        if (!session.timer) {
+          session.timer = loop_.runAfter(
+              due - now,
+              [this, index] {
+                if (Session *s = sessions_[index].get()) {
+                  s->timer.reset();
+                  s->last_progress = Clock::now();
+                  step(index, 0);
+                }
+              },
+              "replay write");
+        }
+        break;
+      }
+
+      std::size_t n = 0;
+      try {
+        n = session.socket.send(write.data.subspan(session.partial));
+      } catch (const std::system_error &error) {
+        if (!wouldBlock(error)) {
+          throw;
+        }
+      }
+      if (n > 0) {
+        // A request starts with its first byte on the wire; a send that
+        // hit EAGAIN is retried and must not be timed twice.
+        if (session.partial == 0 && write.response_target &&
+            *write.response_target > write.after_received) {
+          session.outstanding.push_back({now, *write.response_target});
+          ++report_.requests;
+        }
+        session.partial += n;
+        session.last_progress = now;
+        report_.bytes_sent += n;
+      }
+      if (session.partial < write.data.size()) {
+        blocked = true;
+        break;
+      }
+      session.partial = 0;
+      ++session.next_write;
+    }
+
+    if (session.next_write == plan.writes.size() &&
+        session.received >= plan.response_bytes) {
+      finish(index, true);
+      return;
+    }
+    if (blocked != session.want_write) {
+      session.want_write = blocked;
+      loop_.modify(session.socket.native_handle(),
+                   EventLoop::Readable | (blocked ? EventLoop::Writable : 0u));
+    }
+  }
+
+  void finish(std::size_t index, bool ok) {
+    std::unique_ptr<Session> session = std::move(sessions_[index]);
+    if (session->timer) {
+      loop_.cancel(*session->timer);
+    }
+    loop_.remove(session->socket.native_handle());
+    if (ok) {
+      ++report_.completed;
+    } else {
+      ++report_.failed;
+    }
+    done();
+  }
+
+  void done() {
+    if (--remaining_ == 0) {
+      loop_.stop();
+    }
+  }
+
+  /// Fail sessions that wait on the server without progress.
+  void scheduleSweep() {
+    const auto interval = std::max<Clock::duration>(
+        options_.idle_timeout / 4, std::chrono::milliseconds(1));
+    loop_.runAfter(
+        interval,
+        [this] {
+          const Clock::time_point now = Clock::now();
+          for (std::size_t i = 0; i < sessions_.size(); ++i) {
+            Session *session = sessions_[i].get();
+            if (session != nullptr && !session->timer &&
+                now - session->last_progress > options_.idle_timeout) {
+              finish(i, false);
+            }
+          }
+          if (remaining_ > 0) {
+            scheduleSweep();
+          }
+        },
+        "replay sweep");
+  }
+
+  Endpoint target_;
+  TrafficReplayer::Options options_;
+  EventLoop loop_;
+  std::vector<Plan> plans_;
+  std::vector<std::unique_ptr<Session>> sessions_;
+  std::size_t remaining_ = 0;
+  std::vector<std::byte> scratch_;
+  TrafficReplayer::Report report_;
+};
+
+} // namespace
+
+std::chrono::nanoseconds
+TrafficReplayer::Report::percentile(double fraction) const noexcept {
+  if (latencies.empty()) {
+    return std::chrono::nanoseconds::zero();
+  }
+  const auto rank = static_cast<std::size_t>(
+      std::ceil(std::clamp(fraction, 0.0, 1.0) *
+                static_cast<double>(latencies.size())));
+  return latencies[std::clamp<std::size_t>(rank, 1, latencies.size()) - 1];
+}
+
+TrafficReplayer::TrafficReplayer(const Endpoint &target, Options options)
+    : target_(target), options_(options) {
+  if (!(options_.speed >= 0) || std::isinf(options_.speed)) {
+    throw std::invalid_argument("replay speed must be finite and >= 0");
+  }
+  if (options_.idle_timeout <= std::chrono::milliseconds::zero()) {
+    throw std::invalid_argument("replay idle timeout must be positive");
+  }
+}
+
+TrafficReplayer::Report
+TrafficReplayer::run(std::span<const RecordedSession> sessions) const {
+  ReplayRun replay(target_, options_, sessions);
+  return replay.run();
+}
+
+} // namespace net
@@ -0,0 +1,79 @@
+#include "net/protocol/udp/datagram_pacer.h"
+#include <algorithm>
+#include <stdexcept>
+#include <system_error>
+#include <thread>
+
+namespace net {
+
+namespace {
+
+// Sleeping is only accurate to roughly a scheduler tick; spin for the tail.
+constexpr std::chrono::microseconds kSpinThreshold{50};
+
+} // namespace
+
+DatagramPacer::DatagramPacer(UdpSocket &socket, std::uint64_t bytes_per_second,
+                             Mode mode)
+    : socket_(socket), rate_(bytes_per_second), mode_(mode) {
+  if (rate_ == 0) {
+    throw std::invalid_argument("DatagramPacer rate must be positive");
+  }
+
+  if (mode_ != Mode::Kernel) {
+    return;
+  }
+  if (!socket_.transmitTimeEnabled()) {
+    try {
+      socket_.enableTransmitTime(TransmitClock::Monotonic);
+    } catch (const std::system_error &) {
+      mode_ = Mode::UserSpace;
+    }
+  } else if (socket_.transmitClock() != TransmitClock::Monotonic) {
+    // Departure times come from steady_clock; stamped against CLOCK_TAI
+    // they would be tens of seconds off. Throws if it cannot be switched.
+    socket_.enableTransmitTime(TransmitClock::Monotonic);
+  }
+}
+
+void DatagramPacer::setRate(std::uint64_t bytes_per_second) {
+  if (bytes_per_second == 0) {
+    throw std::invalid_argument("DatagramPacer rate must be positive");
+  }
+  rate_ = bytes_per_second;
+}
+
+DatagramPacer::Clock::time_point DatagramPacer::reserve(std::size_t bytes) {
+  const auto now = Clock::now();
+  if (next_ < now - burst_) {
+    next_ = now - burst_;
+  }
+
+  const auto departure = std::max(next_, now);
+  next_ += std::chrono::nanoseconds(
+      static_cast<std::int64_t>(bytes * 1'000'000'000ull / rate_));
+  return departure;
+}
+
+std::size_t DatagramPacer::sendTo(std::span<const std::byte> data,
+                                  const Endpoint &destination) {
+  const auto departure = reserve(data.size());
+
+  if (mode_ == Mode::Kernel) {
+    // steady_clock is CLOCK_MONOTONIC on Linux, the clock fq paces against.
+    return socket_.sendAt(
+        data, destination,
+        std::chrono::duration_cast<std::chrono::nanoseconds>(
+            departure.time_since_epoch()));
+  }
+
+  if (departure - Clock::now() > kSpinThreshold) {
+    std::this_thread::sleep_until(departure - kSpinThreshold);
+  }
+  while (Clock::now() < departure) {
+    std::this_thread::yield();
+  }
+  return socket_.sendTo(data, destination);
+}
+
+} // namespace net
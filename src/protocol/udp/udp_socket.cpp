@@ -0,0 +1,434 @@
+#include "net/protocol/udp/udp_socket.h"
+#include "net/detail/platform_error.h"
+#include "net/detail/syscall_helpers.h"
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <system_error>
+
+#ifdef __linux__
+#include <linux/net_tstamp.h>
+#include <time.h>
+#endif
+
+#ifndef _WIN32
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#else
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#endif
+
+namespace net {
+
+namespace {
+
+#ifdef _WIN32
+using io_size_t = int;
+#else
+using io_size_t = std::size_t;
+#endif
+
+void check_family(const detail::IpAddress &address,
+                  detail::SocketFlags::AddressFamily family) {
+  const bool v6 = family == detail::SocketFlags::AddressFamily::IPV6;
+  if ((address.type() == detail::IpAddress::Type::IPv6) != v6) {
+    throw std::invalid_argument(
+        "multicast address family does not match socket family");
+  }
+}
+
+} // namespace
+
+void UdpSocket::setOption(int level, int name, const void *value,
+                          detail::socket_length_t length, const char *what) {
+  if (!is_valid()) {
+    throw std::logic_error(std::string(what) + " on invalid socket");
+  }
+  if (::setsockopt(native_handle(), level, name,
+                   reinterpret_cast<const char *>(value), length) < 0) {
+    throw std::system_error(detail::last_socket_error(),
+                            detail::socket_category(), what);
+  }
+}
+
+void UdpSocket::bind(const Endpoint &ep) {
+  if (!is_valid()) {
+    throw std::logic_error("bind on invalid socket");
+  }
+  if (::bind(native_handle(), ep.data(), ep.size()) < 0) {
+    throw std::system_error(detail::last_socket_error(),
+                            detail::socket_category(), "udp bind failed");
+  }
+}
+
+void UdpSocket::connect(const Endpoint &ep) {
+  if (!is_valid()) {
+    throw std::logic_error("connect on invalid socket");
+  }
+  auto result = detail::retry_if_interrupted(
+      [&] { return ::connect(native_handle(), ep.data(), ep.size()); });
+
+  if (result < 0) {
+    throw std::system_error(detail::last_socket_error(),
+                            detail::socket_category(), "udp connect failed");
+  }
+}
+
+void UdpSocket::setReuseAddress(bool enable) {
+  int opt = enable ? 1 : 0;
+  setOption(SOL_SOCKET, SO_REUSEADDR, &opt, sizeof(opt),
+            "setsockopt(SO_REUSEADDR) failed");
+}
+
+void UdpSocket::setReceiveBufferSize(int bytes) {
+  setOption(SOL_SOCKET, SO_RCVBUF, &bytes, sizeof(bytes),
+            "setsockopt(SO_RCVBUF) failed");
+}
+
+std::size_t UdpSocket::send(std::span<const std::byte> data) {
+  return raw_send(data);
+}
+
+std::size_t UdpSocket::sendTo(std::span<const std::byte> data,
+                              const Endpoint &destination) {
+  auto result = detail::retry_if_interrupted([&] {
+    return ::sendto(native_handle(),
+                    reinterpret_cast<const char *>(data.data()),
+                    static_cast<io_size_t>(data.size()), 0, destination.data(),
+                    destination.size());
+  });
+
+  if (result < 0) {
+    throw std::system_error(detail::last_socket_error(),
+                            detail::socket_category(), "sendto() failed");
+  }
+  return static_cast<std::size_t>(result);
+}
+
+std::size_t UdpSocket::receive(std::span<std::byte> buffer) {
+  return raw_recv(buffer);
+}
+
+std::size_t UdpSocket::receiveFrom(std::span<std::byte> buffer,
+                                   Endpoint &peer) {
+  peer.set_size(sizeof(sockaddr_storage));
+
+  auto result = detail::retry_if_interrupted([&] {
+    return ::recvfrom(native_handle(), reinterpret_cast<char *>(buffer.data()),
+                      static_cast<io_size_t>(buffer.size()), 0, peer.data(),
+                      peer.size_ptr());
+  });
+
+  if (result < 0) {
+    throw std::system_error(detail::last_socket_error(),
+                            detail::socket_category(), "recvfrom() failed");
+  }
+  return static_cast<std::size_t>(result);
+}
+
+std::size_t UdpSocket::receiveBatch(std::span<ReceivedDatagram> datagrams) {
+  if (datagrams.empty()) {
+    return 0;
+  }
+
+#ifdef __linux__
+  // Bounded on-stack batches keep the hot path allocation-free.
+  constexpr std::size_t kChunk = 64;
+  std::array<mmsghdr, kChunk> headers;
+  std::array<iovec, kChunk> vectors;
+
+  std::size_t received = 0;
+  while (received < datagrams.size()) {
+    const std::size_t count = std::min(kChunk, datagrams.size() - received);
+
+    for (std::size_t i = 0; i < count; ++i) {
+      auto &slot = datagrams[received + i];
+      vectors[i].iov_base = slot.buffer.data();
+      vectors[i].iov_len = slot.buffer.size();
+
+      headers[i] = mmsghdr{};
+      headers[i].msg_hdr.msg_name = slot.peer.data();
+      headers[i].msg_hdr.msg_namelen = sizeof(sockaddr_storage);
+      headers[i].msg_hdr.msg_iov = &vectors[i];
+      headers[i].msg_hdr.msg_iovlen = 1;
+    }
+
+    // Only the very first datagram may wait; the rest is opportunistic.
+    const int flags = received == 0 ? MSG_WAITFORONE : MSG_DONTWAIT;
+    int n = detail::retry_if_interrupted([&] {
+      return ::recvmmsg(native_handle(), headers.data(),
+                        static_cast<unsigned>(count), flags, nullptr);
+    });
+
+    if (n < 0) {
+      int err = detail::last_socket_error();
+      if (received > 0 && detail::is_would_block(err)) {
+        break;
+      }
+      throw std::system_error(err, detail::socket_category(),
+                              "recvmmsg() failed");
+    }
+
+    for (int i = 0; i < n; ++i) {
+      auto &slot = datagrams[received + i];
+      slot.size = headers[i].msg_len;
+      slot.truncated = (headers[i].msg_hdr.msg_flags & MSG_TRUNC) != 0;
+      slot.peer.set_size(headers[i].msg_hdr.msg_namelen);
+    }
+
+    received += static_cast<std::size_t>(n);
+    if (static_cast<std::size_t>(n) < count) {
+      break;
+    }
+  }
+  return received;
+#else
+  std::size_t received = 0;
+  for (auto &slot : datagrams) {
+    if (received > 0 && blocking() == BlockingType::Blocking) {
+      break; // cannot probe a blocking socket without waiting
+    }
+    try {
+      slot.size = receiveFrom(slot.buffer, slot.peer);
+      slot.truncated = false;
+    } catch (const std::system_error &e) {
+      if (received > 0 && detail::is_would_block(e.code().value())) {
+        break;
+      }
+      throw;
+    }
+    ++received;
+  }
+  return received;
+#endif
+}
+
+Endpoint UdpSocket::localEndpoint() const {
+  if (!is_valid()) {
+    throw std::logic_error("localEndpoint on invalid socket");
+  }
+
+  Endpoint endpoint;
+  detail::socket_length_t len = sizeof(sockaddr_storage);
+
+  if (::getsockname(native_handle(), endpoint.data(), &len) < 0) {
+    throw std::system_error(detail::last_socket_error(),
+                            detail::socket_category(), "getsockname failed");
+  }
+
+  endpoint.set_size(len);
+  return endpoint;
+}
+
+void UdpSocket::changeMembership(const detail::IpAddress &group,
+                                 const detail::IpAddress *source,
+                                 unsigned interface_index, bool join) {
+  check_family(group, address_family());
+  const bool v6 = group.type() == detail::IpAddress::Type::IPv6;
+  const int level = v6 ? IPPROTO_IPV6 : IPPROTO_IP;
+
+  if (source != nullptr) {
+    check_family(*source, address_family());
+
+    group_source_req request{};
+    request.gsr_interface = interface_index;
+    Endpoint group_ep(group, 0);
+    Endpoint source_ep(*source, 0);
+    std::memcpy(&request.gsr_group, group_ep.data(), group_ep.size());
+    std::memcpy(&request.gsr_source, source_ep.data(), source_ep.size());
+
+    setOption(level, join ? MCAST_JOIN_SOURCE_GROUP : MCAST_LEAVE_SOURCE_GROUP,
+              &request, sizeof(request),
+              join ? "setsockopt(MCAST_JOIN_SOURCE_GROUP) failed"
+                   : "setsockopt(MCAST_LEAVE_SOURCE_GROUP) failed");
+    return;
+  }
+
+  if (v6) {
+    ipv6_mreq request{};
+    std::memcpy(&request.ipv6mr_multiaddr, group.data(), sizeof(in6_addr));
+    request.ipv6mr_interface = interface_index;
+
+    setOption(level, join ? IPV6_JOIN_GROUP : IPV6_LEAVE_GROUP, &request,
+              sizeof(request),
+              join ? "setsockopt(IPV6_JOIN_GROUP) failed"
+                   : "setsockopt(IPV6_LEAVE_GROUP) failed");
+    return;
+  }
+
+#ifdef __linux__
+  ip_mreqn request{};
+  std::memcpy(&request.imr_multiaddr, group.data(), sizeof(in_addr));
+  request.imr_address.s_addr = htonl(INADDR_ANY);
+  request.imr_ifindex = static_cast<int>(interface_index);
+
+  setOption(level, join ? IP_ADD_MEMBERSHIP : IP_DROP_MEMBERSHIP, &request,
+            sizeof(request),
+            join ? "setsockopt(IP_ADD_MEMBERSHIP) failed"
+                 : "setsockopt(IP_DROP_MEMBERSHIP) failed");
+#else
+  // ip_mreq selects the interface by address only; the protocol-independent
+  // request takes an index like the IPv6 variant.
+  group_req request{};
+  request.gr_interface = interface_index;
+  Endpoint group_ep(group, 0);
+  std::memcpy(&request.gr_group, group_ep.data(), group_ep.size());
+
+  setOption(level, join ? MCAST_JOIN_GROUP : MCAST_LEAVE_GROUP, &request,
+            sizeof(request),
+            join ? "setsockopt(MCAST_JOIN_GROUP) failed"
+                 : "setsockopt(MCAST_LEAVE_GROUP) failed");
+#endif
+}
+
+void UdpSocket::joinGroup(const detail::IpAddress &group,
+                          unsigned interface_index) {
+  changeMembership(group, nullptr, interface_index, true);
+}
+
+void UdpSocket::leaveGroup(const detail::IpAddress &group,
+                           unsigned interface_index) {
+  changeMembership(group, nullptr, interface_index, false);
+}
+
+void UdpSocket::joinSourceGroup(const detail::IpAddress &group,
+                                const detail::IpAddress &source,
+                                unsigned interface_index) {
+  changeMembership(group, &source, interface_index, true);
+}
+
+void UdpSocket::leaveSourceGroup(const detail::IpAddress &group,
+                                 const detail::IpAddress &source,
+                                 unsigned interface_index) {
+  changeMembership(group, &source, interface_index, false);
+}
+
+void UdpSocket::setMulticastInterface(unsigned interface_index) {
+  if (address_family() == AddressFamily::IPV6) {
+    setOption(IPPROTO_IPV6, IPV6_MULTICAST_IF, &interface_index,
+              sizeof(interface_index), "setsockopt(IPV6_MULTICAST_IF) failed");
+    return;
+  }
+
+#if defined(__linux__)
+  ip_mreqn request{};
+  request.imr_ifindex = static_cast<int>(interface_index);
+  setOption(IPPROTO_IP, IP_MULTICAST_IF, &request, sizeof(request),
+            "setsockopt(IP_MULTICAST_IF) failed");
+#elif defined(_WIN32)
+  // Winsock interprets an address of the form 0.x.x.x as an interface index.
+  DWORD index = htonl(interface_index);
+  setOption(IPPROTO_IP, IP_MULTICAST_IF, &index, sizeof(index),
+            "setsockopt(IP_MULTICAST_IF) failed");
+#elif defined(IP_MULTICAST_IFINDEX)
+  setOption(IPPROTO_IP, IP_MULTICAST_IFINDEX, &interface_index,
+            sizeof(interface_index), "setsockopt(IP_MULTICAST_IFINDEX) failed");
+#else
+  throw std::system_error(std::make_error_code(std::errc::not_supported),
+                          "IPv4 multicast interface index");
+#endif
+}
+
+void UdpSocket::setMulticastLoopback(bool enable) {
+  if (address_family() == AddressFamily::IPV6) {
+    unsigned int value = enable ? 1 : 0;
+    setOption(IPPROTO_IPV6, IPV6_MULTICAST_LOOP, &value, sizeof(value),
+              "setsockopt(IPV6_MULTICAST_LOOP) failed");
+    return;
+  }
+
+#ifdef _WIN32
+  DWORD value = enable ? 1 : 0;
+#else
+  // BSD stacks insist on a single byte here; Linux accepts either width.
+  unsigned char value = enable ? 1 : 0;
+#endif
+  setOption(IPPROTO_IP, IP_MULTICAST_LOOP, &value, sizeof(value),
+            "setsockopt(IP_MULTICAST_LOOP) failed");
+}
+
+void UdpSocket::setMulticastTtl(int hops) {
+  if (hops < 0 || hops > 255) {
+    throw std::invalid_argument("multicast TTL must be in [0, 255]");
+  }
+
+  if (address_family() == AddressFamily::IPV6) {
+    setOption(IPPROTO_IPV6, IPV6_MULTICAST_HOPS, &hops, sizeof(hops),
+              "setsockopt(IPV6_MULTICAST_HOPS) failed");
+    return;
+  }
+
+#ifdef _WIN32
+  DWORD value = static_cast<DWORD>(hops);
+#else
+  unsigned char value = static_cast<unsigned char>(hops);
+#endif
+  setOption(IPPROTO_IP, IP_MULTICAST_TTL, &value, sizeof(value),
+            "setsockopt(IP_MULTICAST_TTL) failed");
+}
+
+void UdpSocket::enableTransmitTime(TransmitClock clock, bool deadline_mode) {
+#if defined(__linux__) && defined(SO_TXTIME)
+  sock_txtime config{};
+  config.clockid = clock == TransmitClock::Tai ? CLOCK_TAI : CLOCK_MONOTONIC;
+  config.flags = deadline_mode ? SOF_TXTIME_DEADLINE_MODE : 0;
+
+  setOption(SOL_SOCKET, SO_TXTIME, &config, sizeof(config),
+            "setsockopt(SO_TXTIME) failed");
+  txtime_enabled_ = true;
+  txtime_clock_ = clock;
+#else
+  (void)clock;
+  (void)deadline_mode;
+  throw std::system_error(std::make_error_code(std::errc::not_supported),
+                          "SO_TXTIME");
+#endif
+}
+
+std::size_t UdpSocket::sendAt(std::span<const std::byte> data,
+                              const Endpoint &destination,
+                              std::chrono::nanoseconds departure) {
+  if (!txtime_enabled_) {
+    throw std::logic_error("sendAt without enableTransmitTime");
+  }
+
+#if defined(__linux__) && defined(SO_TXTIME)
+  iovec vector{const_cast<std::byte *>(data.data()), data.size()};
+
+  alignas(cmsghdr) std::array<char, CMSG_SPACE(sizeof(std::uint64_t))>
+      control{};
+  msghdr message{};
+  message.msg_name = const_cast<sockaddr *>(destination.data());
+  message.msg_namelen = destination.size();
+  message.msg_iov = &vector;
+  message.msg_iovlen = 1;
+  message.msg_control = control.data();
+  message.msg_controllen = control.size();
+
+  cmsghdr *header = CMSG_FIRSTHDR(&message);
+  header->cmsg_level = SOL_SOCKET;
+  header->cmsg_type = SCM_TXTIME;
+  header->cmsg_len = CMSG_LEN(sizeof(std::uint64_t));
+  const auto stamp = static_cast<std::uint64_t>(departure.count());
+  std::memcpy(CMSG_DATA(header), &stamp, sizeof(stamp));
+
+  auto result = detail::retry_if_interrupted(
+      [&] { return ::sendmsg(native_handle(), &message, MSG_NOSIGNAL); });
+
+  if (result < 0) {
+    throw std::system_error(detail::last_socket_error(),
+                            detail::socket_category(), "sendmsg() failed");
+  }
+  return static_cast<std::size_t>(result);
+#else
+  (void)data;
+  (void)destination;
+  (void)departure;
+  throw std::system_error(std::make_error_code(std::errc::not_supported),
+                          "SO_TXTIME");
+#endif
+}
+
+} // namespace net
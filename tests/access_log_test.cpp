@@ -0,0 +1,156 @@
+#include "catch2/catch_test_macros.hpp"
+
+#ifndef _WIN32
+
+#include "net/core/access_log.h"
+#include "net/core/endpoint.h"
+#include "support/temp_file.h"
+#include <catch2/catch_all.hpp>
+#include <atomic>
+#include <map>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace net;
+using namespace std::chrono_literals;
+
+namespace {
+
+AccessRecord sampleRecord() {
+  AccessRecord record;
+  record.timestamp_ns = 1792315800LL * 1'000'000'000 + 123'456'789;
+  record.peer = Endpoint("10.0.0.1", 51234);
+  record.status = 200;
+  record.duration_us = 1532;
+  record.bytes_in = 120;
+  record.bytes_out = 5120;
+  record.setTarget("/index.html");
+  return record;
+}
+
+} // namespace
+
+TEST_CASE("AccessLogger formats records as one line each", "[access_log]") {
+  char line[AccessLogger::max_line_length];
+  AccessRecord record = sampleRecord();
+
+  std::size_t n = AccessLogger::format(record, line);
+  REQUIRE(std::string(line, n) ==
+          "2026-10-18T09:30:00.123456Z 10.0.0.1:51234 \"/index.html\" 200 "
+          "1532us in=120 out=5120\n");
+
+  // Quotes and control characters are masked; long targets truncated.
+  record.setTarget(std::string("/a\"b\nc") + std::string(100, 'x'));
+  REQUIRE(record.targetView().size() == record.target.size());
+  record.peer = Endpoint();
+  record.timestamp_ns = 0;
+  n = AccessLogger::format(record, line);
+  const std::string text(line, n);
+  REQUIRE(text.starts_with("1970-01-01T00:00:00.000000Z - \"/a?b?c"));
+  REQUIRE(text.find('\n') == text.size() - 1);
+
+  // Pre-epoch timestamps still produce a valid date.
+  record.timestamp_ns = -1'000;
+  n = AccessLogger::format(record, line);
+  REQUIRE(std::string(line, n).starts_with("1969-12-31T23:59:59.999999Z"));
+
+  REQUIRE(AccessLogger::format(sampleRecord(), std::span(line, 20)) == 0);
+  char small[100];
+  REQUIRE(AccessLogger::format(sampleRecord(), small) > 0);
+}
+
+TEST_CASE("AccessLogger rejects invalid options", "[access_log]") {
+  REQUIRE_THROWS_AS(AccessLogger(1, {.ring_capacity = 0}),
+                    std::invalid_argument);
+  REQUIRE_THROWS_AS(AccessLogger(1, {.batch_bytes = 16}),
+                    std::invalid_argument);
+}
+
+TEST_CASE("AccessLogger writes records from many threads in batches",
+          "[access_log]") {
+  test::TempFile file("netlib_access_log");
+  constexpr int kThreads = 4;
+  constexpr int kRecords = 2000;
+  {
+    AccessLogger logger(file.fd(), {.ring_capacity = 4096});
+    std::atomic<int> rejected{0};
+    std::vector<std::thread> workers;
+    for (int t = 0; t < kThreads; ++t) {
+      workers.emplace_back([&logger, &rejected, t] {
+        AccessRecord record = sampleRecord();
+        for (int i = 0; i < kRecords; ++i) {
+          record.setTarget("t" + std::to_string(t) + "/" + std::to_string(i));
+          if (!logger.log(record)) {
+            ++rejected;
+          }
+        }
+        logger.flush();
+      });
+    }
+    for (auto &worker : workers) {
+      worker.join();
+    }
+    REQUIRE(rejected == 0);
+
+    const auto stats = logger.stats();
+    REQUIRE(stats.logged == kThreads * kRecords);
+    REQUIRE(stats.written == kThreads * kRecords);
+    REQUIRE(stats.dropped == 0);
+    // Many records per write() call.
+    REQUIRE(stats.writes < stats.written / 50);
+  }
+
+  // Each thread's records appear in order.
+  std::map<int, int> next;
+  const auto lines = file.lines();
+  REQUIRE(lines.size() == kThreads * kRecords);
+  for (const auto &line : lines) {
+    const auto open = line.find("\"t");
+    const auto slash = line.find('/', open);
+    const int thread = std::stoi(line.substr(open + 2, slash - open - 2));
+    const int index = std::stoi(line.substr(slash + 1));
+    REQUIRE(index == next[thread]++);
+  }
+}
+
+TEST_CASE("AccessLogger drops records when a ring is full",
+          "[access_log]") {
+  test::TempFile file("netlib_access_log");
+  {
+    // The background thread only drains on flush() here.
+    AccessLogger logger(file.fd(),
+                        {.ring_capacity = 4, .flush_interval = 1h});
+    int accepted = 0;
+    for (int i = 0; i < 10; ++i) {
+      accepted += logger.log(sampleRecord()) ? 1 : 0;
+    }
+    REQUIRE(accepted == 4);
+    auto stats = logger.stats();
+    REQUIRE(stats.logged == 4);
+    REQUIRE(stats.dropped == 6);
+
+    logger.flush();
+    REQUIRE(logger.stats().written == 4);
+    REQUIRE(logger.log(sampleRecord()));
+  }
+  // The destructor wrote the last record.
+  REQUIRE(file.lines().size() == 5);
+}
+
+TEST_CASE("AccessLogger stamps records without a timestamp",
+          "[access_log]") {
+  test::TempFile file("netlib_access_log");
+  {
+    AccessLogger logger(file.fd());
+    AccessRecord record = sampleRecord();
+    record.timestamp_ns = 0;
+    logger.log(record);
+  }
+  const auto lines = file.lines();
+  REQUIRE(lines.size() == 1);
+  REQUIRE_FALSE(lines[0].starts_with("1970"));
+}
+
+#endif
@@ -0,0 +1,135 @@
+#include "catch2/catch_test_macros.hpp"
+#include "net/core/endpoint.h"
+#include "net/protocol/tcp/adaptive_receive.h"
+#include "net/protocol/tcp/tcp_socket.h"
+#include "support/loopback_pair.h"
+#include <catch2/catch_all.hpp>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+using namespace net;
+
+TEST_CASE("AdaptiveReceiveSizer validates bounds", "[tcp][adaptive]") {
+  REQUIRE_THROWS_AS(AdaptiveReceiveSizer(0, 64, 128), std::invalid_argument);
+  REQUIRE_THROWS_AS(AdaptiveReceiveSizer(128, 64, 256), std::invalid_argument);
+  REQUIRE_THROWS_AS(AdaptiveReceiveSizer(64, 512, 256), std::invalid_argument);
+}
+
+TEST_CASE("AdaptiveReceiveSizer grows on full reads", "[tcp][adaptive]") {
+  AdaptiveReceiveSizer sizer(64, 1024, 65536);
+  REQUIRE(sizer.nextSize() == 1024);
+
+  sizer.record(1024);
+  REQUIRE(sizer.nextSize() == 16384); // four steps up
+
+  sizer.record(16384);
+  REQUIRE(sizer.nextSize() == 65536); // clamped to maximum
+}
+
+TEST_CASE("AdaptiveReceiveSizer shrinks after two small reads",
+          "[tcp][adaptive]") {
+  AdaptiveReceiveSizer sizer(64, 2048, 65536);
+
+  sizer.record(100);
+  REQUIRE(sizer.nextSize() == 2048); // first small read only arms the cut
+  sizer.record(100);
+  REQUIRE(sizer.nextSize() == 1024);
+
+  for (int i = 0; i < 100; ++i) {
+    sizer.record(1);
+  }
+  REQUIRE(sizer.nextSize() == 64); // never below minimum
+}
+
+TEST_CASE("AdaptiveReceiveSizer uses the queued hint", "[tcp][adaptive]") {
+  AdaptiveReceiveSizer sizer(64, 2048, 65536);
+  REQUIRE(sizer.nextSize(0) == 2048);
+  REQUIRE(sizer.nextSize(10) == 64);
+  REQUIRE(sizer.nextSize(5000) == 5000);
+  REQUIRE(sizer.nextSize(1 << 20) == 65536);
+}
+
+TEST_CASE("TcpSocket availableBytes reports queued data", "[tcp][adaptive]") {
+  test::LoopbackPair pair(TcpSocket::BlockingType::NonBlocking);
+  REQUIRE(pair.server.availableBytes() == 0);
+  pair.sendAll(1000);
+  pair.waitQueued(1000);
+  REQUIRE(pair.server.availableBytes() == 1000);
+}
+
+TEST_CASE("receiveAvailable drains the queue", "[tcp][adaptive]") {
+  test::LoopbackPair pair(TcpSocket::BlockingType::NonBlocking);
+  pair.sendAll(96 * 1024);
+  pair.waitQueued(96 * 1024);
+
+  AdaptiveReceiveSizer sizer(64, 1024, 16 * 1024);
+  ReceiveBuffer out;
+  ReceiveBudget budget{1 << 20, 64};
+
+  auto result = receiveAvailable(pair.server, sizer, out, budget);
+  REQUIRE(result.drained);
+  REQUIRE_FALSE(result.eof);
+  REQUIRE(result.bytes == 96 * 1024);
+  REQUIRE(out.size() == 96 * 1024);
+  // Predictions ramp up quickly, so far fewer reads than 1 KiB each.
+  REQUIRE(result.reads < 10);
+  REQUIRE(sizer.nextSize() > 1024);
+}
+
+TEST_CASE("receiveAvailable stops at the budget", "[tcp][adaptive]") {
+  test::LoopbackPair pair(TcpSocket::BlockingType::NonBlocking);
+  pair.sendAll(100 * 1024);
+  pair.waitQueued(100 * 1024);
+
+  AdaptiveReceiveSizer sizer(64, 2048, 128 * 1024);
+  ReceiveBuffer out;
+
+  auto result = receiveAvailable(pair.server, sizer, out, {10 * 1024, 64});
+  REQUIRE(result.bytes == 10 * 1024);
+  REQUIRE_FALSE(result.drained);
+
+  result = receiveAvailable(pair.server, sizer, out, {1 << 20, 1}, true);
+  REQUIRE(result.reads == 2); // FIONREAD, then one receive
+  REQUIRE(result.bytes == 90 * 1024); // FIONREAD sized the single read
+  REQUIRE(out.size() == 100 * 1024);
+}
+
+TEST_CASE("receiveAvailable stops when FIONREAD reports an empty queue",
+          "[tcp][adaptive]") {
+  test::LoopbackPair pair(TcpSocket::BlockingType::NonBlocking);
+  pair.sendAll(1000);
+  pair.waitQueued(1000);
+
+  AdaptiveReceiveSizer sizer;
+  ReceiveBuffer out;
+  auto result = receiveAvailable(pair.server, sizer, out, {}, true);
+  REQUIRE(result.drained);
+  REQUIRE(result.bytes == 1000);
+  REQUIRE(out.size() == 1000);
+  // FIONREAD sized the receive to fill exactly; the second FIONREAD
+  // replaces the receive that would have reported EAGAIN.
+  REQUIRE(result.reads == 3);
+}
+
+TEST_CASE("receiveAvailable reports would-block and EOF",
+          "[tcp][adaptive]") {
+  test::LoopbackPair pair(TcpSocket::BlockingType::NonBlocking);
+  AdaptiveReceiveSizer sizer;
+  ReceiveBuffer out;
+
+  auto result = receiveAvailable(pair.server, sizer, out);
+  REQUIRE(result.drained);
+  REQUIRE(result.bytes == 0);
+  REQUIRE(result.reads == 1); // the receive that would block
+  REQUIRE(out.empty());
+
+  pair.client.shutdown(TcpSocket::ShutdownType::Sending);
+  std::this_thread::sleep_for(std::chrono::milliseconds(20));
+
+  result = receiveAvailable(pair.server, sizer, out);
+  REQUIRE(result.eof);
+  // FIONREAD reports nothing queued for a FIN; the receive still runs.
+  result = receiveAvailable(pair.server, sizer, out, {}, true);
+  REQUIRE(result.eof);
+}
@@ -0,0 +1,50 @@
+#include "catch2/catch_test_macros.hpp"
+#include "net/core/buffer_pool.h"
+#include <catch2/catch_all.hpp>
+#include <vector>
+
+using namespace net;
+
+TEST_CASE("BufferPool validates its buffer size", "[bufferpool]") {
+  REQUIRE_THROWS_AS(BufferPool(0), std::invalid_argument);
+}
+
+TEST_CASE("BufferPool recycles released buffers", "[bufferpool]") {
+  BufferPool pool(4096, 2);
+  REQUIRE(pool.bufferSize() == 4096);
+  REQUIRE(pool.available() == 2);
+  REQUIRE(pool.allocated() == 2);
+
+  std::byte *first_data = nullptr;
+  {
+    auto first = pool.acquire();
+    REQUIRE(first);
+    REQUIRE(first.data().size() == 4096);
+    first.data()[4095] = std::byte{1};
+    first_data = first.data().data();
+    REQUIRE(pool.available() == 1);
+  }
+  REQUIRE(pool.available() == 2);
+
+  std::vector<BufferPool::Buffer> leases;
+  for (int i = 0; i < 5; ++i) {
+    leases.push_back(pool.acquire());
+  }
+  REQUIRE(pool.allocated() == 5);
+  REQUIRE(pool.available() == 0);
+
+  bool reused = false;
+  for (auto &lease : leases) {
+    reused = reused || lease.data().data() == first_data;
+  }
+  REQUIRE(reused);
+
+  BufferPool::Buffer moved = std::move(leases.front());
+  REQUIRE_FALSE(leases.front());
+  moved.reset();
+  REQUIRE_FALSE(moved);
+  REQUIRE(pool.available() == 1);
+
+  leases.clear();
+  REQUIRE(pool.available() == 5);
+}
@@ -0,0 +1,232 @@
+#include "catch2/catch_test_macros.hpp"
+#include "net/core/endpoint.h"
+#include "net/detail/lz4_block.h"
+#include "net/protocol/tcp/compressed_stream.h"
+#include "net/protocol/tcp/tcp_socket.h"
+#include "support/loopback_pair.h"
+#include <catch2/catch_all.hpp>
+#include <algorithm>
+#include <cstdint>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace net;
+
+namespace {
+
+std::vector<std::byte> text_payload(std::size_t size) {
+  const std::string line = "GET /api/v1/replication/segment HTTP/1.1 seq=";
+  std::vector<std::byte> data;
+  data.reserve(size);
+  for (std::size_t i = 0; data.size() < size; ++i) {
+    auto chunk = line + std::to_string(i) + "\n";
+    for (char c : chunk) {
+      if (data.size() == size) {
+        break;
+      }
+      data.push_back(static_cast<std::byte>(c));
+    }
+  }
+  return data;
+}
+
+std::vector<std::byte> random_payload(std::size_t size) {
+  std::vector<std::byte> data(size);
+  std::uint64_t state = 0x9E3779B97F4A7C15ull;
+  for (auto &b : data) {
+    state ^= state << 13;
+    state ^= state >> 7;
+    state ^= state << 17;
+    b = static_cast<std::byte>(state);
+  }
+  return data;
+}
+
+std::vector<std::byte> transfer(const std::vector<std::byte> &data,
+                                CompressedStream::Options options,
+                                CompressedStream::Stats &sender_stats) {
+  test::LoopbackPair pair;
+  std::vector<std::byte> received;
+
+  std::thread reader([&] {
+    CompressedStream in(pair.server);
+    std::array<std::byte, 3000> buffer{};
+    while (auto n = in.receive(buffer)) {
+      received.insert(received.end(), buffer.begin(), buffer.begin() + n);
+    }
+  });
+
+  CompressedStream out(pair.client, options);
+  // Uneven writes exercise block assembly across calls.
+  std::span<const std::byte> rest(data);
+  for (std::size_t step = 1; !rest.empty(); step = step * 3 + 1) {
+    auto n = std::min(step, rest.size());
+    out.send(rest.first(n));
+    rest = rest.subspan(n);
+  }
+  out.flush();
+  pair.client.shutdown(TcpSocket::ShutdownType::Sending);
+
+  reader.join();
+  sender_stats = out.stats();
+  return received;
+}
+
+} // namespace
+
+TEST_CASE("LZ4 block round-trips", "[lz4]") {
+  detail::Lz4Compressor compressor;
+
+  for (auto data : {text_payload(0), text_payload(7), text_payload(100000),
+                    random_payload(5000), std::vector<std::byte>(70000)}) {
+    for (int acceleration : {1, 8, 64}) {
+      std::vector<std::byte> compressed(
+          detail::Lz4Compressor::bound(data.size()));
+      auto size = compressor.compress(data, compressed, acceleration);
+      REQUIRE(size <= compressed.size());
+
+      std::vector<std::byte> decoded(data.size());
+      REQUIRE(detail::lz4_decompress(std::span(compressed).first(size),
+                                     decoded) == data.size());
+      REQUIRE(decoded == data);
+    }
+  }
+}
+
+TEST_CASE("LZ4 decodes a block from the reference implementation",
+          "[lz4]") {
+  // LZ4_compress_default() output for `expected`: extended literal and
+  // match lengths, a distant match and overlapping matches (offsets 1, 10).
+  const std::vector<std::uint8_t> reference{
+      0xff, 0x1e, 0x54, 0x68, 0x65, 0x20, 0x71, 0x75, 0x69, 0x63, 0x6b, 0x20,
+      0x62, 0x72, 0x6f, 0x77, 0x6e, 0x20, 0x66, 0x6f, 0x78, 0x20, 0x6a, 0x75,
+      0x6d, 0x70, 0x73, 0x20, 0x6f, 0x76, 0x65, 0x72, 0x20, 0x74, 0x68, 0x65,
+      0x20, 0x6c, 0x61, 0x7a, 0x79, 0x20, 0x64, 0x6f, 0x67, 0x2e, 0x20, 0x2d,
+      0x00, 0x47, 0x1f, 0x61, 0x01, 0x00, 0xff, 0x19, 0xa6, 0x30, 0x31, 0x32,
+      0x33, 0x34, 0x35, 0x36, 0x37, 0x38, 0x39, 0x0a, 0x00, 0x50, 0x74, 0x61,
+      0x69, 0x6c, 0x21};
+  std::string expected;
+  for (int i = 0; i < 3; ++i) {
+    expected += "The quick brown fox jumps over the lazy dog. ";
+  }
+  expected += std::string(300, 'a') + "01234567890123456789" + "tail!";
+
+  std::vector<std::byte> decoded(expected.size());
+  REQUIRE(detail::lz4_decompress(std::as_bytes(std::span(reference)),
+                                 decoded) == expected.size());
+  REQUIRE(std::equal(decoded.begin(), decoded.end(), expected.begin(),
+                     [](std::byte b, char c) {
+                       return b == static_cast<std::byte>(c);
+                     }));
+}
+
+TEST_CASE("LZ4 shrinks repetitive data", "[lz4]") {
+  detail::Lz4Compressor compressor;
+  auto data = text_payload(64 * 1024);
+  std::vector<std::byte> compressed(detail::Lz4Compressor::bound(data.size()));
+  REQUIRE(compressor.compress(data, compressed) < data.size() / 3);
+}
+
+TEST_CASE("LZ4 rejects malformed blocks", "[lz4]") {
+  std::vector<std::byte> out(16);
+
+  // Match offset pointing before the start of the output.
+  std::vector<std::byte> bad_offset{std::byte{0x10}, std::byte{'a'},
+                                    std::byte{0x05}, std::byte{0x00},
+                                    std::byte{0x00}};
+  REQUIRE_THROWS_AS(detail::lz4_decompress(bad_offset, out),
+                    std::runtime_error);
+
+  // Literal run longer than the input.
+  std::vector<std::byte> truncated{std::byte{0x50}, std::byte{'a'}};
+  REQUIRE_THROWS_AS(detail::lz4_decompress(truncated, out),
+                    std::runtime_error);
+
+  // Output too small.
+  std::vector<std::byte> tiny(2);
+  std::vector<std::byte> literals{std::byte{0x30}, std::byte{'a'},
+                                  std::byte{'b'}, std::byte{'c'}};
+  REQUIRE_THROWS_AS(detail::lz4_decompress(literals, tiny),
+                    std::runtime_error);
+
+  std::vector<std::byte> compressed(8);
+  detail::Lz4Compressor compressor;
+  REQUIRE_THROWS_AS(compressor.compress(text_payload(100), compressed),
+                    std::length_error);
+}
+
+TEST_CASE("CompressedStream validates options", "[compress]") {
+  TcpSocket socket;
+  CompressedStream::Options options;
+  options.block_size = 0;
+  REQUIRE_THROWS_AS(CompressedStream(socket, options), std::invalid_argument);
+
+  options = {};
+  options.level = CompressedStream::kLevels;
+  REQUIRE_THROWS_AS(CompressedStream(socket, options), std::invalid_argument);
+}
+
+TEST_CASE("CompressedStream compresses text over TCP", "[compress]") {
+  auto data = text_payload(1 << 20);
+  CompressedStream::Options options;
+  options.adaptive = false;
+
+  CompressedStream::Stats stats;
+  auto received = transfer(data, options, stats);
+
+  REQUIRE(received == data);
+  REQUIRE(stats.raw_bytes_sent == data.size());
+  REQUIRE(stats.wire_bytes_sent < data.size() / 3);
+  REQUIRE(stats.stored_blocks_sent == 0);
+  REQUIRE(stats.level == 0);
+}
+
+TEST_CASE("CompressedStream stores incompressible blocks", "[compress]") {
+  auto data = random_payload(300000);
+  CompressedStream::Stats stats;
+  auto received = transfer(data, {}, stats);
+
+  REQUIRE(received == data);
+  REQUIRE(stats.stored_blocks_sent == stats.blocks_sent);
+  // Only frame headers are added.
+  REQUIRE(stats.wire_bytes_sent == data.size() + 9 * stats.blocks_sent);
+}
+
+TEST_CASE("CompressedStream adaptive mode measures the link", "[compress]") {
+  auto data = text_payload(4 << 20);
+  CompressedStream::Options options;
+  options.block_size = 16 * 1024;
+
+  CompressedStream::Stats stats;
+  auto received = transfer(data, options, stats);
+
+  REQUIRE(received == data);
+  REQUIRE(stats.link_bytes_per_second > 0.0);
+  REQUIRE(stats.level < CompressedStream::kLevels);
+  REQUIRE(stats.wire_bytes_sent < stats.raw_bytes_sent);
+}
+
+TEST_CASE("CompressedStream sends buffer chains", "[compress]") {
+  test::LoopbackPair pair;
+  auto head = text_payload(100);
+  auto body = random_payload(5000);
+
+  CompressedStream out(pair.client);
+  std::array<std::span<const std::byte>, 2> chain{std::span(head),
+                                                  std::span(body)};
+  out.send(chain);
+  out.flush();
+
+  CompressedStream in(pair.server);
+  std::vector<std::byte> received(head.size() + body.size());
+  std::size_t total = 0;
+  while (total < received.size()) {
+    auto n = in.receive(std::span(received).subspan(total));
+    REQUIRE(n > 0);
+    total += n;
+  }
+
+  REQUIRE(std::equal(head.begin(), head.end(), received.begin()));
+  REQUIRE(std::equal(body.begin(), body.end(), received.begin() + 100));
+}
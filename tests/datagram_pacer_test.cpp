@@ -0,0 +1,92 @@
+#include "catch2/catch_test_macros.hpp"
+#include "net/core/endpoint.h"
+#include "net/protocol/udp/datagram_pacer.h"
+#include "net/protocol/udp/udp_socket.h"
+#include <array>
+#include <catch2/catch_all.hpp>
+#include <chrono>
+
+using namespace net;
+
+TEST_CASE("DatagramPacer rejects a zero rate", "[udp][pacer]") {
+  UdpSocket socket;
+  REQUIRE_THROWS_AS(DatagramPacer(socket, 0), std::invalid_argument);
+
+  DatagramPacer pacer(socket, 1000, DatagramPacer::Mode::UserSpace);
+  REQUIRE_THROWS_AS(pacer.setRate(0), std::invalid_argument);
+}
+
+TEST_CASE("DatagramPacer user-space mode spreads a burst", "[udp][pacer]") {
+  UdpSocket receiver;
+  receiver.bind(Endpoint("127.0.0.1", 0));
+  Endpoint bound = receiver.localEndpoint();
+
+  UdpSocket sender;
+  // 10 x 1000 bytes at 100 kB/s: the last datagram leaves ~90 ms after the
+  // first one.
+  DatagramPacer pacer(sender, 100'000, DatagramPacer::Mode::UserSpace);
+  REQUIRE(pacer.mode() == DatagramPacer::Mode::UserSpace);
+
+  std::array<std::byte, 1000> payload{};
+  const auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < 10; ++i) {
+    REQUIRE(pacer.sendTo(payload, bound) == payload.size());
+  }
+  const auto elapsed = std::chrono::steady_clock::now() - start;
+  REQUIRE(elapsed >= std::chrono::milliseconds(85));
+
+  std::array<std::byte, 1500> buffer{};
+  for (int i = 0; i < 10; ++i) {
+    Endpoint peer;
+    REQUIRE(receiver.receiveFrom(buffer, peer) == payload.size());
+  }
+}
+
+TEST_CASE("DatagramPacer kernel mode stamps departure times", "[udp][pacer]") {
+  UdpSocket receiver;
+  receiver.bind(Endpoint("127.0.0.1", 0));
+  Endpoint bound = receiver.localEndpoint();
+
+  UdpSocket sender;
+  DatagramPacer pacer(sender, 1'000'000, DatagramPacer::Mode::Kernel);
+
+#ifdef __linux__
+  REQUIRE(pacer.mode() == DatagramPacer::Mode::Kernel);
+  REQUIRE(sender.transmitTimeEnabled());
+#endif
+
+  // Kernel mode never blocks the caller; loopback has no pacing qdisc, so
+  // the datagrams are delivered right away.
+  std::array<std::byte, 100> payload{};
+  for (int i = 0; i < 5; ++i) {
+    REQUIRE(pacer.sendTo(payload, bound) == payload.size());
+  }
+
+  std::array<std::byte, 1500> buffer{};
+  for (int i = 0; i < 5; ++i) {
+    Endpoint peer;
+    REQUIRE(receiver.receiveFrom(buffer, peer) == payload.size());
+  }
+}
+
+TEST_CASE("DatagramPacer switches a TAI socket to the monotonic clock",
+          "[udp][pacer]") {
+  UdpSocket sender;
+#ifdef __linux__
+  sender.enableTransmitTime(TransmitClock::Tai);
+  REQUIRE(sender.transmitClock() == TransmitClock::Tai);
+
+  DatagramPacer pacer(sender, 1'000'000, DatagramPacer::Mode::Kernel);
+  REQUIRE(pacer.mode() == DatagramPacer::Mode::Kernel);
+  REQUIRE(sender.transmitTimeEnabled());
+  REQUIRE(sender.transmitClock() == TransmitClock::Monotonic);
+#endif
+}
+
+TEST_CASE("UdpSocket sendAt requires transmit times", "[udp][pacer]") {
+  UdpSocket socket;
+  std::array<std::byte, 1> payload{};
+  REQUIRE_THROWS_AS(socket.sendAt(payload, Endpoint("127.0.0.1", 9),
+                                  std::chrono::nanoseconds(0)),
+                    std::logic_error);
+}
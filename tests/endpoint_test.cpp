@@ -32,3 +32,40 @@ TEST_CASE("Endpoint to_string", "[endpoint]") {
   REQUIRE(s.find("127.0.0.1") != std::string::npos);
   REQUIRE(s.find("8080") != std::string::npos);
 }
+
+TEST_CASE("Endpoint format_to writes without allocating", "[endpoint]") {
+  char buffer[Endpoint::max_string_length];
+
+  Endpoint v4("192.168.10.255", 65535);
+  std::size_t n = v4.format_to(buffer);
+  REQUIRE(std::string(buffer, n) == "192.168.10.255:65535");
+  REQUIRE(std::string(buffer, n) == v4.to_string());
+
+  Endpoint v6("2001:db8:ffff:ffff:ffff:ffff:ffff:ffff", 443);
+  n = v6.format_to(buffer);
+  REQUIRE(std::string(buffer, n) ==
+          "[2001:db8:ffff:ffff:ffff:ffff:ffff:ffff]:443");
+  REQUIRE(std::string(buffer, n) == v6.to_string());
+
+  Endpoint zeros("0.0.0.0", 0);
+  n = zeros.format_to(buffer);
+  REQUIRE(std::string(buffer, n) == "0.0.0.0:0");
+
+  // Too small: nothing usable is reported.
+  REQUIRE(v4.format_to(std::span(buffer, 10)) == 0);
+  REQUIRE(v6.format_to(std::span(buffer, 41)) == 0);
+}
+
+TEST_CASE("Endpoint equality and hashing", "[endpoint]") {
+  Endpoint a("10.0.0.1", 80);
+  Endpoint b(detail::IpAddress("10.0.0.1"), 80);
+  REQUIRE(a == b);
+  REQUIRE(a.hash() == b.hash());
+  REQUIRE(std::hash<Endpoint>{}(a) == a.hash());
+
+  REQUIRE_FALSE(a == Endpoint("10.0.0.1", 81));
+  REQUIRE_FALSE(a == Endpoint("10.0.0.2", 80));
+  REQUIRE_FALSE(Endpoint("::1", 80) == Endpoint("127.0.0.1", 80));
+  REQUIRE(Endpoint("2001:db8::1", 443) == Endpoint("2001:db8::1", 443));
+  REQUIRE_FALSE(Endpoint("2001:db8::1", 443) == Endpoint("2001:db8::2", 443));
+}
@@ -0,0 +1,199 @@
+#include "catch2/catch_test_macros.hpp"
+#include "net/core/epoch.h"
+#include <catch2/catch_all.hpp>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <future>
+#include <memory>
+#include <thread>
+#include <vector>
+
+using namespace net;
+using namespace std::chrono_literals;
+
+namespace {
+
+/// Counts live instances and poisons itself on destruction, so a reader
+/// touching a freed node is caught.
+struct Node {
+  static inline std::atomic<int> alive{0};
+  static constexpr std::uint64_t live_mark = 0x6c697665;
+
+  explicit Node(std::uint64_t v) : value(v) { alive.fetch_add(1); }
+  ~Node() {
+    mark = 0;
+    alive.fetch_sub(1);
+  }
+
+  std::uint64_t value;
+  std::uint64_t mark = live_mark;
+};
+
+} // namespace
+
+TEST_CASE("EpochDomain defers reclamation while pinned", "[epoch]") {
+  const int baseline = Node::alive.load();
+  EpochDomain domain;
+  auto *first = new Node(1);
+
+  {
+    auto guard = domain.pin();
+    {
+      auto nested = domain.pin(); // nesting keeps the outer epoch
+    }
+    domain.retire(first);
+    REQUIRE(domain.pending() == 1);
+    REQUIRE(domain.reclaim() == 0);
+    REQUIRE(first->mark == Node::live_mark);
+  }
+  REQUIRE(domain.reclaim() == 1);
+  REQUIRE(domain.pending() == 0);
+  REQUIRE(Node::alive.load() == baseline);
+
+  // Unpinned: freed by retire() itself.
+  domain.retire(new Node(2));
+  REQUIRE(domain.pending() == 0);
+
+  // The destructor frees what is left.
+  {
+    EpochDomain scoped;
+    auto guard = scoped.pin();
+    scoped.retire(new Node(3));
+    guard.release();
+    REQUIRE(scoped.pending() == 1);
+  }
+  REQUIRE(Node::alive.load() == baseline);
+}
+
+TEST_CASE("EpochDomain only waits for readers that may hold an object",
+          "[epoch]") {
+  EpochDomain domain;
+  auto guard = domain.pin();
+  domain.retire(new Node(1)); // retired while we are pinned
+
+  // A reader entering after the retirement does not hold the object, but
+  // ours still does.
+  const std::size_t freed = std::async(std::launch::async, [&] {
+                              auto late = domain.pin();
+                              return domain.reclaim();
+                            }).get();
+  REQUIRE(freed == 0);
+
+  guard.release();
+  REQUIRE(domain.reclaim() == 1);
+}
+
+TEST_CASE("EpochDomain synchronize waits for other readers", "[epoch]") {
+  EpochDomain domain;
+  std::promise<void> pinned;
+  std::promise<void> finish;
+  std::atomic<bool> released{false};
+
+  std::thread reader([&] {
+    auto guard = domain.pin();
+    pinned.set_value();
+    finish.get_future().wait();
+    released = true;
+  });
+  pinned.get_future().wait();
+
+  domain.retire(new Node(1));
+  REQUIRE(domain.pending() == 1);
+
+  auto sync = std::async(std::launch::async, [&] { domain.synchronize(); });
+  REQUIRE(sync.wait_for(50ms) == std::future_status::timeout);
+  finish.set_value();
+  sync.get();
+  REQUIRE(released);
+  REQUIRE(domain.pending() == 0);
+  reader.join();
+}
+
+TEST_CASE("EpochDomain supports quiescent-state readers", "[epoch]") {
+  EpochDomain domain;
+  domain.quiescent(); // no-op for a thread that is not online
+  domain.online();
+
+  auto *node = new Node(1);
+  std::async(std::launch::async, [&] { domain.retire(node); }).get();
+  REQUIRE(domain.pending() == 1);
+
+  // Guards inside an online thread do not move its epoch.
+  {
+    auto guard = domain.pin();
+    domain.quiescent(); // ignored inside a guard
+  }
+  REQUIRE(domain.reclaim() == 0);
+  REQUIRE(node->mark == Node::live_mark);
+
+  domain.quiescent();
+  REQUIRE(domain.reclaim() == 1);
+
+  std::async(std::launch::async, [&] { domain.retire(new Node(2)); }).get();
+  REQUIRE(domain.pending() == 1);
+  domain.offline();
+  REQUIRE(domain.reclaim() == 1);
+}
+
+TEST_CASE("EpochDomain recycles slots of exited threads", "[epoch]") {
+  EpochDomain domain;
+  for (int i = 0; i < 4; ++i) {
+    // Each thread exits while pinned-then-released; its slot must not
+    // block reclamation afterwards.
+    std::thread([&] { auto guard = domain.pin(); }).join();
+  }
+  domain.retire(new Node(1));
+  REQUIRE(domain.pending() == 0);
+}
+
+TEST_CASE("EpochCell readers never see freed values", "[epoch]") {
+  const int baseline = Node::alive.load();
+  {
+    EpochDomain domain;
+    EpochCell<Node> cell(domain, std::make_unique<const Node>(0));
+    std::atomic<bool> done{false};
+    std::atomic<int> failures{0};
+
+    std::vector<std::thread> readers;
+    for (int i = 0; i < 3; ++i) {
+      readers.emplace_back([&] {
+        std::uint64_t last = 0;
+        while (!done.load(std::memory_order_relaxed)) {
+          auto value = cell.read();
+          if (value->mark != Node::live_mark || value->value < last) {
+            failures.fetch_add(1);
+          }
+          last = value->value;
+        }
+      });
+    }
+    // One quiescent-state reader.
+    readers.emplace_back([&] {
+      domain.online();
+      std::uint64_t last = 0;
+      while (!done.load(std::memory_order_relaxed)) {
+        const Node *value = cell.load();
+        if (value->mark != Node::live_mark || value->value < last) {
+          failures.fetch_add(1);
+        }
+        last = value->value;
+        domain.quiescent();
+      }
+      domain.offline();
+    });
+
+    for (std::uint64_t v = 1; v <= 5000; ++v) {
+      cell.publish(std::make_unique<const Node>(v));
+    }
+    done = true;
+    for (auto &reader : readers) {
+      reader.join();
+    }
+    REQUIRE(failures.load() == 0);
+    REQUIRE(cell.read()->value == 5000);
+    domain.synchronize();
+    REQUIRE(domain.pending() == 0);
+  }
+  REQUIRE(Node::alive.load() == baseline);
+}
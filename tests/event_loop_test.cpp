@@ -0,0 +1,438 @@
+#include "catch2/catch_test_macros.hpp"
+
+#ifndef _WIN32
+
+#include "net/core/endpoint.h"
+#include "net/core/event_loop.h"
+#include "net/protocol/tcp/adaptive_receive.h"
+#include "net/protocol/tcp/tcp_socket.h"
+#include "support/loopback_pair.h"
+#include <catch2/catch_all.hpp>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <future>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace net;
+using namespace std::chrono_literals;
+
+namespace {
+
+EventLoop::Options backendOptions(bool force_poll) {
+  EventLoop::Options options;
+  options.force_poll = force_poll;
+  return options;
+}
+
+} // namespace
+
+TEST_CASE("EventLoop validates registrations", "[eventloop]") {
+  EventLoop loop;
+  test::LoopbackPair pair(TcpSocket::BlockingType::NonBlocking);
+  const auto fd = pair.server.native_handle();
+
+  REQUIRE_THROWS_AS(loop.add(fd, EventLoop::Readable, {}),
+                    std::invalid_argument);
+  loop.add(fd, EventLoop::Readable, [](unsigned) {});
+  REQUIRE(loop.contains(fd));
+  REQUIRE_THROWS_AS(loop.add(fd, EventLoop::Readable, [](unsigned) {}),
+                    std::invalid_argument);
+  REQUIRE_THROWS_AS(loop.modify(fd + 1000, EventLoop::Writable),
+                    std::invalid_argument);
+
+  loop.remove(fd);
+  REQUIRE_FALSE(loop.contains(fd));
+  loop.remove(fd); // ignored
+}
+
+TEST_CASE("EventLoop dispatches readiness", "[eventloop]") {
+  const bool force_poll = GENERATE(false, true);
+  EventLoop loop(backendOptions(force_poll));
+#ifdef __linux__
+  REQUIRE(loop.backend() == (force_poll ? "poll" : "epoll"));
+#endif
+  test::LoopbackPair pair(TcpSocket::BlockingType::NonBlocking);
+
+  std::vector<unsigned> seen;
+  loop.add(pair.server.native_handle(), EventLoop::Readable,
+           [&](unsigned events) {
+             seen.push_back(events);
+             if (events & EventLoop::Readable) {
+               std::byte buffer[64];
+               (void)pair.server.receive(buffer);
+             }
+           },
+           "reader");
+
+  REQUIRE(loop.runOnce(0ms) == 0);
+
+  const std::byte data[4] = {};
+  REQUIRE(pair.client.send(data) == 4);
+  REQUIRE(loop.runOnce(1000ms) == 1);
+  REQUIRE(seen.size() == 1);
+  REQUIRE((seen[0] & EventLoop::Readable) != 0);
+
+  loop.modify(pair.server.native_handle(),
+              EventLoop::Readable | EventLoop::Writable);
+  REQUIRE(loop.runOnce(1000ms) == 1);
+  REQUIRE((seen[1] & EventLoop::Writable) != 0);
+}
+
+TEST_CASE("EventLoop handlers may remove themselves", "[eventloop]") {
+  EventLoop loop;
+  test::LoopbackPair pair(TcpSocket::BlockingType::NonBlocking);
+  const auto fd = pair.server.native_handle();
+  int calls = 0;
+  loop.add(fd, EventLoop::Writable, [&](unsigned) {
+    ++calls;
+    loop.remove(fd);
+  });
+  loop.runOnce(1000ms);
+  loop.runOnce(0ms);
+  REQUIRE(calls == 1);
+}
+
+TEST_CASE("EventLoop timers fire in order and can be cancelled",
+          "[eventloop]") {
+  EventLoop loop;
+  std::vector<int> order;
+  loop.runAfter(20ms, [&] { order.push_back(2); });
+  loop.runAfter(5ms, [&] { order.push_back(1); });
+  const auto cancelled = loop.runAfter(10ms, [&] { order.push_back(99); });
+  REQUIRE(loop.cancel(cancelled));
+  REQUIRE_FALSE(loop.cancel(cancelled));
+
+  const auto start = EventLoop::Clock::now();
+  while (order.size() < 2) {
+    loop.runOnce(-1ms);
+  }
+  REQUIRE(order == std::vector<int>{1, 2});
+  REQUIRE(EventLoop::Clock::now() - start >= 20ms);
+
+  const auto &stats = loop.stats();
+  REQUIRE(stats.lag_samples == 2);
+  REQUIRE(stats.lag_max >= stats.lag_last);
+  REQUIRE(stats.lagMean() <= stats.lag_max);
+  REQUIRE(stats.total.wait > 0ns);
+}
+
+TEST_CASE("EventLoop reports timer lag behind a slow callback",
+          "[eventloop]") {
+  EventLoop::Options options;
+  options.stall_threshold = 0ns;
+  EventLoop loop(options);
+
+  loop.runAfter(0ms, [] { std::this_thread::sleep_for(30ms); });
+  loop.runAfter(1ms, [] {});
+  while (loop.stats().lag_samples < 2) {
+    loop.runOnce(-1ms);
+  }
+  REQUIRE(loop.stats().lag_max >= 25ms);
+  REQUIRE(loop.stats().stalls == 0);
+}
+
+TEST_CASE("EventLoop post and stop work across threads", "[eventloop]") {
+  EventLoop loop;
+  std::atomic<int> ran{0};
+
+  std::thread runner([&] { loop.run(); });
+  for (int i = 0; i < 100; ++i) {
+    loop.post([&] {
+      REQUIRE(loop.isInLoopThread());
+      ++ran;
+    });
+  }
+  while (ran.load() < 100) {
+    std::this_thread::sleep_for(1ms);
+  }
+  loop.stop();
+  runner.join();
+  REQUIRE(ran.load() == 100);
+  REQUIRE_FALSE(loop.isInLoopThread());
+}
+
+TEST_CASE("EventLoop attributes phases and names stalling callbacks",
+          "[eventloop]") {
+  EventLoop::Options options;
+  options.stall_threshold = 10ms;
+  EventLoop loop(options);
+
+  std::vector<std::string> culprits;
+  std::chrono::nanoseconds culprit_time{};
+  loop.setStallHandler([&](const EventLoop::StallReport &report) {
+    culprits.emplace_back(report.culprit);
+    culprit_time = report.culprit_time;
+    REQUIRE(report.phases.callbacks >= report.culprit_time);
+  });
+
+  loop.post([] {}, "quick");
+  loop.post([] { std::this_thread::sleep_for(20ms); }, "slow-handler");
+  REQUIRE(loop.runOnce(0ms) == 2);
+
+  REQUIRE(loop.stats().stalls == 1);
+  REQUIRE(culprits == std::vector<std::string>{"slow-handler"});
+  REQUIRE(culprit_time >= 20ms);
+  REQUIRE(loop.stats().last.callbacks >= 20ms);
+  REQUIRE(loop.stats().last.dispatch < 10ms);
+
+  loop.runAfter(0ms, [] {});
+  loop.runOnce(-1ms);
+  REQUIRE(loop.stats().stalls == 1);
+  REQUIRE(loop.stats().iterations == 2);
+
+  loop.resetStats();
+  REQUIRE(loop.stats().iterations == 0);
+}
+
+TEST_CASE("IoBudget charges saturate at zero", "[eventloop]") {
+  EventLoop::IoBudget budget{100, 50, 2, 1};
+  budget.chargeRead(60);
+  REQUIRE(budget.canRead());
+  budget.chargeRead(60);
+  REQUIRE(budget.read_bytes == 0);
+  REQUIRE_FALSE(budget.canRead());
+
+  budget.chargeWrite(10);
+  REQUIRE(budget.write_ops == 0);
+  REQUIRE_FALSE(budget.canWrite());
+}
+
+TEST_CASE("EventLoop requeues connections that exhaust their budget",
+          "[eventloop]") {
+  const bool force_poll = GENERATE(false, true);
+  EventLoop::Options options = backendOptions(force_poll);
+  options.io_budget = {16 * 1024, 64 * 1024, 4, 16};
+  EventLoop loop(options);
+
+  test::LoopbackPair hot(TcpSocket::BlockingType::NonBlocking);
+  test::LoopbackPair quiet(TcpSocket::BlockingType::NonBlocking);
+  constexpr std::size_t kHotBytes = 96 * 1024;
+
+  std::vector<std::byte> payload(kHotBytes, std::byte{1});
+  for (std::span<const std::byte> rest(payload); !rest.empty();) {
+    rest = rest.subspan(hot.client.send(rest));
+  }
+  const std::byte hello[10] = {};
+  REQUIRE(quiet.client.send(hello) == sizeof(hello));
+  while (hot.server.availableBytes() < kHotBytes ||
+         quiet.server.availableBytes() < sizeof(hello)) {
+    std::this_thread::sleep_for(1ms);
+  }
+
+  struct Conn {
+    TcpSocket *socket;
+    AdaptiveReceiveSizer sizer;
+    ReceiveBuffer data;
+    int calls = 0;
+  };
+  Conn hot_conn{&hot.server, AdaptiveReceiveSizer(64, 4096, 65536), {}, 0};
+  Conn quiet_conn{&quiet.server, AdaptiveReceiveSizer(), {}, 0};
+
+  auto reader = [](Conn &conn) {
+    return [&conn](unsigned, EventLoop::IoBudget &budget) {
+      ++conn.calls;
+      auto result = receiveAvailable(*conn.socket, conn.sizer, conn.data,
+                                     {budget.read_bytes, budget.read_ops});
+      budget.chargeRead(result.bytes, result.reads);
+      return result.drained || result.eof ? EventLoop::IoStatus::Done
+                                          : EventLoop::IoStatus::Pending;
+    };
+  };
+  const unsigned interest = EventLoop::Readable | EventLoop::EdgeTriggered;
+  loop.addBudgeted(hot.server.native_handle(), interest, reader(hot_conn),
+                   "hot");
+  loop.addBudgeted(quiet.server.native_handle(), interest,
+                   reader(quiet_conn), "quiet");
+
+  loop.runOnce(1000ms);
+  REQUIRE(quiet_conn.data.size() == sizeof(hello));
+  REQUIRE(hot_conn.data.size() <= 16 * 1024);
+  REQUIRE(loop.stats().requeued == 1);
+
+  // Without new readiness events the hot connection keeps being served
+  // from the ready list until it is drained.
+  for (int i = 0; i < 100 && hot_conn.data.size() < kHotBytes; ++i) {
+    loop.runOnce(0ms);
+  }
+  REQUIRE(hot_conn.data.size() == kHotBytes);
+  REQUIRE(hot_conn.calls >= static_cast<int>(kHotBytes / (16 * 1024)));
+  REQUIRE(quiet_conn.calls == 1);
+
+  // A connection removed while requeued is not called again.
+  REQUIRE(hot.client.send(hello) == sizeof(hello));
+  while (hot.server.availableBytes() < sizeof(hello)) {
+    std::this_thread::sleep_for(1ms);
+  }
+  const int calls = hot_conn.calls;
+  loop.remove(hot.server.native_handle());
+  loop.runOnce(0ms);
+  REQUIRE(hot_conn.calls == calls);
+}
+
+TEST_CASE("EventLoop keeps unserved work when a handler throws",
+          "[eventloop]") {
+  EventLoop loop;
+
+  std::vector<int> ran;
+  loop.post([&] { ran.push_back(1); });
+  loop.post([] { throw std::runtime_error("posted"); });
+  loop.post([&] { ran.push_back(3); });
+  REQUIRE_THROWS_AS(loop.runOnce(0ms), std::runtime_error);
+  REQUIRE(ran == std::vector<int>{1});
+  loop.runOnce(0ms);
+  REQUIRE(ran == std::vector<int>{1, 3});
+
+  // Two requeued connections; whichever is served first throws, and the
+  // other must still be served by the next iteration.
+  test::LoopbackPair first(TcpSocket::BlockingType::NonBlocking);
+  test::LoopbackPair second(TcpSocket::BlockingType::NonBlocking);
+  const std::byte hello[1] = {};
+  REQUIRE(first.client.send(hello) == 1);
+  REQUIRE(second.client.send(hello) == 1);
+  while (first.server.availableBytes() < 1 ||
+         second.server.availableBytes() < 1) {
+    std::this_thread::sleep_for(1ms);
+  }
+
+  int calls[2] = {};
+  bool thrown = false;
+  auto handler = [&](int index) {
+    return [&, index](unsigned, EventLoop::IoBudget &) {
+      if (++calls[index] == 2 && !thrown) {
+        thrown = true;
+        throw std::runtime_error("handler");
+      }
+      return calls[index] == 1 ? EventLoop::IoStatus::Pending
+                               : EventLoop::IoStatus::Done;
+    };
+  };
+  const unsigned interest = EventLoop::Readable | EventLoop::EdgeTriggered;
+  loop.addBudgeted(first.server.native_handle(), interest, handler(0));
+  loop.addBudgeted(second.server.native_handle(), interest, handler(1));
+
+  for (int i = 0; i < 100 && calls[0] + calls[1] < 2; ++i) {
+    loop.runOnce(10ms);
+  }
+  REQUIRE(calls[0] == 1);
+  REQUIRE(calls[1] == 1);
+  REQUIRE(loop.stats().requeued == 2);
+
+  REQUIRE_THROWS_AS(loop.runOnce(0ms), std::runtime_error);
+  REQUIRE(calls[0] + calls[1] == 3);
+  loop.runOnce(0ms);
+  REQUIRE(calls[0] == 2);
+  REQUIRE(calls[1] == 2);
+}
+
+TEST_CASE("EventLoop detach and adopt validate their arguments",
+          "[eventloop][migration]") {
+  EventLoop loop;
+  REQUIRE_THROWS_AS((void)loop.detach(12345), std::invalid_argument);
+  REQUIRE_THROWS_AS(loop.adopt(EventLoop::Migration{}),
+                    std::invalid_argument);
+}
+
+TEST_CASE("EventLoop migrates a connection mid-stream between threads",
+          "[eventloop][migration]") {
+  const bool edge = GENERATE(false, true);
+  EventLoop source;
+  EventLoop target;
+  test::LoopbackPair pair(TcpSocket::BlockingType::NonBlocking);
+  const auto fd = pair.server.native_handle();
+
+  struct Connection {
+    TcpSocket socket;
+    AdaptiveReceiveSizer sizer;
+    ReceiveBuffer data;
+    EventLoop *loop = nullptr;
+    std::vector<std::thread::id> threads;
+  };
+  auto conn = std::make_shared<Connection>();
+  conn->socket = std::move(pair.server);
+  conn->loop = &source;
+
+  constexpr std::size_t kTotal = 64 * 1024;
+  constexpr std::size_t kMigrateAt = 8 * 1024;
+  std::atomic<bool> migrated{false};
+  std::atomic<bool> adopted{false};
+
+  const unsigned interest =
+      EventLoop::Readable | (edge ? EventLoop::EdgeTriggered : 0u);
+  source.addBudgeted(
+      fd, interest,
+      [conn, &target, &migrated, &adopted,
+       fd](unsigned, EventLoop::IoBudget &budget) {
+        conn->threads.push_back(std::this_thread::get_id());
+        auto result = receiveAvailable(conn->socket, conn->sizer, conn->data,
+                                       {budget.read_bytes, budget.read_ops});
+        budget.chargeRead(result.bytes, result.reads);
+        if (!migrated && conn->data.size() >= kMigrateAt) {
+          // Move to the other loop while data is still arriving.
+          migrated = true;
+          target.adopt(conn->loop->detach(fd), [conn, &adopted](EventLoop &l) {
+            conn->loop = &l;
+            adopted = true;
+          });
+          return EventLoop::IoStatus::Pending;
+        }
+        return result.drained || result.eof ? EventLoop::IoStatus::Done
+                                            : EventLoop::IoStatus::Pending;
+      },
+      "migrating", EventLoop::IoBudget{4096, 4096, 4, 4});
+
+  std::thread target_thread([&] { target.run(); });
+  std::thread source_thread([&] {
+    while (!migrated) {
+      source.runOnce(10ms);
+    }
+  });
+
+  std::vector<std::byte> payload(kTotal);
+  for (std::size_t i = 0; i < kTotal; ++i) {
+    payload[i] = static_cast<std::byte>(i * 31);
+  }
+  std::thread sender([&] {
+    for (std::size_t off = 0; off < kTotal; off += 1024) {
+      std::span<const std::byte> chunk(payload.data() + off, 1024);
+      while (!chunk.empty()) {
+        chunk = chunk.subspan(pair.client.send(chunk));
+      }
+      std::this_thread::sleep_for(200us);
+    }
+  });
+  sender.join();
+  source_thread.join();
+
+  std::promise<std::size_t> done;
+  auto received = done.get_future();
+  std::function<void()> check;
+  check = [&] {
+    if (conn->data.size() >= kTotal) {
+      done.set_value(conn->data.size());
+    } else {
+      target.runAfter(1ms, check);
+    }
+  };
+  target.post(check);
+  REQUIRE(received.wait_for(5s) == std::future_status::ready);
+  REQUIRE(received.get() == kTotal);
+  const auto target_id = target_thread.get_id();
+  target.stop();
+  target_thread.join();
+
+  REQUIRE(adopted);
+  REQUIRE(conn->loop == &target);
+  REQUIRE(std::ranges::equal(conn->data, payload));
+  REQUIRE_FALSE(source.contains(fd));
+  REQUIRE(target.contains(fd));
+  REQUIRE(conn->threads.front() != conn->threads.back());
+  REQUIRE(conn->threads.back() == target_id);
+
+  target.remove(fd);
+}
+#endif
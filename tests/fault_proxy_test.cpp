@@ -0,0 +1,258 @@
+#include "catch2/catch_test_macros.hpp"
+
+#ifndef _WIN32
+
+#include "net/core/endpoint.h"
+#include "net/protocol/tcp/tcp_socket.h"
+#include "support/fault_proxy.h"
+#include <catch2/catch_all.hpp>
+#include <array>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+#include <sys/socket.h>
+
+using namespace net;
+using namespace std::chrono_literals;
+using net::test::FaultProxy;
+
+namespace {
+
+/// Echo server that serves `connections` clients, one thread each.
+class EchoServer {
+public:
+  explicit EchoServer(int connections) {
+    listener_.bind(Endpoint("127.0.0.1", 0));
+    listener_.listen();
+    acceptor_ = std::thread([this, connections] {
+      for (int i = 0; i < connections; ++i) {
+        Endpoint peer;
+        auto connection = std::make_shared<TcpSocket>(listener_.accept(peer));
+        workers_.emplace_back([connection] {
+          std::array<std::byte, 16 * 1024> buffer{};
+          try {
+            std::size_t n = 0;
+            while ((n = connection->receive(buffer)) > 0) {
+              std::size_t sent = 0;
+              while (sent < n) {
+                sent += connection->send(
+                    std::span<const std::byte>(buffer).subspan(sent,
+                                                               n - sent));
+              }
+            }
+          } catch (const std::system_error &) {
+            // Reset by the proxy.
+          }
+        });
+      }
+    });
+  }
+
+  ~EchoServer() {
+    acceptor_.join();
+    for (auto &worker : workers_) {
+      worker.join();
+    }
+  }
+
+  [[nodiscard]] Endpoint endpoint() const { return listener_.localEndpoint(); }
+
+private:
+  TcpSocket listener_;
+  std::thread acceptor_;
+  std::vector<std::thread> workers_;
+};
+
+std::vector<std::byte> pattern(std::size_t size) {
+  std::vector<std::byte> data(size);
+  for (std::size_t i = 0; i < size; ++i) {
+    data[i] = static_cast<std::byte>((i * 29 + i / 251) & 0xff);
+  }
+  return data;
+}
+
+void sendAll(TcpSocket &socket, std::span<const std::byte> data) {
+  std::size_t sent = 0;
+  while (sent < data.size()) {
+    sent += socket.send(data.subspan(sent));
+  }
+}
+
+std::vector<std::byte> receiveExactly(TcpSocket &socket, std::size_t size) {
+  std::vector<std::byte> data(size);
+  std::size_t received = 0;
+  while (received < size) {
+    const std::size_t n =
+        socket.receive(std::span(data).subspan(received));
+    REQUIRE(n > 0);
+    received += n;
+  }
+  return data;
+}
+
+/// Receive until the connection ends; true if it ended with an error.
+bool endsWithError(TcpSocket &socket) {
+  std::array<std::byte, 4096> buffer{};
+  try {
+    while (socket.receive(buffer) > 0) {
+    }
+    return false;
+  } catch (const std::system_error &) {
+    return true;
+  }
+}
+
+template <typename Predicate> bool eventually(Predicate predicate) {
+  const auto deadline = std::chrono::steady_clock::now() + 5s;
+  while (!predicate()) {
+    if (std::chrono::steady_clock::now() > deadline) {
+      return false;
+    }
+    std::this_thread::sleep_for(1ms);
+  }
+  return true;
+}
+
+} // namespace
+
+TEST_CASE("FaultProxy relays both directions unchanged", "[fault_proxy]") {
+  EchoServer server(1);
+  FaultProxy proxy(server.endpoint());
+
+  TcpSocket client;
+  client.connect(proxy.endpoint());
+  const auto data = pattern(96 * 1024);
+  std::thread writer([&] { sendAll(client, data); });
+  REQUIRE(receiveExactly(client, data.size()) == data);
+  writer.join();
+
+  // Half-close travels through: the echo server ends, so does the client.
+  client.shutdown(TcpSocket::ShutdownType::Sending);
+  REQUIRE_FALSE(endsWithError(client));
+  REQUIRE(eventually([&] { return proxy.stats().active == 0; }));
+
+  const auto stats = proxy.stats();
+  REQUIRE(stats.accepted == 1);
+  REQUIRE(stats.bytes == 2 * data.size());
+  REQUIRE(stats.resets == 0);
+}
+
+TEST_CASE("FaultProxy adds one-way delay in each direction",
+          "[fault_proxy]") {
+  EchoServer server(1);
+  FaultProxy proxy(server.endpoint(), {.delay = 25ms});
+
+  TcpSocket client;
+  client.connect(proxy.endpoint());
+  const auto ping = pattern(16);
+
+  const auto start = std::chrono::steady_clock::now();
+  sendAll(client, ping);
+  REQUIRE(receiveExactly(client, ping.size()) == ping);
+  REQUIRE(std::chrono::steady_clock::now() - start >= 50ms);
+}
+
+TEST_CASE("FaultProxy keeps stream order under jitter", "[fault_proxy]") {
+  EchoServer server(1);
+  FaultProxy proxy(server.endpoint(),
+                   {.delay = 5ms, .jitter = 5ms, .seed = 7});
+
+  TcpSocket client;
+  client.connect(proxy.endpoint());
+  const auto data = pattern(64 * 64);
+  for (std::size_t i = 0; i < data.size(); i += 64) {
+    sendAll(client, std::span(data).subspan(i, 64));
+    std::this_thread::sleep_for(100us);
+  }
+  REQUIRE(receiveExactly(client, data.size()) == data);
+}
+
+TEST_CASE("FaultProxy limits bandwidth", "[fault_proxy]") {
+  EchoServer server(1);
+  FaultProxy proxy(server.endpoint(), {.bandwidth = 256 * 1024});
+
+  TcpSocket client;
+  client.connect(proxy.endpoint());
+  const auto data = pattern(32 * 1024);
+
+  const auto start = std::chrono::steady_clock::now();
+  sendAll(client, data);
+  REQUIRE(receiveExactly(client, data.size()) == data);
+  // 32 KiB at 256 KiB/s is 125 ms per direction.
+  REQUIRE(std::chrono::steady_clock::now() - start >= 230ms);
+}
+
+TEST_CASE("FaultProxy resets connections", "[fault_proxy]") {
+  SECTION("after a byte threshold") {
+    EchoServer server(1);
+    FaultProxy proxy(server.endpoint(), {.reset_after_bytes = 1000});
+    TcpSocket client;
+    client.connect(proxy.endpoint());
+    sendAll(client, pattern(2000));
+    REQUIRE(endsWithError(client));
+    REQUIRE(eventually([&] { return proxy.stats().resets == 1; }));
+  }
+
+  SECTION("on demand") {
+    EchoServer server(2);
+    FaultProxy proxy(server.endpoint());
+    TcpSocket first;
+    TcpSocket second;
+    first.connect(proxy.endpoint());
+    second.connect(proxy.endpoint());
+    const auto ping = pattern(8);
+    sendAll(first, ping);
+    sendAll(second, ping);
+    REQUIRE(receiveExactly(first, ping.size()) == ping);
+    REQUIRE(receiveExactly(second, ping.size()) == ping);
+
+    proxy.resetAll();
+    REQUIRE(endsWithError(first));
+    REQUIRE(endsWithError(second));
+    REQUIRE(eventually([&] {
+      return proxy.stats().resets == 2 && proxy.stats().active == 0;
+    }));
+  }
+
+  SECTION("with a probability per chunk") {
+    EchoServer server(1);
+    FaultProxy proxy(server.endpoint());
+    proxy.setOptions({.reset_probability = 1.0});
+    TcpSocket client;
+    client.connect(proxy.endpoint());
+    sendAll(client, pattern(10));
+    REQUIRE(endsWithError(client));
+  }
+}
+
+TEST_CASE("FaultProxy closes a half-closed connection reset by its peer",
+          "[fault_proxy]") {
+  TcpSocket listener;
+  listener.bind(Endpoint("127.0.0.1", 0));
+  listener.listen();
+  FaultProxy proxy(listener.localEndpoint());
+
+  auto client = std::make_unique<TcpSocket>();
+  client->connect(proxy.endpoint());
+  Endpoint peer;
+  TcpSocket upstream = listener.accept(peer);
+
+  // The client's FIN reaches upstream, so the proxy has read EOF from the
+  // client; the reset that follows arrives as hangup with nothing to read.
+  client->shutdown(TcpSocket::ShutdownType::Sending);
+  std::array<std::byte, 16> buffer{};
+  REQUIRE(upstream.receive(buffer) == 0);
+  linger option{1, 0};
+  ::setsockopt(client->native_handle(), SOL_SOCKET, SO_LINGER, &option,
+               sizeof(option));
+  client.reset();
+
+  REQUIRE(eventually([&] { return proxy.stats().active == 0; }));
+  REQUIRE(proxy.stats().resets == 1);
+}
+
+#endif
@@ -0,0 +1,333 @@
+#include "catch2/catch_test_macros.hpp"
+
+#ifndef _WIN32
+
+#include "net/core/endpoint.h"
+#include "net/core/event_loop.h"
+#include "net/core/fiber_scheduler.h"
+#include "net/detail/fiber_context.h"
+#include "net/detail/fiber_stack.h"
+#include "net/protocol/tcp/tcp_socket.h"
+#include <catch2/catch_all.hpp>
+#include <chrono>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <unistd.h>
+
+using namespace net;
+using namespace std::chrono_literals;
+
+namespace {
+
+detail::FiberContext main_context;
+detail::FiberContext child_context;
+int context_steps = 0;
+
+void childEntry(void *arg) {
+  auto *value = static_cast<int *>(arg);
+  *value += 1;
+  ++context_steps;
+  detail::FiberContext::switchTo(child_context, main_context);
+  *value += 10;
+  ++context_steps;
+  detail::FiberContext::switchTo(child_context, main_context);
+}
+
+void runUntil(EventLoop &loop, const std::function<bool()> &done) {
+  const auto deadline = std::chrono::steady_clock::now() + 5s;
+  while (!done() && std::chrono::steady_clock::now() < deadline) {
+    loop.runOnce(50ms);
+  }
+}
+
+std::span<const std::byte> bytesOf(const std::string &text) {
+  return std::as_bytes(std::span(text.data(), text.size()));
+}
+
+} // namespace
+
+TEST_CASE("FiberContext switches to a fresh stack and back",
+          "[fiber][context]") {
+  detail::FiberStackPool pool(32 * 1024, 1);
+  auto stack = pool.acquire();
+  int value = 0;
+  context_steps = 0;
+
+  child_context.prepare(stack.usable, &childEntry, &value);
+  detail::FiberContext::switchTo(main_context, child_context);
+  REQUIRE(value == 1);
+  detail::FiberContext::switchTo(main_context, child_context);
+  REQUIRE(value == 11);
+  REQUIRE(context_steps == 2);
+  pool.release(stack);
+}
+
+TEST_CASE("FiberStackPool reuses released stacks", "[fiber][stack]") {
+  REQUIRE_THROWS_AS(detail::FiberStackPool(0, 1), std::invalid_argument);
+
+  detail::FiberStackPool pool(16 * 1024, 1);
+  auto first = pool.acquire();
+  REQUIRE(first.usable.size() >= 16 * 1024);
+  REQUIRE(first.mapping_size > first.usable.size());
+  REQUIRE(pool.mapped() == 1);
+
+  void *mapping = first.mapping;
+  pool.release(first);
+  REQUIRE(pool.pooled() == 1);
+  auto again = pool.acquire();
+  REQUIRE(again.mapping == mapping);
+  REQUIRE(pool.mapped() == 1);
+
+  auto second = pool.acquire();
+  REQUIRE(pool.mapped() == 2);
+  pool.release(again);
+  pool.release(second); // over max_pooled: unmapped
+  REQUIRE(pool.pooled() == 1);
+  REQUIRE(pool.mapped() == 2);
+}
+
+TEST_CASE("FiberScheduler interleaves yielding fibers", "[fiber]") {
+  EventLoop loop;
+  FiberScheduler fibers(loop);
+  std::vector<std::string> order;
+
+  REQUIRE_FALSE(FiberScheduler::inFiber());
+  REQUIRE_THROWS_AS(FiberScheduler::yield(), std::logic_error);
+
+  for (const char *name : {"a", "b"}) {
+    fibers.spawn([&order, name] {
+      REQUIRE(FiberScheduler::inFiber());
+      for (int i = 0; i < 3; ++i) {
+        order.push_back(name + std::to_string(i));
+        FiberScheduler::yield();
+      }
+    });
+  }
+  REQUIRE(fibers.active() == 2);
+
+  runUntil(loop, [&] { return fibers.active() == 0; });
+  REQUIRE(order == std::vector<std::string>{"a0", "b0", "a1", "b1", "a2",
+                                            "b2"});
+  auto stats = fibers.stats();
+  REQUIRE(stats.spawned == 2);
+  REQUIRE(stats.completed == 2);
+  REQUIRE(stats.switches == 8);
+  REQUIRE(stats.stacks_mapped == 2);
+}
+
+TEST_CASE("FiberScheduler sleeps on loop timers", "[fiber]") {
+  EventLoop loop;
+  FiberScheduler fibers(loop);
+  std::vector<int> order;
+
+  fibers.spawn([&] {
+    FiberScheduler::sleepFor(30ms);
+    order.push_back(2);
+  });
+  fibers.spawn([&] {
+    FiberScheduler::sleepFor(5ms);
+    order.push_back(1);
+  });
+
+  const auto start = std::chrono::steady_clock::now();
+  runUntil(loop, [&] { return fibers.active() == 0; });
+  REQUIRE(std::chrono::steady_clock::now() - start >= 30ms);
+  REQUIRE(order == std::vector<int>{1, 2});
+}
+
+TEST_CASE("FiberScheduler reports a fiber's exception without the loop",
+          "[fiber]") {
+  EventLoop loop;
+  FiberScheduler fibers(loop);
+  int finished = 0;
+  fibers.spawn([] { throw std::runtime_error("fiber failed"); }, "failing");
+  fibers.spawn([&] { ++finished; });
+
+  REQUIRE_NOTHROW(loop.runOnce(50ms));
+  REQUIRE(finished == 1);
+  REQUIRE(fibers.active() == 0);
+  REQUIRE(fibers.stats().completed == 2);
+  REQUIRE(fibers.stats().failed == 1);
+  auto errors = fibers.takeErrors();
+  REQUIRE(errors.size() == 1);
+  REQUIRE_THROWS_AS(std::rethrow_exception(errors[0]), std::runtime_error);
+  REQUIRE(fibers.takeErrors().empty());
+
+  std::vector<std::string> labels;
+  fibers.setErrorHandler([&](std::exception_ptr, const std::string &label) {
+    labels.push_back(label);
+  });
+  fibers.spawn([] { throw std::logic_error("again"); }, "second");
+  loop.runOnce(50ms);
+  REQUIRE(labels == std::vector<std::string>{"second"});
+  REQUIRE(fibers.takeErrors().empty());
+  REQUIRE_THROWS_AS(fibers.spawn(nullptr), std::invalid_argument);
+}
+
+TEST_CASE("FiberScheduler leaves other registrations alone", "[fiber]") {
+  EventLoop loop;
+  FiberScheduler fibers(loop);
+  int pipe_fds[2];
+  REQUIRE(::pipe(pipe_fds) == 0);
+  loop.add(pipe_fds[0], EventLoop::Readable, [](unsigned) {}, "owner");
+
+  bool refused = false;
+  fibers.spawn([&] {
+    try {
+      FiberScheduler::waitFor(pipe_fds[0], false);
+    } catch (const std::logic_error &) {
+      refused = true;
+    }
+  });
+  loop.runOnce(50ms);
+  REQUIRE(refused);
+  REQUIRE(loop.contains(pipe_fds[0]));
+  REQUIRE(fibers.stats().io_waits == 0);
+
+  // A descriptor the scheduler added itself is removed once nobody waits.
+  fibers.spawn([&] { FiberScheduler::waitFor(pipe_fds[1], true); });
+  runUntil(loop, [&] { return fibers.active() == 0; });
+  REQUIRE_FALSE(loop.contains(pipe_fds[1]));
+
+  loop.remove(pipe_fds[0]);
+  ::close(pipe_fds[0]);
+  ::close(pipe_fds[1]);
+}
+
+TEST_CASE("FiberScheduler turns blocking socket calls into fiber switches",
+          "[fiber][tcp]") {
+  EventLoop loop;
+  FiberScheduler fibers(loop);
+
+  TcpSocket listener;
+  listener.bind(Endpoint("127.0.0.1", 0));
+  listener.listen();
+  const Endpoint address = listener.localEndpoint();
+  constexpr int kClients = 3;
+  int echoed = 0;
+
+  // Blocking-mode accept/receive/send inside fibers: one server fiber
+  // accepts and spawns a handler per connection on the same thread.
+  fibers.spawn(
+      [&] {
+        for (int i = 0; i < kClients; ++i) {
+          Endpoint peer;
+          auto connection =
+              std::make_shared<TcpSocket>(listener.accept(peer));
+          fibers.spawn(
+              [connection] {
+                std::array<std::byte, 64> buffer{};
+                std::size_t n = 0;
+                while ((n = connection->receive(buffer)) > 0) {
+                  std::size_t sent = 0;
+                  while (sent < n) {
+                    sent += connection->send(
+                        std::span<const std::byte>(buffer).subspan(sent,
+                                                                   n - sent));
+                  }
+                }
+              },
+              "echo");
+        }
+      },
+      "acceptor");
+
+  for (int i = 0; i < kClients; ++i) {
+    fibers.spawn(
+        [&, i] {
+          // Let the acceptor park in accept() first.
+          FiberScheduler::sleepFor(std::chrono::milliseconds(5 * (i + 1)));
+          TcpSocket client;
+          client.connect(address);
+          const std::string message = "hello " + std::to_string(i);
+          REQUIRE(client.send(bytesOf(message)) == message.size());
+
+          std::string reply;
+          std::array<std::byte, 64> buffer{};
+          while (reply.size() < message.size()) {
+            std::size_t n = client.receive(buffer);
+            REQUIRE(n > 0);
+            reply.append(reinterpret_cast<const char *>(buffer.data()), n);
+          }
+          REQUIRE(reply == message);
+          ++echoed;
+        },
+        "client");
+  }
+
+  runUntil(loop, [&] { return fibers.active() == 0; });
+  REQUIRE(echoed == kClients);
+  REQUIRE(fibers.active() == 0);
+  REQUIRE(fibers.stats().io_waits >= kClients);
+  REQUIRE(loop.registrationCount() == 0);
+}
+
+TEST_CASE("FiberScheduler parks many fibers in blocking receive",
+          "[fiber][tcp]") {
+  EventLoop loop;
+  FiberScheduler fibers(loop, {.stack_size = 32 * 1024, .pooled_stacks = 8});
+
+  TcpSocket listener;
+  listener.bind(Endpoint("127.0.0.1", 0));
+  listener.listen(256);
+
+  constexpr int kFibers = 100;
+  std::vector<TcpSocket> writers;
+  std::vector<std::shared_ptr<TcpSocket>> readers;
+  for (int i = 0; i < kFibers; ++i) {
+    writers.emplace_back();
+    writers.back().connect(listener.localEndpoint());
+    Endpoint peer;
+    readers.push_back(std::make_shared<TcpSocket>(listener.accept(peer)));
+  }
+
+  int received = 0;
+  for (auto &reader : readers) {
+    fibers.spawn([&received, reader] {
+      std::array<std::byte, 8> buffer{};
+      REQUIRE(reader->receive(buffer) == 4);
+      ++received;
+    });
+  }
+
+  loop.runOnce(10ms);
+  REQUIRE(received == 0);
+  REQUIRE(fibers.stats().io_waits == kFibers);
+  REQUIRE(loop.registrationCount() == kFibers);
+
+  for (auto &writer : writers) {
+    REQUIRE(writer.send(bytesOf("ping")) == 4);
+  }
+  runUntil(loop, [&] { return fibers.active() == 0; });
+  REQUIRE(received == kFibers);
+  REQUIRE(fibers.stats().stacks_mapped == kFibers);
+
+  // Finished fibers left their stacks in the pool.
+  fibers.spawn([] {});
+  runUntil(loop, [&] { return fibers.active() == 0; });
+  REQUIRE(fibers.stats().stacks_mapped == kFibers);
+  REQUIRE(loop.registrationCount() == 0);
+}
+
+TEST_CASE("FiberScheduler destructor releases parked fibers", "[fiber]") {
+  EventLoop loop;
+  TcpSocket listener;
+  listener.bind(Endpoint("127.0.0.1", 0));
+  listener.listen();
+  {
+    FiberScheduler fibers(loop);
+    fibers.spawn([&] {
+      Endpoint peer;
+      (void)listener.accept(peer);
+    });
+    loop.runOnce(10ms);
+    REQUIRE(loop.contains(listener.native_handle()));
+  }
+  REQUIRE_FALSE(loop.contains(listener.native_handle()));
+  loop.runOnce(0ms);
+}
+
+#endif
@@ -0,0 +1,274 @@
+#include "catch2/catch_test_macros.hpp"
+#include "net/core/retry_budget.h"
+#include <catch2/catch_all.hpp>
+#include <chrono>
+
+using namespace std::chrono_literals;
+
+TEST_CASE("RetryBudget spends deposits and a time-based reserve",
+          "[retry_budget]") {
+  using net::RetryBudget;
+  REQUIRE_THROWS_AS(RetryBudget(RetryBudget::Options{-0.1, 1.0, 10.0}),
+                    std::invalid_argument);
+  REQUIRE_THROWS_AS(RetryBudget(RetryBudget::Options{0.1, 1.0, 0.5}),
+                    std::invalid_argument);
+
+  const auto t0 = RetryBudget::Clock::now();
+  RetryBudget budget(RetryBudget::Options{0.25, 2.0, 3.0}, t0);
+  REQUIRE(budget.balance(t0) == 2.0);
+  REQUIRE(budget.tryWithdraw(t0));
+  REQUIRE(budget.tryWithdraw(t0));
+  REQUIRE_FALSE(budget.tryWithdraw(t0));
+
+  // Four requests pay for one retry.
+  for (int i = 0; i < 3; ++i) {
+    budget.deposit();
+  }
+  REQUIRE_FALSE(budget.tryWithdraw(t0));
+  budget.deposit();
+  REQUIRE(budget.tryWithdraw(t0));
+
+  // The reserve refills with time, up to the burst.
+  REQUIRE(budget.balance(t0 + 500ms) == 1.0);
+  REQUIRE(budget.balance(t0 + 10s) == 3.0);
+}
+
+#ifndef _WIN32
+
+#include "net/core/endpoint.h"
+#include "net/core/event_loop.h"
+#include "net/core/hedging_client.h"
+#include "net/core/upstream_health.h"
+#include <map>
+#include <memory>
+#include <optional>
+#include <string>
+#include <system_error>
+#include <vector>
+
+using namespace net;
+
+namespace {
+
+/// Simulated upstreams answering after a fixed delay on the loop.
+struct FakeUpstreams {
+  struct Behaviour {
+    std::chrono::milliseconds delay{0};
+    std::error_code error;
+    bool synchronous = false;
+  };
+
+  EventLoop &loop;
+  std::map<std::string, Behaviour> behaviour;
+  std::vector<std::string> started;
+  std::vector<std::string> cancelled;
+
+  HedgingClient::Attempt attempt() {
+    return [this](const Endpoint &endpoint, HedgingClient::Done done) {
+      const std::string name = endpoint.to_string();
+      started.push_back(name);
+      const Behaviour b = behaviour[name];
+      if (b.synchronous) {
+        done(b.error);
+        return HedgingClient::Cancel{};
+      }
+      const auto timer =
+          loop.runAfter(b.delay, [done, error = b.error] { done(error); });
+      return HedgingClient::Cancel([this, timer, name] {
+        loop.cancel(timer);
+        cancelled.push_back(name);
+      });
+    };
+  }
+};
+
+HedgingClient::Result runCall(EventLoop &loop, HedgingClient &client,
+                              const std::vector<Endpoint> &candidates,
+                              HedgingClient::Attempt attempt) {
+  std::optional<HedgingClient::Result> result;
+  client.call(candidates, std::move(attempt),
+              [&](const HedgingClient::Result &r) { result = r; });
+  REQUIRE_FALSE(result); // never delivered from inside call()
+  const auto deadline = EventLoop::Clock::now() + 5s;
+  while (!result && EventLoop::Clock::now() < deadline) {
+    loop.runOnce(100ms);
+  }
+  REQUIRE(result);
+  return *result;
+}
+
+HedgingClient::Options fixedDelay(std::chrono::milliseconds delay) {
+  HedgingClient::Options options;
+  options.min_delay = delay;
+  options.max_delay = delay;
+  return options;
+}
+
+} // namespace
+
+TEST_CASE("HedgingClient validates its options", "[hedging]") {
+  EventLoop loop;
+  auto budget = std::make_shared<RetryBudget>();
+  HedgingClient::Options options;
+  options.percentile = 0;
+  REQUIRE_THROWS_AS(HedgingClient(loop, options, budget),
+                    std::invalid_argument);
+  options = {};
+  options.max_delay = options.min_delay / 2;
+  REQUIRE_THROWS_AS(HedgingClient(loop, options, budget),
+                    std::invalid_argument);
+  REQUIRE_THROWS_AS(HedgingClient(loop, HedgingClient::Options{}, nullptr),
+                    std::invalid_argument);
+}
+
+TEST_CASE("HedgingClient does not hedge fast answers", "[hedging]") {
+  EventLoop loop;
+  FakeUpstreams upstreams{loop, {}, {}, {}};
+  const std::vector<Endpoint> candidates = {Endpoint("10.0.0.1", 80),
+                                            Endpoint("10.0.0.2", 80)};
+  upstreams.behaviour["10.0.0.1:80"].delay = 1ms;
+
+  HedgingClient client(loop, fixedDelay(200ms),
+                       std::make_shared<RetryBudget>());
+  const auto result = runCall(loop, client, candidates, upstreams.attempt());
+  REQUIRE_FALSE(result.error);
+  REQUIRE(result.candidate == 0);
+  REQUIRE(result.attempts == 1);
+  REQUIRE_FALSE(result.hedged);
+  REQUIRE(upstreams.started.size() == 1);
+  REQUIRE(client.stats().calls == 1);
+  REQUIRE(client.stats().hedges == 0);
+}
+
+TEST_CASE("HedgingClient hedges slow answers and cancels the loser",
+          "[hedging]") {
+  EventLoop loop;
+  FakeUpstreams upstreams{loop, {}, {}, {}};
+  const std::vector<Endpoint> candidates = {Endpoint("10.0.0.1", 80),
+                                            Endpoint("10.0.0.2", 80)};
+  upstreams.behaviour["10.0.0.1:80"].delay = 2000ms;
+  upstreams.behaviour["10.0.0.2:80"].delay = 5ms;
+
+  UpstreamHealth health;
+  HedgingClient client(loop, fixedDelay(20ms),
+                       std::make_shared<RetryBudget>(), &health);
+  const auto result = runCall(loop, client, candidates, upstreams.attempt());
+  REQUIRE_FALSE(result.error);
+  REQUIRE(result.candidate == 1);
+  REQUIRE(result.attempts == 2);
+  REQUIRE(result.hedged);
+  REQUIRE(result.latency < 1000ms);
+  REQUIRE(upstreams.cancelled == std::vector<std::string>{"10.0.0.1:80"});
+
+  const auto &stats = client.stats();
+  REQUIRE(stats.hedges == 1);
+  REQUIRE(stats.hedge_wins == 1);
+  REQUIRE(stats.cancelled == 1);
+
+  // The cancelled loser released its permit without counting as a failure.
+  const auto loser = health.stats(candidates[0]);
+  REQUIRE(loser.pending == 0);
+  REQUIRE(loser.failures == 0);
+  REQUIRE(health.stats(candidates[1]).successes == 1);
+}
+
+TEST_CASE("HedgingClient respects the retry budget", "[hedging]") {
+  EventLoop loop;
+  FakeUpstreams upstreams{loop, {}, {}, {}};
+  const std::vector<Endpoint> candidates = {Endpoint("10.0.0.1", 80),
+                                            Endpoint("10.0.0.2", 80)};
+  upstreams.behaviour["10.0.0.1:80"].delay = 60ms;
+
+  auto budget = std::make_shared<RetryBudget>(RetryBudget::Options{0, 0, 1});
+  HedgingClient client(loop, fixedDelay(10ms), budget);
+  const auto result = runCall(loop, client, candidates, upstreams.attempt());
+  REQUIRE_FALSE(result.error);
+  REQUIRE(result.candidate == 0);
+  REQUIRE_FALSE(result.hedged);
+  REQUIRE(client.stats().budget_denied == 1);
+  REQUIRE(upstreams.started.size() == 1);
+}
+
+TEST_CASE("HedgingClient retries failures on the next candidate",
+          "[hedging]") {
+  EventLoop loop;
+  FakeUpstreams upstreams{loop, {}, {}, {}};
+  const std::vector<Endpoint> candidates = {Endpoint("10.0.0.1", 80),
+                                            Endpoint("10.0.0.2", 80)};
+  auto &first = upstreams.behaviour["10.0.0.1:80"];
+  first.synchronous = true;
+  first.error = std::make_error_code(std::errc::connection_refused);
+  upstreams.behaviour["10.0.0.2:80"].delay = 1ms;
+
+  HedgingClient client(loop, fixedDelay(200ms),
+                       std::make_shared<RetryBudget>());
+  auto result = runCall(loop, client, candidates, upstreams.attempt());
+  REQUIRE_FALSE(result.error);
+  REQUIRE(result.candidate == 1);
+  REQUIRE(result.attempts == 2);
+  REQUIRE_FALSE(result.hedged);
+  REQUIRE(client.stats().retries == 1);
+
+  // Nothing left to retry on: the last error is reported.
+  auto &second = upstreams.behaviour["10.0.0.2:80"];
+  second.error = std::make_error_code(std::errc::timed_out);
+  result = runCall(loop, client, candidates, upstreams.attempt());
+  REQUIRE(result.error == std::errc::timed_out);
+  REQUIRE(result.candidate == 1);
+  REQUIRE(client.stats().failed == 1);
+}
+
+TEST_CASE("HedgingClient skips endpoints the health tracker rejects",
+          "[hedging]") {
+  EventLoop loop;
+  FakeUpstreams upstreams{loop, {}, {}, {}};
+  const std::vector<Endpoint> candidates = {Endpoint("10.0.0.1", 80),
+                                            Endpoint("10.0.0.2", 80)};
+  upstreams.behaviour["10.0.0.2:80"].delay = 1ms;
+
+  UpstreamHealth::Options health_options;
+  health_options.consecutive_failures = 1;
+  UpstreamHealth health(health_options);
+  health.tryAcquire(candidates[0])->failure();
+  REQUIRE(health.state(candidates[0]) == UpstreamHealth::State::Ejected);
+
+  HedgingClient client(loop, fixedDelay(200ms),
+                       std::make_shared<RetryBudget>(), &health);
+  auto result = runCall(loop, client, candidates, upstreams.attempt());
+  REQUIRE_FALSE(result.error);
+  REQUIRE(result.candidate == 1);
+  REQUIRE(upstreams.started == std::vector<std::string>{"10.0.0.2:80"});
+
+  result = runCall(loop, client, std::vector<Endpoint>{candidates[0]},
+                   upstreams.attempt());
+  REQUIRE(result.error == std::errc::resource_unavailable_try_again);
+  REQUIRE(result.attempts == 0);
+  REQUIRE(client.stats().unavailable == 1);
+}
+
+TEST_CASE("HedgingClient derives the hedge delay from a percentile",
+          "[hedging]") {
+  EventLoop loop;
+  HedgingClient::Options options;
+  options.percentile = 0.95;
+  options.min_samples = 100;
+  options.min_delay = 1ms;
+  options.max_delay = 1s;
+  options.window = 10s;
+  HedgingClient client(loop, options, std::make_shared<RetryBudget>());
+  const auto t0 = HedgingClient::Clock::now();
+
+  REQUIRE(client.hedgeDelay(t0) == 1s);
+  for (int ms = 1; ms <= 100; ++ms) {
+    client.record(std::chrono::milliseconds(ms), t0);
+  }
+  const auto delay = client.hedgeDelay(t0);
+  REQUIRE(delay >= 95ms);
+  REQUIRE(delay <= 108ms);
+
+  // Samples survive one rotation and are forgotten after two.
+  REQUIRE(client.hedgeDelay(t0 + 10s) == delay);
+  REQUIRE(client.hedgeDelay(t0 + 20s) == 1s);
+}
+
+#endif
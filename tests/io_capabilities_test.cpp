@@ -0,0 +1,184 @@
+#include "catch2/catch_test_macros.hpp"
+#include "net/core/endpoint.h"
+#include "net/core/io_capabilities.h"
+#include "net/protocol/tcp/tcp_socket.h"
+#include <catch2/catch_all.hpp>
+#include <stdexcept>
+#include <string>
+
+#ifndef _WIN32
+#include "net/core/event_loop.h"
+#include "net/detail/platform_error.h"
+#include <fcntl.h>
+#endif
+
+using namespace net;
+
+namespace {
+
+IoCapabilities everything() {
+  IoCapabilities caps;
+  caps.epoll = caps.io_uring = caps.io_uring_read_fixed = true;
+  caps.io_uring_send = caps.tcp_zerocopy_receive = caps.accept4 = true;
+  return caps;
+}
+
+/// Restores the process-wide selection when a test changes it.
+struct BackendsGuard {
+  IoBackends saved = ioBackends();
+  ~BackendsGuard() { setIoBackends(saved); }
+};
+
+} // namespace
+
+TEST_CASE("IoCapabilities are probed once and consistently", "[io][caps]") {
+  const IoCapabilities &cached = ioCapabilities();
+  REQUIRE(&cached == &ioCapabilities());
+
+  const IoCapabilities fresh = probeIoCapabilities();
+  REQUIRE(fresh.kernel == cached.kernel);
+  REQUIRE(fresh.epoll == cached.epoll);
+  REQUIRE(fresh.io_uring == cached.io_uring);
+  REQUIRE(fresh.accept4 == cached.accept4);
+
+#ifdef __linux__
+  REQUIRE_FALSE(cached.kernel.empty());
+  REQUIRE(cached.epoll);
+  REQUIRE(cached.accept4);
+#endif
+  if (!cached.io_uring) {
+    REQUIRE_FALSE(cached.io_uring_send);
+    REQUIRE_FALSE(cached.io_uring_multishot_recv);
+  }
+  if (cached.reuseport_cbpf) {
+    REQUIRE(cached.reuseport);
+  }
+}
+
+TEST_CASE("selectIoBackends picks the fastest available path",
+          "[io][caps]") {
+  IoBackends best = selectIoBackends(everything());
+  REQUIRE(best.poller == PollerBackend::Epoll);
+  REQUIRE(best.file_send == FileSendBackend::IoUring);
+  REQUIRE(best.receive == ReceiveBackend::ZeroCopy);
+  REQUIRE(best.accept == AcceptBackend::Accept4);
+
+  IoBackends minimal = selectIoBackends(IoCapabilities{});
+  REQUIRE(minimal.poller == PollerBackend::Poll);
+  REQUIRE(minimal.file_send == FileSendBackend::ReadSend);
+  REQUIRE(minimal.receive == ReceiveBackend::Copy);
+  REQUIRE(minimal.accept == AcceptBackend::Accept);
+
+  // io_uring without the needed opcodes is not used for file sends.
+  IoCapabilities no_send = everything();
+  no_send.io_uring_send = false;
+  REQUIRE(selectIoBackends(no_send).file_send == FileSendBackend::ReadSend);
+}
+
+TEST_CASE("selectIoBackends applies overrides", "[io][caps]") {
+  IoBackends chosen = selectIoBackends(
+      everything(), " poller = poll ,file_send=read_send,,receive=copy");
+  REQUIRE(chosen.poller == PollerBackend::Poll);
+  REQUIRE(chosen.file_send == FileSendBackend::ReadSend);
+  REQUIRE(chosen.receive == ReceiveBackend::Copy);
+  REQUIRE(chosen.accept == AcceptBackend::Accept4);
+
+  // Asking for a missing fast path resolves to the best available one.
+  REQUIRE(selectIoBackends(IoCapabilities{}, "file_send=io_uring")
+              .file_send == FileSendBackend::ReadSend);
+
+  REQUIRE_THROWS_AS(selectIoBackends(everything(), "poller=kqueue"),
+                    std::invalid_argument);
+  REQUIRE_THROWS_AS(selectIoBackends(everything(), "sendfile=yes"),
+                    std::invalid_argument);
+  REQUIRE_THROWS_AS(selectIoBackends(everything(), "poller"),
+                    std::invalid_argument);
+}
+
+TEST_CASE("describeIo reports capabilities and backends", "[io][caps]") {
+  IoCapabilities caps = everything();
+  caps.kernel = "6.1.0-test";
+  const std::string report = describeIo(caps, selectIoBackends(caps));
+  REQUIRE(report.find("kernel: 6.1.0-test\n") != std::string::npos);
+  REQUIRE(report.find("io_uring: yes\n") != std::string::npos);
+  REQUIRE(report.find("so_zerocopy: no\n") != std::string::npos);
+  REQUIRE(report.find("backend.poller: epoll\n") != std::string::npos);
+  REQUIRE(report.find("backend.file_send: io_uring\n") != std::string::npos);
+  REQUIRE(report.find("backend.accept: accept4\n") != std::string::npos);
+}
+TEST_CASE("setIoBackends falls back for paths the kernel lacks",
+          "[io][caps]") {
+  BackendsGuard guard;
+  setIoBackends(IoBackends{PollerBackend::Epoll, FileSendBackend::IoUring,
+                           ReceiveBackend::ZeroCopy, AcceptBackend::Accept4});
+  const IoBackends stored = ioBackends();
+  const IoBackends best = selectIoBackends(ioCapabilities());
+  REQUIRE(stored.poller == best.poller);
+  REQUIRE(stored.file_send == best.file_send);
+  REQUIRE(stored.receive == best.receive);
+  REQUIRE(stored.accept == best.accept);
+
+  // Fallback backends are stored as given.
+  setIoBackends(IoBackends{});
+  REQUIRE(ioBackends().poller == PollerBackend::Poll);
+  REQUIRE(ioBackends().file_send == FileSendBackend::ReadSend);
+}
+
+#ifndef _WIN32
+
+TEST_CASE("EventLoop follows the selected poller", "[io][caps]") {
+  BackendsGuard guard;
+  IoBackends backends = ioBackends();
+  backends.poller = PollerBackend::Poll;
+  setIoBackends(backends);
+  REQUIRE(ioBackends().poller == PollerBackend::Poll);
+  REQUIRE(EventLoop().backend() == "poll");
+
+  if (ioCapabilities().epoll) {
+    backends.poller = PollerBackend::Epoll;
+    setIoBackends(backends);
+    REQUIRE(EventLoop().backend() == "epoll");
+  }
+}
+
+TEST_CASE("accept applies socket flags with either accept backend",
+          "[io][caps]") {
+  BackendsGuard guard;
+  const auto accept_backend =
+      GENERATE(AcceptBackend::Accept4, AcceptBackend::Accept);
+  if (accept_backend == AcceptBackend::Accept4 && !ioCapabilities().accept4) {
+    return;
+  }
+  IoBackends backends = ioBackends();
+  backends.accept = accept_backend;
+  setIoBackends(backends);
+  REQUIRE(ioBackends().accept == accept_backend);
+
+  TcpSocket listener(TcpSocket::AddressFamily::IPV4,
+                     TcpSocket::BlockingType::NonBlocking,
+                     TcpSocket::InheritableType::NonInheritable);
+  listener.bind(Endpoint("127.0.0.1", 0));
+  listener.listen();
+  TcpSocket client;
+  client.connect(listener.localEndpoint());
+
+  Endpoint peer;
+  TcpSocket accepted = [&] {
+    for (;;) {
+      try {
+        return listener.accept(peer);
+      } catch (const std::system_error &error) {
+        // Connection not queued yet on the non-blocking listener.
+        if (!detail::is_would_block(error.code().value())) {
+          throw;
+        }
+      }
+    }
+  }();
+  REQUIRE(peer.port() == client.localEndpoint().port());
+  REQUIRE(accepted.blocking() == TcpSocket::BlockingType::NonBlocking);
+  REQUIRE((::fcntl(accepted.native_handle(), F_GETFL) & O_NONBLOCK) != 0);
+  REQUIRE((::fcntl(accepted.native_handle(), F_GETFD) & FD_CLOEXEC) != 0);
+}
+
+#endif
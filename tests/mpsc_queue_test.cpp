@@ -0,0 +1,69 @@
+#include "catch2/catch_test_macros.hpp"
+#include "net/detail/mpsc_queue.h"
+#include <catch2/catch_all.hpp>
+#include <memory>
+#include <thread>
+#include <vector>
+
+using net::detail::MpscQueue;
+
+TEST_CASE("MpscQueue is FIFO for a single producer", "[mpsc]") {
+  MpscQueue<int> queue;
+  REQUIRE(queue.empty());
+  REQUIRE_FALSE(queue.pop().has_value());
+
+  for (int i = 0; i < 10; ++i) {
+    queue.push(i);
+  }
+  REQUIRE_FALSE(queue.empty());
+  for (int i = 0; i < 10; ++i) {
+    REQUIRE(queue.pop() == i);
+  }
+  REQUIRE(queue.empty());
+}
+
+TEST_CASE("MpscQueue holds move-only values and frees leftovers", "[mpsc]") {
+  auto tracked = std::make_shared<int>(7);
+  {
+    MpscQueue<std::unique_ptr<std::shared_ptr<int>>> queue;
+    queue.push(std::make_unique<std::shared_ptr<int>>(tracked));
+    queue.push(std::make_unique<std::shared_ptr<int>>(tracked));
+    auto first = queue.pop();
+    REQUIRE(first.has_value());
+    REQUIRE(**first.value() == 7);
+    REQUIRE(tracked.use_count() == 3);
+  }
+  REQUIRE(tracked.use_count() == 1);
+}
+
+TEST_CASE("MpscQueue delivers every push from many producers", "[mpsc]") {
+  constexpr int kProducers = 4;
+  constexpr int kPerProducer = 20000;
+  MpscQueue<std::pair<int, int>> queue;
+
+  std::vector<std::thread> producers;
+  for (int p = 0; p < kProducers; ++p) {
+    producers.emplace_back([&queue, p] {
+      for (int i = 0; i < kPerProducer; ++i) {
+        queue.push({p, i});
+      }
+    });
+  }
+
+  std::vector<int> next(kProducers, 0);
+  int received = 0;
+  bool ordered = true;
+  while (received < kProducers * kPerProducer) {
+    if (auto item = queue.pop()) {
+      ordered = ordered && item->second == next[item->first];
+      next[item->first] = item->second + 1;
+      ++received;
+    }
+  }
+  for (auto &producer : producers) {
+    producer.join();
+  }
+
+  REQUIRE(ordered); // per-producer order is preserved
+  REQUIRE(queue.empty());
+}
@@ -0,0 +1,84 @@
+#include "catch2/catch_test_macros.hpp"
+#include "net/core/endpoint.h"
+#include "net/protocol/tcp/receive_low_watermark.h"
+#include "net/protocol/tcp/tcp_socket.h"
+#include "support/loopback_pair.h"
+#include <catch2/catch_all.hpp>
+#include <vector>
+
+#ifndef _WIN32
+#include <poll.h>
+#endif
+
+using namespace net;
+
+TEST_CASE("TcpSocket receive low watermark on invalid socket",
+          "[tcp][lowat]") {
+  test::LoopbackPair pair;
+  TcpSocket moved = std::move(pair.server);
+  REQUIRE_THROWS_AS(pair.server.setReceiveLowWatermark(16), std::logic_error);
+  REQUIRE_THROWS_AS((void)pair.server.receiveLowWatermark(), std::logic_error);
+}
+
+#ifndef _WIN32
+
+namespace {
+
+bool readable(TcpSocket &socket, int timeout_ms) {
+  pollfd pfd{socket.native_handle(), POLLIN, 0};
+  return ::poll(&pfd, 1, timeout_ms) == 1 && (pfd.revents & POLLIN) != 0;
+}
+
+} // namespace
+
+TEST_CASE("TcpSocket receive low watermark round-trips", "[tcp][lowat]") {
+  test::LoopbackPair pair;
+  REQUIRE(pair.server.receiveLowWatermark() == 1);
+
+  pair.server.setReceiveLowWatermark(4096);
+  REQUIRE(pair.server.receiveLowWatermark() == 4096);
+
+  pair.server.setReceiveLowWatermark(0);
+  REQUIRE(pair.server.receiveLowWatermark() == 1);
+}
+
+TEST_CASE("Low watermark defers readability until enough is queued",
+          "[tcp][lowat]") {
+  test::LoopbackPair pair;
+  pair.server.setReceiveLowWatermark(1000);
+
+  pair.sendAll(400);
+  REQUIRE_FALSE(readable(pair.server, 50));
+
+  pair.sendAll(600);
+  REQUIRE(readable(pair.server, 1000));
+  REQUIRE(pair.server.availableBytes() == 1000);
+}
+
+TEST_CASE("Low watermark does not hide end of stream", "[tcp][lowat]") {
+  test::LoopbackPair pair;
+  pair.server.setReceiveLowWatermark(1000);
+  pair.sendAll(10);
+  pair.client.shutdown(TcpSocket::ShutdownType::Sending);
+  REQUIRE(readable(pair.server, 1000));
+}
+
+TEST_CASE("ScopedReceiveLowWatermark restores the previous value",
+          "[tcp][lowat]") {
+  test::LoopbackPair pair;
+  pair.server.setReceiveLowWatermark(8);
+  {
+    ScopedReceiveLowWatermark guard(pair.server, 512);
+    REQUIRE(guard.previous() == 8);
+    REQUIRE(pair.server.receiveLowWatermark() == 512);
+
+    pair.sendAll(200);
+    REQUIRE_FALSE(readable(pair.server, 50));
+
+    guard.update(200);
+    REQUIRE(readable(pair.server, 1000));
+  }
+  REQUIRE(pair.server.receiveLowWatermark() == 8);
+}
+
+#endif
@@ -0,0 +1,212 @@
+#include "catch2/catch_test_macros.hpp"
+#include "net/core/endpoint.h"
+#include "net/protocol/rudp/reliable_channel.h"
+#include "net/protocol/udp/udp_socket.h"
+#include <catch2/catch_all.hpp>
+#include <chrono>
+#include <cstdint>
+#include <vector>
+
+using namespace net;
+using namespace std::chrono_literals;
+
+namespace {
+
+/**
+ * Forwards datagrams between two channels on loopback, dropping a
+ * deterministic pseudo-random fraction in each direction.
+ */
+class LossyRelay {
+public:
+  explicit LossyRelay(unsigned drop_percent) : drop_percent_(drop_percent) {
+    for (auto *side : {&a_, &b_}) {
+      side->bind(Endpoint("127.0.0.1", 0));
+    }
+  }
+
+  Endpoint sideA() const { return a_.localEndpoint(); }
+  Endpoint sideB() const { return b_.localEndpoint(); }
+
+  void connect(const Endpoint &peer_a, const Endpoint &peer_b) {
+    peer_a_ = peer_a;
+    peer_b_ = peer_b;
+  }
+
+  void pump() {
+    forward(a_, b_, peer_b_);
+    forward(b_, a_, peer_a_);
+  }
+
+  std::size_t dropped() const { return dropped_; }
+
+private:
+  void forward(UdpSocket &from, UdpSocket &to, const Endpoint &destination) {
+    std::array<std::byte, 2048> buffer{};
+    for (;;) {
+      Endpoint sender;
+      std::size_t n;
+      try {
+        n = from.receiveFrom(buffer, sender);
+      } catch (const std::system_error &) {
+        return; // drained
+      }
+      state_ = state_ * 6364136223846793005ull + 1442695040888963407ull;
+      if ((state_ >> 33) % 100 < drop_percent_) {
+        ++dropped_;
+        continue;
+      }
+      (void)to.sendTo(std::span(buffer).first(n), destination);
+    }
+  }
+
+  unsigned drop_percent_;
+  std::uint64_t state_ = 42;
+  std::size_t dropped_ = 0;
+  UdpSocket a_{UdpSocket::AddressFamily::IPV4,
+               UdpSocket::BlockingType::NonBlocking};
+  UdpSocket b_{UdpSocket::AddressFamily::IPV4,
+               UdpSocket::BlockingType::NonBlocking};
+  Endpoint peer_a_;
+  Endpoint peer_b_;
+};
+
+std::vector<std::byte> make_message(std::size_t id, std::size_t size) {
+  std::vector<std::byte> message(size);
+  for (std::size_t i = 0; i < size; ++i) {
+    message[i] = static_cast<std::byte>((id * 31 + i) & 0xFF);
+  }
+  return message;
+}
+
+std::size_t message_id(const std::vector<std::byte> &message) {
+  // Invert make_message(): first byte is id * 31 mod 256.
+  for (std::size_t id = 0; id < 256; ++id) {
+    if (static_cast<std::byte>((id * 31) & 0xFF) == message.front()) {
+      return id;
+    }
+  }
+  return 256;
+}
+
+struct Harness {
+  explicit Harness(unsigned drop_percent,
+                   ReliableChannel::Delivery delivery =
+                       ReliableChannel::Delivery::Ordered)
+      : relay(drop_percent),
+        sender(Endpoint("127.0.0.1", 0), relay.sideA(), options(delivery)),
+        receiver(Endpoint("127.0.0.1", 0), relay.sideB(), options(delivery)) {
+    relay.connect(sender.localEndpoint(), receiver.localEndpoint());
+  }
+
+  static ReliableChannel::Options options(ReliableChannel::Delivery delivery) {
+    ReliableChannel::Options o;
+    o.delivery = delivery;
+    o.min_rto = 5ms;
+    o.initial_rto = 20ms;
+    o.max_rto = 200ms;
+    return o;
+  }
+
+  std::vector<std::vector<std::byte>> run(std::size_t expected) {
+    std::vector<std::vector<std::byte>> delivered;
+    const auto deadline = std::chrono::steady_clock::now() + 20s;
+    while ((delivered.size() < expected || !sender.idle()) &&
+           std::chrono::steady_clock::now() < deadline) {
+      sender.poll(0ms);
+      relay.pump();
+      receiver.poll(1ms);
+      relay.pump();
+      while (auto message = receiver.receive()) {
+        delivered.push_back(std::move(*message));
+      }
+    }
+    return delivered;
+  }
+
+  LossyRelay relay;
+  ReliableChannel sender;
+  ReliableChannel receiver;
+};
+
+} // namespace
+
+TEST_CASE("ReliableChannel rejects undersized datagrams", "[rudp]") {
+  ReliableChannel::Options options;
+  options.max_datagram = 8;
+  REQUIRE_THROWS_AS(ReliableChannel(Endpoint("127.0.0.1", 0),
+                                    Endpoint("127.0.0.1", 9), options),
+                    std::invalid_argument);
+}
+
+TEST_CASE("ReliableChannel delivers in order without loss", "[rudp]") {
+  Harness h(0);
+
+  for (std::size_t id = 0; id < 50; ++id) {
+    h.sender.send(make_message(id, 100));
+  }
+
+  auto delivered = h.run(50);
+  REQUIRE(delivered.size() == 50);
+  for (std::size_t id = 0; id < 50; ++id) {
+    REQUIRE(delivered[id] == make_message(id, 100));
+  }
+  REQUIRE(h.sender.idle());
+  REQUIRE(h.sender.stats().retransmissions == 0);
+}
+
+TEST_CASE("ReliableChannel recovers ordered delivery over a lossy relay",
+          "[rudp]") {
+  Harness h(20);
+
+  // Mix of single-datagram and fragmented messages.
+  for (std::size_t id = 0; id < 200; ++id) {
+    h.sender.send(make_message(id, id % 10 == 0 ? 5000 : 300));
+  }
+
+  auto delivered = h.run(200);
+  REQUIRE(delivered.size() == 200);
+  for (std::size_t id = 0; id < 200; ++id) {
+    REQUIRE(delivered[id] == make_message(id, id % 10 == 0 ? 5000 : 300));
+  }
+
+  REQUIRE(h.relay.dropped() > 0);
+  auto stats = h.sender.stats();
+  REQUIRE(stats.retransmissions > 0);
+  REQUIRE(stats.srtt > std::chrono::microseconds(0));
+  REQUIRE(h.receiver.stats().messages_delivered == 200);
+}
+
+TEST_CASE("ReliableChannel unordered mode delivers every message once",
+          "[rudp]") {
+  Harness h(20, ReliableChannel::Delivery::Unordered);
+
+  for (std::size_t id = 0; id < 200; ++id) {
+    h.sender.send(make_message(id, 200));
+  }
+
+  auto delivered = h.run(200);
+  REQUIRE(delivered.size() == 200);
+
+  std::vector<int> seen(200, 0);
+  bool reordered = false;
+  for (std::size_t i = 0; i < delivered.size(); ++i) {
+    auto id = message_id(delivered[i]);
+    REQUIRE(id < 200);
+    REQUIRE(delivered[i] == make_message(id, 200));
+    reordered |= id != i;
+    ++seen[id];
+  }
+  for (int count : seen) {
+    REQUIRE(count == 1);
+  }
+  // With 20% loss some messages overtake the ones being retransmitted.
+  REQUIRE(reordered);
+}
+
+TEST_CASE("ReliableChannel delivers empty messages", "[rudp]") {
+  Harness h(0);
+  h.sender.send({});
+  auto delivered = h.run(1);
+  REQUIRE(delivered.size() == 1);
+  REQUIRE(delivered.front().empty());
+}
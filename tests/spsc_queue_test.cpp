@@ -0,0 +1,62 @@
+#include "catch2/catch_test_macros.hpp"
+#include "net/detail/spsc_queue.h"
+#include <catch2/catch_all.hpp>
+#include <memory>
+#include <thread>
+
+using net::detail::SpscQueue;
+
+TEST_CASE("SpscQueue rounds capacity and reports full", "[spsc]") {
+  REQUIRE_THROWS_AS(SpscQueue<int>(0), std::invalid_argument);
+
+  SpscQueue<int> queue(3);
+  REQUIRE(queue.capacity() == 4);
+  REQUIRE(queue.empty());
+
+  for (int i = 0; i < 4; ++i) {
+    REQUIRE(queue.push(int{i}));
+  }
+  REQUIRE_FALSE(queue.push(99));
+
+  REQUIRE(queue.pop() == 0);
+  REQUIRE(queue.push(4));
+  for (int i = 1; i <= 4; ++i) {
+    REQUIRE(queue.pop() == i);
+  }
+  REQUIRE_FALSE(queue.pop().has_value());
+}
+
+TEST_CASE("SpscQueue leaves a rejected value untouched", "[spsc]") {
+  SpscQueue<std::unique_ptr<int>> queue(1);
+  REQUIRE(queue.push(std::make_unique<int>(1)));
+  auto second = std::make_unique<int>(2);
+  REQUIRE_FALSE(queue.push(std::move(second)));
+  REQUIRE(second != nullptr);
+  REQUIRE(*queue.pop().value() == 1);
+}
+
+TEST_CASE("SpscQueue transfers in order between threads", "[spsc]") {
+  constexpr int kCount = 200000;
+  SpscQueue<int> queue(64);
+
+  std::thread producer([&] {
+    for (int i = 0; i < kCount; ++i) {
+      while (!queue.push(int{i})) {
+        std::this_thread::yield();
+      }
+    }
+  });
+
+  bool ordered = true;
+  for (int expected = 0; expected < kCount;) {
+    if (auto value = queue.pop()) {
+      ordered = ordered && *value == expected;
+      ++expected;
+    } else {
+      std::this_thread::yield();
+    }
+  }
+  producer.join();
+  REQUIRE(ordered);
+  REQUIRE(queue.empty());
+}
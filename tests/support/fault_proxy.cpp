@@ -0,0 +1,346 @@
+#include "fault_proxy.h"
+
+#ifndef _WIN32
+
+#include "net/detail/platform_error.h"
+#include <algorithm>
+#include <array>
+#include <system_error>
+
+#include <sys/socket.h>
+
+namespace net::test {
+
+namespace {
+
+constexpr std::size_t kReadSize = 64 * 1024;
+/// Stop reading from a side once this much is waiting for the other.
+constexpr std::size_t kMaxQueued = 1024 * 1024;
+
+bool wouldBlock(const std::system_error &error) {
+  return detail::is_would_block(error.code().value());
+}
+
+void setAbortiveClose(TcpSocket &socket) {
+  linger option{1, 0};
+  ::setsockopt(socket.native_handle(), SOL_SOCKET, SO_LINGER, &option,
+               sizeof(option));
+}
+
+} // namespace
+
+FaultProxy::FaultProxy(const Endpoint &upstream, Options options)
+    : upstream_(upstream), options_(options), rng_(options.seed),
+      listener_(TcpSocket::AddressFamily::IPV4,
+                TcpSocket::BlockingType::NonBlocking),
+      acceptor_(listener_,
+                TcpAcceptor::Options{.raise_descriptor_limit = false}) {
+  listener_.bind(Endpoint("127.0.0.1", 0));
+  listener_.listen();
+  endpoint_ = listener_.localEndpoint();
+  loop_.add(listener_.native_handle(), EventLoop::Readable,
+            [this](unsigned) { onAccept(); }, "fault proxy accept");
+  thread_ = std::thread([this] { loop_.run(); });
+}
+
+FaultProxy::~FaultProxy() {
+  loop_.stop();
+  thread_.join();
+}
+
+void FaultProxy::setOptions(const Options &options) {
+  loop_.post([this, options] {
+    options_ = options;
+    rng_.seed(options.seed);
+  });
+}
+
+void FaultProxy::resetAll() {
+  loop_.post([this] {
+    std::vector<std::uint64_t> ids;
+    for (const auto &[id, session] : sessions_) {
+      ids.push_back(id);
+    }
+    for (std::uint64_t id : ids) {
+      closeSession(id, true);
+    }
+  });
+}
+
+FaultProxy::Stats FaultProxy::stats() const noexcept {
+  return {accepted_.load(), bytes_.load(), resets_.load(), active_.load(),
+          accept_errors_.load(), shed_.load()};
+}
+
+void FaultProxy::onAccept() {
+  for (;;) {
+    Endpoint peer;
+    std::optional<TcpSocket> accepted;
+    try {
+      accepted = acceptor_.accept(peer);
+    } catch (const std::system_error &) {
+      // An aborted handshake is dropped; the listener stays registered and
+      // is retried on the next readiness event.
+      ++accept_errors_;
+      return;
+    }
+    shed_ = acceptor_.stats().shed;
+    if (!accepted) {
+      return; // nothing pending, or shed on descriptor exhaustion
+    }
+    TcpSocket client = std::move(*accepted);
+
+    auto session = std::make_unique<Session>();
+    session->id = next_id_++;
+    session->client = std::move(client);
+    session->upstream =
+        TcpSocket(upstream_.data()->sa_family == AF_INET6
+                      ? TcpSocket::AddressFamily::IPV6
+                      : TcpSocket::AddressFamily::IPV4,
+                  TcpSocket::BlockingType::NonBlocking);
+    try {
+      session->upstream.connect(upstream_);
+    } catch (const std::system_error &) {
+      setAbortiveClose(session->client);
+      ++resets_;
+      continue;
+    }
+
+    Session &s = *session;
+    s.outbound.from = &s.client;
+    s.outbound.to = &s.upstream;
+    s.inbound.from = &s.upstream;
+    s.inbound.to = &s.client;
+
+    const std::uint64_t id = s.id;
+    loop_.add(s.client.native_handle(), EventLoop::Readable,
+              [this, id](unsigned events) { onEvents(id, true, events); },
+              "fault proxy client");
+    loop_.add(s.upstream.native_handle(), EventLoop::Readable,
+              [this, id](unsigned events) { onEvents(id, false, events); },
+              "fault proxy upstream");
+    sessions_.emplace(id, std::move(session));
+    ++accepted_;
+    ++active_;
+  }
+}
+
+void FaultProxy::onEvents(std::uint64_t id, bool client_side,
+                          unsigned events) {
+  auto found = sessions_.find(id);
+  if (found == sessions_.end()) {
+    return;
+  }
+  Session &session = *found->second;
+  // The socket that fired is the source of one direction and the
+  // destination of the other.
+  Direction &source = client_side ? session.outbound : session.inbound;
+  Direction &sink = client_side ? session.inbound : session.outbound;
+
+  if ((events & EventLoop::Writable) != 0) {
+    sink.blocked = false;
+    flush(session, sink);
+    if (!sessions_.contains(id)) {
+      return;
+    }
+  }
+  if ((events & (EventLoop::Hangup | EventLoop::Error)) != 0 && source.eof) {
+    // Hangup and error are reported regardless of interest; with nothing
+    // left to read they would fire on every wait.
+    closeSession(id, true);
+    return;
+  }
+  if ((events & (EventLoop::Readable | EventLoop::Hangup |
+                 EventLoop::Error)) != 0) {
+    readFrom(session, source);
+    if (!sessions_.contains(id)) {
+      return;
+    }
+  }
+  updateInterest(session);
+}
+
+FaultProxy::Clock::time_point FaultProxy::releaseTime(Direction &direction,
+                                                      std::size_t bytes) {
+  const auto now = Clock::now();
+  auto departed = now;
+  if (options_.bandwidth > 0) {
+    const auto start = std::max(now, direction.link_free);
+    direction.link_free =
+        start + std::chrono::duration_cast<Clock::duration>(
+                    std::chrono::duration<double>(
+                        static_cast<double>(bytes) /
+                        static_cast<double>(options_.bandwidth)));
+    departed = direction.link_free;
+  }
+
+  auto release = departed + options_.delay;
+  if (options_.jitter.count() > 0) {
+    std::uniform_int_distribution<std::int64_t> spread(
+        -options_.jitter.count(), options_.jitter.count());
+    release += std::chrono::microseconds(spread(rng_));
+  }
+  release = std::max({release, departed, direction.last_release});
+  direction.last_release = release;
+  return release;
+}
+
+void FaultProxy::readFrom(Session &session, Direction &direction) {
+  if (direction.eof || direction.queued >= kMaxQueued) {
+    return;
+  }
+
+  std::vector<std::byte> data(kReadSize);
+  std::size_t n = 0;
+  try {
+    n = direction.from->receive(data);
+  } catch (const std::system_error &error) {
+    if (!wouldBlock(error)) {
+      closeSession(session.id, true); // refused or reset: pass it on
+    }
+    return;
+  }
+
+  if (n == 0) {
+    direction.eof = true;
+    direction.queue.push_back({releaseTime(direction, 0), {}, 0, true});
+    schedule(session, direction);
+    return;
+  }
+
+  session.relayed += n;
+  std::bernoulli_distribution reset(
+      std::clamp(options_.reset_probability, 0.0, 1.0));
+  if ((options_.reset_after_bytes > 0 &&
+       session.relayed >= options_.reset_after_bytes) ||
+      (options_.reset_probability > 0 && reset(rng_))) {
+    closeSession(session.id, true);
+    return;
+  }
+
+  data.resize(n);
+  direction.queued += n;
+  direction.queue.push_back({releaseTime(direction, n), std::move(data)});
+  schedule(session, direction);
+}
+
+void FaultProxy::flush(Session &session, Direction &direction) {
+  const auto now = Clock::now();
+  while (!direction.queue.empty() && !direction.blocked &&
+         direction.queue.front().release <= now) {
+    Chunk &chunk = direction.queue.front();
+    if (chunk.fin) {
+      try {
+        direction.to->shutdown(TcpSocket::ShutdownType::Sending);
+      } catch (const std::system_error &) {
+        closeSession(session.id, true); // ENOTCONN: the peer reset first
+        return;
+      }
+      direction.fin_sent = true;
+      direction.queue.pop_front();
+      continue;
+    }
+
+    try {
+      const std::size_t sent = direction.to->send(
+          std::span<const std::byte>(chunk.data).subspan(chunk.offset));
+      chunk.offset += sent;
+      bytes_ += sent;
+    } catch (const std::system_error &error) {
+      if (!wouldBlock(error)) {
+        closeSession(session.id, true);
+        return;
+      }
+    }
+    if (chunk.offset < chunk.data.size()) {
+      direction.blocked = true; // resume when writable
+      break;
+    }
+    direction.queued -= chunk.data.size();
+    direction.queue.pop_front();
+  }
+
+  if (session.outbound.fin_sent && session.inbound.fin_sent) {
+    closeSession(session.id, false);
+    return;
+  }
+  schedule(session, direction);
+}
+
+void FaultProxy::schedule(Session &session, Direction &direction) {
+  if (direction.queue.empty() || direction.blocked) {
+    return;
+  }
+  const auto release = direction.queue.front().release;
+  if (direction.timer && direction.timer_at <= release) {
+    return;
+  }
+  if (direction.timer) {
+    loop_.cancel(*direction.timer);
+  }
+
+  const std::uint64_t id = session.id;
+  const bool outbound = &direction == &session.outbound;
+  direction.timer_at = release;
+  direction.timer = loop_.runAfter(
+      std::max(release - Clock::now(), Clock::duration::zero()),
+      [this, id, outbound] {
+        auto found = sessions_.find(id);
+        if (found == sessions_.end()) {
+          return;
+        }
+        Session &s = *found->second;
+        Direction &d = outbound ? s.outbound : s.inbound;
+        d.timer.reset();
+        flush(s, d);
+        if (sessions_.contains(id)) {
+          updateInterest(s);
+        }
+      },
+      "fault proxy release");
+}
+
+void FaultProxy::updateInterest(Session &session) {
+  auto interest = [](const Direction &out, const Direction &in) {
+    unsigned bits = 0;
+    if (!out.eof && out.queued < kMaxQueued) {
+      bits |= EventLoop::Readable;
+    }
+    if (in.blocked) {
+      bits |= EventLoop::Writable;
+    }
+    return bits;
+  };
+  loop_.modify(session.client.native_handle(),
+               interest(session.outbound, session.inbound));
+  loop_.modify(session.upstream.native_handle(),
+               interest(session.inbound, session.outbound));
+}
+
+void FaultProxy::closeSession(std::uint64_t id, bool reset) {
+  auto found = sessions_.find(id);
+  if (found == sessions_.end()) {
+    return;
+  }
+  Session &session = *found->second;
+  for (Direction *direction : {&session.outbound, &session.inbound}) {
+    if (direction->timer) {
+      loop_.cancel(*direction->timer);
+    }
+  }
+  loop_.remove(session.client.native_handle());
+  loop_.remove(session.upstream.native_handle());
+  if (reset) {
+    setAbortiveClose(session.client);
+    setAbortiveClose(session.upstream);
+  }
+  sessions_.erase(found);
+  --active_;
+  if (reset) {
+    ++resets_;
+  }
+}
+
+} // namespace net::test
+
+#endif
@@ -0,0 +1,157 @@
+#pragma once
+#include "net/core/endpoint.h"
+#include "net/core/event_loop.h"
+#include "net/protocol/tcp/tcp_acceptor.h"
+#include "net/protocol/tcp/tcp_socket.h"
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <optional>
+#include <random>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace net::test {
+
+/**
+ * @brief Loopback TCP proxy that injects delay, jitter, bandwidth limits and
+ * connection resets, for tests and benchmarks that need realistic network
+ * conditions without root or netem.
+ *
+ * Clients connect to endpoint(); each connection is relayed to `upstream`
+ * over a fresh connection. Both directions are shaped independently with
+ * the same options: every chunk read from one side is released to the
+ * other after `delay` plus a uniform jitter in [-jitter, +jitter], no
+ * earlier than the chunk before it (stream order is preserved), and no
+ * faster than `bandwidth` allows. Resets close both sides with RST.
+ *
+ * The proxy runs its own EventLoop thread. All public members are
+ * thread-safe.
+ *
+ * @note Available on POSIX platforms only.
+ */
+class FaultProxy {
+public:
+  /// Shaping applied to each direction of every connection.
+  struct Options {
+    std::chrono::microseconds delay{0};  ///< One-way latency
+    std::chrono::microseconds jitter{0}; ///< Uniform spread around delay
+    std::uint64_t bandwidth = 0;         ///< Bytes per second; 0 = unlimited
+    /// Chance that a chunk read from either side resets the connection.
+    double reset_probability = 0;
+    /// Reset a connection once it has relayed this many bytes (0 = never).
+    std::uint64_t reset_after_bytes = 0;
+    std::uint32_t seed = 1; ///< Seed for jitter and reset draws
+  };
+
+  /// Counters since construction.
+  struct Stats {
+    std::uint64_t accepted = 0;
+    std::uint64_t bytes = 0; ///< Bytes delivered in both directions
+    std::uint64_t resets = 0;
+    std::uint64_t active = 0; ///< Connections currently relayed
+    std::uint64_t accept_errors = 0; ///< Failed accepts, dropped
+    std::uint64_t shed = 0; ///< Closed at once: descriptors ran out
+  };
+
+  /**
+   * @brief Listen on an ephemeral loopback port and start relaying.
+   *
+   * @throws std::system_error if the listener cannot be created.
+   */
+  explicit FaultProxy(const Endpoint &upstream, Options options);
+
+  /// Proxy without faults (plain relay).
+  explicit FaultProxy(const Endpoint &upstream)
+      : FaultProxy(upstream, Options{}) {}
+
+  /// Stop the loop thread and close all connections.
+  ~FaultProxy();
+
+  FaultProxy(const FaultProxy &) = delete;
+  FaultProxy &operator=(const FaultProxy &) = delete;
+
+  /// Address clients should connect to.
+  [[nodiscard]] Endpoint endpoint() const { return endpoint_; }
+
+  /**
+   * @brief Change shaping; applies to data read after the call.
+   */
+  void setOptions(const Options &options);
+
+  /**
+   * @brief Reset every active connection.
+   */
+  void resetAll();
+
+  /// Counters since construction.
+  [[nodiscard]] Stats stats() const noexcept;
+
+private:
+  using Clock = EventLoop::Clock;
+
+  struct Chunk {
+    Clock::time_point release;
+    std::vector<std::byte> data;
+    std::size_t offset = 0;
+    bool fin = false; ///< Half-close marker, no data
+  };
+
+  /// One direction of a connection.
+  struct Direction {
+    TcpSocket *from = nullptr;
+    TcpSocket *to = nullptr;
+    std::deque<Chunk> queue;
+    std::size_t queued = 0;       ///< Bytes waiting in queue
+    Clock::time_point link_free;  ///< When the bandwidth limit frees up
+    Clock::time_point last_release;
+    std::optional<EventLoop::TimerId> timer;
+    Clock::time_point timer_at;
+    bool eof = false;      ///< Source has closed its side
+    bool fin_sent = false; ///< Shutdown forwarded to destination
+    bool blocked = false;  ///< Destination buffer full
+  };
+
+  struct Session {
+    std::uint64_t id = 0;
+    TcpSocket client;
+    TcpSocket upstream;
+    Direction outbound; ///< client -> upstream
+    Direction inbound;  ///< upstream -> client
+    std::uint64_t relayed = 0;
+  };
+
+  void onAccept();
+  void onEvents(std::uint64_t id, bool client_side, unsigned events);
+  void readFrom(Session &session, Direction &direction);
+  void flush(Session &session, Direction &direction);
+  void schedule(Session &session, Direction &direction);
+  void updateInterest(Session &session);
+  void closeSession(std::uint64_t id, bool reset);
+  Clock::time_point releaseTime(Direction &direction, std::size_t bytes);
+
+  Endpoint upstream_;
+  Options options_; ///< Loop thread only
+  std::mt19937 rng_;
+  EventLoop loop_;
+  TcpSocket listener_;
+  TcpAcceptor acceptor_; ///< Sheds instead of spinning on EMFILE
+  Endpoint endpoint_;
+  std::unordered_map<std::uint64_t, std::unique_ptr<Session>> sessions_;
+  std::uint64_t next_id_ = 1;
+
+  std::atomic<std::uint64_t> accepted_{0};
+  std::atomic<std::uint64_t> bytes_{0};
+  std::atomic<std::uint64_t> resets_{0};
+  std::atomic<std::uint64_t> active_{0};
+  std::atomic<std::uint64_t> accept_errors_{0};
+  std::atomic<std::uint64_t> shed_{0};
+
+  std::thread thread_;
+};
+
+} // namespace net::test
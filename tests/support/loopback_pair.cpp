@@ -0,0 +1,45 @@
+#include "loopback_pair.h"
+#include "net/core/endpoint.h"
+#include "net/detail/platform_error.h"
+#include <chrono>
+#include <span>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+namespace net::test {
+
+LoopbackPair::LoopbackPair(TcpSocket::BlockingType server_blocking) {
+  TcpSocket listener(TcpSocket::AddressFamily::IPV4, server_blocking);
+  listener.bind(Endpoint("127.0.0.1", 0));
+  listener.listen();
+  client.connect(listener.localEndpoint());
+
+  Endpoint peer;
+  for (;;) {
+    try {
+      server = listener.accept(peer);
+      return;
+    } catch (const std::system_error &error) {
+      if (!detail::is_would_block(error.code().value())) {
+        throw;
+      }
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+  }
+}
+
+void LoopbackPair::sendAll(std::size_t size, std::byte fill) {
+  const std::vector<std::byte> data(size, fill);
+  for (std::span<const std::byte> rest(data); !rest.empty();) {
+    rest = rest.subspan(client.send(rest));
+  }
+}
+
+void LoopbackPair::waitQueued(std::size_t size) {
+  while (server.availableBytes() < size) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+}
+
+} // namespace net::test
@@ -0,0 +1,28 @@
+#pragma once
+#include "net/protocol/tcp/tcp_socket.h"
+#include <cstddef>
+
+namespace net::test {
+
+/**
+ * @brief Connected IPv4 loopback TCP pair for tests.
+ *
+ * The client is blocking. The server side is accepted from a listener in
+ * `server_blocking` mode and inherits it, so a non-blocking pair can be
+ * registered with an EventLoop directly.
+ */
+struct LoopbackPair {
+  explicit LoopbackPair(TcpSocket::BlockingType server_blocking =
+                            TcpSocket::BlockingType::Blocking);
+
+  /// Send `size` copies of `fill` from the client.
+  void sendAll(std::size_t size, std::byte fill = std::byte{0x5A});
+
+  /// Wait until at least `size` bytes are queued on the server side.
+  void waitQueued(std::size_t size);
+
+  TcpSocket client;
+  TcpSocket server{TcpSocket::AddressFamily::IPV4};
+};
+
+} // namespace net::test
@@ -0,0 +1,53 @@
+#include "temp_file.h"
+
+#ifndef _WIN32
+
+#include <cerrno>
+#include <fstream>
+#include <iterator>
+#include <system_error>
+#include <utility>
+
+#include <unistd.h>
+
+namespace net::test {
+
+TempFile::TempFile(const std::string &prefix) {
+  std::string pattern = "/tmp/" + prefix + "_XXXXXX";
+  fd_ = ::mkstemp(pattern.data());
+  if (fd_ < 0) {
+    throw std::system_error(errno, std::generic_category(), "mkstemp failed");
+  }
+  path_ = std::move(pattern);
+}
+
+TempFile::~TempFile() {
+  ::close(fd_);
+  ::unlink(path_.c_str());
+}
+
+std::vector<std::uint8_t> TempFile::bytes() const {
+  std::ifstream in(path_, std::ios::binary);
+  return {std::istreambuf_iterator<char>(in),
+          std::istreambuf_iterator<char>()};
+}
+
+std::vector<std::string> TempFile::lines() const {
+  std::ifstream in(path_);
+  std::vector<std::string> result;
+  std::string line;
+  while (std::getline(in, line)) {
+    result.push_back(line);
+  }
+  return result;
+}
+
+void TempFile::write(const std::vector<std::uint8_t> &bytes) const {
+  std::ofstream out(path_, std::ios::binary | std::ios::trunc);
+  out.write(reinterpret_cast<const char *>(bytes.data()),
+            static_cast<std::streamsize>(bytes.size()));
+}
+
+} // namespace net::test
+
+#endif
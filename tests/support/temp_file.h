@@ -0,0 +1,42 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace net::test {
+
+/**
+ * @brief Empty file under /tmp, removed on destruction.
+ *
+ * The descriptor from mkstemp() stays open (read-write) until destruction,
+ * for code under test that writes to an fd.
+ *
+ * @note Available on POSIX platforms only.
+ */
+class TempFile {
+public:
+  /// Create `/tmp/<prefix>_XXXXXX`; throws std::system_error on failure.
+  explicit TempFile(const std::string &prefix = "netlib");
+  ~TempFile();
+
+  TempFile(const TempFile &) = delete;
+  TempFile &operator=(const TempFile &) = delete;
+
+  [[nodiscard]] const std::string &path() const noexcept { return path_; }
+  [[nodiscard]] int fd() const noexcept { return fd_; }
+
+  /// Current contents.
+  [[nodiscard]] std::vector<std::uint8_t> bytes() const;
+
+  /// Current contents split into lines, without the newlines.
+  [[nodiscard]] std::vector<std::string> lines() const;
+
+  /// Replace the contents.
+  void write(const std::vector<std::uint8_t> &bytes) const;
+
+private:
+  std::string path_;
+  int fd_ = -1;
+};
+
+} // namespace net::test
@@ -0,0 +1,133 @@
+#include "catch2/catch_test_macros.hpp"
+#include "net/core/endpoint.h"
+#include "net/protocol/tcp/tcp_acceptor.h"
+#include "net/protocol/tcp/tcp_socket.h"
+#include <catch2/catch_all.hpp>
+#include <vector>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/resource.h>
+#include <unistd.h>
+#endif
+
+using namespace net;
+
+namespace {
+
+TcpSocket makeListener(TcpSocket::BlockingType blocking) {
+  TcpSocket listener(TcpSocket::AddressFamily::IPV4, blocking);
+  listener.bind(Endpoint("127.0.0.1", 0));
+  listener.listen();
+  return listener;
+}
+
+} // namespace
+
+TEST_CASE("TcpAcceptor rejects an invalid listener", "[tcp][acceptor]") {
+  TcpSocket listener = makeListener(TcpSocket::BlockingType::NonBlocking);
+  TcpSocket moved = std::move(listener);
+  REQUIRE_THROWS_AS(TcpAcceptor(listener), std::logic_error);
+}
+
+TEST_CASE("TcpAcceptor accepts and reports would-block", "[tcp][acceptor]") {
+  TcpSocket listener = makeListener(TcpSocket::BlockingType::NonBlocking);
+  TcpAcceptor acceptor(listener, {.raise_descriptor_limit = false});
+#ifndef _WIN32
+  REQUIRE(acceptor.hasReserve());
+#endif
+
+  Endpoint peer;
+  REQUIRE_FALSE(acceptor.accept(peer).has_value());
+
+  TcpSocket client(TcpSocket::AddressFamily::IPV4);
+  client.connect(listener.localEndpoint());
+
+  std::optional<TcpSocket> server;
+  while (!server) {
+    server = acceptor.accept(peer);
+  }
+  REQUIRE(server->is_valid());
+  REQUIRE(server->blocking() == TcpSocket::BlockingType::NonBlocking);
+  REQUIRE(peer.port() == client.localEndpoint().port());
+  REQUIRE(acceptor.stats().accepted == 1);
+  REQUIRE(acceptor.stats().shed == 0);
+}
+
+#ifndef _WIN32
+
+TEST_CASE("raiseFileDescriptorLimit never lowers the limit",
+          "[tcp][acceptor]") {
+  rlimit before{};
+  REQUIRE(::getrlimit(RLIMIT_NOFILE, &before) == 0);
+
+  const std::size_t raised = raiseFileDescriptorLimit(1);
+  REQUIRE(raised >= static_cast<std::size_t>(before.rlim_cur));
+
+  rlimit after{};
+  REQUIRE(::getrlimit(RLIMIT_NOFILE, &after) == 0);
+  REQUIRE(after.rlim_cur >= before.rlim_cur);
+}
+
+TEST_CASE("TcpAcceptor sheds connections when descriptors run out",
+          "[tcp][acceptor]") {
+  TcpSocket listener = makeListener(TcpSocket::BlockingType::NonBlocking);
+  TcpAcceptor acceptor(listener, {.raise_descriptor_limit = false});
+
+  TcpSocket client(TcpSocket::AddressFamily::IPV4);
+  client.connect(listener.localEndpoint());
+
+  rlimit saved{};
+  REQUIRE(::getrlimit(RLIMIT_NOFILE, &saved) == 0);
+
+  // Lower the soft limit to just above what is open, then use up the rest.
+  int highest = ::open("/dev/null", O_RDONLY);
+  REQUIRE(highest >= 0);
+  ::close(highest);
+  rlimit tight = saved;
+  tight.rlim_cur = static_cast<rlim_t>(highest + 16);
+  REQUIRE(::setrlimit(RLIMIT_NOFILE, &tight) == 0);
+
+  std::vector<int> filler;
+  for (int fd; (fd = ::open("/dev/null", O_RDONLY)) >= 0;) {
+    filler.push_back(fd);
+  }
+
+  Endpoint peer;
+  std::optional<TcpSocket> server;
+  for (int i = 0; i < 1000 && acceptor.stats().shed == 0; ++i) {
+    server = acceptor.accept(peer);
+    REQUIRE_FALSE(server.has_value());
+  }
+
+  const auto stats = acceptor.stats();
+  for (int fd : filler) {
+    ::close(fd);
+  }
+  REQUIRE(::setrlimit(RLIMIT_NOFILE, &saved) == 0);
+
+  REQUIRE(stats.exhausted >= 1);
+  REQUIRE(stats.shed == 1);
+  REQUIRE(stats.reserve_failures == 0);
+  REQUIRE(acceptor.hasReserve());
+
+  // The shed client observes the connection closing.
+  std::vector<std::byte> buffer(16);
+  std::size_t received = 1;
+  try {
+    received = client.receive(buffer);
+  } catch (const std::system_error &) {
+    received = 0; // ECONNRESET is an acceptable way to be shed
+  }
+  REQUIRE(received == 0);
+
+  // With descriptors available again, accepting proceeds normally.
+  TcpSocket second(TcpSocket::AddressFamily::IPV4);
+  second.connect(listener.localEndpoint());
+  while (!server) {
+    server = acceptor.accept(peer);
+  }
+  REQUIRE(acceptor.stats().accepted == 1);
+}
+
+#endif
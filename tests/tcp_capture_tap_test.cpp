@@ -0,0 +1,384 @@
+#include "catch2/catch_test_macros.hpp"
+
+#ifndef _WIN32
+
+#include "net/core/endpoint.h"
+#include "net/core/pcapng_writer.h"
+#include "net/protocol/tcp/tcp_capture_tap.h"
+#include "net/protocol/tcp/tcp_socket.h"
+#include "support/temp_file.h"
+#include <catch2/catch_all.hpp>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <unistd.h>
+
+using namespace net;
+
+namespace {
+
+struct Packet {
+  std::uint64_t timestamp = 0;
+  std::uint32_t original_length = 0;
+  std::vector<std::uint8_t> data;
+};
+
+struct Capture {
+  std::uint16_t link_type = 0;
+  std::uint32_t snap_length = 0;
+  std::vector<Packet> packets;
+};
+
+std::uint32_t host32(const std::uint8_t *p) {
+  std::uint32_t value;
+  std::memcpy(&value, p, sizeof(value));
+  return value;
+}
+
+std::uint16_t host16(const std::uint8_t *p) {
+  std::uint16_t value;
+  std::memcpy(&value, p, sizeof(value));
+  return value;
+}
+
+std::uint16_t net16(const std::uint8_t *p) {
+  return static_cast<std::uint16_t>((p[0] << 8) | p[1]);
+}
+
+std::uint32_t net32(const std::uint8_t *p) {
+  return (static_cast<std::uint32_t>(net16(p)) << 16) | net16(p + 2);
+}
+
+/// Walk the blocks of a host-endian pcapng file, checking their framing.
+Capture parse(const std::vector<std::uint8_t> &file) {
+  Capture capture;
+  std::size_t offset = 0;
+  bool saw_section = false;
+  bool saw_interface = false;
+  while (offset < file.size()) {
+    REQUIRE(file.size() - offset >= 12);
+    const std::uint8_t *block = file.data() + offset;
+    const std::uint32_t type = host32(block);
+    const std::uint32_t length = host32(block + 4);
+    REQUIRE(length % 4 == 0);
+    REQUIRE(length <= file.size() - offset);
+    REQUIRE(host32(block + length - 4) == length);
+
+    if (type == 0x0A0D0D0A) {
+      REQUIRE(host32(block + 8) == 0x1A2B3C4D);
+      REQUIRE(host16(block + 12) == 1);
+      saw_section = true;
+    } else if (type == 1) {
+      capture.link_type = host16(block + 8);
+      capture.snap_length = host32(block + 12);
+      REQUIRE(host16(block + 16) == 9); // if_tsresol
+      REQUIRE(block[20] == 9);          // nanoseconds
+      saw_interface = true;
+    } else if (type == 6) {
+      REQUIRE(saw_interface);
+      Packet packet;
+      packet.timestamp =
+          (static_cast<std::uint64_t>(host32(block + 12)) << 32) |
+          host32(block + 16);
+      const std::uint32_t captured = host32(block + 20);
+      packet.original_length = host32(block + 24);
+      REQUIRE(28 + captured + 4 <= length);
+      packet.data.assign(block + 28, block + 28 + captured);
+      capture.packets.push_back(std::move(packet));
+    } else {
+      FAIL("unexpected block type " << type);
+    }
+    offset += length;
+  }
+  REQUIRE(saw_section);
+  return capture;
+}
+
+/// Decoded view of a synthesized TCP/IP packet.
+struct Segment {
+  int version = 0;
+  std::vector<std::uint8_t> source;
+  std::vector<std::uint8_t> destination;
+  std::uint16_t source_port = 0;
+  std::uint16_t destination_port = 0;
+  std::uint32_t seq = 0;
+  std::uint32_t ack = 0;
+  std::uint8_t flags = 0;
+  std::string payload;
+};
+
+Segment decode(const Packet &packet) {
+  const auto &d = packet.data;
+  Segment segment;
+  segment.version = d.at(0) >> 4;
+  std::size_t tcp = 0;
+  if (segment.version == 4) {
+    REQUIRE(net16(&d[2]) == d.size());
+    REQUIRE(d[9] == 6);
+    // A correct header checksums to zero.
+    std::uint32_t sum = 0;
+    for (std::size_t i = 0; i < 20; i += 2) {
+      sum += net16(&d[i]);
+    }
+    while ((sum >> 16) != 0) {
+      sum = (sum & 0xFFFF) + (sum >> 16);
+    }
+    REQUIRE(sum == 0xFFFF);
+    segment.source.assign(d.begin() + 12, d.begin() + 16);
+    segment.destination.assign(d.begin() + 16, d.begin() + 20);
+    tcp = 20;
+  } else {
+    REQUIRE(segment.version == 6);
+    REQUIRE(net16(&d[4]) + 40u == d.size());
+    REQUIRE(d[6] == 6);
+    segment.source.assign(d.begin() + 8, d.begin() + 24);
+    segment.destination.assign(d.begin() + 24, d.begin() + 40);
+    tcp = 40;
+  }
+  segment.source_port = net16(&d[tcp]);
+  segment.destination_port = net16(&d[tcp + 2]);
+  segment.seq = net32(&d[tcp + 4]);
+  segment.ack = net32(&d[tcp + 8]);
+  REQUIRE((d[tcp + 12] >> 4) == 5);
+  segment.flags = d[tcp + 13];
+  segment.payload.assign(d.begin() + static_cast<std::ptrdiff_t>(tcp + 20),
+                         d.end());
+  return segment;
+}
+
+std::span<const std::byte> asBytes(const std::string &text) {
+  return std::as_bytes(std::span(text.data(), text.size()));
+}
+
+constexpr std::uint8_t syn = 0x02;
+constexpr std::uint8_t psh_ack = 0x18;
+constexpr std::uint8_t ack = 0x10;
+
+} // namespace
+
+TEST_CASE("PcapngWriter frames packets and drops what does not fit",
+          "[pcapng]") {
+  test::TempFile file("netlib_capture");
+  {
+    PcapngWriter writer(file.path(), {.capacity = 28 + 32 + 2 * 40,
+                                      .snap_length = 6});
+    const std::string first = "abcd";
+    const std::string second = "0123456789"; // truncated to snap_length
+    const std::string third = "x";
+
+    REQUIRE(writer.write(asBytes(first), {}, 0x0000000100000002));
+    REQUIRE(writer.write(asBytes(second).first(3), asBytes(second).subspan(3),
+                         7));
+    REQUIRE_FALSE(writer.write(asBytes(third))); // only 4 bytes left
+
+    const auto stats = writer.stats();
+    REQUIRE(stats.packets == 2);
+    REQUIRE(stats.dropped == 1);
+    REQUIRE(stats.bytes == 28 + 32 + 36 + 40);
+  }
+
+  const auto bytes = file.bytes();
+  REQUIRE(bytes.size() == 28 + 32 + 36 + 40); // truncated to the used size
+  const Capture capture = parse(bytes);
+  REQUIRE(capture.link_type == PcapngWriter::link_type);
+  REQUIRE(capture.snap_length == 6);
+  REQUIRE(capture.packets.size() == 2);
+  REQUIRE(capture.packets[0].timestamp == 0x0000000100000002);
+  REQUIRE(std::string(capture.packets[0].data.begin(),
+                      capture.packets[0].data.end()) == "abcd");
+  REQUIRE(capture.packets[1].timestamp == 7);
+  REQUIRE(capture.packets[1].original_length == 10);
+  REQUIRE(std::string(capture.packets[1].data.begin(),
+                      capture.packets[1].data.end()) == "012345");
+}
+
+TEST_CASE("PcapngWriter rejects unusable options", "[pcapng]") {
+  test::TempFile file("netlib_capture");
+  REQUIRE_THROWS_AS(PcapngWriter(file.path(), {.capacity = 16}),
+                    std::invalid_argument);
+  REQUIRE_THROWS_AS(PcapngWriter(file.path(), {.snap_length = 0}),
+                    std::invalid_argument);
+  REQUIRE_THROWS_AS(PcapngWriter("/nonexistent-dir/capture.pcapng"),
+                    std::system_error);
+}
+
+TEST_CASE("PcapngWriter accepts concurrent writers", "[pcapng]") {
+  test::TempFile file("netlib_capture");
+  constexpr int threads = 4;
+  constexpr int per_thread = 2000;
+  {
+    PcapngWriter writer(file.path());
+    std::atomic<int> failures{0};
+    std::vector<std::thread> workers;
+    for (int t = 0; t < threads; ++t) {
+      workers.emplace_back([&writer, &failures, t] {
+        std::vector<std::byte> packet(1 + t * 3, std::byte(t));
+        for (int i = 0; i < per_thread; ++i) {
+          if (!writer.write(packet)) {
+            ++failures;
+          }
+        }
+      });
+    }
+    for (auto &worker : workers) {
+      worker.join();
+    }
+    REQUIRE(failures == 0);
+    REQUIRE(writer.stats().packets == threads * per_thread);
+  }
+
+  const Capture capture = parse(file.bytes());
+  REQUIRE(capture.packets.size() == threads * per_thread);
+  std::vector<int> seen(threads, 0);
+  for (const Packet &packet : capture.packets) {
+    const int t = packet.data.at(0);
+    REQUIRE(t < threads);
+    REQUIRE(packet.data.size() == static_cast<std::size_t>(1 + t * 3));
+    for (std::uint8_t byte : packet.data) {
+      REQUIRE(byte == t);
+    }
+    ++seen[t];
+  }
+  for (int count : seen) {
+    REQUIRE(count == per_thread);
+  }
+}
+
+TEST_CASE("TcpCaptureTap records what a socket sent and received",
+          "[pcapng][tcp]") {
+  test::TempFile file("netlib_capture");
+  Endpoint local;
+  Endpoint remote;
+  {
+    auto writer = std::make_shared<PcapngWriter>(file.path());
+
+    TcpSocket listener;
+    listener.bind(Endpoint("127.0.0.1", 0));
+    listener.listen();
+    TcpSocket client;
+    client.connect(listener.localEndpoint());
+    Endpoint peer;
+    TcpSocket server = listener.accept(peer);
+
+    local = client.localEndpoint();
+    remote = client.remoteEndpoint();
+    REQUIRE(remote.port() == listener.localEndpoint().port());
+    REQUIRE(peer.port() == local.port());
+
+    auto tap = TcpCaptureTap::attach(client, writer);
+    REQUIRE(client.tap() == tap.get());
+    REQUIRE(server.tap() == nullptr);
+
+    const std::string request = "GET / HTTP/1.1\r\n\r\n";
+    REQUIRE(client.send(asBytes(request)) == request.size());
+    std::array<std::byte, 64> buffer{};
+    REQUIRE(server.receive(buffer) == request.size());
+
+    const std::string response = "HTTP/1.1 204 No Content\r\n\r\n";
+    REQUIRE(server.send(asBytes(response)) == response.size());
+    std::size_t received = 0;
+    while (received < response.size()) {
+      received += client.receive(std::span(buffer).subspan(received));
+    }
+
+    // Untapped traffic on the other socket is not recorded twice.
+    REQUIRE(writer->stats().packets == 5);
+  }
+
+  const Capture capture = parse(file.bytes());
+  REQUIRE(capture.packets.size() == 5);
+  std::vector<Segment> segments;
+  for (const Packet &packet : capture.packets) {
+    segments.push_back(decode(packet));
+  }
+
+  const std::vector<std::uint8_t> loopback{127, 0, 0, 1};
+  for (const Segment &segment : segments) {
+    REQUIRE(segment.version == 4);
+    REQUIRE(segment.source == loopback);
+    REQUIRE(segment.destination == loopback);
+  }
+
+  // Handshake initiated by the local side.
+  REQUIRE(segments[0].flags == syn);
+  REQUIRE(segments[0].source_port == local.port());
+  REQUIRE(segments[1].flags == (syn | ack));
+  REQUIRE(segments[1].source_port == remote.port());
+  REQUIRE(segments[1].ack == 1);
+  REQUIRE(segments[2].flags == ack);
+
+  REQUIRE(segments[3].flags == psh_ack);
+  REQUIRE(segments[3].source_port == local.port());
+  REQUIRE(segments[3].destination_port == remote.port());
+  REQUIRE(segments[3].seq == 1);
+  REQUIRE(segments[3].ack == 1);
+  REQUIRE(segments[3].payload == "GET / HTTP/1.1\r\n\r\n");
+
+  REQUIRE(segments[4].source_port == remote.port());
+  REQUIRE(segments[4].seq == 1);
+  REQUIRE(segments[4].ack == 1 + segments[3].payload.size());
+  REQUIRE(segments[4].payload == "HTTP/1.1 204 No Content\r\n\r\n");
+}
+
+TEST_CASE("TcpCaptureTap splits large payloads and supports IPv6",
+          "[pcapng][tcp]") {
+  test::TempFile file("netlib_capture");
+  {
+    auto writer = std::make_shared<PcapngWriter>(file.path());
+    TcpCaptureTap tap(writer, Endpoint("::1", 40000), Endpoint("::1", 80),
+                      {.handshake = false});
+
+    std::vector<std::byte> large(TcpCaptureTap::max_segment + 100);
+    for (std::size_t i = 0; i < large.size(); ++i) {
+      large[i] = static_cast<std::byte>(i % 251);
+    }
+    tap.onReceive(large);
+    tap.onSend(asBytes(std::string("ok")));
+  }
+
+  const Capture capture = parse(file.bytes());
+  REQUIRE(capture.packets.size() == 3);
+  const Segment first = decode(capture.packets[0]);
+  const Segment second = decode(capture.packets[1]);
+  const Segment reply = decode(capture.packets[2]);
+
+  REQUIRE(first.version == 6);
+  REQUIRE(first.source_port == 80);
+  REQUIRE(first.destination_port == 40000);
+  REQUIRE(first.seq == 0);
+  REQUIRE(first.payload.size() == TcpCaptureTap::max_segment);
+  REQUIRE(second.seq == TcpCaptureTap::max_segment);
+  REQUIRE(second.payload.size() == 100);
+  REQUIRE(static_cast<std::uint8_t>(second.payload[0]) ==
+          TcpCaptureTap::max_segment % 251);
+
+  REQUIRE(reply.source_port == 40000);
+  REQUIRE(reply.seq == 0);
+  REQUIRE(reply.ack == TcpCaptureTap::max_segment + 100);
+  REQUIRE(reply.payload == "ok");
+}
+
+TEST_CASE("TcpCaptureTap rejects mismatched endpoints", "[pcapng][tcp]") {
+  test::TempFile file("netlib_capture");
+  auto writer = std::make_shared<PcapngWriter>(file.path());
+  REQUIRE_THROWS_AS(TcpCaptureTap(writer, Endpoint("127.0.0.1", 1),
+                                  Endpoint("::1", 2)),
+                    std::invalid_argument);
+  REQUIRE_THROWS_AS(TcpCaptureTap(nullptr, Endpoint("127.0.0.1", 1),
+                                  Endpoint("127.0.0.1", 2)),
+                    std::invalid_argument);
+
+  TcpSocket unconnected;
+  REQUIRE_THROWS_AS(TcpCaptureTap::attach(unconnected, writer),
+                    std::system_error);
+}
+
+#endif
@@ -0,0 +1,236 @@
+#include "catch2/catch_test_macros.hpp"
+
+#ifndef _WIN32
+
+#include "net/core/endpoint.h"
+#include "net/core/event_loop.h"
+#include "net/detail/io_uring.h"
+#include "net/protocol/tcp/tcp_file_sender.h"
+#include "net/protocol/tcp/tcp_socket.h"
+#include "support/loopback_pair.h"
+#include "support/temp_file.h"
+#include <catch2/catch_all.hpp>
+#include <future>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <vector>
+
+#include <sys/socket.h>
+#include <unistd.h>
+
+using namespace net;
+using namespace std::chrono_literals;
+
+namespace {
+
+/// Temporary file filled with a position-dependent pattern.
+class PatternFile {
+public:
+  explicit PatternFile(std::size_t size)
+      : file_("netlib_file_sender"), contents_(size) {
+    for (std::size_t i = 0; i < size; ++i) {
+      contents_[i] = static_cast<std::byte>((i * 131 + i / 977) & 0xff);
+    }
+    REQUIRE(::write(file_.fd(), contents_.data(), size) ==
+            static_cast<ssize_t>(size));
+  }
+
+  [[nodiscard]] int fd() const { return file_.fd(); }
+  [[nodiscard]] const std::vector<std::byte> &contents() const {
+    return contents_;
+  }
+
+private:
+  test::TempFile file_;
+  std::vector<std::byte> contents_;
+};
+
+/// Read from `socket` until the peer closes.
+std::future<std::vector<std::byte>> receiveAll(TcpSocket &socket) {
+  return std::async(std::launch::async, [&socket] {
+    std::vector<std::byte> received;
+    std::array<std::byte, 16 * 1024> buffer{};
+    std::size_t n = 0;
+    while ((n = socket.receive(buffer)) > 0) {
+      received.insert(received.end(), buffer.begin(), buffer.begin() + n);
+    }
+    return received;
+  });
+}
+
+std::vector<std::byte> slice(const std::vector<std::byte> &data,
+                             std::size_t offset, std::size_t length) {
+  return {data.begin() + static_cast<std::ptrdiff_t>(offset),
+          data.begin() + static_cast<std::ptrdiff_t>(offset + length)};
+}
+
+} // namespace
+
+TEST_CASE("IoUring completes a no-op", "[io_uring]") {
+  if (!detail::IoUring::available()) {
+    SUCCEED("io_uring unavailable");
+    return;
+  }
+  detail::IoUring ring(4);
+  REQUIRE(ring.fd() >= 0);
+  REQUIRE(ring.space() >= 4);
+  ring.prepareNop(42);
+  REQUIRE(ring.space() == 3);
+  REQUIRE(ring.submit(1) == 1);
+  auto completion = ring.peek();
+  REQUIRE(completion.has_value());
+  REQUIRE(completion->user_data == 42);
+  REQUIRE(completion->result == 0);
+  REQUIRE_FALSE(ring.peek().has_value());
+}
+
+TEST_CASE("TcpFileSender rejects invalid options", "[tcp][file_sender]") {
+  TcpSocket socket;
+  REQUIRE_THROWS_AS(TcpFileSender(socket, {.chunk_size = 0}),
+                    std::invalid_argument);
+  REQUIRE_THROWS_AS(TcpFileSender(socket, {.chain_length = 0}),
+                    std::invalid_argument);
+  REQUIRE_THROWS_AS(TcpFileSender(socket, {.chain_length = 4096}),
+                    std::invalid_argument);
+}
+
+TEST_CASE("TcpFileSender streams a file region in order",
+          "[tcp][file_sender]") {
+  const bool use_io_uring = GENERATE(true, false);
+  PatternFile file(1024 * 1024 + 123);
+  test::LoopbackPair pair;
+  auto received = receiveAll(pair.client);
+
+  TcpFileSender sender(pair.server, {.chunk_size = 16 * 1024,
+                                     .chain_length = 4,
+                                     .use_io_uring = use_io_uring});
+  REQUIRE(sender.usingIoUring() ==
+          (use_io_uring && detail::IoUring::available()));
+  REQUIRE((sender.completionHandle() >= 0) == sender.usingIoUring());
+
+  const std::size_t offset = 4099;
+  const std::size_t length = 700 * 1024 + 5;
+  REQUIRE(sender.sendFile(file.fd(), offset, length) == length);
+  REQUIRE_FALSE(sender.busy());
+  pair.server.close();
+
+  REQUIRE(received.get() == slice(file.contents(), offset, length));
+  auto stats = sender.stats();
+  REQUIRE(stats.bytes_sent == length);
+  REQUIRE(stats.bytes_read >= length);
+  if (sender.usingIoUring()) {
+    // 16K chunks, four per chain.
+    REQUIRE(stats.chains >= (length + 64 * 1024 - 1) / (64 * 1024));
+  }
+}
+
+TEST_CASE("TcpFileSender stops at end of file", "[tcp][file_sender]") {
+  const bool use_io_uring = GENERATE(true, false);
+  PatternFile file(50 * 1000);
+  test::LoopbackPair pair;
+  auto received = receiveAll(pair.client);
+
+  TcpFileSender sender(pair.server, {.chunk_size = 8 * 1024,
+                                     .use_io_uring = use_io_uring});
+  REQUIRE(sender.sendFile(file.fd(), 60 * 1000, 10) == 0);
+  REQUIRE(sender.sendFile(file.fd(), 1000, 1 << 30) == 49 * 1000);
+  pair.server.close();
+  REQUIRE(received.get() == slice(file.contents(), 1000, 49 * 1000));
+}
+
+TEST_CASE("TcpFileSender is driven by an EventLoop", "[tcp][file_sender]") {
+  PatternFile file(300 * 1024);
+  test::LoopbackPair pair;
+  auto received = receiveAll(pair.client);
+
+  TcpFileSender sender(pair.server, {.chunk_size = 32 * 1024});
+  if (!sender.usingIoUring()) {
+    SUCCEED("io_uring unavailable");
+    pair.server.close();
+    return;
+  }
+
+  EventLoop loop;
+  sender.start(file.fd(), 0, file.contents().size());
+  REQUIRE(sender.busy());
+  REQUIRE_THROWS_AS(sender.start(file.fd(), 0, 1), std::logic_error);
+
+  bool done = false;
+  loop.add(sender.completionHandle(), EventLoop::Readable, [&](unsigned) {
+    if (sender.advance()) {
+      done = true;
+      loop.remove(sender.completionHandle());
+    }
+  });
+  const auto deadline = std::chrono::steady_clock::now() + 5s;
+  while (!done && std::chrono::steady_clock::now() < deadline) {
+    loop.runOnce(50ms);
+  }
+  REQUIRE(done);
+  REQUIRE(sender.sent() == file.contents().size());
+  pair.server.close();
+  REQUIRE(received.get() == file.contents());
+}
+
+TEST_CASE("TcpFileSender fallback resumes on a non-blocking socket",
+          "[tcp][file_sender]") {
+  PatternFile file(4 * 1024 * 1024);
+  test::LoopbackPair pair(TcpSocket::BlockingType::NonBlocking);
+  // Small buffers so the transfer cannot fit in them.
+  const int small = 64 * 1024;
+  ::setsockopt(pair.server.native_handle(), SOL_SOCKET, SO_SNDBUF, &small,
+               sizeof(small));
+  ::setsockopt(pair.client.native_handle(), SOL_SOCKET, SO_RCVBUF, &small,
+               sizeof(small));
+
+  TcpFileSender sender(pair.server, {.use_io_uring = false});
+  REQUIRE(sender.completionHandle() == -1);
+
+  // Nobody reads yet, so the send buffer fills and advance() must return
+  // without throwing.
+  sender.start(file.fd(), 0, file.contents().size());
+  bool done = false;
+  for (int i = 0; i < 1000 && !done; ++i) {
+    done = sender.advance();
+  }
+  REQUIRE_FALSE(done);
+  REQUIRE(sender.busy());
+
+  auto received = receiveAll(pair.client);
+  EventLoop loop;
+  loop.add(pair.server.native_handle(), EventLoop::Writable, [&](unsigned) {
+    if (sender.advance()) {
+      done = true;
+      loop.remove(pair.server.native_handle());
+    }
+  });
+  const auto deadline = std::chrono::steady_clock::now() + 5s;
+  while (!done && std::chrono::steady_clock::now() < deadline) {
+    loop.runOnce(50ms);
+  }
+  REQUIRE(done);
+
+  // sendFile() waits for writability itself.
+  REQUIRE(sender.sendFile(file.fd(), 0, 1024 * 1024) == 1024 * 1024);
+  pair.server.close();
+
+  std::vector<std::byte> expected = file.contents();
+  const auto head = slice(file.contents(), 0, 1024 * 1024);
+  expected.insert(expected.end(), head.begin(), head.end());
+  REQUIRE(received.get() == expected);
+}
+
+TEST_CASE("TcpFileSender reports a closed peer", "[tcp][file_sender]") {
+  const bool use_io_uring = GENERATE(true, false);
+  PatternFile file(4 * 1024 * 1024);
+  test::LoopbackPair pair;
+  pair.client.close();
+
+  TcpFileSender sender(pair.server, {.use_io_uring = use_io_uring});
+  REQUIRE_THROWS_AS(sender.sendFile(file.fd(), 0, file.contents().size()),
+                    std::system_error);
+  REQUIRE_FALSE(sender.busy());
+}
+
+#endif
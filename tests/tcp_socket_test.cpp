@@ -192,3 +192,83 @@ TEST_CASE("TcpSocket invalid operations throw", "[tcp]") {
   REQUIRE_THROWS(sock.receive(buf));
   REQUIRE_THROWS(sock.shutdown(net::detail::SocketFlags::ShutdownType::Both));
 }
+
+TEST_CASE("TcpSocket rejects non-stream protocols", "[tcp]") {
+  using namespace net;
+
+  REQUIRE_THROWS_AS(TcpSocket(detail::SocketFlags::AddressFamily::IPV4,
+                              detail::SocketFlags::BlockingType::Blocking,
+                              detail::SocketFlags::InheritableType::Inheritable,
+                              detail::SocketFlags::ProtocolType::UDP),
+                    std::invalid_argument);
+}
+
+TEST_CASE("TcpSocket MPTCP connects or falls back to TCP", "[tcp][mptcp]") {
+  using namespace net;
+  using Flags = detail::SocketFlags;
+
+  TcpSocket server(Flags::AddressFamily::IPV4, Flags::BlockingType::Blocking,
+                   Flags::InheritableType::Inheritable,
+                   Flags::ProtocolType::MPTCP);
+
+  server.bind(Endpoint("127.0.0.1", 0));
+  server.listen();
+  Endpoint bound = server.localEndpoint();
+
+  std::thread server_thread([&] {
+    Endpoint peer;
+    TcpSocket conn = server.accept(peer);
+    REQUIRE(conn.protocol_type() == server.protocol_type());
+
+    std::array<std::byte, 4> buffer{};
+    std::size_t total = 0;
+    while (total < buffer.size()) {
+      auto n = conn.receive(std::span(buffer).subspan(total));
+      REQUIRE(n > 0);
+      total += n;
+    }
+    REQUIRE(conn.send(buffer) == buffer.size());
+  });
+
+  TcpSocket client(Flags::AddressFamily::IPV4, Flags::BlockingType::Blocking,
+                   Flags::InheritableType::Inheritable,
+                   Flags::ProtocolType::MPTCP);
+
+  // Originate from another loopback address than the listener's. Only the
+  // data exchange is checked: it must work whether the kernel negotiates
+  // MPTCP or falls back to plain TCP (no MPTCP support, or no endpoint
+  // configured for extra subflows).
+#ifdef __linux__
+  client.bind(Endpoint("127.0.0.2", 0));
+#endif
+  client.connect(bound);
+
+  std::array<std::byte, 4> ping{std::byte{'p'}, std::byte{'i'}, std::byte{'n'},
+                                std::byte{'g'}};
+  REQUIRE(client.send(ping) == ping.size());
+
+  std::array<std::byte, 4> pong{};
+  std::size_t total = 0;
+  while (total < pong.size()) {
+    auto n = client.receive(std::span(pong).subspan(total));
+    REQUIRE(n > 0);
+    total += n;
+  }
+  REQUIRE(pong == ping);
+
+  if (client.isMultipath()) {
+    MptcpInfo info = client.multipathInfo();
+    REQUIRE_FALSE(info.fallback);
+
+    auto flows = client.subflows();
+    REQUIRE_FALSE(flows.empty());
+    REQUIRE(flows.front().remote.port() == bound.port());
+    REQUIRE(flows.front().local.to_string().starts_with("127.0.0.2"));
+  } else {
+    // Kernel without MPTCP: the socket degraded to plain TCP.
+    REQUIRE(client.protocol_type() == Flags::ProtocolType::TCP);
+    REQUIRE_THROWS_AS(client.multipathInfo(), std::logic_error);
+  }
+
+  server_thread.join();
+}
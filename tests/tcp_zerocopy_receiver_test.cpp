@@ -0,0 +1,82 @@
+#include "catch2/catch_test_macros.hpp"
+#include "net/core/endpoint.h"
+#include "net/protocol/tcp/tcp_socket.h"
+#include "net/protocol/tcp/tcp_zerocopy_receiver.h"
+#include <catch2/catch_all.hpp>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+using namespace net;
+
+namespace {
+
+std::byte pattern(std::size_t i) {
+  return static_cast<std::byte>((i * 7 + (i >> 12)) & 0xFF);
+}
+
+} // namespace
+
+TEST_CASE("TcpZeroCopyReceiver rejects empty regions", "[tcp][zerocopy]") {
+  TcpSocket socket;
+  REQUIRE_THROWS_AS(TcpZeroCopyReceiver(socket, 0), std::invalid_argument);
+  REQUIRE_THROWS_AS(TcpZeroCopyReceiver(socket, 4096, 0),
+                    std::invalid_argument);
+}
+
+TEST_CASE("TcpZeroCopyReceiver delivers the exact stream", "[tcp][zerocopy]") {
+  TcpSocket listener;
+  listener.bind(Endpoint("127.0.0.1", 0));
+  listener.listen();
+  Endpoint bound = listener.localEndpoint();
+
+  constexpr std::size_t kTotal = 8 * 1024 * 1024;
+
+  std::thread writer([&] {
+    TcpSocket client;
+    client.connect(bound);
+
+    std::vector<std::byte> block(256 * 1024);
+    std::size_t offset = 0;
+    while (offset < kTotal) {
+      const std::size_t n = std::min(block.size(), kTotal - offset);
+      for (std::size_t i = 0; i < n; ++i) {
+        block[i] = pattern(offset + i);
+      }
+      std::span<const std::byte> rest(block.data(), n);
+      while (!rest.empty()) {
+        rest = rest.subspan(client.send(rest));
+      }
+      offset += n;
+    }
+    client.shutdown(TcpSocket::ShutdownType::Sending);
+  });
+
+  Endpoint peer;
+  TcpSocket conn = listener.accept(peer);
+  TcpZeroCopyReceiver receiver(conn);
+
+  std::size_t offset = 0;
+  bool mismatch = false;
+  for (;;) {
+    ZeroCopyChunk chunk = receiver.receive();
+    if (chunk.empty()) {
+      break;
+    }
+    for (auto part : {chunk.mapped, chunk.copied}) {
+      for (std::byte b : part) {
+        mismatch |= b != pattern(offset++);
+      }
+    }
+  }
+  writer.join();
+
+  REQUIRE_FALSE(mismatch);
+  REQUIRE(offset == kTotal);
+
+  auto stats = receiver.stats();
+  REQUIRE(stats.mapped_bytes + stats.copied_bytes == kTotal);
+#ifndef __linux__
+  REQUIRE_FALSE(receiver.zeroCopyEnabled());
+#endif
+}
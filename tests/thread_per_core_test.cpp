@@ -0,0 +1,155 @@
+#include "catch2/catch_test_macros.hpp"
+
+#ifndef _WIN32
+
+#include "net/core/endpoint.h"
+#include "net/core/thread_per_core.h"
+#include "net/protocol/tcp/tcp_socket.h"
+#include <catch2/catch_all.hpp>
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <set>
+#include <stdexcept>
+#include <vector>
+
+using namespace net;
+using namespace std::chrono_literals;
+
+namespace {
+
+ThreadPerCoreRuntime::Options twoCores() {
+  ThreadPerCoreRuntime::Options options;
+  options.cores = 2;
+  options.pin_threads = false;
+  options.queue_capacity = 8;
+  options.buffers_per_core = 4;
+  return options;
+}
+
+} // namespace
+
+TEST_CASE("TcpSocket setReusePort allows sharing a port", "[tcp][runtime]") {
+  TcpSocket first(TcpSocket::AddressFamily::IPV4);
+  first.setReusePort(true);
+  first.bind(Endpoint("127.0.0.1", 0));
+  first.listen();
+
+  TcpSocket second(TcpSocket::AddressFamily::IPV4);
+  second.setReusePort(true);
+  REQUIRE_NOTHROW(second.bind(first.localEndpoint()));
+}
+
+TEST_CASE("ThreadPerCoreRuntime builds per-core state", "[runtime]") {
+  ThreadPerCoreRuntime runtime(twoCores());
+  REQUIRE(runtime.coreCount() == 2);
+  REQUIRE(runtime.core(1).index() == 1);
+  REQUIRE(runtime.core(0).buffers().available() == 4);
+  REQUIRE(ThreadPerCoreRuntime::currentCore() == nullptr);
+  REQUIRE_THROWS_AS(runtime.core(0).send(2, [](auto &) {}),
+                    std::out_of_range);
+
+  auto options = twoCores();
+  options.queue_capacity = 0;
+  REQUIRE_THROWS_AS(ThreadPerCoreRuntime(options), std::invalid_argument);
+}
+
+TEST_CASE("ThreadPerCoreRuntime passes messages between cores",
+          "[runtime]") {
+  ThreadPerCoreRuntime runtime(twoCores());
+  constexpr int kRounds = 1000;
+
+  std::promise<int> finished;
+  auto result = finished.get_future();
+  std::atomic<bool> wrong_thread{false};
+
+  // Ping-pong a counter between the two cores.
+  std::function<void(ThreadPerCoreRuntime::Core &, int)> bounce;
+  bounce = [&](ThreadPerCoreRuntime::Core &core, int count) {
+    if (ThreadPerCoreRuntime::currentCore() != &core) {
+      wrong_thread = true;
+    }
+    if (count == kRounds) {
+      finished.set_value(count);
+      return;
+    }
+    ThreadPerCoreRuntime::Message next = [&bounce, count](auto &target) {
+      bounce(target, count + 1);
+    };
+    while (!core.send(1 - core.index(), std::move(next))) {
+    }
+  };
+
+  runtime.start();
+  runtime.submit(0, [&](ThreadPerCoreRuntime::Core &core) { bounce(core, 0); });
+  REQUIRE(result.wait_for(5s) == std::future_status::ready);
+  REQUIRE(result.get() == kRounds);
+  runtime.stop();
+
+  REQUIRE_FALSE(wrong_thread);
+  REQUIRE(runtime.core(0).received() + runtime.core(1).received() ==
+          kRounds);
+}
+
+TEST_CASE("ThreadPerCoreRuntime delivers self-sends and survives throws",
+          "[runtime]") {
+  ThreadPerCoreRuntime runtime(twoCores());
+  std::promise<void> delivered;
+  auto result = delivered.get_future();
+
+  runtime.start();
+  // Core 0 drains core 1's inbox after its own, so a self-send made while
+  // handling core 1's message lands in an inbox already drained this pass.
+  runtime.submit(1, [&](ThreadPerCoreRuntime::Core &core) {
+    core.send(0, [](auto &) { throw std::runtime_error("bad message"); });
+    core.send(0, [&](ThreadPerCoreRuntime::Core &self) {
+      self.send(0, [&](auto &) { delivered.set_value(); });
+    });
+  });
+  REQUIRE(result.wait_for(5s) == std::future_status::ready);
+  runtime.stop();
+
+  REQUIRE(runtime.core(0).received() == 3);
+  REQUIRE(runtime.core(0).failed() == 1);
+}
+
+TEST_CASE("ThreadPerCoreRuntime accepts on per-core listeners",
+          "[runtime]") {
+  ThreadPerCoreRuntime runtime(twoCores());
+  std::atomic<int> accepted{0};
+
+  const Endpoint bound = runtime.listen(
+      Endpoint("127.0.0.1", 0),
+      [&](ThreadPerCoreRuntime::Core &core, TcpSocket connection,
+          const Endpoint &) {
+        // Reply with the accepting core's index, using a pooled buffer.
+        auto buffer = core.buffers().acquire();
+        buffer.data()[0] = static_cast<std::byte>(core.index());
+        (void)connection.send(buffer.data().first(1));
+        ++accepted;
+      });
+  REQUIRE(bound.port() != 0);
+  runtime.start();
+  REQUIRE_THROWS_AS(runtime.start(), std::logic_error);
+  REQUIRE_THROWS_AS(runtime.listen(bound, {}), std::logic_error);
+
+  constexpr int kClients = 32;
+  std::set<int> cores;
+  for (int i = 0; i < kClients; ++i) {
+    TcpSocket client(TcpSocket::AddressFamily::IPV4);
+    client.connect(bound);
+    std::byte reply[1];
+    REQUIRE(client.receive(reply) == 1);
+    cores.insert(static_cast<int>(reply[0]));
+  }
+  runtime.stop();
+
+  REQUIRE(accepted == kClients);
+  REQUIRE(*cores.rbegin() < 2);
+#ifdef __linux__
+  // SO_REUSEPORT hashes connections across every listener.
+  REQUIRE(cores.size() == 2);
+#endif
+}
+
+#endif
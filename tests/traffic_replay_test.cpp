@@ -0,0 +1,418 @@
+#include "catch2/catch_test_macros.hpp"
+
+#ifndef _WIN32
+
+#include "net/core/endpoint.h"
+#include "net/core/pcapng_reader.h"
+#include "net/core/pcapng_writer.h"
+#include "net/protocol/tcp/tcp_capture_tap.h"
+#include "net/protocol/tcp/tcp_socket.h"
+#include "net/protocol/tcp/traffic_replay.h"
+#include "support/temp_file.h"
+#include <catch2/catch_all.hpp>
+#include <array>
+#include <bit>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <unistd.h>
+
+using namespace net;
+using namespace std::chrono_literals;
+
+namespace {
+
+std::vector<std::byte> bytesOf(const std::string &text) {
+  const auto view = std::as_bytes(std::span(text.data(), text.size()));
+  return {view.begin(), view.end()};
+}
+
+std::string textOf(const std::vector<std::byte> &bytes) {
+  return {reinterpret_cast<const char *>(bytes.data()), bytes.size()};
+}
+
+/// Big-endian block builder for hand-made captures.
+class BigEndianCapture {
+public:
+  void u16(std::uint16_t v) {
+    bytes_.push_back(static_cast<std::uint8_t>(v >> 8));
+    bytes_.push_back(static_cast<std::uint8_t>(v));
+  }
+  void u32(std::uint32_t v) {
+    u16(static_cast<std::uint16_t>(v >> 16));
+    u16(static_cast<std::uint16_t>(v));
+  }
+  void raw(const std::vector<std::uint8_t> &data) {
+    bytes_.insert(bytes_.end(), data.begin(), data.end());
+    while (bytes_.size() % 4 != 0) {
+      bytes_.push_back(0);
+    }
+  }
+  void block(std::uint32_t type, const std::vector<std::uint8_t> &body) {
+    const auto length = static_cast<std::uint32_t>(12 + ((body.size() + 3) & ~3u));
+    u32(type);
+    u32(length);
+    raw(body);
+    u32(length);
+  }
+
+  [[nodiscard]] const std::vector<std::uint8_t> &bytes() const {
+    return bytes_;
+  }
+
+private:
+  std::vector<std::uint8_t> bytes_;
+};
+
+/// Body of a big-endian block, built field by field.
+std::vector<std::uint8_t> fields(std::initializer_list<std::uint32_t> words) {
+  std::vector<std::uint8_t> out;
+  for (std::uint32_t w : words) {
+    for (int shift = 24; shift >= 0; shift -= 8) {
+      out.push_back(static_cast<std::uint8_t>(w >> shift));
+    }
+  }
+  return out;
+}
+
+/// IPv4 TCP segment between 10.0.0.1 and 10.0.0.2.
+std::vector<std::uint8_t> tcpPacket(bool from_client, std::uint32_t seq,
+                                    std::uint8_t flags,
+                                    const std::string &payload) {
+  std::vector<std::uint8_t> p(40, 0);
+  const auto total = static_cast<std::uint16_t>(40 + payload.size());
+  p[0] = 0x45;
+  p[2] = static_cast<std::uint8_t>(total >> 8);
+  p[3] = static_cast<std::uint8_t>(total);
+  p[8] = 64;
+  p[9] = 6;
+  const std::uint8_t client[4] = {10, 0, 0, 1};
+  const std::uint8_t server[4] = {10, 0, 0, 2};
+  std::copy_n(from_client ? client : server, 4, p.begin() + 12);
+  std::copy_n(from_client ? server : client, 4, p.begin() + 16);
+  const std::uint16_t client_port = 50000;
+  const std::uint16_t server_port = 8080;
+  const std::uint16_t sport = from_client ? client_port : server_port;
+  const std::uint16_t dport = from_client ? server_port : client_port;
+  p[20] = static_cast<std::uint8_t>(sport >> 8);
+  p[21] = static_cast<std::uint8_t>(sport);
+  p[22] = static_cast<std::uint8_t>(dport >> 8);
+  p[23] = static_cast<std::uint8_t>(dport);
+  for (int i = 0; i < 4; ++i) {
+    p[24 + i] = static_cast<std::uint8_t>(seq >> (24 - 8 * i));
+  }
+  p[32] = 5 << 4;
+  p[33] = flags;
+  p.insert(p.end(), payload.begin(), payload.end());
+  return p;
+}
+
+void writeRaw(PcapngWriter &writer, const std::vector<std::uint8_t> &packet,
+              std::uint64_t timestamp) {
+  writer.write(std::as_bytes(std::span(packet)), {}, timestamp);
+}
+
+/// Accepts one connection and answers every `request_size` bytes with
+/// `response_size` bytes until the client closes.
+class ReplyServer {
+public:
+  ReplyServer(std::size_t request_size, std::size_t response_size) {
+    listener_.bind(Endpoint("127.0.0.1", 0));
+    listener_.listen();
+    endpoint_ = listener_.localEndpoint();
+    thread_ = std::thread([this, request_size, response_size] {
+      Endpoint peer;
+      TcpSocket connection = listener_.accept(peer);
+      std::vector<std::byte> buffer(request_size);
+      const std::vector<std::byte> response(response_size, std::byte{'r'});
+      for (;;) {
+        std::size_t filled = 0;
+        while (filled < request_size) {
+          const std::size_t n =
+              connection.receive(std::span(buffer).subspan(filled));
+          if (n == 0) {
+            return;
+          }
+          filled += n;
+        }
+        received_ += filled;
+        if (response_size > 0) {
+          std::size_t sent = 0;
+          while (sent < response_size) {
+            sent += connection.send(std::span(response).subspan(sent));
+          }
+        }
+      }
+    });
+  }
+  ~ReplyServer() { thread_.join(); }
+
+  [[nodiscard]] const Endpoint &endpoint() const { return endpoint_; }
+  [[nodiscard]] std::size_t received() const { return received_; }
+
+private:
+  TcpSocket listener_;
+  Endpoint endpoint_;
+  std::atomic<std::size_t> received_{0};
+  std::thread thread_;
+};
+
+RecordedMessage message(std::chrono::nanoseconds offset, bool from_client,
+                        std::size_t size) {
+  return {offset, from_client, std::vector<std::byte>(size, std::byte{'x'})};
+}
+
+} // namespace
+
+TEST_CASE("PcapngReader reads what PcapngWriter wrote", "[pcapng][replay]") {
+  test::TempFile file("netlib_replay");
+  {
+    PcapngWriter writer(file.path());
+    const auto first = bytesOf("first packet");
+    const auto second = bytesOf("second");
+    writer.write(first, {}, 1'700'000'000'123'456'789ULL);
+    writer.write(second, {}, 1'700'000'001'000'000'000ULL);
+  }
+
+  PcapngReader reader(file.path());
+  auto packet = reader.next();
+  REQUIRE(packet);
+  REQUIRE(packet->link_type == PcapngWriter::link_type);
+  REQUIRE(packet->timestamp_ns == 1'700'000'000'123'456'789ULL);
+  REQUIRE(textOf(packet->data) == "first packet");
+  REQUIRE(packet->original_length == 12);
+  packet = reader.next();
+  REQUIRE(packet);
+  REQUIRE(textOf(packet->data) == "second");
+  REQUIRE_FALSE(reader.next());
+}
+
+TEST_CASE("PcapngReader stops at the zero-filled tail of a live capture",
+          "[pcapng][replay]") {
+  test::TempFile file("netlib_replay");
+  // Not destroyed while reading: the file is still the full capacity.
+  PcapngWriter writer(file.path(), {.capacity = 4096});
+  writer.write(bytesOf("only packet"), {}, 1'700'000'000'000'000'000ULL);
+  REQUIRE(file.bytes().size() == 4096);
+
+  PcapngReader reader(file.path());
+  auto packet = reader.next();
+  REQUIRE(packet);
+  REQUIRE(textOf(packet->data) == "only packet");
+  REQUIRE_FALSE(reader.next());
+  REQUIRE_FALSE(reader.next());
+}
+
+TEST_CASE("PcapngReader handles big-endian sections and simple packets",
+          "[pcapng][replay]") {
+  BigEndianCapture capture;
+  capture.block(0x0A0D0D0A, fields({0x1A2B3C4D, 0x00010000, 0xFFFFFFFF,
+                                    0xFFFFFFFF}));
+  // Ethernet, snap length 64, no options: microsecond timestamps.
+  capture.block(1, fields({0x00010000, 64}));
+  capture.block(5, fields({0, 0})); // statistics block, skipped
+  auto epb = fields({0, 0, 2'500'000, 3, 3});
+  epb.insert(epb.end(), {'a', 'b', 'c'});
+  capture.block(6, epb);
+  auto spb = fields({100}); // original length larger than the snap length
+  spb.resize(4 + 64, 'z');
+  capture.block(3, spb);
+
+  test::TempFile file("netlib_replay");
+  file.write(capture.bytes());
+
+  PcapngReader reader(file.path());
+  auto packet = reader.next();
+  REQUIRE(packet);
+  REQUIRE(packet->link_type == 1);
+  REQUIRE(packet->timestamp_ns == 2'500'000'000ULL);
+  REQUIRE(textOf(packet->data) == "abc");
+
+  packet = reader.next();
+  REQUIRE(packet);
+  REQUIRE(packet->timestamp_ns == 0);
+  REQUIRE(packet->original_length == 100);
+  REQUIRE(packet->data.size() == 64);
+  REQUIRE_FALSE(reader.next());
+}
+
+TEST_CASE("PcapngReader rejects malformed input", "[pcapng][replay]") {
+  test::TempFile file("netlib_replay");
+  file.write({'n', 'o', 't', ' ', 'p', 'c', 'a', 'p'});
+  REQUIRE_THROWS_AS(PcapngReader(file.path()), std::runtime_error);
+
+  BigEndianCapture capture;
+  capture.block(0x0A0D0D0A, fields({0x1A2B3C4D, 0x00010000, 0xFFFFFFFF,
+                                    0xFFFFFFFF}));
+  capture.block(6, fields({0, 0, 0, 0, 0})); // no interface described
+  file.write(capture.bytes());
+  PcapngReader reader(file.path());
+  REQUIRE_THROWS_AS(reader.next(), std::runtime_error);
+
+  auto truncated = capture.bytes();
+  truncated.resize(truncated.size() - 6);
+  file.write(truncated);
+  PcapngReader short_reader(file.path());
+  REQUIRE_THROWS_AS(short_reader.next(), std::runtime_error);
+
+  REQUIRE_THROWS_AS(PcapngReader("/nonexistent-dir/capture.pcapng"),
+                    std::system_error);
+}
+
+TEST_CASE("extractTcpSessions rebuilds a tapped connection",
+          "[pcapng][replay]") {
+  test::TempFile file("netlib_replay");
+  const std::vector<std::byte> large(TcpCaptureTap::max_segment * 2 + 10,
+                                     std::byte{'L'});
+  {
+    auto writer = std::make_shared<PcapngWriter>(file.path());
+    // Tapped on the server: the remote side sent the SYN.
+    TcpCaptureTap tap(writer, Endpoint("127.0.0.1", 8080),
+                      Endpoint("127.0.0.1", 41000),
+                      {.handshake = true, .local_initiated = false});
+    tap.onReceive(bytesOf("GET /big"));
+    std::this_thread::sleep_for(2ms);
+    tap.onSend(large);
+    std::this_thread::sleep_for(2ms);
+    tap.onReceive(bytesOf("GET /small"));
+    tap.onSend(bytesOf("ok"));
+  }
+
+  const auto sessions = loadTcpSessions(file.path());
+  REQUIRE(sessions.size() == 1);
+  const RecordedSession &session = sessions[0];
+  REQUIRE(session.client.port() == 41000);
+  REQUIRE(session.server.port() == 8080);
+  REQUIRE(session.start == 0ns);
+  REQUIRE(session.messages.size() == 4);
+
+  REQUIRE(session.messages[0].from_client);
+  REQUIRE(textOf(session.messages[0].payload) == "GET /big");
+  REQUIRE_FALSE(session.messages[1].from_client);
+  REQUIRE(session.messages[1].payload == large); // three segments, one write
+  REQUIRE(session.messages[1].offset >= 2ms);
+  REQUIRE(textOf(session.messages[2].payload) == "GET /small");
+  REQUIRE(textOf(session.messages[3].payload) == "ok");
+  REQUIRE(session.bytesFrom(true) == 18);
+  REQUIRE(session.bytesFrom(false) == large.size() + 2);
+}
+
+TEST_CASE("extractTcpSessions reorders and deduplicates segments",
+          "[pcapng][replay]") {
+  test::TempFile file("netlib_replay");
+  {
+    PcapngWriter writer(file.path());
+    const std::uint8_t syn = 0x02, ack = 0x10, psh_ack = 0x18, fin = 0x11;
+    writeRaw(writer, tcpPacket(true, 999, syn, ""), 1000);
+    writeRaw(writer, tcpPacket(false, 4999, syn | ack, ""), 1001);
+    writeRaw(writer, tcpPacket(true, 1005, psh_ack, "world"), 2000); // early
+    writeRaw(writer, tcpPacket(true, 1000, psh_ack, "hello"), 2001);
+    writeRaw(writer, tcpPacket(true, 1000, psh_ack, "hello"), 2002); // retx
+    writeRaw(writer, tcpPacket(false, 5000, psh_ack, "reply"), 3000);
+    writeRaw(writer, tcpPacket(true, 1008, psh_ack, "ld!"), 3001); // overlap
+    writeRaw(writer, tcpPacket(true, 1010, fin, ""), 4000);
+
+    // Port reuse: a new SYN after FIN starts a second session.
+    writeRaw(writer, tcpPacket(true, 7000, syn, ""), 9000);
+    writeRaw(writer, tcpPacket(true, 7001, psh_ack, "again"), 9500);
+  }
+
+  const auto sessions = loadTcpSessions(file.path());
+  REQUIRE(sessions.size() == 2);
+  const RecordedSession &first = sessions[0];
+  REQUIRE(first.client.to_string() == "10.0.0.1:50000");
+  REQUIRE(first.server.to_string() == "10.0.0.2:8080");
+  REQUIRE(first.messages.size() == 3);
+  REQUIRE(textOf(first.messages[0].payload) == "helloworld");
+  REQUIRE(first.messages[0].offset == 1001ns);
+  REQUIRE(textOf(first.messages[1].payload) == "reply");
+  REQUIRE_FALSE(first.messages[1].from_client);
+  REQUIRE(textOf(first.messages[2].payload) == "!");
+
+  REQUIRE(sessions[1].start == 8000ns);
+  REQUIRE(textOf(sessions[1].messages.at(0).payload) == "again");
+}
+
+TEST_CASE("TrafficReplayer replays requests and measures latency",
+          "[replay]") {
+  ReplyServer server(4, 8);
+  RecordedSession session;
+  for (int i = 0; i < 3; ++i) {
+    session.messages.push_back(message(i * 1ms, true, 4));
+    session.messages.push_back(message(i * 1ms + 100us, false, 8));
+  }
+  const std::vector<RecordedSession> sessions{session};
+
+  const TrafficReplayer replayer(server.endpoint(), {.speed = 0});
+  const auto report = replayer.run(sessions);
+  REQUIRE(report.sessions == 1);
+  REQUIRE(report.completed == 1);
+  REQUIRE(report.failed == 0);
+  REQUIRE(report.requests == 3);
+  REQUIRE(report.bytes_sent == 12);
+  REQUIRE(report.bytes_received == 24);
+  REQUIRE(report.latencies.size() == 3);
+  REQUIRE(report.latencies.front() <= report.latencies.back());
+  REQUIRE(report.percentile(0.5) == report.latencies[1]);
+  REQUIRE(report.percentile(1.0) == report.latencies[2]);
+  REQUIRE(report.percentile(0.0) == report.latencies[0]);
+}
+
+TEST_CASE("TrafficReplayer scales recorded timing", "[replay]") {
+  ReplyServer server(4, 0);
+  RecordedSession session;
+  session.messages.push_back(message(0ms, true, 4));
+  session.messages.push_back(message(300ms, true, 4));
+  const std::vector<RecordedSession> sessions{session};
+
+  const TrafficReplayer replayer(server.endpoint(), {.speed = 3});
+  const auto report = replayer.run(sessions);
+  REQUIRE(report.completed == 1);
+  REQUIRE(report.requests == 0); // no answers recorded, nothing to time
+  REQUIRE(report.bytes_sent == 8);
+  REQUIRE(report.elapsed >= 95ms);
+  REQUIRE(report.elapsed < 290ms);
+}
+
+TEST_CASE("TrafficReplayer reports refused and unanswered sessions",
+          "[replay]") {
+  Endpoint closed;
+  {
+    TcpSocket listener;
+    listener.bind(Endpoint("127.0.0.1", 0));
+    closed = listener.localEndpoint();
+  }
+  RecordedSession session;
+  session.messages.push_back(message(0ms, true, 4));
+  session.messages.push_back(message(1ms, false, 4));
+  std::vector<RecordedSession> sessions{session, session};
+  sessions[1].start = 5ms;
+
+  const TrafficReplayer refused(closed, {.speed = 1});
+  auto report = refused.run(sessions);
+  REQUIRE(report.sessions == 2);
+  REQUIRE(report.failed == 2);
+  REQUIRE(report.latencies.empty());
+  REQUIRE(report.percentile(0.99) == 0ns);
+
+  // The server reads the request but never answers.
+  ReplyServer silent(4, 0);
+  const TrafficReplayer idle(silent.endpoint(),
+                             {.speed = 0, .idle_timeout = 50ms});
+  report = idle.run(std::span(sessions).first(1));
+  REQUIRE(report.failed == 1);
+  REQUIRE(report.elapsed >= 50ms);
+
+  REQUIRE_THROWS_AS(TrafficReplayer(closed, {.speed = -1}),
+                    std::invalid_argument);
+  REQUIRE_THROWS_AS(TrafficReplayer(closed, {.idle_timeout = 0ms}),
+                    std::invalid_argument);
+}
+
+#endif
@@ -0,0 +1,205 @@
+#include "catch2/catch_test_macros.hpp"
+#include "net/core/endpoint.h"
+#include "net/detail/ip_address.h"
+#include "net/detail/socket_flags.h"
+#include "net/protocol/udp/udp_socket.h"
+#include <array>
+#include <catch2/catch_all.hpp>
+#include <string_view>
+#include <vector>
+
+#ifdef __linux__
+#include <net/if.h>
+#endif
+
+using namespace net;
+using Flags = detail::SocketFlags;
+
+static std::span<const std::byte> as_bytes(std::string_view text) {
+  return std::as_bytes(std::span(text.data(), text.size()));
+}
+
+static std::string_view as_text(std::span<const std::byte> bytes) {
+  return {reinterpret_cast<const char *>(bytes.data()), bytes.size()};
+}
+
+TEST_CASE("UdpSocket sendTo & receiveFrom", "[udp]") {
+  UdpSocket receiver;
+  receiver.bind(Endpoint("127.0.0.1", 0));
+  Endpoint bound = receiver.localEndpoint();
+
+  UdpSocket sender;
+  sender.bind(Endpoint("127.0.0.1", 0));
+
+  REQUIRE(sender.sendTo(as_bytes("hello"), bound) == 5);
+
+  std::array<std::byte, 16> buffer{};
+  Endpoint peer;
+  auto n = receiver.receiveFrom(buffer, peer);
+
+  REQUIRE(as_text(std::span(buffer).first(n)) == "hello");
+  REQUIRE(peer.port() == sender.localEndpoint().port());
+}
+
+TEST_CASE("UdpSocket port sharing is opt-in", "[udp]") {
+  UdpSocket first;
+  first.bind(Endpoint("127.0.0.1", 0));
+  const Endpoint bound = first.localEndpoint();
+
+  UdpSocket second;
+  REQUIRE_THROWS_AS(second.bind(bound), std::system_error);
+
+  UdpSocket shared_a;
+  shared_a.setReuseAddress(true);
+  shared_a.bind(Endpoint("127.0.0.1", 0));
+  UdpSocket shared_b;
+  shared_b.setReuseAddress(true);
+  REQUIRE_NOTHROW(shared_b.bind(shared_a.localEndpoint()));
+}
+
+TEST_CASE("UdpSocket connected send & receive", "[udp]") {
+  UdpSocket a;
+  UdpSocket b;
+  a.bind(Endpoint("127.0.0.1", 0));
+  b.bind(Endpoint("127.0.0.1", 0));
+  a.connect(b.localEndpoint());
+  b.connect(a.localEndpoint());
+
+  REQUIRE(a.send(as_bytes("ping")) == 4);
+
+  std::array<std::byte, 16> buffer{};
+  auto n = b.receive(buffer);
+  REQUIRE(as_text(std::span(buffer).first(n)) == "ping");
+}
+
+TEST_CASE("UdpSocket receiveBatch drains queued datagrams", "[udp]") {
+  UdpSocket receiver(Flags::AddressFamily::IPV4,
+                     Flags::BlockingType::NonBlocking);
+  receiver.bind(Endpoint("127.0.0.1", 0));
+  receiver.setReceiveBufferSize(1 << 20);
+  Endpoint bound = receiver.localEndpoint();
+
+  UdpSocket sender;
+  constexpr std::size_t kCount = 100;
+  for (std::size_t i = 0; i < kCount; ++i) {
+    std::array<std::byte, 4> payload{};
+    payload[0] = static_cast<std::byte>(i);
+    REQUIRE(sender.sendTo(payload, bound) == payload.size());
+  }
+
+  std::vector<std::array<std::byte, 4>> storage(kCount + 10);
+  std::vector<ReceivedDatagram> slots(storage.size());
+  for (std::size_t i = 0; i < slots.size(); ++i) {
+    slots[i].buffer = storage[i];
+  }
+
+  std::size_t total = 0;
+  while (total < kCount) {
+    auto n = receiver.receiveBatch(std::span(slots).subspan(total));
+    REQUIRE(n > 0);
+    total += n;
+  }
+
+  REQUIRE(total == kCount);
+  for (std::size_t i = 0; i < kCount; ++i) {
+    REQUIRE(slots[i].size == 4);
+    REQUIRE_FALSE(slots[i].truncated);
+    REQUIRE(storage[i][0] == static_cast<std::byte>(i));
+  }
+
+  // Queue is empty: a non-blocking batch receive reports EAGAIN.
+  REQUIRE_THROWS_AS(receiver.receiveBatch(slots), std::system_error);
+}
+
+TEST_CASE("UdpSocket multicast option validation", "[udp][multicast]") {
+  UdpSocket v4;
+  REQUIRE_THROWS_AS(v4.joinGroup(detail::IpAddress("ff02::1")),
+                    std::invalid_argument);
+  REQUIRE_THROWS_AS(v4.setMulticastTtl(256), std::invalid_argument);
+
+  v4.setMulticastTtl(1);
+  v4.setMulticastLoopback(true);
+
+  UdpSocket v6(Flags::AddressFamily::IPV6);
+  v6.setMulticastTtl(1);
+  v6.setMulticastLoopback(false);
+}
+
+#ifdef __linux__
+TEST_CASE("UdpSocket IPv4 multicast over loopback", "[udp][multicast]") {
+  const unsigned lo = ::if_nametoindex("lo");
+  REQUIRE(lo != 0);
+
+  detail::IpAddress group("239.255.0.77");
+
+  UdpSocket receiver;
+  receiver.setReuseAddress(true);
+  receiver.bind(Endpoint("0.0.0.0", 0));
+  receiver.joinGroup(group, lo);
+  const auto port = receiver.localEndpoint().port();
+
+  UdpSocket sender;
+  sender.setMulticastInterface(lo);
+  sender.setMulticastLoopback(true);
+  sender.setMulticastTtl(1);
+  REQUIRE(sender.sendTo(as_bytes("tick"), Endpoint(group, port)) == 4);
+
+  std::array<std::byte, 16> buffer{};
+  Endpoint peer;
+  auto n = receiver.receiveFrom(buffer, peer);
+  REQUIRE(as_text(std::span(buffer).first(n)) == "tick");
+
+  receiver.leaveGroup(group, lo);
+}
+
+TEST_CASE("UdpSocket source-specific multicast filters senders",
+          "[udp][multicast]") {
+  const unsigned lo = ::if_nametoindex("lo");
+  REQUIRE(lo != 0);
+
+  detail::IpAddress group("232.1.1.1");
+
+  UdpSocket sender;
+  sender.bind(Endpoint("127.0.0.1", 0));
+  sender.setMulticastInterface(lo);
+  sender.setMulticastLoopback(true);
+
+  UdpSocket receiver(Flags::AddressFamily::IPV4,
+                     Flags::BlockingType::NonBlocking);
+  receiver.setReuseAddress(true);
+  receiver.bind(Endpoint("0.0.0.0", 0));
+  receiver.joinSourceGroup(group, detail::IpAddress("127.0.0.1"), lo);
+  const auto port = receiver.localEndpoint().port();
+
+  REQUIRE(sender.sendTo(as_bytes("ssm"), Endpoint(group, port)) == 3);
+
+  std::array<std::byte, 16> buffer{};
+  std::array<ReceivedDatagram, 1> slot{};
+  slot[0].buffer = buffer;
+
+  // Loopback delivery is synchronous with sendto(), so the datagram is
+  // already queued if the channel accepted it.
+  REQUIRE(receiver.receiveBatch(slot) == 1);
+  REQUIRE(as_text(std::span(buffer).first(slot[0].size)) == "ssm");
+
+  receiver.leaveSourceGroup(group, detail::IpAddress("127.0.0.1"), lo);
+}
+
+TEST_CASE("UdpSocket IPv6 group membership", "[udp][multicast]") {
+  const unsigned lo = ::if_nametoindex("lo");
+  REQUIRE(lo != 0);
+
+  UdpSocket receiver(Flags::AddressFamily::IPV6);
+  receiver.setReuseAddress(true);
+  receiver.bind(Endpoint("::", 0));
+
+  detail::IpAddress group("ff02::1:77");
+  receiver.joinGroup(group, lo);
+  receiver.leaveGroup(group, lo);
+
+  receiver.joinSourceGroup(detail::IpAddress("ff3e::1234"),
+                           detail::IpAddress("::1"), lo);
+  receiver.leaveSourceGroup(detail::IpAddress("ff3e::1234"),
+                            detail::IpAddress("::1"), lo);
+}
+#endif
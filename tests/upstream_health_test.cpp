@@ -0,0 +1,231 @@
+#include "catch2/catch_test_macros.hpp"
+#include "net/core/upstream_health.h"
+#include <catch2/catch_all.hpp>
+#include <chrono>
+#include <optional>
+#include <vector>
+
+using namespace net;
+using namespace std::chrono_literals;
+using State = UpstreamHealth::State;
+
+TEST_CASE("UpstreamHealth validates its options", "[upstream_health]") {
+  UpstreamHealth::Options options;
+  options.max_ejection_fraction = 1.5;
+  REQUIRE_THROWS_AS(UpstreamHealth(options), std::invalid_argument);
+
+  options = {};
+  options.interval = 0ms;
+  REQUIRE_THROWS_AS(UpstreamHealth(options), std::invalid_argument);
+
+  options = {};
+  options.max_ejection = options.base_ejection / 2;
+  REQUIRE_THROWS_AS(UpstreamHealth(options), std::invalid_argument);
+
+  options = {};
+  options.half_open_probes = 0;
+  REQUIRE_THROWS_AS(UpstreamHealth(options), std::invalid_argument);
+}
+
+TEST_CASE("UpstreamHealth ejects after consecutive failures and probes",
+          "[upstream_health]") {
+  UpstreamHealth::Options options;
+  options.consecutive_failures = 3;
+  options.base_ejection = 1s;
+  options.max_ejection = 3s;
+  UpstreamHealth health(options);
+  const Endpoint upstream("10.0.0.1", 8080);
+  const auto t0 = UpstreamHealth::Clock::now();
+
+  REQUIRE(health.state(upstream, t0) == State::Healthy);
+
+  // A success in between resets the streak.
+  for (int i = 0; i < 2; ++i) {
+    auto permit = health.tryAcquire(upstream, t0);
+    REQUIRE(permit);
+    permit->failure(t0);
+  }
+  health.tryAcquire(upstream, t0)->success(t0);
+  REQUIRE(health.stats(upstream, t0).consecutive_failures == 0);
+
+  for (int i = 0; i < 3; ++i) {
+    auto permit = health.tryAcquire(upstream, t0);
+    REQUIRE(permit);
+    REQUIRE_FALSE(permit->probe());
+    permit->failure(t0);
+  }
+  auto stats = health.stats(upstream, t0);
+  REQUIRE(stats.state == State::Ejected);
+  REQUIRE(stats.failures == 5);
+  REQUIRE(stats.successes == 1);
+  REQUIRE(stats.times_ejected == 1);
+  REQUIRE(stats.ejected_until == t0 + 1s);
+  REQUIRE_FALSE(health.tryAcquire(upstream, t0 + 500ms));
+
+  // Expired: one probe at a time.
+  REQUIRE(health.state(upstream, t0 + 1s) == State::HalfOpen);
+  auto probe = health.tryAcquire(upstream, t0 + 1s);
+  REQUIRE(probe);
+  REQUIRE(probe->probe());
+  REQUIRE(probe->endpoint() == upstream);
+  REQUIRE_FALSE(health.tryAcquire(upstream, t0 + 1s));
+
+  // A failed probe ejects again, for longer.
+  probe->failure(t0 + 1s);
+  stats = health.stats(upstream, t0 + 1s);
+  REQUIRE(stats.state == State::Ejected);
+  REQUIRE(stats.ejections == 2);
+  REQUIRE(stats.ejected_until == t0 + 3s);
+  REQUIRE_THROWS_AS(probe->failure(t0 + 1s), std::logic_error);
+
+  probe = health.tryAcquire(upstream, t0 + 3s);
+  REQUIRE(probe);
+  REQUIRE(probe->probe());
+  probe->success(5ms, t0 + 3s);
+  REQUIRE(health.state(upstream, t0 + 3s) == State::Healthy);
+  REQUIRE(health.unavailableCount(t0 + 3s) == 0);
+}
+
+TEST_CASE("UpstreamHealth caps the ejection duration", "[upstream_health]") {
+  UpstreamHealth::Options options;
+  options.consecutive_failures = 1;
+  options.base_ejection = 1s;
+  options.max_ejection = 2s;
+  UpstreamHealth health(options);
+  const Endpoint upstream("10.0.0.1", 8080);
+  auto now = UpstreamHealth::Clock::now();
+
+  health.tryAcquire(upstream, now)->failure(now);
+  for (int i = 0; i < 3; ++i) {
+    now = health.stats(upstream, now).ejected_until;
+    health.tryAcquire(upstream, now)->failure(now);
+  }
+  const auto stats = health.stats(upstream, now);
+  REQUIRE(stats.times_ejected == 4);
+  REQUIRE(stats.ejected_until == now + 2s);
+}
+
+TEST_CASE("UpstreamHealth limits requests in flight", "[upstream_health]") {
+  UpstreamHealth::Options options;
+  options.max_pending = 2;
+  UpstreamHealth health(options);
+  const Endpoint upstream("10.0.0.1", 8080);
+  const auto now = UpstreamHealth::Clock::now();
+
+  auto first = health.tryAcquire(upstream, now);
+  auto second = health.tryAcquire(upstream, now);
+  REQUIRE(first);
+  REQUIRE(second);
+  REQUIRE(health.stats(upstream, now).pending == 2);
+  REQUIRE_FALSE(health.tryAcquire(upstream, now));
+  REQUIRE(health.stats(upstream, now).overflows == 1);
+
+  first->success(now);
+  REQUIRE(health.stats(upstream, now).pending == 1);
+  REQUIRE(health.tryAcquire(upstream, now));
+
+  // A moved-from permit releases nothing; the destination still counts.
+  auto moved = std::move(*second);
+  second.reset();
+  REQUIRE(health.stats(upstream, now).pending == 1);
+}
+
+TEST_CASE("UpstreamHealth cancelled permits only release their slot",
+          "[upstream_health]") {
+  UpstreamHealth::Options options;
+  options.consecutive_failures = 1;
+  options.base_ejection = 1s;
+  UpstreamHealth health(options);
+  const Endpoint upstream("10.0.0.1", 8080);
+  const auto t0 = UpstreamHealth::Clock::now();
+
+  health.tryAcquire(upstream, t0)->failure(t0);
+  {
+    auto probe = health.tryAcquire(upstream, t0 + 1s);
+    REQUIRE(probe);
+    REQUIRE(probe->probe());
+  }
+  auto stats = health.stats(upstream, t0 + 1s);
+  REQUIRE(stats.state == State::HalfOpen);
+  REQUIRE(stats.pending == 0);
+  REQUIRE(stats.failures == 1);
+  REQUIRE(health.tryAcquire(upstream, t0 + 1s));
+}
+
+TEST_CASE("UpstreamHealth ejects latency outliers", "[upstream_health]") {
+  UpstreamHealth::Options options;
+  options.interval = 1s;
+  options.min_requests = 5;
+  options.min_endpoints = 3;
+  options.latency_factor = 3.0;
+  options.base_ejection = 10s;
+  options.max_ejection = 60s;
+  UpstreamHealth health(options);
+  const auto t0 = UpstreamHealth::Clock::now();
+
+  const std::vector<Endpoint> upstreams = {
+      Endpoint("10.0.0.1", 80), Endpoint("10.0.0.2", 80),
+      Endpoint("10.0.0.3", 80), Endpoint("10.0.0.4", 80)};
+  const Endpoint &slow = upstreams[3];
+
+  for (int i = 0; i < 5; ++i) {
+    for (const Endpoint &upstream : upstreams) {
+      auto permit = health.tryAcquire(upstream, t0);
+      REQUIRE(permit);
+      permit->success(&upstream == &slow ? 100ms : 10ms + i * 1ms, t0);
+    }
+  }
+
+  health.analyze(t0 + 1s);
+  REQUIRE(health.state(slow, t0 + 1s) == State::Ejected);
+  for (int i = 0; i < 3; ++i) {
+    REQUIRE(health.state(upstreams[i], t0 + 1s) == State::Healthy);
+  }
+
+  // The next window starts empty, so nothing else is judged.
+  health.analyze(t0 + 2s);
+  REQUIRE(health.unavailableCount(t0 + 2s) == 1);
+}
+
+TEST_CASE("UpstreamHealth skips latency analysis with few endpoints",
+          "[upstream_health]") {
+  UpstreamHealth::Options options;
+  options.interval = 1s;
+  options.min_requests = 1;
+  options.min_endpoints = 3;
+  UpstreamHealth health(options);
+  const auto t0 = UpstreamHealth::Clock::now();
+  const Endpoint fast("10.0.0.1", 80);
+  const Endpoint slow("10.0.0.2", 80);
+
+  health.tryAcquire(fast, t0)->success(1ms, t0);
+  health.tryAcquire(slow, t0)->success(1s, t0);
+  health.analyze(t0 + 1s);
+  REQUIRE(health.state(slow, t0 + 1s) == State::Healthy);
+}
+
+TEST_CASE("UpstreamHealth keeps most endpoints in rotation",
+          "[upstream_health]") {
+  UpstreamHealth::Options options;
+  options.consecutive_failures = 1;
+  options.max_ejection_fraction = 0.25;
+  UpstreamHealth health(options);
+  const auto now = UpstreamHealth::Clock::now();
+
+  std::vector<Endpoint> upstreams;
+  for (std::uint16_t port = 1; port <= 4; ++port) {
+    upstreams.emplace_back("10.0.0.1", port);
+    REQUIRE(health.tryAcquire(upstreams.back(), now));
+  }
+
+  health.tryAcquire(upstreams[0], now)->failure(now);
+  health.tryAcquire(upstreams[1], now)->failure(now);
+  REQUIRE(health.state(upstreams[0], now) == State::Ejected);
+  REQUIRE(health.state(upstreams[1], now) == State::Healthy);
+  REQUIRE(health.unavailableCount(now) == 1);
+
+  // Forgetting the ejected endpoint frees the slot.
+  health.remove(upstreams[0]);
+  health.tryAcquire(upstreams[1], now)->failure(now);
+  REQUIRE(health.state(upstreams[1], now) == State::Ejected);
+}
@@ -0,0 +1,247 @@
+#include "catch2/catch_test_macros.hpp"
+#include "net/core/upstream_set.h"
+#include <catch2/catch_all.hpp>
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace net;
+
+TEST_CASE("parseUpstreams reads address:port lines", "[upstream_set]") {
+  const auto endpoints = parseUpstreams("# primary pool\n"
+                                        "10.0.0.1:8080\n"
+                                        "\n"
+                                        "  10.0.0.2:8081  # canary\r\n"
+                                        "[2001:db8::1]:443");
+  REQUIRE(endpoints.size() == 3);
+  REQUIRE(endpoints[0] == Endpoint("10.0.0.1", 8080));
+  REQUIRE(endpoints[1] == Endpoint("10.0.0.2", 8081));
+  REQUIRE(endpoints[2] == Endpoint("2001:db8::1", 443));
+  REQUIRE(parseUpstreams("").empty());
+  REQUIRE(parseUpstreams("# nothing\n\n").empty());
+}
+
+TEST_CASE("parseUpstreams names the bad line", "[upstream_set]") {
+  std::string message;
+  try {
+    parseUpstreams("10.0.0.1:80\n10.0.0.2\n");
+  } catch (const std::invalid_argument &e) {
+    message = e.what();
+  }
+  REQUIRE(message.find("upstreams:2") != std::string::npos);
+  REQUIRE_THROWS_AS(parseUpstreams("10.0.0.1:0"), std::invalid_argument);
+  REQUIRE_THROWS_AS(parseUpstreams("10.0.0.1:65536"), std::invalid_argument);
+  REQUIRE_THROWS_AS(parseUpstreams("10.0.0.1:80x"), std::invalid_argument);
+  REQUIRE_THROWS_AS(parseUpstreams("2001:db8::1:80"), std::invalid_argument);
+  REQUIRE_THROWS_AS(parseUpstreams("[2001:db8::1]80"), std::invalid_argument);
+  REQUIRE_THROWS_AS(parseUpstreams("example.com:80"), std::invalid_argument);
+}
+
+TEST_CASE("UpstreamSource snapshots outlive updates", "[upstream_set]") {
+  UpstreamSource source({Endpoint("10.0.0.1", 80)});
+  {
+    auto before = source.read();
+    REQUIRE(before->version == 0);
+
+    REQUIRE(source.update({Endpoint("10.0.0.2", 80)}) == 1);
+    {
+      auto nested = source.read();
+      REQUIRE(nested->version == 1);
+      REQUIRE(nested->endpoints[0] == Endpoint("10.0.0.2", 80));
+    }
+    // The pinned set is still intact and cannot be freed yet.
+    REQUIRE(before->endpoints[0] == Endpoint("10.0.0.1", 80));
+    source.reclaim();
+    REQUIRE(source.retiredCount() == 1);
+  }
+  source.reclaim();
+  REQUIRE(source.retiredCount() == 0);
+
+  // Without readers an update frees its predecessor at once.
+  REQUIRE(source.update({}) == 2);
+  REQUIRE(source.retiredCount() == 0);
+  REQUIRE(source.read()->endpoints.empty());
+}
+
+TEST_CASE("UpstreamSource readers see consistent sets during updates",
+          "[upstream_set]") {
+  // Every set holds `width` copies of one endpoint whose port encodes the
+  // version, so a torn or freed set shows up as a mismatch.
+  constexpr std::size_t width = 8;
+  const auto makeSet = [](std::uint64_t version) {
+    return std::vector<Endpoint>(
+        width,
+        Endpoint("127.0.0.1", static_cast<std::uint16_t>(version % 60000 + 1)));
+  };
+
+  UpstreamSource source(makeSet(0));
+  std::atomic<bool> done{false};
+  std::atomic<int> failures{0};
+  std::vector<std::thread> readers;
+  for (int i = 0; i < 4; ++i) {
+    readers.emplace_back([&] {
+      std::uint64_t last = 0;
+      while (!done.load(std::memory_order_relaxed)) {
+        auto snapshot = source.read();
+        const auto port =
+            static_cast<std::uint16_t>(snapshot->version % 60000 + 1);
+        if (snapshot->version < last || snapshot->endpoints.size() != width) {
+          failures.fetch_add(1);
+          continue;
+        }
+        last = snapshot->version;
+        for (const Endpoint &endpoint : snapshot->endpoints) {
+          if (endpoint.port() != port) {
+            failures.fetch_add(1);
+          }
+        }
+      }
+    });
+  }
+
+  for (std::uint64_t version = 1; version <= 2000; ++version) {
+    source.update(makeSet(version));
+  }
+  done = true;
+  for (auto &reader : readers) {
+    reader.join();
+  }
+
+  REQUIRE(failures.load() == 0);
+  REQUIRE(source.read()->version == 2000);
+  source.reclaim();
+  REQUIRE(source.retiredCount() == 0);
+}
+
+#ifndef _WIN32
+
+#include "net/core/event_loop.h"
+#include "net/core/upstream_watcher.h"
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <string>
+
+#include <unistd.h>
+
+using namespace std::chrono_literals;
+
+namespace {
+
+/// Temporary directory holding an upstream file; removed on destruction.
+class TempUpstreamFile {
+public:
+  TempUpstreamFile() {
+    char dir[] = "/tmp/netlib_upstreams_XXXXXX";
+    REQUIRE(::mkdtemp(dir) != nullptr);
+    dir_ = dir;
+    path_ = dir_ + "/upstreams.conf";
+  }
+  ~TempUpstreamFile() {
+    std::remove(path_.c_str());
+    std::remove((path_ + ".tmp").c_str());
+    ::rmdir(dir_.c_str());
+  }
+
+  [[nodiscard]] const std::string &path() const { return path_; }
+
+  /// Replace the file the way deployment tools do: write aside, rename.
+  void replace(const std::string &contents) const {
+    {
+      std::ofstream out(path_ + ".tmp");
+      out << contents;
+    }
+    REQUIRE(std::rename((path_ + ".tmp").c_str(), path_.c_str()) == 0);
+  }
+
+private:
+  std::string dir_;
+  std::string path_;
+};
+
+template <typename Predicate>
+bool runUntil(EventLoop &loop, Predicate predicate) {
+  const auto deadline = EventLoop::Clock::now() + 5s;
+  while (!predicate() && EventLoop::Clock::now() < deadline) {
+    loop.runOnce(50ms);
+  }
+  return predicate();
+}
+
+} // namespace
+
+TEST_CASE("UpstreamFileWatcher publishes file changes", "[upstream_set]") {
+  TempUpstreamFile file;
+  file.replace("10.0.0.1:80\n");
+
+  EventLoop loop;
+  UpstreamSource source;
+  UpstreamFileWatcher::Options options;
+  options.debounce = 10ms;
+  options.poll_interval = 20ms;
+  UpstreamFileWatcher watcher(loop, file.path(), source, options);
+  std::vector<std::string> errors;
+  watcher.setErrorHandler(
+      [&](const std::string &message) { errors.push_back(message); });
+
+  REQUIRE(source.read()->version == 1);
+  REQUIRE(source.read()->endpoints ==
+          std::vector<Endpoint>{Endpoint("10.0.0.1", 80)});
+
+  file.replace("10.0.0.1:80\n10.0.0.2:80\n");
+  REQUIRE(runUntil(loop, [&] { return source.read()->version == 2; }));
+  REQUIRE(source.read()->endpoints.size() == 2);
+
+  // A broken file keeps the current set.
+  file.replace("10.0.0.3\n");
+  REQUIRE(runUntil(loop, [&] { return watcher.stats().errors == 1; }));
+  REQUIRE(errors.size() == 1);
+  REQUIRE(errors[0].find("upstreams:1") != std::string::npos);
+  REQUIRE(source.read()->version == 2);
+
+  // Rewriting the same endpoints publishes nothing.
+  file.replace("# same as before\n10.0.0.1:80\n10.0.0.2:80\n");
+  REQUIRE(runUntil(loop, [&] { return watcher.stats().unchanged == 1; }));
+  REQUIRE(source.read()->version == 2);
+  REQUIRE(watcher.stats().reloads == 2);
+}
+
+TEST_CASE("UpstreamFileWatcher reads a burst of changes once",
+          "[upstream_set]") {
+  TempUpstreamFile file;
+  file.replace("10.0.0.1:80\n");
+
+  EventLoop loop;
+  UpstreamSource source;
+  UpstreamFileWatcher::Options options;
+  options.debounce = 200ms;
+  UpstreamFileWatcher watcher(loop, file.path(), source, options);
+
+  // Each change lands well inside the quiet period of the one before.
+  for (int i = 2; i <= 6; ++i) {
+    file.replace("10.0.0." + std::to_string(i) + ":80\n");
+    const auto until = EventLoop::Clock::now() + 20ms;
+    while (EventLoop::Clock::now() < until) {
+      loop.runOnce(5ms);
+    }
+  }
+  REQUIRE(source.read()->version == 1);
+
+  REQUIRE(runUntil(loop, [&] { return source.read()->version == 2; }));
+  REQUIRE(source.read()->endpoints ==
+          std::vector<Endpoint>{Endpoint("10.0.0.6", 80)});
+  REQUIRE(watcher.stats().reloads == 2);
+  REQUIRE(watcher.stats().unchanged == 0);
+}
+
+TEST_CASE("UpstreamFileWatcher requires a readable file", "[upstream_set]") {
+  EventLoop loop;
+  UpstreamSource source;
+  REQUIRE_THROWS_AS(
+      UpstreamFileWatcher(loop, "/nonexistent/upstreams.conf", source),
+      std::system_error);
+}
+
+#endif